@@ -0,0 +1,163 @@
+#pragma once
+
+#include <string.h>
+
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+#include <meta_definitions.h>
+#include <scene.h>
+
+// This file is responsible for describing where the fields of each
+// component live, the serialized ones and the ones the engine keeps at
+// runtime, so that when a hot reload changes the size
+// or the fields of a component, the pools that were filled in by the
+// old game module can be migrated to the new layout instead of being
+// misinterpreted.
+
+constexpr u32 MAX_COMPONENT_FIELDS = 16;
+constexpr u32 MAX_LAYOUT_NAME_LENGTH = 48;
+
+// Moves the field at the source into the destination, and destroys the
+// one at the source.
+typedef void field_move_function_t(void *destination, void *source);
+
+struct ComponentFieldLayout
+{
+    char name[MAX_LAYOUT_NAME_LENGTH];
+    u32 offset;
+    u32 size;
+    // NOTE(marvin): Hash of the type's name, so that a field that
+    // changed type is treated as a new field.
+    u64 typeHash;
+    // Whether the field is in the SERIALIZE of the component, rather
+    // than only in its RUNTIME_FIELDS.
+    b32 serialized;
+    // NOTE(marvin): Null for the trivially copyable fields, which are
+    // moved with a copy. The field is the same type in both modules
+    // when it is moved, so the functions of the new module work on
+    // what the old one made, only those of the current layouts are
+    // ever called. The first moves into uninitialized memory, the
+    // second into a field that was default constructed.
+    field_move_function_t *moveConstructFunc;
+    field_move_function_t *moveAssignFunc;
+};
+
+// NOTE(marvin): Lives in the game memory, which is why the names are
+// copied rather than pointing into the game module that described them.
+struct ComponentLayout
+{
+    char name[MAX_LAYOUT_NAME_LENGTH];
+    u32 size;
+    u32 fieldCount;
+    ComponentFieldLayout fields[MAX_COMPONENT_FIELDS];
+};
+
+// Where a pool was and where it is after a migration, for the
+// components that point into their own pool, like the parents and
+// children of transforms.
+struct ComponentPoolRemap
+{
+    u8 *oldBase;
+    siz oldElementSize;
+    u8 *newBase;
+    siz newElementSize;
+};
+
+// Produces where the component that the pointer pointed to in the old
+// pool is now. Pointers that don't point into the old pool, including
+// nullptr, are left as they are.
+template <typename T>
+T *RemapPoolPointer(ComponentPoolRemap *remap, T *pointer)
+{
+    u8 *at = reinterpret_cast<u8 *>(pointer);
+    if (at < remap->oldBase || at >= remap->oldBase + MAX_ENTITIES * remap->oldElementSize)
+    {
+        return pointer;
+    }
+    siz index = static_cast<siz>(at - remap->oldBase) / remap->oldElementSize;
+    return reinterpret_cast<T *>(remap->newBase + index * remap->newElementSize);
+}
+
+// The layouts of the components that the scene's component pools were
+// made with, indexed by component ID.
+struct ComponentLayoutTable
+{
+    ComponentLayout layouts[MAX_COMPONENTS];
+    u32 count;
+    u64 hash;
+};
+
+inline u64 HashLayoutName(const char *name)
+{
+    // NOTE(marvin): FNV-1a.
+    u64 result = 14695981039346656037ull;
+    for (const char *at = name; *at; ++at)
+    {
+        result ^= static_cast<u8>(*at);
+        result *= 1099511628211ull;
+    }
+    return result;
+}
+
+template <typename F>
+void MoveConstructField(void *destination, void *source)
+{
+    F *from = static_cast<F *>(source);
+    new (destination) F(std::move(*from));
+    from->~F();
+}
+
+template <typename F>
+void MoveAssignField(void *destination, void *source)
+{
+    F *from = static_cast<F *>(source);
+    *static_cast<F *>(destination) = std::move(*from);
+    from->~F();
+}
+
+template <typename F>
+void AddFieldLayout(ComponentLayout *layout, const char *name, siz offset, b32 serialized)
+{
+    static_assert(std::is_trivially_copyable_v<F> || (std::is_move_constructible_v<F> && std::is_move_assignable_v<F>),
+                  "Component fields have to be movable to be migrated.");
+    ASSERT(layout->fieldCount < MAX_COMPONENT_FIELDS);
+    ComponentFieldLayout *field = layout->fields + layout->fieldCount++;
+    strncpy(field->name, name, MAX_LAYOUT_NAME_LENGTH - 1);
+    field->offset = static_cast<u32>(offset);
+    field->size = sizeof(F);
+    field->typeHash = HashLayoutName(typeid(F).name());
+    field->serialized = serialized;
+    if constexpr (std::is_trivially_copyable_v<F>)
+    {
+        field->moveConstructFunc = nullptr;
+        field->moveAssignFunc = nullptr;
+    }
+    else
+    {
+        field->moveConstructFunc = MoveConstructField<F>;
+        field->moveAssignFunc = MoveAssignField<F>;
+    }
+}
+
+// Produces whether the two layouts put the same fields in the same places.
+b32 ComponentLayoutsMatch(ComponentLayout *a, ComponentLayout *b);
+
+// Copies the layouts of the registered components into the scene's
+// table, to be compared against after the next reload.
+void SaveComponentLayouts(Scene &scene);
+
+// Produces whether the scene's pools were made with a different set of
+// components, or layouts, than the ones registered by this game module.
+b32 ComponentLayoutsChanged(Scene &scene);
+
+// Matches the scene's pools to the registered components by name, and
+// moves the described fields of every component whose layout changed
+// to where the new layout has them. Fields that are new, that changed
+// type, or that are neither in the SERIALIZE nor in the RUNTIME_FIELDS
+// of the component, get the value of a default constructed component,
+// and fields that were removed are dropped. Components that point into
+// their own pool have those pointers moved along with the pool.
+void MigrateComponentPools(Scene &scene);
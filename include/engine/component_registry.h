@@ -20,6 +20,22 @@ DataEntry* ReadToData(T* src, std::string name)
     return new DataEntry(name);
 }
 
+// NOTE(marvin): Components without a SERIALIZE have no fields to
+// migrate, only a size.
+template <typename T>
+void DescribeFields(T* probe, ComponentLayout* layout) {}
+
+// NOTE(marvin): The fields that aren't saved with the map but that the
+// engine keeps at runtime, like the IDs of bodies and lights, which have
+// to survive a migration as well.
+template <typename T>
+void DescribeRuntimeFields(T* probe, ComponentLayout* layout) {}
+
+// NOTE(marvin): Only the components that point into their own pool
+// have anything to remap, which they specialize.
+template <typename T>
+void RemapComponentPointers(void* address, ComponentPoolRemap* remap) {}
+
 template <typename T>
 s32 WriteIfPresent(T* dest, std::string name, std::vector<DataEntry*>& data)
 {
@@ -68,18 +84,40 @@ DataEntry* ReadComponent(Scene &scene, EntityID entity)
     return ReadToData<T>(comp, compName<T>);
 }
 
+template <typename T>
+void ConstructComponent(void *address)
+{
+    new(address) T();
+}
+
+template <typename T>
+void DescribeComponent(ComponentInfo &compInfo, const char *name)
+{
+    ComponentLayout &layout = compInfo.layout;
+    strncpy(layout.name, name, MAX_LAYOUT_NAME_LENGTH - 1);
+    layout.size = sizeof(T);
+
+    // NOTE(marvin): Only the addresses of the fields are taken, the
+    // probe is never constructed.
+    alignas(T) u8 probe[sizeof(T)];
+    DescribeFields<T>(reinterpret_cast<T*>(probe), &layout);
+    DescribeRuntimeFields<T>(reinterpret_cast<T*>(probe), &layout);
+}
+
 template <typename T>
 void AddComponent(const char *name)
 {
     compName<T> = name;
-    CompInfos().push_back({AssignComponent<T>, RemoveComponent<T>, WriteComponent<T>, ReadComponent<T>, sizeof(T), std::type_index(typeid(T)), name});
+    CompInfos().push_back({AssignComponent<T>, RemoveComponent<T>, WriteComponent<T>, ReadComponent<T>, ConstructComponent<T>, RemapComponentPointers<T>, sizeof(T), std::type_index(typeid(T)), name});
+    DescribeComponent<T>(CompInfos().back(), name);
 }
 
 template <typename T>
 void AddComponent(const char *name, const char *icon)
 {
     compName<T> = name;
-    CompInfos().push_back({AssignComponent<T>, RemoveComponent<T>, WriteComponent<T>, ReadComponent<T>, sizeof(T), std::type_index(typeid(T)), name, icon});
+    CompInfos().push_back({AssignComponent<T>, RemoveComponent<T>, WriteComponent<T>, ReadComponent<T>, ConstructComponent<T>, RemapComponentPointers<T>, sizeof(T), std::type_index(typeid(T)), name, icon});
+    DescribeComponent<T>(CompInfos().back(), name);
 }
 
 #define PARENS ()
@@ -101,6 +139,12 @@ void AddComponent(const char *name, const char *icon)
 #define READ_FIELD(type, field) \
     data->structVal.push_back(ReadToData<decltype(type::field)>(&src->field, #field));
 
+#define DESCRIBE_FIELD(type, field) \
+    AddFieldLayout<decltype(type::field)>(layout, #field, reinterpret_cast<u8*>(&probe->field) - reinterpret_cast<u8*>(probe), true);
+
+#define DESCRIBE_RUNTIME_FIELD(type, field) \
+    AddFieldLayout<decltype(type::field)>(layout, #field, reinterpret_cast<u8*>(&probe->field) - reinterpret_cast<u8*>(probe), false);
+
 #define DECLARE_EXTERNS(type, field) \
     extern template s32 WriteFromData<decltype(type::field)>(decltype(type::field)* dest, DataEntry* data); \
     extern template DataEntry* ReadToData<decltype(type::field)>(decltype(type::field)* src, std::string name);
@@ -125,6 +169,18 @@ void AddComponent(const char *name, const char *icon)
         DataEntry* data = new DataEntry(name); \
         FOR_FIELDS(READ_FIELD, name, __VA_ARGS__) \
         return data; \
+    } \
+    template <> \
+    void DescribeFields<name>(name* probe, ComponentLayout* layout) \
+    { \
+        FOR_FIELDS(DESCRIBE_FIELD, name, __VA_ARGS__) \
+    }
+
+#define RUNTIME_FIELDS(name, ...) \
+    template <> \
+    void DescribeRuntimeFields<name>(name* probe, ComponentLayout* layout) \
+    { \
+        FOR_FIELDS(DESCRIBE_RUNTIME_FIELD, name, __VA_ARGS__) \
     }
 
 #define COMPONENT(type, ...) [[maybe_unused]] static int add##type = (AddComponent<type>(#type __VA_OPT__(,) __VA_ARGS__), 0);
@@ -132,6 +188,7 @@ void AddComponent(const char *name, const char *icon)
 #else
 
 #define SERIALIZE(...)
+#define RUNTIME_FIELDS(...)
 #define COMPONENT(...)
 
 #endif
@@ -6,4 +6,6 @@ struct GameState;
 struct GameInput;
 
 void FindCamera(GameState &gameState);
-void DrawScene(GameState &gameState, GameInput &input, f32 deltaTime);
+// The blend factor is how far the frame is from the second to last
+// fixed step to the last one, for drawing the rigid bodies in between.
+void DrawScene(GameState &gameState, GameInput &input, f32 deltaTime, f32 blendFactor);
@@ -7,9 +7,12 @@
 
 enum OverlayMode
 {
-    overlayMode_none      = 0,
-    overlayMode_ecsEditor = 1,
-    overlayMode_memory    = 2,
+    overlayMode_none       = 0,
+    overlayMode_ecsEditor  = 1,
+    overlayMode_memory     = 2,
+    overlayMode_telemetry  = 3,
+    overlayMode_profiler   = 4,
+    overlayMode_frameTimes = 5,
 };
 
 struct GameState
@@ -19,6 +22,10 @@ struct GameState
     EntityID currentCamera = -1;
     b32 isEditor;
 
+    // NOTE(marvin): The frame time that the fixed timestep systems have
+    // yet to step through, always less than one step between frames.
+    f32 fixedTimestepAccumulator;
+
     // TODO(marvin): Overlay mode is a shared between ecs editor and debug mode. Ideally in a different struct or compiled away for the actual game release. However, because ecs editor is part of game release, cannot be compiled away.
     // NOTE(marvin): In actual release, overlay mode should only be none, and is never checked.
     OverlayMode overlayMode;
@@ -27,3 +34,6 @@ struct GameState
 extern PlatformAssetUtils assetUtils;
 extern PlatformRenderer renderer;
 extern PlatformAllocator allocator;
+extern MemoryTelemetry *globalMemoryTelemetry;
+extern FrameStats *globalFrameStats;
+extern JobScheduler *globalJobScheduler;
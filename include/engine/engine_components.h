@@ -9,6 +9,7 @@
 // Define the game's components here
 
 SERIALIZE(Transform3D, position, rotation, scale)
+RUNTIME_FIELDS(Transform3D, parent, children, worldTransform)
 COMPONENT(Transform3D)
 
 struct MeshComponent
@@ -19,6 +20,7 @@ struct MeshComponent
     bool dirty = true;
 };
 SERIALIZE(MeshComponent, mesh, texture, color)
+RUNTIME_FIELDS(MeshComponent, dirty)
 COMPONENT(MeshComponent)
 
 namespace JPH
@@ -36,6 +38,7 @@ struct PlayerCharacter
     b32 isJumping;
 };
 SERIALIZE(PlayerCharacter, moveSpeed)
+RUNTIME_FIELDS(PlayerCharacter, characterVirtual, isJumping)
 COMPONENT(PlayerCharacter)
 
 
@@ -44,8 +47,49 @@ struct StaticBox
     bool initialized = false;
 };
 SERIALIZE(StaticBox)
+RUNTIME_FIELDS(StaticBox, initialized)
 COMPONENT(StaticBox)
 
+// NOTE(marvin): A dynamic box the size of the scale of its transform.
+// The physics system writes the position and rotation of the transform
+// after every step in which the body moved. They are in world space, so
+// the entity shouldn't have a parent.
+struct RigidBody
+{
+    f32 mass = 1.0f;
+    f32 friction = 0.2f;
+    f32 restitution = 0.0f;
+
+    // The JPH::BodyID, 0xffffffff until the body is created.
+    u32 bodyID = 0xffffffff;
+
+    // NOTE(marvin): The state of the body after the last two steps, in
+    // Jolt's coordinate system, so that a frame can be drawn in between
+    // them. The rotations are quaternions, xyzw.
+    glm::vec3 previousPosition;
+    glm::vec4 previousRotation;
+    glm::vec3 position;
+    glm::vec4 rotation;
+};
+SERIALIZE(RigidBody, mass, friction, restitution)
+RUNTIME_FIELDS(RigidBody, bodyID, previousPosition, previousRotation, position, rotation)
+COMPONENT(RigidBody)
+
+// NOTE(marvin): A static collider in the shape of the mesh of the
+// MeshComponent of the entity, scaled, rotated and placed by its
+// transform. Either the convex hull of the vertices, or the triangles
+// themselves, for the meshes that aren't convex.
+struct MeshCollider
+{
+    bool convex = true;
+
+    // The JPH::BodyID, 0xffffffff until the body is created.
+    u32 bodyID = 0xffffffff;
+};
+SERIALIZE(MeshCollider, convex)
+RUNTIME_FIELDS(MeshCollider, bodyID)
+COMPONENT(MeshCollider)
+
 struct CameraComponent
 {
     f32 fov = 90;
@@ -60,6 +104,7 @@ struct EditorController
     f32 moveSpeed = 5;
     f32 turnSpeed = 0.1;
 };
+RUNTIME_FIELDS(EditorController, moveSpeed, turnSpeed)
 COMPONENT(EditorController)
 
 struct DirLight
@@ -69,6 +114,7 @@ struct DirLight
     LightID lightID = -1;
 };
 SERIALIZE(DirLight, diffuse, specular)
+RUNTIME_FIELDS(DirLight, lightID)
 COMPONENT(DirLight, "gizmos/dir_light")
 
 
@@ -83,6 +129,7 @@ struct SpotLight
     f32 range = 100;
 };
 SERIALIZE(SpotLight, diffuse, specular, innerCone, outerCone, range)
+RUNTIME_FIELDS(SpotLight, lightID)
 COMPONENT(SpotLight, "gizmos/spot_light")
 
 
@@ -96,6 +143,8 @@ struct PointLight
     f32 falloff{ 0 };
 };
 SERIALIZE(PointLight, diffuse, specular, radius, falloff)
+RUNTIME_FIELDS(PointLight, lightID)
 COMPONENT(PointLight, "gizmos/point_light")
 
+RUNTIME_FIELDS(NameComponent, name)
 COMPONENT(NameComponent)
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <game_platform.h>
+#include <meta_definitions.h>
+
+// This file is responsible for the input action map, which is what the
+// engine queries instead of specific keys, so that a binding is changed
+// in one place. The bindings are written as key names, and are
+// resolved to key codes once on game load, so that a query is only a
+// few bit tests.
+
+enum InputAction
+{
+    inputAction_moveForward    = 0,
+    inputAction_moveBackward   = 1,
+    inputAction_moveRight      = 2,
+    inputAction_moveLeft       = 3,
+    inputAction_editorLook     = 4,
+    inputAction_editorSelect   = 5,
+    inputAction_editorSave     = 6,
+    inputAction_editorModifier = 7,
+
+    inputAction_count,
+};
+
+constexpr u32 MAX_BINDINGS_PER_INPUT_ACTION = 2;
+
+enum InputDevice
+{
+    inputDevice_none     = 0,
+    inputDevice_keyboard = 1,
+    inputDevice_mouse    = 2,
+};
+
+struct InputBinding
+{
+    InputDevice device;
+    u32 code;  // KeyCode or MouseButton, depending on the device.
+};
+
+struct InputActionMap
+{
+    InputBinding bindings[inputAction_count][MAX_BINDINGS_PER_INPUT_ACTION];
+};
+
+extern InputActionMap globalInputActionMap;
+
+// Produces false if the name isn't of a known key, in which case the
+// binding is left untouched. The names are the same as SDL's, such as
+// "W", "Left Ctrl" or "Mouse 1".
+b32 ResolveInputBinding(const char *name, InputBinding *binding);
+
+// Resolves the default bindings. Called on every game load.
+void LoadInputActionMap(InputActionMap *map);
+
+// NOTE(marvin): An action is down if any of its bindings is down.
+
+b32 OnPress(GameInput *input, InputAction action);
+b32 OnRelease(GameInput *input, InputAction action);
+b32 OnHold(GameInput *input, InputAction action);
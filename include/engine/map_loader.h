@@ -4,6 +4,8 @@
 #include <vector>
 #include <typeindex>
 
+#include <component_layout.h>
+
 struct NameComponent
 {
     std::string name;
@@ -22,10 +24,16 @@ struct ComponentInfo
     void (*removeFunc)(Scene&, EntityID);
     s32 (*writeFunc)(Scene&, EntityID, DataEntry*);
     DataEntry* (*readFunc)(Scene&, EntityID);
+    // Default constructs the component at the given address.
+    void (*constructFunc)(void*);
+    // Points the pointers of the component at the given address into
+    // its own pool to where the pool is after a migration.
+    void (*remapFunc)(void*, ComponentPoolRemap*);
     size_t size;
     std::type_index type;
     std::string name;
     std::string iconPath;
+    ComponentLayout layout;
 };
 
 struct IconGizmo
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <span>
+
 #include <engine.h>
 #include <scene.h>
 #include <engine_components.h>
@@ -10,13 +12,19 @@ namespace JPH
 {
     class PhysicsSystem;
     class JobSystem;
+    class ContactListener;
     class CharacterVirtual;
     class Vec3;
+    class Quat;
 }
 
 // TODO(marvin): Major differences between physics subsystem and an ecs system. Should there abe any differences? Biggest once is that physics subsystem is not a struct and cannot hold information of its own. Doesn't have initialize, though there could be initialization checks in there that does initialization first-time.
 
 class SKLPhysicsSystem;
+class SKLTempAllocator;
+struct SKLShapeCache;
+struct SKLContactRecorder;
+struct SKLSnapshotCache;
 
 #define SKL_PHYSICS_SUBSYSTEM(name) void name(SKLPhysicsSystem* sklPhysicsSystem, SYSTEM_VTABLE_ON_UPDATE_PARAMS)
 typedef SKL_PHYSICS_SUBSYSTEM(skl_physics_subsystem_t);
@@ -29,6 +37,115 @@ struct SKLPhysicsSubSystemBuffer
 
 SKLPhysicsSubSystemBuffer InitPhysicsSubsystemBuffer(u32 count);
 
+// What the temp allocator of the physics steps has, see SKLTempAllocator.
+struct SKLTempArena
+{
+    MemoryArena arena;
+
+    // Bytes that didn't fit in the arena, and are from the platform
+    // allocator instead.
+    siz overflowUsed;
+    u32 overflowCount;
+
+    // The most that was used, arena and overflow together, in the
+    // current step and over all steps.
+    siz stepHighWater;
+    siz highWater;
+};
+
+// The capacities that the Jolt physics system is created with. It
+// can't grow them itself, so it is recreated with larger ones when
+// they run out, see SKLPhysicsSystem::requestedCapacities.
+struct SKLPhysicsCapacities
+{
+    u32 maxBodies;
+    u32 maxBodyPairs;
+    u32 maxContactConstraints;
+};
+
+// The closest hit of a ray, see SKLPhysicsSystem::CastRays.
+struct SKLRayHit
+{
+    b32 hit;
+    // NOTE(marvin): The entity is only there for the bodies that were
+    // made from a component, the body ID is there for all of them.
+    EntityID entity;
+    u32 bodyID;
+    // How far along the direction of the ray the hit is, from 0 to 1.
+    f32 fraction;
+    glm::vec3 point;
+    glm::vec3 normal;
+};
+
+// A box to test for overlaps, rotated by Euler angles in degrees like
+// a Transform3D.
+struct SKLOverlapBox
+{
+    glm::vec3 center;
+    glm::vec3 halfExtents;
+    glm::vec3 rotation;
+};
+
+struct SKLOverlapSphere
+{
+    glm::vec3 center;
+    f32 radius;
+};
+
+// The entities of the bodies that overlap one box or sphere, see
+// SKLPhysicsSystem::OverlapBoxes.
+struct SKLOverlap
+{
+    EntityID *entities;
+    u32 count;
+    // Whether there were more bodies than the most that were asked for.
+    b32 truncated;
+};
+
+// A saved state of the bodies and constraints of the physics world, see
+// SKLPhysicsSystem::SaveState.
+struct SKLPhysicsSnapshot
+{
+    // NOTE(marvin): A snapshot with a base only has what changed since
+    // it, which has to be kept around for as long as this one is.
+    SKLPhysicsSnapshot *base;
+    u8 *data;
+    siz size;
+    // The size of the state, once decoded.
+    siz stateSize;
+    // The number of bases before this one, see MAX_SNAPSHOT_CHAIN_LENGTH.
+    u32 chainLength;
+};
+
+enum SKLContactEventType
+{
+    contactEventType_added     = 0,
+    contactEventType_persisted = 1,
+    contactEventType_removed   = 2,
+};
+
+// A contact between the bodies of two entities, or an overlap with a
+// sensor, see SKLPhysicsSystem::GetContactEvents. A contact is there
+// once for each of its two entities.
+struct SKLContactEvent
+{
+    SKLContactEventType type;
+    EntityID entity;
+    EntityID otherEntity;
+    u32 bodyID;
+    u32 otherBodyID;
+    // Whether either of the bodies is a sensor, which only overlaps.
+    b32 sensor;
+    // The fixed step of the frame it happened in, from 0.
+    u32 stepIndex;
+
+    // NOTE(marvin): Zero for a removed contact. The normal points from
+    // the entity towards the other one.
+    glm::vec3 point;
+    glm::vec3 normal;
+    f32 penetrationDepth;
+};
+
 class SKLPhysicsSystem : public System
 {
 public:
@@ -37,10 +154,41 @@ public:
     JPH::ObjectVsBroadPhaseLayerFilter* objectVsBroadPhaseLayerFilter;
     JPH::ObjectLayerPairFilter* objectLayerPairFilter;
     JPH::JobSystem* jobSystem;
-    JPH::TempAllocatorImpl* allocator;
+    SKLTempAllocator* allocator;
+    SKLTempArena tempArena;
+    SKLShapeCache* shapeCache;
+    JPH::ContactListener* contactListener;
+    SKLContactRecorder* contactRecorder;
+    SKLSnapshotCache* snapshotCache;
+
+    // NOTE(marvin): The contact events of the steps of the current
+    // frame, sorted by entity, see GetContactEvents.
+    SKLContactEvent* contactEvents;
+    u32 contactEventCount;
+    u32 contactEventCapacity;
+    u32 frameStepCount;
+
+    // NOTE(marvin): The IDs of the rigid bodies that were awake after
+    // the last step, to catch the ones that fell asleep since.
+    u32* awakeBodyIDs;
+    u32 awakeBodyCount;
+    u32 awakeBodyCapacity;
+
+    SKLPhysicsCapacities capacities;
+    // NOTE(marvin): Raised when the physics system runs out of one of
+    // its capacities, it is recreated with these before the next step.
+    SKLPhysicsCapacities requestedCapacities;
+    // Incremented every time the physics system is recreated. Anything
+    // that holds on to the old one, like a constraint, has to be made
+    // again when it changes.
+    u32 physicsSystemGeneration;
 
     b32 userOverrideLayers;
 
+    // NOTE(marvin): Static bodies added since the broad phase was last
+    // optimized.
+    u32 staticBodiesSinceOptimize;
+
     SKLPhysicsSubSystemBuffer preUpdateSubsystemBuffer;
     SKLPhysicsSubSystemBuffer postUpdateSubsystemBuffer;
     
@@ -48,9 +196,13 @@ public:
 
     ~SKLPhysicsSystem();
 
+    SYSTEM_ON_START();
+
     SYSTEM_ON_UPDATE();
 
-    void Initialize(b32 firstTime = false);
+    // The scene is only needed the first time, the capacities are sized
+    // for the bodies that it already has.
+    void Initialize(b32 firstTime = false, Scene *scene = nullptr);
 
     // Must be called before Initialize for it to take effect.
     void InitializeLayers(JPH::BroadPhaseLayerInterface* broadPhaseLayer_, JPH::ObjectVsBroadPhaseLayerFilter* objectVsBroadPhaseLayerFilter, JPH::ObjectLayerPairFilter* objectLayerPairFilter_);
@@ -58,6 +210,47 @@ public:
     // Must be called before Initialize for it to take effect.
     void InitializeSubSystems(SKLPhysicsSubSystemBuffer preUpdateSubsystemBuffer,
                               SKLPhysicsSubSystemBuffer postUpdateSubsystemBuffer);
+
+    // NOTE(marvin): The queries are split into jobs and wait for them,
+    // so they can take thousands at a time. They read the bodies as of
+    // the last step, and can't be made while a step is running. Their
+    // results are pushed onto the given arena, one for each query, in
+    // the same order.
+
+    // Casts each ray, whose direction is as long as the distance it
+    // goes, producing its closest hit.
+    SKLRayHit *CastRays(std::span<const SKLRay> rays, MemoryArena *resultArena);
+
+    // Produces up to maxHitsPerQuery of the entities that overlap each
+    // box or sphere.
+    SKLOverlap *OverlapBoxes(std::span<const SKLOverlapBox> boxes, u32 maxHitsPerQuery, MemoryArena *resultArena);
+
+    SKLOverlap *OverlapSpheres(std::span<const SKLOverlapSphere> spheres, u32 maxHitsPerQuery, MemoryArena *resultArena);
+
+    // Saves the state of the physics world between steps, pushed onto
+    // the given arena. With a base, only what changed since it is kept,
+    // which for consecutive frames is a fraction of the whole state.
+    // Every so many snapshots, the whole state is kept instead, so that
+    // decoding one never goes through more than a few bases.
+    SKLPhysicsSnapshot *SaveState(MemoryArena *arena, SKLPhysicsSnapshot *base = nullptr);
+
+    // Clears the contact events of the last frame. Called by the engine
+    // before the first step of a frame.
+    void BeginFrame();
+
+    // Produces the contact events of every step of the frame so far,
+    // sorted by entity, and in the order of the steps for each entity.
+    // Jolt reports them on its worker threads, but they are only put
+    // here after the step, so nothing runs into game code during it.
+    std::span<SKLContactEvent> GetContactEvents();
+
+    // Produces the contact events of one entity, see above.
+    std::span<SKLContactEvent> GetContactEvents(EntityID ent);
+
+    // Restores a saved state, and the rigid bodies of the scene with it.
+    // The world has to have the same bodies as when it was saved.
+    // Produces whether it could be restored.
+    b32 RestoreState(SKLPhysicsSnapshot *snapshot, Scene *scene);
 };
 
 JPH::Vec3 OurToJoltCoordinateSystem(glm::vec3 ourVec3);
@@ -66,3 +259,13 @@ glm::vec3 JoltToOurCoordinateSystem(JPH::Vec3 joltVec3);
 
 JPH::Vec3 LerpJPHVec3(JPH::Vec3 a, JPH::Vec3 b, f32 blendFactor);
 
+// The rotation of a Transform3D, Euler angles in degrees, as a
+// quaternion in Jolt's coordinate system, and back.
+JPH::Quat OurToJoltRotation(glm::vec3 ourRotation);
+
+glm::vec3 JoltToOurRotation(JPH::Quat joltRotation);
+
+// Produces the world transform to draw a rigid body with, in between
+// the state of its last two steps. A blend factor of 1 is the last one.
+glm::mat4 GetRigidBodyRenderTransform(RigidBody *rigidBody, Transform3D *transform, f32 blendFactor);
+
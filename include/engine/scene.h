@@ -24,6 +24,10 @@ constexpr u32 MAX_SYSTEMS = 64;
 
 constexpr u32 SYSTEMS_MEMORY = Kilobytes(16);
 
+// NOTE(marvin): How many assignments of a tracked component are kept
+// between two drains, see ComponentAddedList.
+constexpr u32 COMPONENT_ADDED_LIST_CAPACITY = 4096;
+
 // NOTE(marvin): The heuristic is that a component will take 32 bytes on average. Admittedly not a great heuristic... 
 constexpr u32 COMPONENT_POOLS_MEMORY = MAX_COMPONENTS * MAX_ENTITIES * 32;
 
@@ -110,6 +114,7 @@ struct ComponentPool
 
 struct Scene;
 struct GameInput;
+struct ComponentLayoutTable;
 
 #define SYSTEM_VTABLE_ON_START_PARAMS Scene *scene
 #define SYSTEM_VTABLE_ON_START_PASS scene
@@ -131,6 +136,7 @@ typedef SYSTEM_VTABLE_ON_UPDATE(system_vtable_on_update_t);
 
 struct SystemVTable
 {
+    const char *name;
     system_vtable_on_start_t *onStart;
     system_vtable_on_update_t *onUpdate;
 };
@@ -176,6 +182,7 @@ public:
     }                                                       \
     SystemVTable NameConcat3(global, T, VTable) =           \
     {                                                       \
+        .name = #T,                                         \
         .onStart = NameConcat(T, _OnStart),                 \
         .onUpdate = NameConcat(T, _OnUpdate),               \
     };                                                      \
@@ -366,6 +373,37 @@ struct ComponentPoolsBuffer
     void Push(ComponentPool componentPool);
 };
 
+// The entities that were assigned a component since the list was last
+// drained, for systems that want to react to new components rather
+// than scan for them every frame. Only kept for the components that
+// a system asked for with TrackAdded.
+struct ComponentAddedList
+{
+    EntityID *entities;  // nullptr if the component isn't tracked.
+    u32 count;
+    // NOTE(marvin): Set when more were assigned than fit, in which
+    // case whoever drains the list has to scan for them instead.
+    b32 overflowed;
+};
+
+inline void PushComponentAdded(ComponentAddedList *added, EntityID id)
+{
+    if (added->count < COMPONENT_ADDED_LIST_CAPACITY)
+    {
+        added->entities[added->count++] = id;
+    }
+    else
+    {
+        added->overflowed = true;
+    }
+}
+
+inline void ClearComponentAdded(ComponentAddedList *added)
+{
+    added->count = 0;
+    added->overflowed = false;
+}
+
 // Each component has its own memory pool, to have good memory
 // locality. An entity's ID is the index into its own component in the
 // component pool.
@@ -381,6 +419,9 @@ public:
 
     ComponentPoolsBuffer componentPools;
     MemoryArena componentPoolsArena;
+    ComponentLayoutTable *componentLayouts;
+    // Indexed by component ID.
+    ComponentAddedList *componentAddedLists;
 
 private:
     void *GetComponentAddress(EntityID entityId, ComponentID componentId)
@@ -421,6 +462,28 @@ public:
         return componentPools.count;
     }
 
+    // Starts keeping the entities that are assigned the component,
+    // beginning with the ones that already have it.
+    void TrackAdded(ComponentID componentId);
+
+    template<typename T>
+    void TrackAdded()
+    {
+        TrackAdded(GetComponentId<T>());
+    }
+
+    // The entities that were assigned the component since the list
+    // was last cleared. An entity may have been destroyed, or had the
+    // component removed, since.
+    template<typename T>
+    ComponentAddedList *GetAdded()
+    {
+        ComponentID componentId = GetComponentId<T>();
+        ComponentAddedList *result = componentAddedLists + componentId;
+        ASSERT(result->entities);
+        return result;
+    }
+
     // Removes a component from the entity with the given EntityID
     // if the EntityID is not already removed.
     template<typename T>
@@ -467,6 +530,12 @@ public:
             void *componentAddress = GetComponentAddress(id, componentId);
             result = new(componentAddress) T();
             componentMask.set(componentId);
+
+            ComponentAddedList *added = componentAddedLists + componentId;
+            if (added->entities)
+            {
+                PushComponentAdded(added, id);
+            }
         }
         return result;
     }
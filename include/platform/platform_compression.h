@@ -0,0 +1,20 @@
+#pragma once
+
+#include <meta_definitions.h>
+
+// This file is responsible for the compression of the platform's own
+// files, like the memory image of looped live editing. It's a small
+// LZ77 codec in the style of LZ4, which trades ratio for speed: the
+// images are mostly zeros and repeated patterns, which it compresses
+// well enough at several hundred MB/s.
+
+// Produces the largest size that the source can compress into.
+u64 GetCompressLZBound(u64 sourceSize);
+
+// Produces the size of the compressed source in dest. Dest must be at
+// least GetCompressLZBound(sourceSize) bytes.
+u64 CompressLZ(const u8* source, u64 sourceSize, u8* dest, u64 destCapacity);
+
+// Produces whether the source decompressed into exactly destSize
+// bytes. Malformed sources are caught rather than overrunning dest.
+b32 DecompressLZ(const u8* source, u64 sourceSize, u8* dest, u64 destSize);
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <meta_definitions.h>
+#include <platform_loop.h>
+
+// This file is responsible for the I/O thread of the platform, which
+// does the file writes of looped live editing, so that recording
+// doesn't stall the frame. The main thread is the only producer and
+// the I/O thread the only consumer of its queue, so the queue is a
+// lock-free ring buffer, and the I/O thread sleeps on a semaphore
+// while it is empty.
+
+struct SDLSnapshotCapture;
+
+constexpr u32 SDL_IO_QUEUE_SIZE = 256;  // Power of 2.
+
+enum SDLIOMessageType
+{
+    sdlIOMessage_writeInput    = 0,
+    sdlIOMessage_writeSnapshot = 1,
+    sdlIOMessage_close         = 2,
+    // Ends the I/O thread, once the messages before it are done.
+    sdlIOMessage_stop          = 3,
+};
+
+struct SDLIOMessage
+{
+    SDLIOMessageType type;
+    SDL_IOStream* stream;
+    union
+    {
+        LoopInputRecord input;
+        // NOTE(marvin): Owned by the I/O thread once pushed.
+        SDLSnapshotCapture* capture;
+    };
+};
+
+struct SDLIOThread
+{
+    // NOTE(marvin): nullptr if the thread couldn't be started, in
+    // which case the messages are done on the main thread.
+    SDL_Thread* thread;
+    SDL_Semaphore* semaphore;
+
+    SDLIOMessage messages[SDL_IO_QUEUE_SIZE];
+    // Only written by the main thread, once the message is in place.
+    u64 volatile writeIndex;
+    // Only written by the I/O thread, once the message has been done.
+    u64 volatile readIndex;
+};
+
+// Starts the thread if it hasn't been started yet.
+void StartIOThread(SDLIOThread* ioThread);
+
+// Copies the message into the queue, waiting for room if it's full.
+void PushIOMessage(SDLIOThread* ioThread, const SDLIOMessage* message);
+
+// Waits until every message pushed so far has been done.
+void DrainIOThread(SDLIOThread* ioThread);
+
+// Waits until at most the given number of messages are left to be
+// done, so that what they hold on to stays bounded.
+void WaitForIOThread(SDLIOThread* ioThread, u64 maxPendingCount);
+
+// Does every message pushed so far, then ends the thread and waits for
+// it. It can be started again afterwards.
+void StopIOThread(SDLIOThread* ioThread);
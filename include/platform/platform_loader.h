@@ -2,6 +2,7 @@
 
 #include <platform_memory.h>
 #include <game_platform.h>
+#include <platform_reload_thread.h>
 
 #define GAME_CODE_SRC_FILE_NAME "game-module"
 #define GAME_CODE_USE_FILE_NAME "game-module-locked"
@@ -26,28 +27,25 @@ struct GameCode
 {
 private:
     // >>> Game code with hot reloading logic <<<
-    SDL_SharedObject *m_sharedObjectHandle;
+    SDL_SharedObject *m_sharedObjectHandle{ nullptr };
 
-    SDL_Time m_fileLastWritten;
-    SDL_Time m_fileNewLastWritten;
+    game_initialize_t *m_gameInitializePtr{ nullptr };
+    game_load_t *m_gameLoadPtr{ nullptr };
+    game_get_persistent_dll_paths_t *m_gameGetPersistentDLLPathsPtr{ nullptr };
+    game_update_and_render_t *m_gameUpdateAndRenderPtr{ nullptr };
 
-    game_initialize_t *m_gameInitializePtr;
-    game_load_t *m_gameLoadPtr;
-    game_get_persistent_dll_paths_t *m_gameGetPersistentDLLPathsPtr;
-    game_update_and_render_t *m_gameUpdateAndRenderPtr;
-
-    // The amount of time loadGameCode has been successfully run
+    // The number of times game code has been loaded
     u32 m_loadCount{ 0 };
 
-    const char* getGameCodeSrcFilePath();
+    // NOTE(marvin): Heap allocated, as the thread holds onto it while
+    // the game code may be copied around.
+    SDLReloadThread *m_reloadThread{ nullptr };
+
     const char* getJoltLibSrcFilePath();
-    inline SDL_Time getFileLastWritten(const char *path);
 
-    // Returns whether the load was successful or not 
-    b8 loadGameCode(SDL_Time newFileLastWritten, b8 editor);
-    b8 loadGameCode(b8 editor);
+    // Unloads the current game code, and takes on the loaded one.
+    void swapGameCode(const SDLLoadedGameCode &loaded);
     void unloadGameCode();
-    b8 hasGameCodeChanged();
 
     // >>> Game code with static monolithic logic <<< 
 
@@ -55,8 +53,8 @@ public:
     // >>> Common public interface <<<
     GameCode(bool editor);
 
-    // Checks for any changes made to game code and attempts
-    // hot reload if any changes are found. 
+    // Swaps in the game code that the reload thread has loaded since
+    // the last frame, if any, so it must be called between frames.
     // Does not do anything if SKL_STATIC_MONOLITHIC isn't turned on.
     void updateGameCode(GameMemory& memory, b8 hasEditor);
 
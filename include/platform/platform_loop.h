@@ -5,15 +5,31 @@
 
 #include <SDL3/SDL.h>
 
-#include <set>
-#include <string>
-
 #include <meta_definitions.h>
 
+#include <game_platform.h>
+
 struct SDLState;
-struct GameInput;
 struct SDLMemoryBlock;
 
+// NOTE(marvin): Each slot has its own recording, in its own files, so
+// that several loops can be kept around and switched between.
+constexpr u32 LOOP_SLOT_COUNT = 4;
+
+// NOTE(marvin): A keyframe of the memory is taken every this many
+// frames while recording, so that seeking only has to simulate the
+// frames since the keyframe before.
+constexpr u64 LOOP_KEYFRAME_INTERVAL = 300;
+
+// NOTE(marvin): The frame time is recorded along with the input, so
+// that playing back and seeking simulate the same frames that were
+// recorded.
+struct LoopInputRecord
+{
+    GameInput input;
+    f32 frameTime;
+};
+
 // Represents the state of a memory block durring looping
 struct LoopMemoryFlags {
 private:
@@ -33,23 +49,36 @@ public:
 // For looping.
 struct LoopState {
 private: 
+    // NOTE(marvin): While capturing, the image of the memory at the
+    // start of the loop is copied over several frames, and the
+    // recording starts at the frame that it is done. It isn't a loop
+    // yet, so the memory blocks are allocated and freed as usual.
     enum class LoopedLiveEditingState : u8
     {
         none,
+        capturing,
         recording,
         playing,
     };
     LoopedLiveEditingState loopedLiveEditingState;
     union
     {
-        // NOTE(marvin): A flat sequence of [GameInput, u32 (for
-        // number of elements in keysDown set), a sequence of [u32
-        // (for number of elements in string), characters that make
-        // the string]]
+        // NOTE(marvin): A flat sequence of LoopInputRecord. The image
+        // of the memory at the start of the loop and its keyframes are
+        // in their own file.
         SDL_IOStream* recordingHandle;
         SDL_IOStream* playbackHandle;
     };
 
+    u32 slotIndex;
+    u64 recordedFrameCounts[LOOP_SLOT_COUNT];
+
+    // NOTE(marvin): The frame of the recording that is next to be
+    // recorded or played back.
+    u64 frameIndex;
+    // NOTE(marvin): The frames left to be simulated after a seek.
+    u64 fastForwardFrameCount;
+
 public:
     friend class LoopUtils;
 };
@@ -59,21 +88,22 @@ public:
 // ensuring tight encapsulation.
 class LoopUtils {
 private:
-    static const char* SDLGetInputFilePath();
+    static const char* SDLGetInputFilePath(u32 slotIndex);
+    static const char* SDLGetImageFilePath(u32 slotIndex);
+    static void SDLInvalidateOtherSnapshots(SDLState* state);
+    static b8 SDLReadInputRecord(SDLState* state, GameInput* gameInput, f32* frameTime);
     static b8 SDLIsInLoop(const SDLState* state);
     static void SDLClearBlocksByMask(SDLState* state, LoopMemoryFlags::SDLMemoryFlags mask);
     static void SDLBeginInputPlayback(SDLState* state);
     static void SDLEndInputPlayback(SDLState* state);
     static void SDLBeginRecordingInput(SDLState* state);
+    static void SDLContinueRecordingInput(SDLState* state);
+    static void SDLStartRecordingFrames(SDLState* state);
     static void SDLEndRecordingInput(SDLState* state);
-    static void SDLRecordStdString(SDLState* state, const std::string* str);
-    static void SDLRecordStdSetOfString(SDLState* state, const std::set<std::string>* strings);
-    static void SDLRecordInput(SDLState* state, const GameInput* gameInput);
-    static void SDLPlaybackStdString(SDLState* state, std::set<std::string>* strings);
-    static void SDLPlaybackStdSetOfString(SDLState* state, std::set<std::string>* strings);
+    static void SDLRecordInput(SDLState* state, const GameInput* gameInput, f32 frameTime);
 
     // Returns if a reset happen?
-    static b8 SDLPlaybackInput(SDLState* state, GameInput* gameInput, b8 forceReloadGameCode);
+    static b8 SDLPlaybackInput(SDLState* state, GameInput* gameInput, f32* frameTime, b8 forceReloadGameCode);
 
 public:
     static b8 GetIsStateInLoop(const SDLState* state);
@@ -82,10 +112,33 @@ public:
 
     static void ToggleLoopedLiveEditingState(SDLState* state);
 
-    // Based on live editing state, stores or plays game input
+    // Based on live editing state, stores or plays game input and
+    // frame time.
     // Produces a boolean on whether to reload game code.
     // TODO(marvin): Producing a b8ean for ProcessInputWithLooping feels very contrived. Keep eyes opened for a better way.
-    static b8 ProcessInputWithLooping(SDLState* state, GameInput* gameInput, b8 forceReloadGameCode);
+    static b8 ProcessInputWithLooping(SDLState* state, GameInput* gameInput, f32* frameTime, b8 forceReloadGameCode);
+
+    // Selects the slot that the next recording goes into, and that is
+    // played back. Only while not in a loop.
+    static void SelectSlot(SDLState* state, u32 slotIndex);
+    static u32 GetSlotIndex(const SDLState* state);
+
+    static u64 GetRecordedFrameCount(const SDLState* state);
+    static u64 GetPlaybackFrameIndex(const SDLState* state);
+
+    // Restores the keyframe at or before the frame, and queues up the
+    // frames between it and the frame to be fast forwarded. Only while
+    // playing back.
+    static void SeekToFrame(SDLState* state, u64 frameIndex);
+
+    // Produces the input and frame time of the next frame to fast
+    // forward, or false if there is none left. The game should be
+    // updated with it without rendering.
+    static b8 NextFastForwardInput(SDLState* state, GameInput* gameInput, f32* frameTime);
+
+    // Waits for everything that was recorded to be written, and stops
+    // the I/O thread. Called once, when the platform quits.
+    static void Shutdown(SDLState* state);
 
     // Gets and sets allocation flags
     static void SetBlockFlagLoopAllocated(SDLMemoryBlock* flag);
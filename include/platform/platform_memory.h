@@ -5,6 +5,9 @@
 #include <meta_definitions.h>
 #include <skl_types.h>
 #include <platform_loop.h>
+#include <platform_io_thread.h>
+#include <memory_telemetry.h>
+#include <allocation_guard.h>
 
 struct SDLMemoryBlock
 {
@@ -15,6 +18,7 @@ struct SDLMemoryBlock
     void* requestedBase;
     u64 requestedSize;
     void* wholeBase;
+    MemoryTag tag;
     SDLMemoryBlock* prev;
     SDLMemoryBlock* next;
     
@@ -26,10 +30,129 @@ private:
 #endif
 };
 
-struct SDLSavedMemoryBlock
+// NOTE(marvin): The image of the memory blocks for looped live
+// editing. The image file is a sequence of compressed pages, and
+// where each page is in the file is only kept here, which is enough
+// as the image is only ever restored by the process that wrote
+// it. Rewriting the image appends the pages that changed, and
+// pages that are all zero aren't written at all.
+struct SDLSnapshotBlock
 {
     void* requestedBase;
     u64 requestedSize;
+    u64 firstPage;  // Index of the record of the first page the block overlaps.
+};
+
+// NOTE(marvin): A file offset of zero means the page is all zero.
+struct SDLSnapshotPageRecord
+{
+    u64 fileOffset;
+    u32 storedSize;  // The page size if stored uncompressed.
+};
+
+struct SDLSnapshotPageChange
+{
+    u64 pageIndex;
+    SDLSnapshotPageRecord record;
+};
+
+// NOTE(marvin): The first keyframe is the whole image at the start
+// of the recording, each keyframe after it only has the pages that
+// changed since the one before, so the image at a keyframe is all of
+// the changes up to and including it.
+struct SDLSnapshotKeyframe
+{
+    u64 frameIndex;
+    // NOTE(marvin): Written by the I/O thread.
+    u64 firstChange;
+    u64 changeCount;
+};
+
+constexpr u32 MAX_SNAPSHOT_KEYFRAMES = 256;
+
+struct SDLSnapshotCapture;
+
+// NOTE(marvin): A page that is left to be copied for the image that
+// is being captured.
+struct SDLSnapshotStagedPage
+{
+    u8* page;
+    u64 pageIndex;
+};
+
+struct SDLMemorySnapshot
+{
+    SDLSnapshotBlock* blocks;
+    u32 blockCount;
+    u32 blockCapacity;
+    u64 pageSize;
+
+    // NOTE(marvin): The records of the image at the matched keyframe,
+    // or at the last keyframe written while recording.
+    SDLSnapshotPageRecord* pages;
+    u64 pageCount;
+    u64 pageCapacity;
+
+    SDLSnapshotKeyframe keyframes[MAX_SNAPSHOT_KEYFRAMES];
+    u32 keyframeCount;
+    u32 matchedKeyframe;
+
+    // NOTE(marvin): Written by the I/O thread, so only read once it
+    // has been drained.
+    SDLSnapshotPageChange* changes;
+    u64 changeCount;
+    u64 changeCapacity;
+    u64 fileSize;
+    u64 liveBytes;
+    b32 writeFailed;
+
+    // NOTE(marvin): The soft-dirty bits of Linux say which pages have
+    // been written since they were last cleared. When they are
+    // available and the bits were cleared when the memory matched the
+    // image at the matched keyframe, only the soft-dirty pages differ
+    // from it. As the bits are for the whole process, clearing them
+    // for one snapshot means the clean pages of every other snapshot
+    // can't be trusted anymore.
+    b32 softDirtyProbed;
+    b32 softDirtyAvailable;
+    b32 cleanPagesMatchImage;
+
+    // NOTE(marvin): The pages are handed to the I/O thread a chunk at
+    // a time, which is filled here and owned by the I/O thread once
+    // pushed.
+    SDL_IOStream* captureStream;
+    SDLSnapshotCapture* captureChunk;
+    u32 captureKeyframe;
+    b32 captureStarted;
+
+    // NOTE(marvin): The pages of the first image that are left to be
+    // copied, while it is copied over several frames.
+    SDLSnapshotStagedPage* stagedPages;
+    u64 stagedPageCount;
+    u64 stagedPageCapacity;
+    u64 stagedPageCursor;
+    b32 staging;
+};
+
+// The copies of a chunk of the pages that the main thread captured,
+// for the I/O thread to compress and write. The chunks of a keyframe
+// are written in order, to the same stream, which the last one closes.
+struct SDLSnapshotCapture
+{
+    SDLMemorySnapshot* snapshot;
+    u32 keyframeIndex;
+    u64* pageIndices;  // Into the page records of the snapshot.
+    u8* pages;  // In the same order as the indices.
+    u64 count;
+    b32 first;
+    b32 last;
+};
+
+enum SDLSnapshotProgress
+{
+    sdlSnapshot_failed,
+    sdlSnapshot_capturing,
+    sdlSnapshot_done,
 };
 
 struct SDLState
@@ -46,11 +169,24 @@ struct SDLState
     // NOTE(marvin): nullptr if there is no game process.
     SDL_Process* gameProcess;
 
+    MemoryTelemetry memoryTelemetry;
+    FrameStats frameStats;
+
+    // NOTE(marvin): Set for a headless replay on a backend that needs
+    // a device, so assets are loaded but never uploaded.
+    b32 noRenderer;
+
+#if SKL_ALLOCATION_GUARD
+    AllocationGuard allocationGuard;
+#endif
+
     // Ensures that only loop utils will be able to access loop state
 #if SKL_INTERNAL
     friend class LoopUtils;
 private:
     LoopState loopState;
+    SDLMemorySnapshot loopSnapshots[LOOP_SLOT_COUNT];
+    SDLIOThread loopIOThread;
 #endif
 };
 
@@ -62,12 +198,44 @@ void AddMemoryBlock(SDLState *state, SDLMemoryBlock *block);
 void RemoveMemoryBlock(SDLState *state, SDLMemoryBlock *block);
 
 // >>> Memory / IO interop logic
-void RestoreSavedMemoryBlock(SDLSavedMemoryBlock savedMemoryBlock, SDL_IOStream* fileHandle);
+// Starts capturing the pages of all the memory blocks as the first
+// keyframe, and has the I/O thread write them to the file. If the
+// memory blocks haven't changed since the image was last written or
+// restored, only the pages that have been written since are
+// captured. With soft-dirty pages, the pages are copied over the
+// frames that follow by ContinueMemorySnapshot, and the image is the
+// memory at the frame that it is done. Otherwise, or when staged is
+// false, they are all copied at once.
+SDLSnapshotProgress BeginMemorySnapshot(SDLState* state, SDLMemorySnapshot* snapshot, SDLIOThread* ioThread,
+                                        const char* path, b32 staged);
+
+// Copies the next of the pages of the image that is being captured.
+// Called once a frame, before the frame is simulated, until it
+// produces that it is done or has failed.
+SDLSnapshotProgress ContinueMemorySnapshot(SDLState* state, SDLMemorySnapshot* snapshot, SDLIOThread* ioThread,
+                                           const char* path);
+
+// Gives up on the image that is being captured, which then can't be
+// restored.
+void CancelMemorySnapshot(SDLMemorySnapshot* snapshot, SDLIOThread* ioThread);
 
-inline SDLSavedMemoryBlock InitSavedMemoryBlock(SDLMemoryBlock* source);
+// Captures the pages that have been written since the last keyframe
+// as a new keyframe. Produces false if it can't be done, which is
+// when soft-dirty pages aren't available, the memory blocks have
+// changed since the first keyframe, or there is no room for another.
+b32 AddMemorySnapshotKeyframe(SDLState* state, SDLMemorySnapshot* snapshot, SDLIOThread* ioThread,
+                              const char* path, u64 frameIndex);
 
-void WriteSavedMemoryBlockToFile(SDLSavedMemoryBlock* savedMemoryBlock, SDL_IOStream* fileHandle);
+// Compresses and writes a chunk of the captured pages, then frees
+// it. Called by the I/O thread.
+void WriteSnapshotCapture(SDLSnapshotCapture* capture, SDL_IOStream* fileHandle);
 
-void WriteMemoryBlocksToFile(SDLState* state, SDL_IOStream* fileHandle);
+// Produces the index of the last keyframe at or before the frame.
+u32 FindMemorySnapshotKeyframe(const SDLMemorySnapshot* snapshot, u64 frameIndex);
 
-void RestoreMemoryBlocksFromFile(SDL_IOStream* fileHandle);
\ No newline at end of file
+// Restores the memory blocks to the image at the keyframe. When
+// possible, only the pages that have been written since, or that
+// differ between the keyframe and the one that the memory last
+// matched, are restored. The I/O thread must have been drained
+// beforehand. Produces false on failure.
+b32 RestoreMemorySnapshot(SDLMemorySnapshot* snapshot, const char* path, u32 keyframeIndex);
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <meta_definitions.h>
+#include <game_platform.h>
+
+// This file is responsible for the reload thread of the platform,
+// which watches the game module for a new build, and copies, loads
+// and resolves the symbols of it in the background, so that the main
+// thread only has to swap the function pointers between two frames.
+// On Linux, inotify tells the thread when the linker is done writing
+// the module; elsewhere, the thread polls its modify time.
+
+// NOTE(marvin): The state is how the two threads hand the loaded
+// module back and forth. Only the reload thread moves it out of idle,
+// and only the main thread moves it back.
+enum SDLReloadState
+{
+    sdlReloadState_idle  = 0,
+    sdlReloadState_ready = 1,
+};
+
+struct SDLLoadedGameCode
+{
+    SDL_SharedObject *sharedObjectHandle;
+    SDL_Time fileLastWritten;
+
+    game_initialize_t *gameInitializePtr;
+    game_load_t *gameLoadPtr;
+    game_get_persistent_dll_paths_t *gameGetPersistentDLLPathsPtr;
+    game_update_and_render_t *gameUpdateAndRenderPtr;
+
+    // NOTE(marvin): SDL_GetTicksNS of when the new build was noticed,
+    // and of when it was done loading, for reporting the latency.
+    u64 detectedNS;
+    u64 loadedNS;
+};
+
+struct SDLReloadThread
+{
+    // NOTE(marvin): nullptr if the thread couldn't be started, in
+    // which case the module is reloaded on the main thread.
+    SDL_Thread *thread;
+
+    b8 editor;
+    // Only touched by the reload thread once it's started.
+    u32 loadCount;
+    SDL_Time fileLastWritten;
+
+    u64 volatile state;
+    // Written by the reload thread before the state becomes ready,
+    // read by the main thread after it sees that it is.
+    SDLLoadedGameCode loaded;
+};
+
+const char *GetGameCodeSrcFilePath();
+
+// Copies the game module at the source path to a path of its own
+// for the load count, then loads it and resolves its symbols. Produces
+// false if any of that fails, in which case nothing is left loaded.
+b8 LoadGameCodeObject(const char *srcFilePath, b8 editor, u32 loadCount, SDLLoadedGameCode *loaded);
+
+// Produces the time the file was last modified, or 0 if unknown.
+SDL_Time GetFileLastWritten(const char *path);
+
+// Starts watching the game module, which was last loaded from a file
+// written at the given time, with the given load count.
+void StartReloadThread(SDLReloadThread *reloadThread, b8 editor, u32 loadCount, SDL_Time fileLastWritten);
+
+// Checks for a new build and loads it on the calling thread, for when
+// the reload thread couldn't be started.
+void PollForNewBuild(SDLReloadThread *reloadThread);
+
+// Produces the loaded module if one is ready to be swapped in, in
+// which case FinishReload must be called once it has been.
+SDLLoadedGameCode *GetReadyGameCode(SDLReloadThread *reloadThread);
+
+// Lets the reload thread load the next build.
+void FinishReload(SDLReloadThread *reloadThread);
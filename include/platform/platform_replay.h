@@ -0,0 +1,41 @@
+#pragma once
+
+#include <meta_definitions.h>
+#include <game_platform.h>
+
+struct GameCode;
+
+// This file is responsible for the headless replay, which runs a
+// recorded input stream through the game with a fixed frame time,
+// without a window or a renderer, and reports how long each frame and
+// each timed block took. That way a performance regression in real
+// gameplay can be reproduced on any machine, including one without a
+// GPU.
+
+// NOTE(marvin): The input stream is the loop_<n>_input.skli of a
+// recording. It only replays the same gameplay if the recording
+// started from the map as it is loaded, which is what
+// -record-on-start is for.
+struct ReplayOptions
+{
+    const char *inputPath;
+    const char *reportPath;  // nullptr for no report.
+    const char *mapName;
+    u64 frameCount;          // 0 for all of the recorded frames.
+    f32 frameTime;
+
+    // NOTE(marvin): Whether there is a renderer to draw the frames,
+    // which is only the case for the null backend. Otherwise the
+    // frames are only simulated. ImGui is told that the display is of
+    // the given size.
+    b32 render;
+    u32 displayWidth;
+    u32 displayHeight;
+};
+
+// Produces a renderer whose functions do nothing, for the game to
+// talk to when there is no renderer.
+PlatformRenderer ConstructHeadlessRenderer();
+
+// Produces the exit code of the process.
+s32 RunHeadlessReplay(GameCode &gameCode, GameMemory &gameMemory, const ReplayOptions &options);
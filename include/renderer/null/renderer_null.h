@@ -0,0 +1,43 @@
+#pragma once
+
+#include <meta_definitions.h>
+
+// The null backend implements the renderer interface without a
+// device. It keeps the resources that are uploaded, validates the
+// handles that are used, and counts what the Vulkan backend would have
+// done with them, so that the CPU side of the engine (ECS, physics,
+// building the draw lists) can be profiled on a machine without a GPU.
+
+struct NullRenderCounters
+{
+    // NOTE(marvin): Of the last RenderUpdate. A pass is one depth
+    // prepass, one color pass, one shadow pass per cascade of a
+    // directional light, per spot light and per face of a point
+    // light, and one for the icons of the editor. Every pass draws
+    // each unique mesh once, instanced.
+    u32 passCount;
+    u32 drawCount;
+    u32 instanceCount;
+    u32 iconCount;
+    u32 dirLightCount;
+    u32 spotLightCount;
+    u32 pointLightCount;
+
+    // NOTE(marvin): Instances whose mesh handle isn't a live mesh,
+    // which a real backend would crash or draw garbage on.
+    u32 invalidMeshCount;
+
+    // NOTE(marvin): The bytes of the meshes and textures since
+    // start up, and of the object data that would be uploaded each
+    // frame.
+    u64 uploadedBytes;
+    u64 frameUploadedBytes;
+
+    u32 liveMeshCount;
+    u32 liveTextureCount;
+    u32 liveLightCount;
+
+    u64 frameCount;
+};
+
+NullRenderCounters GetNullRenderCounters();
@@ -31,6 +31,7 @@ struct Mesh
     AllocatedBuffer vertBuffer;
 
     u32 indexCount;
+    u32 vertCount;
 };
 
 // Represents a texture stored on the GPU
@@ -142,6 +143,6 @@ struct LightCascade
 struct IconData
 {
     glm::vec3 pos;
-    TextureID texID;
+    u32 texID;
     u32 id;
 };
\ No newline at end of file
@@ -49,6 +49,18 @@ struct WGPUBackendMeshIdx {
         m_vertexCount(vertexCount)
     {}
 };
+
+// Represents a dynamic light, which is packed from the frame info on every frame,
+// so only its type is kept to know which shadow map it has a shadow in
+enum class WGPUBackendLightType : u8 {
+    Dir,
+    Spot,
+    Point,
+};
+
+struct WGPUBackendLightEntry {
+    WGPUBackendLightType m_type{ WGPUBackendLightType::Dir };
+};
 #pragma endregion
 
 // >>> Represents types meant to be plugged directly into the buffer <<<
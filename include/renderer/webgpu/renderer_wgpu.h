@@ -9,6 +9,7 @@
 #include <single_textures_wgpu.h>
 
 #include <skl_math_types.h>
+#include <handle_pool.h>
 
 #include <webgpu/webgpu.h>
 
@@ -80,9 +81,8 @@ private:
     WGPUBackendBaseDynamicShadowMapArray m_dynamicDirLightShadowMapTexture;
     WGPUBackendBaseDynamicShadowMapArray m_dynamicPointLightShadowMapTexture;
 
-    LightID m_dynamicShadowedDirLightNextID = 0;
-    LightID m_dynamicShadowedPointLightNextID = 0;
-    LightID m_dynamicShadowedSpotLightNextID = 0;
+    // Light handles are pooled so destroyed handles get caught and their slots reused
+    HandlePool<WGPUBackendLightEntry> m_lightStore{ };
     
     // Stores actual GPU buffers
     WGPUBackendSingleUniformBuffer<WGPUBackendPointDepthPassFixedData> m_fixedPointDepthPassDatBuffer{ };
@@ -104,14 +104,19 @@ private:
 
     u32 m_meshTotalVertices{ 0 };
     u32 m_meshTotalIndices{ 0 };
-    // Currently mesh deletion logic requires that meshes with greater MeshID's to correspond to older mesh stores
-    std::unordered_map<MeshID, WGPUBackendMeshIdx> m_meshStore{ };
+    // Meshes are packed in upload order in the vertex and index buffers, 
+    // so deleting a mesh shifts every mesh placed after it
+    HandlePool<WGPUBackendMeshIdx> m_meshStore{ };
 
-    // The id of the next obj that will be created
-    MeshID m_nextMeshID{ 0 }; 
+    // Uploaded meshes and the skybox are recorded under the renderer tag
+    MemoryTelemetry* m_memoryTelemetry{ nullptr };
+    u64 m_skyboxBytes{ 0 };
 
     void printDeviceSpecs();
 
+    // Produces whether the light was live, and removes it
+    bool RemoveLight(LightID lightID, WGPUBackendLightType type);
+
     // The following getters occur asynchronously in wgpu but is awaited for by these functions
     static WGPUAdapter GetAdapter(const WGPUInstance instance, WGPURequestAdapterOptions const * options);
 
@@ -182,7 +187,7 @@ public:
     SDL_WindowFlags GetRenderWindowFlags() { return 0; }
 
     // Sets a SDL window to draw to and initializes the back end
-    void InitRenderer(SDL_Window *window, u32 startWidth, u32 startHeight);
+    void InitRenderer(SDL_Window *window, u32 startWidth, u32 startHeight, MemoryTelemetry* memoryTelemetry);
 
     // Sets up pipelines used to render
     void InitPipelines();
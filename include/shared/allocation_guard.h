@@ -0,0 +1,79 @@
+#pragma once
+
+#include <meta_definitions.h>
+#include <skl_types.h>
+
+// This file is responsible for the allocation guard, which traps heap
+// allocations during a frame of the game, so that regressions of the
+// steady state being allocation free don't go unnoticed. When armed,
+// every allocation through the platform allocator or global operator
+// new is recorded by call site, and reported once the guard is
+// disarmed.
+
+// NOTE(marvin): The guard is owned by the platform, and handed to the
+// game module through the game memory. Each module has its own copy
+// of globalAllocationGuard, which both point to the same guard.
+
+#if SKL_ALLOCATION_GUARD
+
+constexpr u32 MAX_ALLOCATION_GUARD_SITES = 64;
+constexpr u32 ALLOCATION_GUARD_STACK_DEPTH = 8;
+
+// NOTE(marvin): The first frames after a load are allowed to allocate,
+// since that's when things are lazily created.
+constexpr u32 ALLOCATION_GUARD_WARMUP_FRAMES = 120;
+
+enum AllocationGuardSource
+{
+    allocationGuardSource_platformAllocator = 0,
+    allocationGuardSource_operatorNew       = 1,
+};
+
+struct AllocationGuardSite
+{
+    void *stack[ALLOCATION_GUARD_STACK_DEPTH];
+    u32 stackDepth;
+    AllocationGuardSource source;
+    u64 count;
+    u64 bytes;
+};
+
+struct AllocationGuard
+{
+    b32 volatile armed;
+    u32 framesSinceLoad;
+    u64 frameIndex;
+
+    TicketMutex mutex;
+    AllocationGuardSite sites[MAX_ALLOCATION_GUARD_SITES];
+    u32 siteCount;
+    // Allocations that didn't fit in the sites.
+    u64 droppedCount;
+};
+
+extern AllocationGuard *globalAllocationGuard;
+
+// Sets the guard of this module, and warms up the stack walker so
+// that it doesn't allocate while armed.
+void InitAllocationGuard(AllocationGuard *guard);
+
+// Restarts the warm up, for when the game module has been (re)loaded.
+void ResetAllocationGuardWarmup(AllocationGuard *guard);
+
+// Arms the guard, unless still warming up.
+void ArmAllocationGuard(AllocationGuard *guard);
+
+// Disarms the guard, and prints the report of the frame if any
+// allocation was made while armed.
+void DisarmAllocationGuard(AllocationGuard *guard);
+
+// Records the allocation if the guard is armed. Safe to call from any thread.
+void RecordGuardedAllocation(AllocationGuardSource source, u64 size);
+
+#define RECORD_GUARDED_ALLOCATION(...) RecordGuardedAllocation(__VA_ARGS__)
+
+#else
+
+#define RECORD_GUARDED_ALLOCATION(...)
+
+#endif
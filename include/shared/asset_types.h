@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include <glm/glm.hpp>
 
@@ -12,6 +13,11 @@ struct MeshAsset
     std::string name;
     MeshID id;
     AABB aabb;
+
+    // NOTE(marvin): Kept on the CPU, in our coordinate system, for the
+    // colliders that are made from the mesh, see MeshCollider.
+    std::vector<glm::vec3> positions;
+    std::vector<u32> indices;
 };
 
 struct TextureAsset
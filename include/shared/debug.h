@@ -8,6 +8,7 @@
 #include <game_platform.h>
 #include <timer.h>
 #include <skl_thread_safe_primitives.h>
+#include <debug_profiler.h>
 
 #endif
 
@@ -75,10 +76,16 @@ struct DebugArena
     DebugAllocations allocations;
 };
 
+// NOTE(marvin): Consecutive pushes of the same size from the same call
+// site into the same arena are aggregated into one regular allocation,
+// the count is how many pushes it stands for, so that a pop knows how
+// many of them it took.
 struct DebugRegularAllocation
 {
     u32 offset;
     u32 size;
+    u32 count;
+    u32 pushSize;
 };
 
 
@@ -128,13 +135,56 @@ struct DebugAllocationsStore
     // TODO(marvin): The free indices stack never decreases in size. If an element is popped from the stack, that pop is recorded by the debug system, which requires an allocation object, thus taking that which was just popped. When there's frequent pushes and pops, then the free indices stack becomes a ticking time bomb. This is livable for now... but should re-consider the memory viewer's design...
 };
 
-// TODO(marvin): The XBuffer familiy could be abstracted maybe.
-struct DebugIDsBuffer
+// NOTE(marvin): Open addressing hash table of the debug IDs that are
+// stored in our misc arena, so that each is looked up in O(1). It
+// doubles as the aggregation of all the pushes by call site, which is
+// all that is kept track of in the low overhead modes.
+struct DebugIDEntry
+{
+    u64 hash;
+    char *debugID;  // nullptr if the slot is empty.
+    u64 pushCount;
+    u64 pushBytes;
+};
+
+struct DebugIDTable
+{
+    DebugIDEntry *entries;
+    u32 capacity;  // Power of 2.
+    u32 count;
+};
+
+// NOTE(marvin): Maps a source arena to its target in O(1). Keyed by
+// both base and size, because a sub arena can have the same base as
+// the arena containing it.
+struct DebugArenaEntry
+{
+    u08 *base;
+    siz size;
+    DebugArena *target;
+};
+
+struct DebugArenaTable
 {
-    char **base;
+    DebugArenaEntry *entries;
+    u32 capacity;  // Power of 2.
     u32 count;
 };
 
+// NOTE(marvin): Full mode maintains the tree of allocations. The
+// other modes are for when the memory viewer should stay on while
+// profiling: the tree is frozen, and only the used of each arena and
+// the call site aggregates are updated. Sampled mode only looks up
+// the call site of one in every sample interval pushes, and scales up
+// what it records to match. Once the tree is frozen, it can't go back
+// to full mode, as the tree missed the pushes and pops in between.
+enum DebugMemoryViewerMode
+{
+    debugMemoryViewerMode_full      = 0,
+    debugMemoryViewerMode_callSites = 1,
+    debugMemoryViewerMode_sampled   = 2,
+};
+
 struct DebugState
 {
     // NOTE(marvin): The non-store is the tree, the store is the memory arena holding the nodes of the tree.
@@ -147,7 +197,16 @@ struct DebugState
     // NOTE(marvin): Nothing gets freed in here! Will need to work out
     // a better memory management if we need to free stuff.
     MemoryArena miscArena;
-    DebugIDsBuffer debugIDsIndex;
+    DebugIDTable debugIDs;
+    DebugArenaTable arenaTargets;
+
+    DebugMemoryViewerMode mode;
+    u32 sampleInterval;
+    u32 sampleCountdown;
+
+    // NOTE(marvin): For splitting a sub arena off the regular
+    // allocation that its push got aggregated into.
+    u32 lastPushActualSize;
 
     // NOTE(marvin): For purposes of the initialization process.
     b32 readyToInitMemoryArena_;
@@ -178,6 +237,9 @@ void DebugRecordPushSize_(const char *debugID, MemoryArena *source, siz requeste
 
 void DebugRecordPopSize_(MemoryArena *source, siz size);
 
+// Switching away from full mode freezes the tree for good.
+void DebugSetMemoryViewerMode(DebugState *debugState, DebugMemoryViewerMode mode);
+
 #else
 
 #define DebugInitialize(...)
@@ -220,39 +282,117 @@ struct DebugRecord
     const char *blockName;
 
     u32 lineNumber;
-    u32 reserved;
-
-    // NOTE(marvin): Top 32-bits hit count, bottom 32-bits cycle count.
-    u64 hitCount_cycleCount;
+    // NOTE(marvin): The site of the block in the profiler plus one, 0
+    // until the block is first hit while there is a profiler.
+    u32 profilerSite;
+
+    // NOTE(marvin): Separate counters rather than both packed into
+    // one u64, as 32 bits of cycles overflow in about a second.
+    u64 hitCount;
+    u64 cycleCount;
 };
 
 extern DebugRecord debugRecordArray[];
 
+// NOTE(marvin): A copy of the records that were hit in a frame, for
+// when something other than the console wants them, like the report
+// of a headless replay.
+constexpr u32 MAX_DEBUG_FRAME_RECORDS = 256;
+
+struct DebugFrameRecord
+{
+    const char *blockName;
+    const char *fileName;
+    u32 lineNumber;
+    u64 hitCount;
+    u64 cycleCount;
+};
+
+struct DebugFrameSnapshot
+{
+    DebugFrameRecord records[MAX_DEBUG_FRAME_RECORDS];
+    u32 recordCount;
+};
+
 struct TimedBlock
 {
     DebugRecord *debugRecord;
     u64 startCycleCount;
     u32 hitCount;
 
+    #if SKL_PERF_COUNTERS
+    PerfCounterValues startPerfCounters;
+    b32 perfCountersRead;
+    #endif
+
 
     #if SKL_INTERNAL
     TimedBlock(u32 index, const char *fileName, u32 lineNumber,
                const char *blockName, u32 hitCount0 = 1)
     {
-        debugRecord = debugRecordArray + index;
+        Begin(debugRecordArray + index, fileName, lineNumber, blockName, hitCount0);
+    }
+
+    // NOTE(marvin): For records that don't live in the debug record
+    // array, like the ones of the systems.
+    TimedBlock(DebugRecord &debugRecord0, const char *fileName, u32 lineNumber,
+               const char *blockName, u32 hitCount0 = 1)
+    {
+        Begin(&debugRecord0, fileName, lineNumber, blockName, hitCount0);
+    }
+
+    void Begin(DebugRecord *debugRecord0, const char *fileName, u32 lineNumber,
+               const char *blockName, u32 hitCount0)
+    {
+        debugRecord = debugRecord0;
         debugRecord->fileName = fileName;
         debugRecord->lineNumber = lineNumber;
         debugRecord->blockName = blockName;
-        startCycleCount = ReadCPUTimer();
         hitCount = hitCount0;
+
+        DebugProfiler *profiler = globalDebugProfiler;
+        if (profiler)
+        {
+            if (!debugRecord->profilerSite)
+            {
+                debugRecord->profilerSite = ProfilerGetSite(profiler, blockName, fileName, lineNumber);
+            }
+            ProfilerRecordEvent(profiler, debugRecord->profilerSite, profilerEventType_begin);
+        }
+
+        // NOTE(marvin): Read last on the way in, and first on the way
+        // out, so that the counters see as little of the profiling as
+        // possible.
+        #if SKL_PERF_COUNTERS
+        perfCountersRead = profiler && ProfilerReadPerfCounters(profiler, &startPerfCounters);
+        #endif
+
+        startCycleCount = ReadCPUTimer();
     }
 
     ~TimedBlock()
     {
         u64 cycleCountDelta = ReadCPUTimer() - startCycleCount;
-        u64 hitCountDelta = (u64)hitCount;
-        u64 delta = cycleCountDelta | (hitCountDelta << 32);
-        AtomicAddU64(&debugRecord->hitCount_cycleCount, delta);
+
+        DebugProfiler *profiler = globalDebugProfiler;
+        #if SKL_PERF_COUNTERS
+        if (profiler && perfCountersRead)
+        {
+            PerfCounterValues endPerfCounters;
+            if (ProfilerReadPerfCounters(profiler, &endPerfCounters))
+            {
+                ProfilerAddSiteCounters(profiler, debugRecord->profilerSite, &startPerfCounters, &endPerfCounters);
+            }
+        }
+        #endif
+
+        AtomicAddU64(&debugRecord->cycleCount, cycleCountDelta);
+        AtomicAddU64(&debugRecord->hitCount, hitCount);
+
+        if (profiler && debugRecord->profilerSite)
+        {
+            ProfilerRecordEvent(profiler, debugRecord->profilerSite, profilerEventType_end);
+        }
     }
     #endif
 };
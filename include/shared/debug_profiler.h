@@ -0,0 +1,211 @@
+#pragma once
+
+#include <meta_definitions.h>
+#include <timer.h>
+#include <skl_thread_safe_primitives.h>
+#include <perf_counters.h>
+
+// This file is responsible for the timeline profiler. Every thread
+// that is profiled gets a ring of begin and end events, with the CPU
+// timer as their timestamps, that only it writes to and only the main
+// thread reads from, so recording an event never takes a lock. Once a
+// frame, the main thread moves the events out of the rings into a
+// history, which is what the profiler tab of the overlay shows, and
+// what is exported as a Chrome trace (chrome://tracing, or Perfetto).
+
+// NOTE(marvin): Like the memory telemetry, the profiler is owned by
+// the platform so that it survives hot reloads, and the names of the
+// blocks are copied into it, as a string literal of the game module
+// wouldn't survive one either.
+
+#if SKL_INTERNAL
+
+constexpr u32 MAX_PROFILER_THREADS = 32;
+constexpr u32 PROFILER_RING_EVENT_COUNT = 1 << 15;  // Power of 2.
+constexpr u32 MAX_PROFILER_SITES = 2048;
+constexpr u32 PROFILER_NAME_LENGTH = 64;
+constexpr u32 PROFILER_HISTORY_EVENT_COUNT = 1 << 18;  // Power of 2.
+constexpr u32 PROFILER_HISTORY_FRAME_COUNT = 128;  // Power of 2.
+
+enum ProfilerEventType
+{
+    profilerEventType_begin = 0,
+    profilerEventType_end   = 1,
+};
+
+struct ProfilerEvent
+{
+    u64 timestamp;
+    u32 siteIndex;
+    u32 type;
+};
+
+struct ProfilerRing
+{
+    // NOTE(marvin): 0 until the thread that claimed the ring is done
+    // naming it.
+    u64 volatile threadKey;
+    char threadName[PROFILER_NAME_LENGTH];
+
+    // Only written by the thread of the ring.
+    u64 volatile writeIndex;
+    u64 volatile droppedCount;
+    // Only written by the main thread.
+    u64 volatile readIndex;
+
+    ProfilerEvent events[PROFILER_RING_EVENT_COUNT];
+
+#if SKL_PERF_COUNTERS
+    // NOTE(marvin): Opened by the thread of the ring the first time it
+    // reads them. Kept here rather than in a thread local, so that a
+    // hot reload doesn't open another set of them.
+    PerfCounterGroup perfCounters;
+#endif
+};
+
+// Where a block is, which is what the events refer to.
+struct ProfilerSite
+{
+    char blockName[PROFILER_NAME_LENGTH];
+    char fileName[PROFILER_NAME_LENGTH];
+    u32 lineNumber;
+};
+
+#if SKL_PERF_COUNTERS
+// NOTE(marvin): The hardware counters of every block of a site, summed
+// up over a frame. A block's counters include the blocks nested in it.
+struct ProfilerSiteCounters
+{
+    u64 volatile hitCount;
+    u64 volatile values[perfCounter_count];
+};
+#endif
+
+struct ProfilerHistoryEvent
+{
+    u64 timestamp;
+    u32 siteIndex;
+    u16 threadIndex;
+    u16 type;
+};
+
+struct DebugProfiler
+{
+    ProfilerRing rings[MAX_PROFILER_THREADS];
+    u64 volatile ringCount;
+
+    ProfilerSite sites[MAX_PROFILER_SITES];
+    u64 volatile siteCount;
+    u64 volatile siteLock;
+
+#if SKL_PERF_COUNTERS
+    ProfilerSiteCounters siteCounters[MAX_PROFILER_SITES];
+    // Only touched by the main thread, the counters of the last frame.
+    ProfilerSiteCounters lastFrameSiteCounters[MAX_PROFILER_SITES];
+#endif
+
+    // NOTE(marvin): Everything from here on is only touched by the
+    // main thread. The history is a ring as well, of which the last
+    // PROFILER_HISTORY_EVENT_COUNT events are kept.
+    ProfilerHistoryEvent history[PROFILER_HISTORY_EVENT_COUNT];
+    u64 historyWriteIndex;
+
+    // The timestamp and history write index of the start of each of
+    // the last frames.
+    u64 frameStartTimestamps[PROFILER_HISTORY_FRAME_COUNT];
+    u64 frameStartHistoryIndices[PROFILER_HISTORY_FRAME_COUNT];
+    u64 frameIndex;
+
+    // While paused, the rings are still drained, but the history is left as is.
+    b32 paused;
+
+    // NOTE(marvin): The CPU timer is compared against the platform's
+    // performance counter since the profiler was initialized, which
+    // is how its timestamps are turned into time.
+    u64 calibrationTimestamp;
+    u64 calibrationCounter;
+    f64 cpuTimerFrequency;
+};
+
+// NOTE(marvin): Each module has its own, set to the platform's
+// profiler by the platform, and by the game module on load. While it
+// is null, nothing is recorded.
+extern DebugProfiler *globalDebugProfiler;
+
+void InitDebugProfiler(DebugProfiler *profiler, u64 counter);
+
+// Names the ring of the calling thread, claiming one if it doesn't have one yet.
+void ProfilerRegisterThread(DebugProfiler *profiler, const char *threadName);
+
+// Produces the index of the site plus one, or 0 if there is no room
+// for it. Registering the same site again produces the same index.
+u32 ProfilerGetSite(DebugProfiler *profiler, const char *blockName, const char *fileName, u32 lineNumber);
+
+// Records an event on the ring of the calling thread, with the site
+// plus one as produced by ProfilerGetSite.
+void ProfilerRecordEvent(DebugProfiler *profiler, u32 site, ProfilerEventType type);
+
+// Moves the events of every ring into the history, and marks the
+// start of a new frame. Main thread only.
+void ProfilerBeginFrame(DebugProfiler *profiler);
+
+// Called by the platform once a frame, with its performance counter.
+void UpdateProfilerTimerFrequency(DebugProfiler *profiler, u64 counter, u64 counterFrequency);
+
+// Writes the history as Chrome trace event JSON. Produces 0 on success.
+s32 WriteProfilerChromeTrace(DebugProfiler *profiler, const char *path);
+
+#if SKL_PERF_COUNTERS
+// Reads the hardware counters of the calling thread, opening them the
+// first time. Produces false if the thread doesn't have any.
+b32 ProfilerReadPerfCounters(DebugProfiler *profiler, PerfCounterValues *values);
+
+// Adds what the counters counted between the two reads to the site
+// plus one, as produced by ProfilerGetSite.
+void ProfilerAddSiteCounters(DebugProfiler *profiler, u32 site, PerfCounterValues *begin, PerfCounterValues *end);
+#endif
+
+// Records the begin of a block on construction, and its end on destruction.
+struct ProfilerScope
+{
+    u32 site;
+
+    ProfilerScope(u32 *cachedSite, const char *blockName, const char *fileName, u32 lineNumber)
+    {
+        site = 0;
+        DebugProfiler *profiler = globalDebugProfiler;
+        if (profiler)
+        {
+            if (!*cachedSite)
+            {
+                *cachedSite = ProfilerGetSite(profiler, blockName, fileName, lineNumber);
+            }
+            site = *cachedSite;
+            ProfilerRecordEvent(profiler, site, profilerEventType_begin);
+        }
+    }
+
+    ~ProfilerScope()
+    {
+        DebugProfiler *profiler = globalDebugProfiler;
+        if (profiler && site)
+        {
+            ProfilerRecordEvent(profiler, site, profilerEventType_end);
+        }
+    }
+};
+
+// NOTE(marvin): For code outside of the game module, or on threads
+// other than the main thread, which only want to show up on the
+// timeline and not in the timed block totals.
+#define PROFILE_SCOPE_(name, number) \
+    local_persist u32 profilerSite_##number; \
+    ProfilerScope profilerScope_##number = ProfilerScope(&profilerSite_##number, name, __FILE__, __LINE__)
+#define PROFILE_SCOPE__(name, number) PROFILE_SCOPE_(name, number)
+#define PROFILE_SCOPE(name) PROFILE_SCOPE__(name, __LINE__)
+
+#else
+
+#define PROFILE_SCOPE(name)
+
+#endif
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <meta_definitions.h>
+#include <timer.h>
+
+// This file is responsible for the frame time history, which keeps
+// the time of each of the last frames split into the phases of a
+// frame, so that the overlay can show percentiles, and hitches, rather
+// than only the time of the latest frame. The phases are timed with
+// the CPU timer, by the platform (input) and the game module (the
+// rest), and converted to milliseconds when the frame is committed.
+
+// NOTE(marvin): Like the memory telemetry, the history is owned by the
+// platform so that it survives hot reloads, and is handed to the game
+// module through the game memory.
+
+enum FramePhase
+{
+    framePhase_input    = 0,
+    framePhase_fixed    = 1,
+    framePhase_variable = 2,
+    framePhase_draw     = 3,
+    framePhase_submit   = 4,
+
+    framePhase_count,
+};
+
+inline const char *GetFramePhaseName(FramePhase phase)
+{
+    local_persist const char *names[framePhase_count] =
+    {
+        "Input",
+        "Fixed Systems",
+        "Variable Systems",
+        "DrawScene",
+        "Render Submit",
+    };
+
+    ASSERT(phase < framePhase_count);
+    return names[phase];
+}
+
+constexpr u32 FRAME_STATS_HISTORY_COUNT = 1024;  // Power of 2.
+
+struct FrameStatsEntry
+{
+    // NOTE(marvin): The frame is from the start of one frame to the
+    // start of the next, so it also has the time the platform spent
+    // outside of the phases, like waiting on vsync.
+    f32 frameMs;
+    f32 phaseMs[framePhase_count];
+    u32 fixedStepCount;
+};
+
+struct FrameStats
+{
+    FrameStatsEntry entries[FRAME_STATS_HISTORY_COUNT];
+    // The number of frames committed so far, the latest one is at
+    // frameCount - 1.
+    u64 frameCount;
+
+    // While paused, frames are still timed, but not committed.
+    b32 paused;
+
+    // NOTE(marvin): The frame that is being timed, 0 before the first
+    // frame has begun.
+    u64 frameBeginTimestamp;
+    u64 phaseBeginTimestamps[framePhase_count];
+    u64 phaseCycles[framePhase_count];
+    u32 fixedStepCount;
+
+    // Same as the profiler's, see DebugProfiler.
+    u64 calibrationTimestamp;
+    u64 calibrationCounter;
+    f64 cpuTimerFrequency;
+};
+
+// The percentiles of a value over the frames in the history.
+struct FramePercentiles
+{
+    f32 p50;
+    f32 p95;
+    f32 p99;
+    f32 max;
+};
+
+struct FrameStatsSummary
+{
+    u32 frameCount;
+    FramePercentiles frame;
+    FramePercentiles phases[framePhase_count];
+};
+
+void InitFrameStats(FrameStats *stats, u64 counter);
+
+// Commits the frame that was being timed, if any, and starts timing a
+// new one. Called by the platform at the start of every frame, with
+// its performance counter.
+void BeginFrameStatsFrame(FrameStats *stats, u64 counter, u64 counterFrequency);
+
+inline void BeginFramePhase(FrameStats *stats, FramePhase phase)
+{
+    ASSERT(phase < framePhase_count);
+    stats->phaseBeginTimestamps[phase] = ReadCPUTimer();
+}
+
+// NOTE(marvin): A phase can be begun and ended several times in a
+// frame, e.g. the fixed systems once per step, and its times add up.
+inline void EndFramePhase(FrameStats *stats, FramePhase phase)
+{
+    ASSERT(phase < framePhase_count);
+    stats->phaseCycles[phase] += ReadCPUTimer() - stats->phaseBeginTimestamps[phase];
+}
+
+// Produces the entry of the frame that was committed the given number
+// of frames ago, 0 being the latest.
+inline FrameStatsEntry *GetFrameStatsEntry(FrameStats *stats, u64 framesAgo)
+{
+    ASSERT(framesAgo < Minimum(stats->frameCount, (u64)FRAME_STATS_HISTORY_COUNT));
+    u64 frameIndex = stats->frameCount - 1 - framesAgo;
+    return stats->entries + (frameIndex & (FRAME_STATS_HISTORY_COUNT - 1));
+}
+
+// Sorts the frames in the history into their percentiles.
+void SummarizeFrameStats(FrameStats *stats, FrameStatsSummary *summary);
+
+// Writes every frame in the history, oldest first. Produces 0 on success.
+s32 WriteFrameStatsCSV(FrameStats *stats, const char *path);
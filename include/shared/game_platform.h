@@ -1,11 +1,103 @@
 #pragma once
 
-#include <set>
 #include <string>
+#include <type_traits>
 
 #include <meta_definitions.h>
 #include <asset_types.h>
 #include <render_game.h>
+#include <memory_telemetry.h>
+#include <frame_stats.h>
+
+// NOTE(marvin): The key codes are the USB HID usages, the same as the
+// SDL scancodes, so the platform passes them through as is and the
+// game module doesn't need SDL. They are physical positions, not the
+// characters of the keyboard layout. Only the ones that have a name
+// in the input action map are listed, the rest are still tracked.
+enum KeyCode
+{
+    keyCode_unknown = 0,
+
+    keyCode_a = 4, keyCode_b, keyCode_c, keyCode_d, keyCode_e, keyCode_f, keyCode_g,
+    keyCode_h, keyCode_i, keyCode_j, keyCode_k, keyCode_l, keyCode_m, keyCode_n,
+    keyCode_o, keyCode_p, keyCode_q, keyCode_r, keyCode_s, keyCode_t, keyCode_u,
+    keyCode_v, keyCode_w, keyCode_x, keyCode_y, keyCode_z,
+
+    keyCode_1 = 30, keyCode_2, keyCode_3, keyCode_4, keyCode_5,
+    keyCode_6, keyCode_7, keyCode_8, keyCode_9, keyCode_0,
+
+    keyCode_return    = 40,
+    keyCode_escape    = 41,
+    keyCode_backspace = 42,
+    keyCode_tab       = 43,
+    keyCode_space     = 44,
+
+    keyCode_f1 = 58, keyCode_f2, keyCode_f3, keyCode_f4, keyCode_f5, keyCode_f6,
+    keyCode_f7, keyCode_f8, keyCode_f9, keyCode_f10, keyCode_f11, keyCode_f12,
+
+    keyCode_right = 79,
+    keyCode_left  = 80,
+    keyCode_down  = 81,
+    keyCode_up    = 82,
+
+    keyCode_leftCtrl   = 224,
+    keyCode_leftShift  = 225,
+    keyCode_leftAlt    = 226,
+    keyCode_rightCtrl  = 228,
+    keyCode_rightShift = 229,
+    keyCode_rightAlt   = 230,
+
+    // NOTE(marvin): Same as SDL_SCANCODE_COUNT.
+    keyCode_count = 512,
+};
+
+// NOTE(marvin): Same as the SDL mouse buttons.
+enum MouseButton
+{
+    mouseButton_left   = 1,
+    mouseButton_middle = 2,
+    mouseButton_right  = 3,
+    mouseButton_x1     = 4,
+    mouseButton_x2     = 5,
+
+    mouseButton_count = 64,
+};
+
+// NOTE(marvin): One bit per key and per mouse button, so a query is a
+// single bit test.
+struct InputButtons
+{
+    u64 keys[keyCode_count / 64];
+    u64 mouseButtons;
+};
+
+inline b32 IsKeyDown(const InputButtons *buttons, u32 keyCode)
+{
+    ASSERT(keyCode < keyCode_count);
+    b32 result = (buttons->keys[keyCode / 64] >> (keyCode % 64)) & 1;
+    return result;
+}
+
+inline void SetKeyDown(InputButtons *buttons, u32 keyCode, b32 down)
+{
+    ASSERT(keyCode < keyCode_count);
+    u64 bit = 1ull << (keyCode % 64);
+    buttons->keys[keyCode / 64] = down ? (buttons->keys[keyCode / 64] | bit) : (buttons->keys[keyCode / 64] & ~bit);
+}
+
+inline b32 IsMouseButtonDown(const InputButtons *buttons, u32 button)
+{
+    ASSERT(button < mouseButton_count);
+    b32 result = (buttons->mouseButtons >> button) & 1;
+    return result;
+}
+
+inline void SetMouseButtonDown(InputButtons *buttons, u32 button, b32 down)
+{
+    ASSERT(button < mouseButton_count);
+    u64 bit = 1ull << button;
+    buttons->mouseButtons = down ? (buttons->mouseButtons | bit) : (buttons->mouseButtons & ~bit);
+}
 
 struct GameInput
 {
@@ -14,28 +106,50 @@ struct GameInput
     u32 mouseX;
     u32 mouseY;
 
-    std::set<std::string> keysDownPrevFrame;
-    std::set<std::string> keysDownThisFrame;
+    InputButtons buttonsDownPrevFrame;
+    InputButtons buttonsDownThisFrame;
 };
 
+// NOTE(marvin): The looped live editing records and plays back the
+// input as raw bytes.
+static_assert(std::is_trivially_copyable_v<GameInput>);
+
 // NOTE(marvin): When OnPress produces true for some key, OnHold will
 // also produce true for that same key.
 
-inline b32 OnPress(GameInput* input, std::string key)
+inline b32 OnPress(GameInput *input, KeyCode key)
+{
+    b32 result = IsKeyDown(&input->buttonsDownThisFrame, key) && !IsKeyDown(&input->buttonsDownPrevFrame, key);
+    return result;
+}
+
+inline b32 OnRelease(GameInput *input, KeyCode key)
+{
+    b32 result = !IsKeyDown(&input->buttonsDownThisFrame, key) && IsKeyDown(&input->buttonsDownPrevFrame, key);
+    return result;
+}
+
+inline b32 OnHold(GameInput *input, KeyCode key)
 {
-    b32 result = input->keysDownThisFrame.contains(key) && !input->keysDownPrevFrame.contains(key);
+    b32 result = IsKeyDown(&input->buttonsDownThisFrame, key);
     return result;
 }
 
-inline b32 OnRelease(GameInput* input, std::string key)
+inline b32 OnPress(GameInput *input, MouseButton button)
 {
-    b32 result = !input->keysDownThisFrame.contains(key) && input->keysDownPrevFrame.contains(key);
+    b32 result = IsMouseButtonDown(&input->buttonsDownThisFrame, button) && !IsMouseButtonDown(&input->buttonsDownPrevFrame, button);
     return result;
 }
 
-inline b32 OnHold(GameInput* input, std::string key)
+inline b32 OnRelease(GameInput *input, MouseButton button)
 {
-    b32 result = input->keysDownThisFrame.contains(key);
+    b32 result = !IsMouseButtonDown(&input->buttonsDownThisFrame, button) && IsMouseButtonDown(&input->buttonsDownPrevFrame, button);
+    return result;
+}
+
+inline b32 OnHold(GameInput *input, MouseButton button)
+{
+    b32 result = IsMouseButtonDown(&input->buttonsDownThisFrame, button);
     return result;
 }
 
@@ -49,10 +163,12 @@ DEFINE_GAME_MODULE_API(PlatformAssetUtils,ASSET_UTIL_FUNCS)
 
 // TODO(marvin): The creation of the SKL Jolt Allocator must happen on the platform side so that the virtual table can survive the hot reload. I don't see a better way than this...
 
+// NOTE(marvin): The memory tag is remembered by the platform along
+// with the allocation, so free and realloc don't need to be told again.
 #define ALLOCATOR_FUNCS(method) \
-    method(void *,AlignedAllocate,(siz size, siz alignment)) \
+    method(void *,AlignedAllocate,(siz size, siz alignment, MemoryTag tag)) \
     method(void,AlignedFree,(void *block)) \
-    method(void *,Allocate,(siz size)) \
+    method(void *,Allocate,(siz size, MemoryTag tag)) \
     method(void,Free,(void *block)) \
     method(void *,Realloc,(void *block, siz oldSize, siz newSize))
 DEFINE_GAME_MODULE_API(PlatformAllocator, ALLOCATOR_FUNCS)
@@ -66,6 +182,10 @@ struct PlatformAPI
 
 struct ImGuiContext;
 struct DebugState;
+struct DebugFrameSnapshot;
+struct DebugProfiler;
+struct AllocationGuard;
+struct JobScheduler;
 
 struct GameMemory
 {
@@ -74,13 +194,31 @@ struct GameMemory
     // TODO(marvin): Does the imgui context really belong to game memory? Should it be part of the debug storage?
     ImGuiContext *imGuiContext;
 
+    MemoryTelemetry *memoryTelemetry;
+    FrameStats *frameStats;
+    JobScheduler *jobScheduler;
+
+#if SKL_ALLOCATION_GUARD
+    AllocationGuard *allocationGuard;
+#endif
+
 #if SKL_INTERNAL
     void* debugStorage;
     DebugState* debugState;
+
+    // NOTE(marvin): If set by the platform, the timed blocks of each
+    // frame are copied here instead of being logged.
+    DebugFrameSnapshot* debugFrameSnapshot;
+
+    DebugProfiler* debugProfiler;
 #endif
 
     PlatformAPI platformAPI;
 
+    // NOTE(marvin): Set by the platform for frames that are only
+    // simulated, like the ones fast forwarded after seeking a recording.
+    b32 skipRender;
+
     // NOTE(marvin): It is contained in the scene as well, but the SKL physics system's temp allocator need to be reset due to vtable x hot reload conflict. Putting it here for convenience.
     // TODO: It would be ideal to prevent hot reloading logic of sklPhysicsSystem to spread into game code
     //       however we will hold off on abstracting dylib logic until another library like Jolt necessitates the same kind of behavior.
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <vector>
+
+#include <meta_definitions.h>
+
+// This file is responsible for the handle pool, which is how the
+// renderer backends store their resources (meshes, textures,
+// lights). The resources live in a dense array of slots, and the
+// game gets a generational handle to its slot. A handle packs the
+// index of the slot in its low bits and the version of the slot in its
+// high bits, so a lookup is an array index plus a version compare,
+// and a handle to a destroyed resource is caught instead of aliasing
+// whatever reused the slot.
+
+// NOTE(marvin): The handles are the s32 MeshID, TextureID and
+// LightID, where -1 means none, so the sign bit is never set in a
+// valid handle.
+constexpr u32 HANDLE_INDEX_BITS = 20;
+constexpr u32 HANDLE_INDEX_MASK = (1u << HANDLE_INDEX_BITS) - 1;
+constexpr u32 HANDLE_VERSION_MASK = (1u << (31 - HANDLE_INDEX_BITS)) - 1;
+constexpr s32 INVALID_HANDLE = -1;
+
+template <typename T>
+struct HandlePool
+{
+    struct Slot
+    {
+        T item;
+        u32 version;
+        b32 live;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<u32> freeIndices;
+    u32 liveCount = 0;
+
+    static s32 MakeHandle(u32 index, u32 version)
+    {
+        s32 result = static_cast<s32>(((version & HANDLE_VERSION_MASK) << HANDLE_INDEX_BITS) | index);
+        return result;
+    }
+
+    static u32 GetHandleIndex(s32 handle)
+    {
+        u32 result = static_cast<u32>(handle) & HANDLE_INDEX_MASK;
+        return result;
+    }
+
+    static u32 GetHandleVersion(s32 handle)
+    {
+        u32 result = (static_cast<u32>(handle) >> HANDLE_INDEX_BITS) & HANDLE_VERSION_MASK;
+        return result;
+    }
+
+    // Produces the handle of a new default constructed item, reusing
+    // a destroyed slot if there is one. If item isn't null, it is set
+    // to the new item.
+    s32 Add(T **item = nullptr)
+    {
+        u32 index;
+        if (!freeIndices.empty())
+        {
+            index = freeIndices.back();
+            freeIndices.pop_back();
+        }
+        else
+        {
+            ASSERT_PRINT(slots.size() <= HANDLE_INDEX_MASK, "Too many items for the handle pool.");
+            index = static_cast<u32>(slots.size());
+            slots.push_back({});
+        }
+
+        Slot &slot = slots[index];
+        slot.item = T();
+        slot.live = true;
+        ++liveCount;
+
+        if (item)
+        {
+            *item = &slot.item;
+        }
+        return MakeHandle(index, slot.version);
+    }
+
+    // Produces nullptr if the handle is invalid, or its item has been
+    // removed.
+    T *Get(s32 handle)
+    {
+        if (handle < 0)
+        {
+            return nullptr;
+        }
+
+        u32 index = GetHandleIndex(handle);
+        if (index >= slots.size())
+        {
+            return nullptr;
+        }
+
+        Slot &slot = slots[index];
+        if (!slot.live || (slot.version & HANDLE_VERSION_MASK) != GetHandleVersion(handle))
+        {
+            return nullptr;
+        }
+        return &slot.item;
+    }
+
+    // Produces whether there was a live item to remove. Bumping the
+    // version is what invalidates the outstanding handles.
+    b32 Remove(s32 handle)
+    {
+        if (!Get(handle))
+        {
+            return false;
+        }
+
+        u32 index = GetHandleIndex(handle);
+        Slot &slot = slots[index];
+        slot.item = T();
+        slot.live = false;
+        ++slot.version;
+        --liveCount;
+        freeIndices.push_back(index);
+        return true;
+    }
+
+    // Calls the procedure with the handle and the item of each live item.
+    template <typename F>
+    void ForEach(F &&procedure)
+    {
+        for (u32 index = 0; index < slots.size(); ++index)
+        {
+            Slot &slot = slots[index];
+            if (slot.live)
+            {
+                procedure(MakeHandle(index, slot.version), slot.item);
+            }
+        }
+    }
+};
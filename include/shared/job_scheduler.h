@@ -0,0 +1,128 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <meta_definitions.h>
+#include <skl_thread_safe_primitives.h>
+
+// This file is responsible for the job scheduler that the whole engine
+// shares, so that the physics, the ECS and the asset loading don't
+// each start threads of their own that fight over the cores. Every
+// worker has a deque of jobs per priority. A worker takes its own jobs
+// from the back, the latest first, as they are the most likely to still
+// be in its cache, and when it has none left, steals from the front of
+// the others' deques. Threads that aren't workers, like the main thread,
+// share one more deque, which only the workers steal from, and help out
+// with the jobs while they wait for theirs to be done.
+
+// NOTE(marvin): Like the profiler, the scheduler is owned by the
+// platform, which is the only one that starts and stops the workers,
+// so that the code they run outside of the jobs survives hot reloads.
+// The game module only submits jobs, and a job of the game module has
+// to be done before the frame that submitted it ends.
+
+constexpr u32 MAX_JOB_WORKERS = 32;
+constexpr u32 JOB_DEQUE_CAPACITY = 1024;  // Power of 2.
+
+// NOTE(marvin): The deque that the threads that aren't workers share.
+constexpr u32 EXTERNAL_JOB_DEQUE_INDEX = MAX_JOB_WORKERS;
+
+enum JobPriority
+{
+    // Work that a frame waits on, like the physics step.
+    jobPriority_high = 0,
+    // Work that can take frames, like loading assets.
+    jobPriority_low  = 1,
+
+    jobPriority_count,
+};
+
+#define JOB_FUNCTION(name) void name(void *data)
+typedef JOB_FUNCTION(job_function_t);
+
+struct Job
+{
+    job_function_t *function;
+    void *data;
+    // NOTE(marvin): Decremented once the job is done, if set, see
+    // WaitForJobCounter.
+    u64 volatile *counter;
+};
+
+struct JobDeque
+{
+    std::mutex mutex;
+    Job jobs[JOB_DEQUE_CAPACITY];
+    // The front is at head, the back is at tail - 1.
+    u64 head;
+    u64 tail;
+    // NOTE(marvin): So that a thread looking for a job can skip the
+    // empty deques without taking their locks.
+    u64 volatile count;
+};
+
+struct JobScheduler
+{
+    JobDeque deques[MAX_JOB_WORKERS + 1][jobPriority_count];
+
+    // NOTE(marvin): The workers are detached, a worker that is asked to
+    // stop decrements the running count on its way out instead.
+    std::thread::id workerThreadIDs[MAX_JOB_WORKERS];
+    u32 workerCount;
+    u64 volatile runningWorkerCount;
+    u64 volatile stopping;
+    // NOTE(marvin): Set once the thread IDs and the count are in, the
+    // workers don't take any job before then.
+    u64 volatile started;
+
+    // NOTE(marvin): Set by anyone, applied by the platform at the start
+    // of the next frame, see ApplyJobWorkerCount.
+    u32 requestedWorkerCount;
+
+    // Jobs that are in a deque, for the workers to sleep on.
+    u64 volatile queuedJobCount;
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition;
+};
+
+// Produces the number of workers for the cores of the machine, leaving
+// one for the main thread.
+u32 GetDefaultJobWorkerCount();
+
+// Starts the given number of workers. Platform only.
+void InitJobScheduler(JobScheduler *scheduler, u32 workerCount);
+
+// Stops every worker, waiting on the jobs they are in the middle of.
+// The jobs that are still queued stay queued. Platform only.
+void StopJobWorkers(JobScheduler *scheduler);
+
+// Restarts the workers if a different number of them was requested.
+// Called by the platform at the start of a frame, while no jobs of the
+// game module are running.
+void ApplyJobWorkerCount(JobScheduler *scheduler);
+
+inline u32 GetJobWorkerCount(JobScheduler *scheduler)
+{
+    u32 result = scheduler->workerCount;
+    return result;
+}
+
+// Produces the index of the calling worker, or EXTERNAL_JOB_DEQUE_INDEX
+// for a thread that isn't one, so that each thread that runs jobs can
+// have its own of something, without locks.
+u32 GetJobThreadIndex(JobScheduler *scheduler);
+
+// Queues a job. The counter, if any, is incremented now and decremented
+// once the job is done. Without any workers, or with no room left in
+// the deque, the job is run right away instead.
+void SubmitJob(JobScheduler *scheduler, job_function_t *function, void *data,
+               JobPriority priority, u64 volatile *counter = nullptr);
+
+// Runs one queued job, if there is any, on the calling thread.
+// Produces whether it did.
+b32 RunQueuedJob(JobScheduler *scheduler);
+
+// Runs queued jobs until the counter is down to 0.
+void WaitForJobCounter(JobScheduler *scheduler, u64 volatile *counter);
@@ -101,6 +101,10 @@ inline void *PushSize_(INTERNAL_MEMORY_PARAM
     ASSERT(effectiveSize >= requestedSize);
     arena->used += effectiveSize;
     ASSERT(arena->used <= arena->size);
+    if (arena->used > arena->peakUsed)
+    {
+        arena->peakUsed = arena->used;
+    }
 
     if (params.flags & clear_to_zero)
     {
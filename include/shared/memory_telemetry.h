@@ -0,0 +1,127 @@
+#pragma once
+
+#include <meta_definitions.h>
+#include <memory_types.h>
+#include <skl_thread_safe_primitives.h>
+
+// This file is responsible for the always-on allocation telemetry,
+// which accounts for memory per subsystem. Unlike the memory viewer,
+// it doesn't keep a history of allocations, only counters, so that it
+// is cheap enough to leave on in every build. The heap side is
+// recorded by the platform allocator, the arena side is read straight
+// out of the registered memory arenas when it is displayed.
+
+// NOTE(marvin): The telemetry is owned by the platform so that it
+// survives hot reloads, and is handed to the game module through the
+// game memory, just like the debug state.
+
+enum MemoryTag
+{
+    memoryTag_general  = 0,
+    memoryTag_physics  = 1,
+    memoryTag_renderer = 2,
+    memoryTag_assets   = 3,
+    memoryTag_ecs      = 4,
+    memoryTag_debug    = 5,
+
+    memoryTag_count,
+};
+
+inline const char *GetMemoryTagName(MemoryTag tag)
+{
+    local_persist const char *names[memoryTag_count] =
+    {
+        "General",
+        "Physics",
+        "Renderer",
+        "Assets",
+        "ECS",
+        "Debug",
+    };
+
+    ASSERT(tag < memoryTag_count);
+    return names[tag];
+}
+
+// NOTE(marvin): The this frame counters are reset on the frame
+// boundary, after being copied over to the last frame counters, which
+// are the ones that should be displayed.
+struct MemoryTagStats
+{
+    u64 bytesLive;
+    u64 bytesPeak;
+    u64 allocationsThisFrame;
+    u64 bytesThisFrame;
+    u64 allocationsLastFrame;
+    u64 bytesLastFrame;
+
+    // Budget on the live bytes, 0 if there is no budget.
+    u64 budget;
+    b32 overBudget;
+};
+
+constexpr u32 MAX_TELEMETRY_ARENAS = 32;
+constexpr u32 TELEMETRY_ARENA_NAME_LENGTH = 32;
+
+// NOTE(marvin): The name is copied, because a string literal from the
+// game module would not survive a hot reload. The arena itself must
+// live in the fixed size storage.
+struct MemoryTelemetryArena
+{
+    char name[TELEMETRY_ARENA_NAME_LENGTH];
+    MemoryTag tag;
+    MemoryArena *arena;
+};
+
+struct MemoryTelemetry
+{
+    MemoryTagStats tags[memoryTag_count];
+
+    MemoryTelemetryArena arenas[MAX_TELEMETRY_ARENAS];
+    u32 arenaCount;
+
+    u64 frameIndex;
+};
+
+// NOTE(marvin): The platform allocator is called from Jolt's worker
+// threads, so the counters have to be updated atomically.
+
+inline void RecordTelemetryAllocate(MemoryTelemetry *telemetry, MemoryTag tag, u64 size)
+{
+    ASSERT(tag < memoryTag_count);
+    MemoryTagStats *stats = telemetry->tags + tag;
+    u64 bytesLive = AtomicAddU64(&stats->bytesLive, size) + size;
+    AtomicMaxU64(&stats->bytesPeak, bytesLive);
+    AtomicAddU64(&stats->allocationsThisFrame, 1);
+    AtomicAddU64(&stats->bytesThisFrame, size);
+}
+
+inline void RecordTelemetryFree(MemoryTelemetry *telemetry, MemoryTag tag, u64 size)
+{
+    ASSERT(tag < memoryTag_count);
+    MemoryTagStats *stats = telemetry->tags + tag;
+    // NOTE(marvin): Unsigned wrap around does the subtraction.
+    AtomicAddU64(&stats->bytesLive, ~size + 1);
+}
+
+inline void SetMemoryBudget(MemoryTelemetry *telemetry, MemoryTag tag, u64 budget)
+{
+    ASSERT(tag < memoryTag_count);
+    telemetry->tags[tag].budget = budget;
+    telemetry->tags[tag].overBudget = false;
+}
+
+// Registers an arena to be reported under the given tag. Registering
+// the same arena again only updates its name and tag.
+void RegisterTelemetryArena(MemoryTelemetry *telemetry, MemoryArena *arena, const char *name, MemoryTag tag);
+
+// Sums up the used and size of all the registered arenas with the given tag.
+void GetTelemetryArenaTotals(MemoryTelemetry *telemetry, MemoryTag tag, siz *used, siz *peakUsed, siz *size);
+
+// Moves the this frame counters over to the last frame counters, and
+// warns about budgets that have been exceeded. Called by the platform
+// once per frame.
+void EndMemoryTelemetryFrame(MemoryTelemetry *telemetry);
+
+// Produces 0 on success.
+s32 WriteMemoryTelemetryCSV(MemoryTelemetry *telemetry, const char *path);
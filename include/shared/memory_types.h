@@ -8,6 +8,9 @@ struct MemoryArena
   
     u08 *base;
     siz used;
+
+    // NOTE(marvin): High-water mark of used, for sizing the arena.
+    siz peakUsed;
 };
 
 enum ArenaFlag
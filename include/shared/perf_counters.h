@@ -0,0 +1,77 @@
+#pragma once
+
+#include <meta_definitions.h>
+
+// This file is responsible for the hardware performance counters of
+// the CPU, which are read through perf_event_open on Linux. They are
+// counted per thread and only in user space, so that they work with
+// the default perf_event_paranoid of 2. The timed blocks read them at
+// their begin and end, which is what tells apart a block that is
+// bound by memory (low instructions per cycle, many cache misses)
+// from one that is bound by compute.
+
+#if SKL_PERF_COUNTERS
+
+enum PerfCounter
+{
+    perfCounter_cycles       = 0,
+    perfCounter_instructions = 1,
+    perfCounter_l1dMisses    = 2,
+    perfCounter_llcMisses    = 3,
+    perfCounter_branchMisses = 4,
+
+    perfCounter_count,
+};
+
+inline const char *GetPerfCounterName(PerfCounter counter)
+{
+    local_persist const char *names[perfCounter_count] =
+    {
+        "Cycles",
+        "Instructions",
+        "L1D Misses",
+        "LLC Misses",
+        "Branch Misses",
+    };
+
+    ASSERT(counter < perfCounter_count);
+    return names[counter];
+}
+
+struct PerfCounterValues
+{
+    u64 values[perfCounter_count];
+};
+
+enum PerfCounterGroupState
+{
+    perfCounterGroupState_unopened = 0,
+    perfCounterGroupState_open     = 1,
+    perfCounterGroupState_failed   = 2,
+};
+
+// NOTE(marvin): The counters of a thread, opened as one group so that
+// they are all read with one system call. A counter that the CPU (or
+// the virtual machine) doesn't have is left out of the group, and
+// reads as 0.
+struct PerfCounterGroup
+{
+    PerfCounterGroupState state;
+    s32 fds[perfCounter_count];
+    // The counter of each value in a read of the group, in the order
+    // they were opened in.
+    u32 slotCounters[perfCounter_count];
+    u32 slotCount;
+};
+
+// Opens the counters for the calling thread. Produces whether at least
+// the cycles could be opened.
+b32 OpenPerfCounterGroup(PerfCounterGroup *group);
+
+void ClosePerfCounterGroup(PerfCounterGroup *group);
+
+// Reads the counters of the group, which has to have been opened by
+// the calling thread. Produces false if they couldn't be read.
+b32 ReadPerfCounterGroup(PerfCounterGroup *group, PerfCounterValues *values);
+
+#endif
@@ -8,6 +8,7 @@
 #include <skl_math_types.h>
 #include <render_game.h>
 #include <render_types.h>
+#include <memory_telemetry.h>
 
 // Common interface between renderers for systems to call.
 // The interfaces take in Info objects in order to allow for 
@@ -26,6 +27,10 @@ struct RenderInitInfo {
 
     bool editor;
 
+    // The meshes and textures that are uploaded are recorded under
+    // the renderer tag, until they are destroyed.
+    MemoryTelemetry *memoryTelemetry;
+
     // Vulkan Specific 
 
     // WGPU Specific
@@ -11,6 +11,8 @@
 // Really any compile time math concept
 
 struct DataEntry;
+struct ComponentLayout;
+struct ComponentPoolRemap;
 
 class Transform3D
 {
@@ -42,6 +44,15 @@ public:
     template<typename T>
     friend DataEntry* ReadToData(T*, std::string);
 
+    template<typename T>
+    friend void DescribeFields(T*, ComponentLayout*);
+
+    template<typename T>
+    friend void DescribeRuntimeFields(T*, ComponentLayout*);
+
+    template<typename T>
+    friend void RemapComponentPointers(void*, ComponentPoolRemap*);
+
 private:
     glm::vec3 position;
     glm::vec3 rotation;
@@ -18,6 +18,22 @@ inline u64 AtomicExchangeU64(u64 volatile *store_, u64 newValue)
     return atomicRef.exchange(newValue);
 }
 
+// NOTE(marvin): The load and store pair up, so that whatever was
+// written before the store is visible after the load that sees it.
+inline u64 AtomicLoadAcquireU64(u64 volatile *store_)
+{
+    u64 *store = const_cast<u64 *>(store_);
+    std::atomic_ref<u64> atomicRef(*store);
+    return atomicRef.load(std::memory_order_acquire);
+}
+
+inline void AtomicStoreReleaseU64(u64 volatile *store_, u64 value)
+{
+    u64 *store = const_cast<u64 *>(store_);
+    std::atomic_ref<u64> atomicRef(*store);
+    atomicRef.store(value, std::memory_order_release);
+}
+
 // Adds the given addend to the value of the given store, atomically,
 // and returns the old value of the store.
 inline u64 AtomicAddU64(u64 volatile *store_, u64 addend)
@@ -28,3 +44,16 @@ inline u64 AtomicAddU64(u64 volatile *store_, u64 addend)
 }
 
 
+
+// Raises the value of the given store to the given value if it is
+// larger, atomically, and returns the old value of the store.
+inline u64 AtomicMaxU64(u64 volatile *store_, u64 value)
+{
+    u64 *store = const_cast<u64 *>(store_);
+    std::atomic_ref<u64> atomicRef(*store);
+    u64 oldValue = atomicRef.load();
+    while (oldValue < value && !atomicRef.compare_exchange_weak(oldValue, value))
+    {
+    }
+    return oldValue;
+}
@@ -0,0 +1,350 @@
+#include <meta_definitions.h>
+#include <scene.h>
+#include <map_loader.h>
+#include <engine.h>
+#include <component_layout.h>
+
+#define INVALID_COMPONENT_ID (ComponentID)(-1)
+
+// >>> Local Helper Functions <<<
+
+local ComponentFieldLayout *FindFieldLayout(ComponentLayout *layout, const char *name)
+{
+    for (u32 fieldIndex = 0; fieldIndex < layout->fieldCount; ++fieldIndex)
+    {
+        ComponentFieldLayout *field = layout->fields + fieldIndex;
+        if (strcmp(field->name, name) == 0)
+        {
+            return field;
+        }
+    }
+    return nullptr;
+}
+
+local b32 FieldLayoutsMatch(ComponentFieldLayout *a, ComponentFieldLayout *b)
+{
+    b32 result = (strcmp(a->name, b->name) == 0 &&
+                  a->offset == b->offset &&
+                  a->size == b->size &&
+                  a->typeHash == b->typeHash);
+    return result;
+}
+
+local u64 HashComponentLayouts()
+{
+    u64 result = 14695981039346656037ull;
+    for (ComponentInfo &compInfo : CompInfos())
+    {
+        ComponentLayout &layout = compInfo.layout;
+        result = (result ^ HashLayoutName(layout.name)) * 1099511628211ull;
+        result = (result ^ layout.size) * 1099511628211ull;
+        for (u32 fieldIndex = 0; fieldIndex < layout.fieldCount; ++fieldIndex)
+        {
+            ComponentFieldLayout *field = layout.fields + fieldIndex;
+            result = (result ^ HashLayoutName(field->name)) * 1099511628211ull;
+            result = (result ^ field->offset) * 1099511628211ull;
+            result = (result ^ field->typeHash) * 1099511628211ull;
+        }
+    }
+    return result;
+}
+
+local ComponentID FindOldComponent(ComponentLayoutTable *table, const char *name)
+{
+    for (ComponentID id = 0; id < table->count; ++id)
+    {
+        if (strcmp(table->layouts[id].name, name) == 0)
+        {
+            return id;
+        }
+    }
+    return INVALID_COMPONENT_ID;
+}
+
+// Produces whether the field can be carried over to the new layout.
+local b32 FieldCarriesOver(ComponentLayout *newLayout, ComponentFieldLayout *newField, ComponentFieldLayout *oldField)
+{
+    if (!oldField)
+    {
+        LOG(newLayout->name << "::" << newField->name << " is new, defaulting it.");
+        return false;
+    }
+    if (oldField->typeHash != newField->typeHash || oldField->size != newField->size)
+    {
+        LOG(newLayout->name << "::" << newField->name << " changed type, defaulting it.");
+        return false;
+    }
+    return true;
+}
+
+// NOTE(marvin): The old components are packed into the scratch buffer
+// first, as the new pool may be the old pool's memory when the
+// component didn't grow. The fields that aren't trivially copyable are
+// moved there instead, with the functions of the new module, as they
+// can point into themselves. Then every live slot is default
+// constructed, and each field that is in both layouts is moved over one
+// column at a time, i.e. the same field of every entity before the next
+// field.
+local void MigrateComponentPool(ComponentPool *pool, ComponentPool oldPool, ComponentLayout *oldLayout,
+                                ComponentInfo &compInfo, u32 *liveIndices, u32 liveCount, u8 *scratch)
+{
+    ComponentLayout *newLayout = &compInfo.layout;
+    siz oldSize = oldPool.elementSize;
+    siz newSize = pool->elementSize;
+
+    ComponentFieldLayout *oldFields[MAX_COMPONENT_FIELDS];
+    for (u32 fieldIndex = 0; fieldIndex < newLayout->fieldCount; ++fieldIndex)
+    {
+        ComponentFieldLayout *newField = newLayout->fields + fieldIndex;
+        ComponentFieldLayout *oldField = FindFieldLayout(oldLayout, newField->name);
+        oldFields[fieldIndex] = FieldCarriesOver(newLayout, newField, oldField) ? oldField : nullptr;
+    }
+
+    for (u32 liveIndex = 0; liveIndex < liveCount; ++liveIndex)
+    {
+        memcpy(scratch + liveIndex * oldSize, oldPool.get(liveIndices[liveIndex]), oldSize);
+    }
+
+    for (u32 fieldIndex = 0; fieldIndex < newLayout->fieldCount; ++fieldIndex)
+    {
+        ComponentFieldLayout *newField = newLayout->fields + fieldIndex;
+        ComponentFieldLayout *oldField = oldFields[fieldIndex];
+        if (oldField && newField->moveConstructFunc)
+        {
+            for (u32 liveIndex = 0; liveIndex < liveCount; ++liveIndex)
+            {
+                newField->moveConstructFunc(scratch + liveIndex * oldSize + oldField->offset,
+                                            static_cast<u8 *>(oldPool.get(liveIndices[liveIndex])) + oldField->offset);
+            }
+        }
+    }
+
+    for (u32 liveIndex = 0; liveIndex < liveCount; ++liveIndex)
+    {
+        compInfo.constructFunc(pool->get(liveIndices[liveIndex]));
+    }
+
+    for (u32 fieldIndex = 0; fieldIndex < newLayout->fieldCount; ++fieldIndex)
+    {
+        ComponentFieldLayout *newField = newLayout->fields + fieldIndex;
+        ComponentFieldLayout *oldField = oldFields[fieldIndex];
+        if (!oldField)
+        {
+            continue;
+        }
+
+        u8 *source = scratch + oldField->offset;
+        u8 *destination = pool->pData + newField->offset;
+        for (u32 liveIndex = 0; liveIndex < liveCount; ++liveIndex)
+        {
+            if (newField->moveAssignFunc)
+            {
+                newField->moveAssignFunc(destination + liveIndices[liveIndex] * newSize, source + liveIndex * oldSize);
+            }
+            else
+            {
+                memcpy(destination + liveIndices[liveIndex] * newSize, source + liveIndex * oldSize, newField->size);
+            }
+        }
+    }
+
+    // NOTE(marvin): The pointers into the pool were carried over as
+    // they were, so they still point to where the components were in
+    // the old pool.
+    ComponentPoolRemap remap = {oldPool.pData, oldSize, pool->pData, newSize};
+    for (u32 liveIndex = 0; liveIndex < liveCount; ++liveIndex)
+    {
+        compInfo.remapFunc(pool->get(liveIndices[liveIndex]), &remap);
+    }
+
+    for (u32 fieldIndex = 0; fieldIndex < oldLayout->fieldCount; ++fieldIndex)
+    {
+        ComponentFieldLayout *oldField = oldLayout->fields + fieldIndex;
+        if (!FindFieldLayout(newLayout, oldField->name))
+        {
+            LOG(newLayout->name << "::" << oldField->name << " was removed, dropping it.");
+        }
+    }
+}
+
+// >>> Global Function Interface <<<
+
+b32 ComponentLayoutsMatch(ComponentLayout *a, ComponentLayout *b)
+{
+    if (strcmp(a->name, b->name) != 0 || a->size != b->size || a->fieldCount != b->fieldCount)
+    {
+        return false;
+    }
+    for (u32 fieldIndex = 0; fieldIndex < a->fieldCount; ++fieldIndex)
+    {
+        if (!FieldLayoutsMatch(a->fields + fieldIndex, b->fields + fieldIndex))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SaveComponentLayouts(Scene &scene)
+{
+    ComponentLayoutTable *table = scene.componentLayouts;
+    std::vector<ComponentInfo> &compInfos = CompInfos();
+    ASSERT(compInfos.size() <= MAX_COMPONENTS);
+
+    table->count = static_cast<u32>(compInfos.size());
+    for (ComponentID id = 0; id < table->count; ++id)
+    {
+        table->layouts[id] = compInfos[id].layout;
+    }
+    table->hash = HashComponentLayouts();
+}
+
+b32 ComponentLayoutsChanged(Scene &scene)
+{
+    // NOTE(marvin): Only hashed once per game module, as this is
+    // checked every frame to catch a loop restoring memory that was
+    // recorded with an older module.
+    local_persist u64 hash = HashComponentLayouts();
+    b32 result = scene.componentLayouts->hash != hash;
+    return result;
+}
+
+void MigrateComponentPools(Scene &scene)
+{
+    ComponentLayoutTable *table = scene.componentLayouts;
+    std::vector<ComponentInfo> &compInfos = CompInfos();
+    ComponentID newCount = static_cast<ComponentID>(compInfos.size());
+    ASSERT(newCount <= MAX_COMPONENTS);
+
+    ComponentPool oldPools[MAX_COMPONENTS];
+    ComponentID oldCount = scene.componentPools.count;
+    for (ComponentID id = 0; id < oldCount; ++id)
+    {
+        oldPools[id] = *scene.componentPools[id];
+    }
+
+    ComponentID newToOld[MAX_COMPONENTS];
+    b32 oldKept[MAX_COMPONENTS] = {};
+    for (ComponentID newId = 0; newId < newCount; ++newId)
+    {
+        newToOld[newId] = FindOldComponent(table, compInfos[newId].layout.name);
+        if (newToOld[newId] != INVALID_COMPONENT_ID)
+        {
+            oldKept[newToOld[newId]] = true;
+        }
+    }
+
+    u32 entityCount = GetEntitiesPoolSize(&scene.entities);
+    u32 *liveIndices = static_cast<u32 *>(allocator.Allocate(sizeof(u32) * MAX_ENTITIES, memoryTag_ecs));
+    u8 *scratch = nullptr;
+    siz scratchSize = 0;
+
+    ComponentPool newPools[MAX_COMPONENTS];
+    for (ComponentID newId = 0; newId < newCount; ++newId)
+    {
+        ComponentInfo &compInfo = compInfos[newId];
+        ComponentID oldId = newToOld[newId];
+        if (oldId == INVALID_COMPONENT_ID)
+        {
+            void *base = PushSize(&scene.componentPoolsArena, MAX_ENTITIES * compInfo.size);
+            newPools[newId] = ComponentPool(base, compInfo.size);
+            LOG("Added a pool for the new component " << compInfo.name << ".");
+            continue;
+        }
+
+        ComponentPool oldPool = oldPools[oldId];
+        ComponentLayout *oldLayout = table->layouts + oldId;
+        if (ComponentLayoutsMatch(oldLayout, &compInfo.layout))
+        {
+            newPools[newId] = oldPool;
+            continue;
+        }
+
+        u32 liveCount = 0;
+        for (u32 entityIndex = 0; entityIndex < entityCount; ++entityIndex)
+        {
+            EntityEntry *entityEntry = GetFromEntitiesPool(&scene.entities, entityIndex);
+            if (EntityEntryValid(entityEntry) && entityEntry->mask.test(oldId))
+            {
+                liveIndices[liveCount++] = entityIndex;
+            }
+        }
+
+        // NOTE(marvin): A component that didn't grow is migrated within
+        // its own pool, otherwise it gets a new pool and the old one is
+        // left unused until the next GameInitialize.
+        if (compInfo.size <= oldPool.elementSize)
+        {
+            newPools[newId] = ComponentPool(oldPool.pData, compInfo.size);
+        }
+        else
+        {
+            void *base = PushSize(&scene.componentPoolsArena, MAX_ENTITIES * compInfo.size);
+            newPools[newId] = ComponentPool(base, compInfo.size);
+        }
+
+        siz neededScratchSize = liveCount * oldPool.elementSize;
+        if (neededScratchSize > scratchSize)
+        {
+            if (scratch)
+            {
+                allocator.Free(scratch);
+            }
+            scratch = static_cast<u8 *>(allocator.Allocate(neededScratchSize, memoryTag_ecs));
+            scratchSize = neededScratchSize;
+        }
+
+        MigrateComponentPool(&newPools[newId], oldPool, oldLayout, compInfo, liveIndices, liveCount, scratch);
+        LOG("Migrated " << liveCount << " " << compInfo.name << " from " << oldPool.elementSize << " to " << compInfo.size << " bytes.");
+    }
+
+    for (ComponentID oldId = 0; oldId < oldCount; ++oldId)
+    {
+        if (!oldKept[oldId])
+        {
+            LOG("The component " << table->layouts[oldId].name << " was removed, dropping its pool.");
+        }
+    }
+
+    if (scratch)
+    {
+        allocator.Free(scratch);
+    }
+    allocator.Free(liveIndices);
+
+    // NOTE(marvin): Component IDs are the order in which the game
+    // module registered the components, so the masks have to follow
+    // the components that moved.
+    for (u32 entityIndex = 0; entityIndex < entityCount; ++entityIndex)
+    {
+        EntityEntry *entityEntry = GetFromEntitiesPool(&scene.entities, entityIndex);
+        ComponentMask oldMask = entityEntry->mask;
+        ComponentMask newMask = ComponentMask();
+        for (ComponentID newId = 0; newId < newCount; ++newId)
+        {
+            ComponentID oldId = newToOld[newId];
+            if (oldId != INVALID_COMPONENT_ID && oldMask.test(oldId))
+            {
+                newMask.set(newId);
+            }
+        }
+        entityEntry->mask = newMask;
+    }
+
+    scene.componentPools.count = 0;
+    for (ComponentID newId = 0; newId < newCount; ++newId)
+    {
+        scene.componentPools.Push(newPools[newId]);
+    }
+
+    // NOTE(marvin): So are the lists of the tracked components.
+    ComponentAddedList oldAddedLists[MAX_COMPONENTS];
+    memcpy(oldAddedLists, scene.componentAddedLists, sizeof(oldAddedLists));
+    for (ComponentID newId = 0; newId < MAX_COMPONENTS; ++newId)
+    {
+        ComponentID oldId = newId < newCount ? newToOld[newId] : INVALID_COMPONENT_ID;
+        scene.componentAddedLists[newId] = (oldId != INVALID_COMPONENT_ID) ? oldAddedLists[oldId] : ComponentAddedList{};
+    }
+
+    SaveComponentLayouts(scene);
+}
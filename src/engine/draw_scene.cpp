@@ -7,6 +7,7 @@
 #include <scene.h>
 #include <map_loader.h>
 #include <scene_view.h>
+#include <physics.h>
 
 void FindCamera(GameState &gameState)
 {
@@ -18,7 +19,7 @@ void FindCamera(GameState &gameState)
     }
 }
 
-void DrawScene(GameState &gameState, GameInput &input, f32 deltaTime)
+void DrawScene(GameState &gameState, GameInput &input, f32 deltaTime, f32 blendFactor)
 {
     if (gameState.currentCamera == -1)
     {
@@ -93,7 +94,8 @@ void DrawScene(GameState &gameState, GameInput &input, f32 deltaTime)
     for (EntityID ent: SceneView<MeshComponent, Transform3D>(scene))
     {
         Transform3D *t = scene.Get<Transform3D>(ent);
-        glm::mat4 model = t->GetWorldTransform();
+        RigidBody *rb = scene.Get<RigidBody>(ent);
+        glm::mat4 model = rb ? GetRigidBodyRenderTransform(rb, t, blendFactor) : t->GetWorldTransform();
         MeshComponent *m = scene.Get<MeshComponent>(ent);
         if (m->mesh != nullptr)
         {
@@ -116,5 +118,10 @@ void DrawScene(GameState &gameState, GameInput &input, f32 deltaTime)
         .icons = icons
     };
 
+    FrameStats *frameStats = globalFrameStats;
+    EndFramePhase(frameStats, framePhase_draw);
+    BeginFramePhase(frameStats, framePhase_submit);
     renderer.RenderUpdate(sendState);
+    EndFramePhase(frameStats, framePhase_submit);
+    BeginFramePhase(frameStats, framePhase_draw);
 }
@@ -6,6 +6,7 @@
 #include <scene.h>
 #include <map_loader.h>
 #include <utils.h>
+#include <input_actions.h>
 #include <scene_view.h>
 #include <entity_view.h>
 
@@ -203,7 +204,7 @@ MAKE_SYSTEM_MANUAL_VTABLE(EditorSystem);
 
 SYSTEM_ON_UPDATE(EditorSystem)
 {
-    if (OnHold(input, "Mouse 3"))
+    if (OnHold(input, inputAction_editorLook))
     {
         EditorController *f = scene->Get<EditorController>(this->editorCam);
         Transform3D *t = scene->Get<Transform3D>(this->editorCam);
@@ -240,7 +241,7 @@ SYSTEM_ON_UPDATE(EditorSystem)
 
         ImGui::Begin("Overlay", nullptr, window_flags);
 
-        if (OnHold(input, "Mouse 1"))
+        if (OnHold(input, inputAction_editorSelect))
         {
             u32 cursorEntityIndex = renderer.GetIndexAtCursor();
             selectedEntityID = CreateEntityId(cursorEntityIndex, 0);
@@ -399,7 +400,7 @@ SYSTEM_ON_UPDATE(EditorSystem)
         }
 
         // NOTE(marvin): Save scene button
-        if (ImGui::Button("Save Scene") || (OnHold(input, "S") && (OnHold(input, "Left Ctrl") || OnHold(input, "Right Ctrl"))))
+        if (ImGui::Button("Save Scene") || (OnHold(input, inputAction_editorSave) && OnHold(input, inputAction_editorModifier)))
         {
             SaveCurrentMap(*scene);
         }
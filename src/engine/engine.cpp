@@ -12,19 +12,32 @@
 #include <meta_definitions.h>
 #include <scene.h>
 #include <map_loader.h>
+#include <component_layout.h>
 #include <system_registry.h>
 #include <engine_components.h>
 #include <physics.h>
 #include <overlay.h>
 #include <draw_scene.h>
+#include <allocation_guard.h>
+#include <input_actions.h>
 
 constexpr u32 FIXED_SIZE_STORAGE_SIZE = Megabytes(512 + 256);
 
 constexpr f32 FIXED_TIMESTEP_DELTA_TIME = 1.0f / 60.0f;
+// NOTE(marvin): After a hitch, the time that would take more steps
+// than this is dropped, so that the steps that catch up can't make the
+// next frame a hitch as well.
+constexpr u32 MAX_FIXED_TIMESTEPS_PER_FRAME = 4;
+
+// NOTE(marvin): Default budgets, the game may override them on game start.
+constexpr u64 PHYSICS_HEAP_BUDGET = Megabytes(64);
 
 PlatformAssetUtils assetUtils;
 PlatformRenderer renderer;
 PlatformAllocator allocator;
+MemoryTelemetry *globalMemoryTelemetry;
+FrameStats *globalFrameStats;
+JobScheduler *globalJobScheduler;
 
 #if SKL_INTERNAL
 DebugState* globalDebugState;
@@ -36,7 +49,7 @@ __declspec(dllexport)
 #endif
 GAME_INITIALIZE(GameInitialize)
 {
-    memory.fixedSizeStorage = allocator.AlignedAllocate(FIXED_SIZE_STORAGE_SIZE, 8);
+    memory.fixedSizeStorage = allocator.AlignedAllocate(FIXED_SIZE_STORAGE_SIZE, 8, memoryTag_general);
 
     DebugInitialize(memory);
     
@@ -58,10 +71,18 @@ GAME_INITIALIZE(GameInitialize)
     MemoryArena remainingArena = InitMemoryArena(pastGameStateAddress, FIXED_SIZE_STORAGE_SIZE - sizeof(GameState), "GameArena");
 
     gameState->overlayMode = overlayMode_none;
+    gameState->fixedTimestepAccumulator = 0.0f;
     gameState->scene = Scene(&remainingArena);
     Scene &scene = gameState->scene;
 
+    MemoryTelemetry *telemetry = memory.memoryTelemetry;
+    RegisterTelemetryArena(telemetry, &scene.freeIndices.arena, "Entity Free Indices", memoryTag_ecs);
+    RegisterTelemetryArena(telemetry, &scene.systemsArena, "Systems", memoryTag_ecs);
+    RegisterTelemetryArena(telemetry, &scene.componentPoolsArena, "Component Pools", memoryTag_ecs);
+    SetMemoryBudget(telemetry, memoryTag_physics, PHYSICS_HEAP_BUDGET);
+
     CreateComponentPools(scene);
+    SaveComponentLayouts(scene);
 
     s32 rv = LoadMap(scene, mapName);
     if (rv != 0)
@@ -98,7 +119,7 @@ GAME_INITIALIZE(GameInitialize)
 
         #if !SKL_NO_DEFAULT_PHYSICS_SYSTEM
         b32 physicsSystemFirstTimeInitialize = true;
-        sklPhysicsSystem->Initialize(physicsSystemFirstTimeInitialize);
+        sklPhysicsSystem->Initialize(physicsSystemFirstTimeInitialize, &scene);
         #endif
 
         FindCamera(*gameState);
@@ -120,12 +141,33 @@ GAME_LOAD(GameLoad)
     assetUtils = memory.platformAPI.assetUtils;
     renderer = memory.platformAPI.renderer;
     allocator = memory.platformAPI.allocator;
+    globalMemoryTelemetry = memory.memoryTelemetry;
+    globalFrameStats = memory.frameStats;
+    globalJobScheduler = memory.jobScheduler;
+
+    #if SKL_ALLOCATION_GUARD
+    InitAllocationGuard(memory.allocationGuard);
+    ResetAllocationGuardWarmup(memory.allocationGuard);
+    #endif
 
     #if SKL_INTERNAL
     globalDebugState = memory.debugState;
+    globalDebugProfiler = memory.debugProfiler;
     #endif
 
     RegisterComponents(editor);
+    LoadInputActionMap(&globalInputActionMap);
+
+    // NOTE(marvin): The pools were filled in by the previous game
+    // module, which may have laid the components out differently.
+    if (gameInitialized)
+    {
+        GameState *gameState = static_cast<GameState *>(memory.fixedSizeStorage);
+        if (ComponentLayoutsChanged(gameState->scene))
+        {
+            MigrateComponentPools(gameState->scene);
+        }
+    }
 
     DebugUpdate(memory);
 
@@ -150,7 +192,7 @@ GAME_GET_PERSISTENT_DLL_PATHS(GameGetPersistentDLLPaths)
     OnGameGetPersistentDLLPaths(pathBuffer);
 }
 
-local void LogDebugRecords();
+local void LogDebugRecords(GameMemory &memory);
 
 extern "C"
 #if defined(_WIN32) || defined(_WIN64)
@@ -158,31 +200,86 @@ __declspec(dllexport)
 #endif
 GAME_UPDATE_AND_RENDER(GameUpdateAndRender)
 {
+    // NOTE(marvin): Steady state frames shouldn't touch the heap,
+    // everything from here until the guard is disarmed is reported.
+    #if SKL_ALLOCATION_GUARD
+    ArmAllocationGuard(memory.allocationGuard);
+    #endif
+
     DebugUpdate(memory);
+
+    #if SKL_INTERNAL
+    if (globalDebugProfiler)
+    {
+        ProfilerBeginFrame(globalDebugProfiler);
+    }
+    #endif
     
     ASSERT(sizeof(GameState) <= FIXED_SIZE_STORAGE_SIZE);
     GameState *gameState = static_cast<GameState *>(memory.fixedSizeStorage);
     Scene &scene = gameState->scene;
 
-    // TODO(marvin): Use the interpolation technique.
+    // NOTE(marvin): A loop may have just restored memory that was
+    // recorded with an older game module.
+    if (ComponentLayoutsChanged(scene))
+    {
+        MigrateComponentPools(scene);
+    }
 
     // NOTE(marvin): Putting RenderOverlay above the above systems so
     // that EditorSystem's GUI overlay will go below the tabs.
-    RenderOverlay(*gameState);
+    if (!memory.skipRender)
+    {
+        RenderOverlay(*gameState);
+    }
 
-    f32 remainingFrameTime = frameTime;
-    while (remainingFrameTime > 0.0f)
+    FrameStats *frameStats = memory.frameStats;
+
+    #if !SKL_NO_DEFAULT_PHYSICS_SYSTEM
+    SKLPhysicsSystem *sklPhysicsSystem = static_cast<SKLPhysicsSystem *>(memory.sklPhysicsSystem);
+    if (sklPhysicsSystem)
     {
-        f32 deltaTime = Minimum(remainingFrameTime, FIXED_TIMESTEP_DELTA_TIME);
-        scene.UpdateSemifixedTimestepSystems(&input, deltaTime);
-        remainingFrameTime -= deltaTime;
+        sklPhysicsSystem->BeginFrame();
     }
+    #endif
 
+    BeginFramePhase(frameStats, framePhase_fixed);
+    gameState->fixedTimestepAccumulator += frameTime;
+    constexpr f32 maxAccumulatedTime = MAX_FIXED_TIMESTEPS_PER_FRAME * FIXED_TIMESTEP_DELTA_TIME;
+    if (gameState->fixedTimestepAccumulator > maxAccumulatedTime)
+    {
+        gameState->fixedTimestepAccumulator = maxAccumulatedTime;
+    }
+    while (gameState->fixedTimestepAccumulator >= FIXED_TIMESTEP_DELTA_TIME)
+    {
+        scene.UpdateSemifixedTimestepSystems(&input, FIXED_TIMESTEP_DELTA_TIME);
+        gameState->fixedTimestepAccumulator -= FIXED_TIMESTEP_DELTA_TIME;
+        ++frameStats->fixedStepCount;
+    }
+    EndFramePhase(frameStats, framePhase_fixed);
+
+    BeginFramePhase(frameStats, framePhase_variable);
     scene.UpdateVariableTimestepSystems(&input, frameTime);
+    EndFramePhase(frameStats, framePhase_variable);
     
-    DrawScene(*gameState, input, frameTime);
+    if (!memory.skipRender)
+    {
+        // NOTE(marvin): DrawScene takes the render submit out of its
+        // own phase, see DrawScene.
+        // NOTE(marvin): The steps lag behind the frame by the time that
+        // is left in the accumulator, so what is drawn is that far from
+        // the step before the last one to the last one.
+        f32 blendFactor = gameState->fixedTimestepAccumulator / FIXED_TIMESTEP_DELTA_TIME;
+        BeginFramePhase(frameStats, framePhase_draw);
+        DrawScene(*gameState, input, frameTime, blendFactor);
+        EndFramePhase(frameStats, framePhase_draw);
+    }
+
+    LogDebugRecords(memory);
 
-    LogDebugRecords();
+    #if SKL_ALLOCATION_GUARD
+    DisarmAllocationGuard(memory.allocationGuard);
+    #endif
 }
 
 // NOTE(marvin): Our logger doesn't have string format...
@@ -196,30 +293,82 @@ GAME_UPDATE_AND_RENDER(GameUpdateAndRender)
 // number of all the timed blocks that it has seen.
 DebugRecord debugRecordArray[__COUNTER__];
 
-local void LogDebugRecords()
-{
 #if SKL_INTERNAL
-    u32 debugRecordsCount = ArrayCount(debugRecordArray);
+extern DebugRecord debugSystemRecordArray[MAX_SYSTEMS * 2];
+
+// Produces the hit count, and the cycle count through cycleCount, of
+// the record since the last call, resetting it.
+// NOTE(marvin): The two are exchanged one after the other, so a block
+// that ends in between counts its cycles towards this frame and its
+// hit towards the next one.
+local u64 ExchangeDebugRecord(DebugRecord *debugRecord, u64 *cycleCount)
+{
+    *cycleCount = AtomicExchangeU64(&debugRecord->cycleCount, 0);
+    u64 hitCount = AtomicExchangeU64(&debugRecord->hitCount, 0);
+    return hitCount;
+}
+
+local void LogDebugRecordArray(DebugRecord *debugRecords, u32 debugRecordsCount, DebugFrameSnapshot *snapshot, b32 shouldPrint)
+{
     for (u32 i = 0;
          i < debugRecordsCount;
          ++i)
     {
-        DebugRecord *debugRecord = debugRecordArray + i;
-
-        u64 hitCount_cycleCount = AtomicExchangeU64(&debugRecord->hitCount_cycleCount, 0);
-        u32 hitCount = (u32)(hitCount_cycleCount >> 32);
-        u32 cycleCount = (u32)(hitCount_cycleCount & 0xFFFFFFFF);
-
-        printf("%s:%s:%u %ucy (%uh) %ucy/h\n",
-               debugRecord->blockName,
-               debugRecord->fileName,
-               debugRecord->lineNumber,
-               cycleCount,
-               hitCount,
-               cycleCount / hitCount);
+        DebugRecord *debugRecord = debugRecords + i;
+
+        u64 cycleCount;
+        u64 hitCount = ExchangeDebugRecord(debugRecord, &cycleCount);
+        if (hitCount == 0)
+        {
+            continue;
+        }
+
+        if (snapshot)
+        {
+            if (snapshot->recordCount < MAX_DEBUG_FRAME_RECORDS)
+            {
+                DebugFrameRecord *frameRecord = snapshot->records + snapshot->recordCount++;
+                frameRecord->blockName = debugRecord->blockName;
+                frameRecord->fileName = debugRecord->fileName;
+                frameRecord->lineNumber = debugRecord->lineNumber;
+                frameRecord->hitCount = hitCount;
+                frameRecord->cycleCount = cycleCount;
+            }
+        }
+        else if (shouldPrint)
+        {
+            printf("%s:%s:%u %llucy (%lluh) %llucy/h\n",
+                   debugRecord->blockName,
+                   debugRecord->fileName,
+                   debugRecord->lineNumber,
+                   (unsigned long long)cycleCount,
+                   (unsigned long long)hitCount,
+                   (unsigned long long)(cycleCount / hitCount));
+        }
     }
+}
+#endif
+
+local void LogDebugRecords(GameMemory &memory)
+{
+#if SKL_INTERNAL
+    DebugFrameSnapshot *snapshot = memory.debugFrameSnapshot;
+    if (snapshot)
+    {
+        snapshot->recordCount = 0;
+    }
+
+    // NOTE(marvin): With a profiler, the timed blocks are in its tab
+    // of the overlay instead of the console.
+    b32 shouldPrint = !globalDebugProfiler;
+    u32 debugRecordsCount = ArrayCount(debugRecordArray);
+    LogDebugRecordArray(debugRecordArray, debugRecordsCount, snapshot, shouldPrint);
+
+    // NOTE(marvin): Every system is timed, printing all of them each
+    // frame would drown out the console, so they only go to the snapshot.
+    LogDebugRecordArray(debugSystemRecordArray, ArrayCount(debugSystemRecordArray), snapshot, false);
 
-    if (debugRecordsCount > 1)
+    if (!snapshot && shouldPrint && debugRecordsCount > 1)
     {
         puts("");
     }
@@ -5,6 +5,22 @@
 #define REGISTRY
 #include <engine_components.h>
 
+template <>
+void RemapComponentPointers<Transform3D>(void* address, ComponentPoolRemap* remap)
+{
+    Transform3D* comp = static_cast<Transform3D*>(address);
+    comp->parent = RemapPoolPointer(remap, comp->parent);
+
+    // NOTE(marvin): The set is hashed on the pointers, so it is
+    // rebuilt rather than updated in place.
+    std::unordered_set<Transform3D*> children;
+    for (Transform3D* child : comp->children)
+    {
+        children.insert(RemapPoolPointer(remap, child));
+    }
+    comp->children = std::move(children);
+}
+
 template <>
 s32 WriteComponent<Transform3D>(Scene &scene, EntityID entity, DataEntry* compData)
 {
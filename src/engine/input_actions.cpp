@@ -0,0 +1,140 @@
+#include <cstdio>
+#include <cstring>
+
+#include <input_actions.h>
+
+InputActionMap globalInputActionMap;
+
+// NOTE(marvin): In the order of InputAction.
+file_global const char *defaultBindingNames[inputAction_count][MAX_BINDINGS_PER_INPUT_ACTION] =
+{
+    { "W" },
+    { "S" },
+    { "D" },
+    { "A" },
+    { "Mouse 3" },
+    { "Mouse 1" },
+    { "S" },
+    { "Left Ctrl", "Right Ctrl" },
+};
+
+struct NamedKeyCode
+{
+    const char *name;
+    KeyCode keyCode;
+};
+
+file_global NamedKeyCode namedKeyCodes[] =
+{
+    { "Return",      keyCode_return },
+    { "Escape",      keyCode_escape },
+    { "Backspace",   keyCode_backspace },
+    { "Tab",         keyCode_tab },
+    { "Space",       keyCode_space },
+    { "Right",       keyCode_right },
+    { "Left",        keyCode_left },
+    { "Down",        keyCode_down },
+    { "Up",          keyCode_up },
+    { "Left Ctrl",   keyCode_leftCtrl },
+    { "Left Shift",  keyCode_leftShift },
+    { "Left Alt",    keyCode_leftAlt },
+    { "Right Ctrl",  keyCode_rightCtrl },
+    { "Right Shift", keyCode_rightShift },
+    { "Right Alt",   keyCode_rightAlt },
+};
+
+b32 ResolveInputBinding(const char *name, InputBinding *binding)
+{
+    siz length = strlen(name);
+
+    if (length == 1 && name[0] >= 'A' && name[0] <= 'Z')
+    {
+        *binding = { inputDevice_keyboard, static_cast<u32>(keyCode_a + (name[0] - 'A')) };
+        return true;
+    }
+
+    // NOTE(marvin): HID puts 0 after 9.
+    if (length == 1 && name[0] >= '1' && name[0] <= '9')
+    {
+        *binding = { inputDevice_keyboard, static_cast<u32>(keyCode_1 + (name[0] - '1')) };
+        return true;
+    }
+    if (length == 1 && name[0] == '0')
+    {
+        *binding = { inputDevice_keyboard, keyCode_0 };
+        return true;
+    }
+
+    u32 number;
+    if (sscanf(name, "F%u", &number) == 1 && number >= 1 && number <= 12)
+    {
+        *binding = { inputDevice_keyboard, keyCode_f1 + (number - 1) };
+        return true;
+    }
+    if (sscanf(name, "Mouse %u", &number) == 1 && number < mouseButton_count)
+    {
+        *binding = { inputDevice_mouse, number };
+        return true;
+    }
+
+    for (u32 index = 0; index < ArrayCount(namedKeyCodes); ++index)
+    {
+        if (strcmp(namedKeyCodes[index].name, name) == 0)
+        {
+            *binding = { inputDevice_keyboard, static_cast<u32>(namedKeyCodes[index].keyCode) };
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void LoadInputActionMap(InputActionMap *map)
+{
+    *map = {};
+    for (u32 action = 0; action < inputAction_count; ++action)
+    {
+        for (u32 index = 0; index < MAX_BINDINGS_PER_INPUT_ACTION; ++index)
+        {
+            const char *name = defaultBindingNames[action][index];
+            if (name && !ResolveInputBinding(name, &map->bindings[action][index]))
+            {
+                LOG_ERROR("Unknown key name in input binding: " << name);
+            }
+        }
+    }
+}
+
+local b32 IsActionDown(const InputButtons *buttons, InputAction action)
+{
+    ASSERT(action < inputAction_count);
+    InputBinding *bindings = globalInputActionMap.bindings[action];
+    for (u32 index = 0; index < MAX_BINDINGS_PER_INPUT_ACTION; ++index)
+    {
+        InputBinding binding = bindings[index];
+        if ((binding.device == inputDevice_keyboard && IsKeyDown(buttons, binding.code)) ||
+            (binding.device == inputDevice_mouse && IsMouseButtonDown(buttons, binding.code)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+b32 OnPress(GameInput *input, InputAction action)
+{
+    b32 result = IsActionDown(&input->buttonsDownThisFrame, action) && !IsActionDown(&input->buttonsDownPrevFrame, action);
+    return result;
+}
+
+b32 OnRelease(GameInput *input, InputAction action)
+{
+    b32 result = !IsActionDown(&input->buttonsDownThisFrame, action) && IsActionDown(&input->buttonsDownPrevFrame, action);
+    return result;
+}
+
+b32 OnHold(GameInput *input, InputAction action)
+{
+    b32 result = IsActionDown(&input->buttonsDownThisFrame, action);
+    return result;
+}
@@ -3,6 +3,299 @@
 #include <debug.h>
 #include <imgui.h>
 #include <engine.h>
+#include <job_scheduler.h>
+
+local void RenderByteCount(u64 bytes)
+{
+    if (bytes >= Megabytes(1))
+    {
+        ImGui::Text("%.2f MB", static_cast<f64>(bytes) / static_cast<f64>(Megabytes(1)));
+    }
+    else if (bytes >= Kilobytes(1))
+    {
+        ImGui::Text("%.2f KB", static_cast<f64>(bytes) / static_cast<f64>(Kilobytes(1)));
+    }
+    else
+    {
+        ImGui::Text("%llu B", (unsigned long long)bytes);
+    }
+}
+
+local void RenderTelemetry(MemoryTelemetry *telemetry)
+{
+    ImGuiTableFlags tableFlags =
+        ImGuiTableFlags_BordersV |
+        ImGuiTableFlags_BordersOuterH |
+        ImGuiTableFlags_Resizable |
+        ImGuiTableFlags_RowBg |
+        ImGuiTableFlags_NoBordersInBody;
+
+    if (ImGui::Button("Dump CSV"))
+    {
+        WriteMemoryTelemetryCSV(telemetry, SKL_BASE_PATH "/memory_telemetry.csv");
+    }
+
+    if (ImGui::BeginTable("Telemetry Heap Table", 7, tableFlags))
+    {
+        ImGui::TableSetupColumn("SUBSYSTEM");
+        ImGui::TableSetupColumn("HEAP LIVE");
+        ImGui::TableSetupColumn("HEAP PEAK");
+        ImGui::TableSetupColumn("ALLOCS/FRAME");
+        ImGui::TableSetupColumn("BYTES/FRAME");
+        ImGui::TableSetupColumn("BUDGET");
+        ImGui::TableSetupColumn("ARENA USED / PEAK / SIZE");
+        ImGui::TableHeadersRow();
+
+        for (u32 tagIndex = 0; tagIndex < memoryTag_count; ++tagIndex)
+        {
+            MemoryTag tag = static_cast<MemoryTag>(tagIndex);
+            MemoryTagStats *stats = telemetry->tags + tagIndex;
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            if (stats->overBudget)
+            {
+                ImGui::TextColored({1.0f, 0.3f, 0.3f, 1.0f}, "%s (over budget)", GetMemoryTagName(tag));
+            }
+            else
+            {
+                ImGui::Text("%s", GetMemoryTagName(tag));
+            }
+            ImGui::TableNextColumn();
+            RenderByteCount(stats->bytesLive);
+            ImGui::TableNextColumn();
+            RenderByteCount(stats->bytesPeak);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", (unsigned long long)stats->allocationsLastFrame);
+            ImGui::TableNextColumn();
+            RenderByteCount(stats->bytesLastFrame);
+            ImGui::TableNextColumn();
+            if (stats->budget)
+            {
+                RenderByteCount(stats->budget);
+            }
+            else
+            {
+                ImGui::TextDisabled("--");
+            }
+            ImGui::TableNextColumn();
+            siz used, peakUsed, size;
+            GetTelemetryArenaTotals(telemetry, tag, &used, &peakUsed, &size);
+            if (size)
+            {
+                ImGui::Text("%zu / %zu / %zu", used, peakUsed, size);
+            }
+            else
+            {
+                ImGui::TextDisabled("--");
+            }
+        }
+
+        ImGui::EndTable();
+    }
+
+    if (ImGui::BeginTable("Telemetry Arena Table", 6, tableFlags))
+    {
+        ImGui::TableSetupColumn("ARENA");
+        ImGui::TableSetupColumn("SUBSYSTEM");
+        ImGui::TableSetupColumn("USED");
+        ImGui::TableSetupColumn("PEAK");
+        ImGui::TableSetupColumn("PEAK PERCENT");
+        ImGui::TableSetupColumn("SIZE");
+        ImGui::TableHeadersRow();
+
+        for (u32 i = 0; i < telemetry->arenaCount; ++i)
+        {
+            MemoryTelemetryArena *entry = telemetry->arenas + i;
+            MemoryArena *arena = entry->arena;
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", entry->name);
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", GetMemoryTagName(entry->tag));
+            ImGui::TableNextColumn();
+            RenderByteCount(arena->used);
+            ImGui::TableNextColumn();
+            RenderByteCount(arena->peakUsed);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f%%", 100.0f * static_cast<f32>(arena->peakUsed) / static_cast<f32>(arena->size));
+            ImGui::TableNextColumn();
+            RenderByteCount(arena->size);
+        }
+
+        ImGui::EndTable();
+    }
+}
+
+local ImU32 GetFramePhaseColour(FramePhase phase)
+{
+    local_persist ImU32 colours[framePhase_count] =
+    {
+        IM_COL32(230, 200, 80, 255),
+        IM_COL32(90, 170, 230, 255),
+        IM_COL32(120, 210, 130, 255),
+        IM_COL32(200, 120, 220, 255),
+        IM_COL32(240, 140, 90, 255),
+    };
+
+    ASSERT(phase < framePhase_count);
+    return colours[phase];
+}
+
+local void RenderFramePercentilesRow(const char *name, FramePercentiles *percentiles)
+{
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    ImGui::Text("%s", name);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f", percentiles->p50);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f", percentiles->p95);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f", percentiles->p99);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f", percentiles->max);
+}
+
+local void RenderFrameTimes(FrameStats *stats)
+{
+    ImGuiTableFlags tableFlags =
+        ImGuiTableFlags_BordersV |
+        ImGuiTableFlags_BordersOuterH |
+        ImGuiTableFlags_Resizable |
+        ImGuiTableFlags_RowBg |
+        ImGuiTableFlags_NoBordersInBody;
+
+    bool paused = stats->paused;
+    if (ImGui::Checkbox("Pause", &paused))
+    {
+        stats->paused = paused;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Dump CSV"))
+    {
+        WriteFrameStatsCSV(stats, SKL_BASE_PATH "/frame_times.csv");
+    }
+
+    // NOTE(marvin): A hitch is a frame that took this many times the median.
+    local_persist f32 hitchFactor = 2.0f;
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(200.0f);
+    ImGui::SliderFloat("Hitch Factor", &hitchFactor, 1.25f, 5.0f, "%.2fx");
+
+    FrameStatsSummary summary;
+    SummarizeFrameStats(stats, &summary);
+    if (!summary.frameCount)
+    {
+        ImGui::TextDisabled("No frames yet.");
+        return;
+    }
+
+    f32 hitchMs = hitchFactor * summary.frame.p50;
+    u32 hitchCount = 0;
+    for (u32 framesAgo = 0; framesAgo < summary.frameCount; ++framesAgo)
+    {
+        if (GetFrameStatsEntry(stats, framesAgo)->frameMs > hitchMs)
+        {
+            ++hitchCount;
+        }
+    }
+    FrameStatsEntry *latest = GetFrameStatsEntry(stats, 0);
+    ImGui::Text("%.3f ms/frame (FPS: %.1f), %u hitches over %.3f ms in the last %u frames",
+                latest->frameMs, latest->frameMs > 0.0f ? 1000.0f / latest->frameMs : 0.0f,
+                hitchCount, hitchMs, summary.frameCount);
+
+    // NOTE(marvin): The latest frames, one bar each, stacked by phase
+    // from the bottom. Whatever is left of the frame is the platform's,
+    // outside of the phases.
+    f32 graphHeight = 160.0f;
+    f32 barWidth = 2.0f;
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    f32 graphWidth = ImGui::GetContentRegionAvail().x;
+    u32 barCount = Minimum(summary.frameCount, static_cast<u32>(graphWidth / barWidth));
+    f32 scaleMs = Maximum(summary.frame.max, 1.0f);
+    f32 msToPixels = graphHeight / scaleMs;
+
+    ImDrawList *drawList = ImGui::GetWindowDrawList();
+    drawList->AddRectFilled(origin, ImVec2(origin.x + graphWidth, origin.y + graphHeight), IM_COL32(30, 30, 30, 255));
+
+    s32 hoveredFramesAgo = -1;
+    for (u32 framesAgo = 0; framesAgo < barCount; ++framesAgo)
+    {
+        FrameStatsEntry *entry = GetFrameStatsEntry(stats, framesAgo);
+        f32 right = origin.x + graphWidth - framesAgo * barWidth;
+        f32 left = right - barWidth;
+        f32 bottom = origin.y + graphHeight;
+
+        drawList->AddRectFilled(ImVec2(left, bottom - entry->frameMs * msToPixels), ImVec2(right, bottom), IM_COL32(90, 90, 90, 255));
+        for (u32 phaseIndex = 0; phaseIndex < framePhase_count; ++phaseIndex)
+        {
+            f32 top = bottom - entry->phaseMs[phaseIndex] * msToPixels;
+            drawList->AddRectFilled(ImVec2(left, top), ImVec2(right, bottom), GetFramePhaseColour(static_cast<FramePhase>(phaseIndex)));
+            bottom = top;
+        }
+
+        if (entry->frameMs > hitchMs)
+        {
+            drawList->AddRectFilled(ImVec2(left, origin.y), ImVec2(right, origin.y + 6.0f), IM_COL32(255, 60, 60, 255));
+        }
+
+        if (ImGui::IsMouseHoveringRect(ImVec2(left, origin.y), ImVec2(right, origin.y + graphHeight)))
+        {
+            hoveredFramesAgo = static_cast<s32>(framesAgo);
+        }
+    }
+
+    f32 percentileMs[] = { summary.frame.p50, summary.frame.p95, summary.frame.p99 };
+    const char *percentileNames[] = { "p50", "p95", "p99" };
+    for (u32 percentileIndex = 0; percentileIndex < ArrayCount(percentileMs); ++percentileIndex)
+    {
+        f32 y = origin.y + graphHeight - percentileMs[percentileIndex] * msToPixels;
+        drawList->AddLine(ImVec2(origin.x, y), ImVec2(origin.x + graphWidth, y), IM_COL32(255, 255, 255, 120));
+        drawList->AddText(ImVec2(origin.x + 2.0f, y - ImGui::GetTextLineHeight()), IM_COL32(255, 255, 255, 200), percentileNames[percentileIndex]);
+    }
+
+    if (hoveredFramesAgo >= 0)
+    {
+        FrameStatsEntry *entry = GetFrameStatsEntry(stats, static_cast<u64>(hoveredFramesAgo));
+        ImGui::BeginTooltip();
+        ImGui::Text("%d frames ago: %.3f ms, %u fixed steps", hoveredFramesAgo, entry->frameMs, entry->fixedStepCount);
+        for (u32 phaseIndex = 0; phaseIndex < framePhase_count; ++phaseIndex)
+        {
+            ImGui::Text("%s: %.3f ms", GetFramePhaseName(static_cast<FramePhase>(phaseIndex)), entry->phaseMs[phaseIndex]);
+        }
+        ImGui::EndTooltip();
+    }
+
+    ImGui::Dummy(ImVec2(graphWidth, graphHeight));
+
+    for (u32 phaseIndex = 0; phaseIndex < framePhase_count; ++phaseIndex)
+    {
+        FramePhase phase = static_cast<FramePhase>(phaseIndex);
+        ImGui::TextColored(ImGui::ColorConvertU32ToFloat4(GetFramePhaseColour(phase)), "%s", GetFramePhaseName(phase));
+        ImGui::SameLine();
+    }
+    ImGui::TextDisabled("Other");
+
+    if (ImGui::BeginTable("Frame Times Table", 5, tableFlags))
+    {
+        ImGui::TableSetupColumn("PHASE (MS)");
+        ImGui::TableSetupColumn("P50");
+        ImGui::TableSetupColumn("P95");
+        ImGui::TableSetupColumn("P99");
+        ImGui::TableSetupColumn("MAX");
+        ImGui::TableHeadersRow();
+
+        RenderFramePercentilesRow("Frame", &summary.frame);
+        for (u32 phaseIndex = 0; phaseIndex < framePhase_count; ++phaseIndex)
+        {
+            RenderFramePercentilesRow(GetFramePhaseName(static_cast<FramePhase>(phaseIndex)), summary.phases + phaseIndex);
+        }
+
+        ImGui::EndTable();
+    }
+}
 
 #if SKL_DEBUG_MEMORY_VIEWER
 
@@ -37,7 +330,7 @@ local void RenderSizesViewerRowRegular(DebugRegularAllocation *regular, const ch
     ImGui::TableNextColumn();
     ImGui::TextDisabled("--");
     ImGui::TableNextColumn();
-    ImGui::TextDisabled("--");
+    ImGui::Text("%u", regular->count);
     ImGui::TableNextColumn();
     ImGui::TextDisabled("--");
     ImGui::TableNextColumn();
@@ -68,6 +361,379 @@ local void RenderSizesViewerAllocations(DebugAllocations *allocations)
     }
 }
 
+local void RenderMemoryViewerMode(DebugState *debugState)
+{
+    local_persist const char *modeNames[] = { "Full", "Call Sites", "Sampled" };
+    // NOTE(marvin): Full mode can't be gone back to, see DebugMemoryViewerMode.
+    s32 firstMode = (debugState->mode == debugMemoryViewerMode_full) ? 0 : 1;
+    s32 comboIndex = debugState->mode - firstMode;
+    if (ImGui::Combo("Mode", &comboIndex, modeNames + firstMode, ArrayCount(modeNames) - firstMode))
+    {
+        DebugSetMemoryViewerMode(debugState, static_cast<DebugMemoryViewerMode>(comboIndex + firstMode));
+    }
+
+    if (debugState->mode == debugMemoryViewerMode_sampled)
+    {
+        s32 sampleInterval = debugState->sampleInterval;
+        if (ImGui::InputInt("Sample Interval", &sampleInterval) && sampleInterval > 0)
+        {
+            debugState->sampleInterval = sampleInterval;
+            debugState->sampleCountdown = sampleInterval;
+        }
+    }
+    else if (debugState->mode != debugMemoryViewerMode_full)
+    {
+        ImGui::TextDisabled("The tree of allocations is frozen, only the used of the arenas is updated.");
+    }
+}
+
+local void RenderCallSites(DebugIDTable *debugIDs, ImGuiTableFlags tableFlags)
+{
+    if (ImGui::BeginTable("Call Sites Table", 3, tableFlags))
+    {
+        ImGui::TableSetupColumn("PUSHES");
+        ImGui::TableSetupColumn("MEMORY");
+        ImGui::TableSetupColumn("DEBUG ID");
+        ImGui::TableHeadersRow();
+
+        for (u32 index = 0; index < debugIDs->capacity; ++index)
+        {
+            DebugIDEntry *entry = debugIDs->entries + index;
+            if (!entry->debugID || !entry->pushCount)
+            {
+                continue;
+            }
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", (unsigned long long)entry->pushCount);
+            ImGui::TableNextColumn();
+            RenderByteCount(entry->pushBytes);
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", entry->debugID);
+        }
+
+        ImGui::EndTable();
+    }
+}
+
+#endif
+
+#if SKL_INTERNAL
+
+constexpr u32 MAX_PROFILER_BARS = 16384;
+constexpr u32 MAX_PROFILER_DEPTH = 32;
+
+struct ProfilerBar
+{
+    u64 begin;
+    u64 end;
+    u32 siteIndex;
+    u16 threadIndex;
+    u16 depth;
+};
+
+// NOTE(marvin): Pairs up the begin and end events of each thread in
+// the history, keeping the blocks that overlap the given frame. The
+// history is walked from its oldest event, so that the depth of a
+// block that began before the frame is still known, up to the given
+// history index, past which the blocks are of later frames.
+local u32 CollectProfilerBars(DebugProfiler *profiler, u64 frameBegin, u64 frameEnd, u64 historyEndIndex,
+                              ProfilerBar *bars, u32 *threadDepths)
+{
+    u32 stackDepths[MAX_PROFILER_THREADS] = {};
+    ProfilerHistoryEvent *stacks[MAX_PROFILER_THREADS][MAX_PROFILER_DEPTH];
+    u32 barCount = 0;
+
+    u64 historyWriteIndex = profiler->historyWriteIndex;
+    u64 historyReadIndex = historyWriteIndex > PROFILER_HISTORY_EVENT_COUNT ? historyWriteIndex - PROFILER_HISTORY_EVENT_COUNT : 0;
+    historyEndIndex = Minimum(historyEndIndex, historyWriteIndex);
+    for (u64 historyIndex = historyReadIndex; historyIndex < historyEndIndex; ++historyIndex)
+    {
+        ProfilerHistoryEvent *event = profiler->history + (historyIndex & (PROFILER_HISTORY_EVENT_COUNT - 1));
+        u32 threadIndex = event->threadIndex;
+        u32 &stackDepth = stackDepths[threadIndex];
+        if (event->type == profilerEventType_begin)
+        {
+            if (stackDepth < MAX_PROFILER_DEPTH)
+            {
+                stacks[threadIndex][stackDepth] = event;
+            }
+            ++stackDepth;
+            continue;
+        }
+
+        // NOTE(marvin): An end whose begin was dropped, or is older
+        // than the history.
+        if (stackDepth == 0)
+        {
+            continue;
+        }
+        --stackDepth;
+
+        if (stackDepth >= MAX_PROFILER_DEPTH)
+        {
+            continue;
+        }
+        ProfilerHistoryEvent *beginEvent = stacks[threadIndex][stackDepth];
+        if (beginEvent->siteIndex != event->siteIndex ||
+            event->timestamp < frameBegin || beginEvent->timestamp >= frameEnd ||
+            barCount >= MAX_PROFILER_BARS)
+        {
+            continue;
+        }
+
+        ProfilerBar *bar = bars + barCount++;
+        bar->begin = beginEvent->timestamp;
+        bar->end = event->timestamp;
+        bar->siteIndex = event->siteIndex;
+        bar->threadIndex = static_cast<u16>(threadIndex);
+        bar->depth = static_cast<u16>(stackDepth);
+        threadDepths[threadIndex] = Maximum(threadDepths[threadIndex], stackDepth + 1);
+    }
+    return barCount;
+}
+
+#if SKL_PERF_COUNTERS
+
+local f64 GetPerfCounterRatio(ProfilerSiteCounters *counters, PerfCounter numerator, PerfCounter denominator, f64 scale)
+{
+    u64 denominatorValue = counters->values[denominator];
+    f64 result = denominatorValue ? scale * counters->values[numerator] / static_cast<f64>(denominatorValue) : 0.0;
+    return result;
+}
+
+// NOTE(marvin): The misses are per thousand instructions, so that
+// blocks that do different amounts of work can be compared.
+local void RenderPerfCounters(DebugProfiler *profiler)
+{
+    if (!ImGui::CollapsingHeader("Hardware Counters"))
+    {
+        return;
+    }
+
+    if (profiler->rings[0].perfCounters.state == perfCounterGroupState_failed)
+    {
+        ImGui::TextDisabled("The counters couldn't be opened, see the log.");
+        return;
+    }
+
+    ImGuiTableFlags tableFlags =
+        ImGuiTableFlags_BordersV |
+        ImGuiTableFlags_BordersOuterH |
+        ImGuiTableFlags_Resizable |
+        ImGuiTableFlags_RowBg |
+        ImGuiTableFlags_NoBordersInBody;
+
+    if (ImGui::BeginTable("Profiler Counters Table", 7, tableFlags))
+    {
+        ImGui::TableSetupColumn("BLOCK");
+        ImGui::TableSetupColumn("HITS");
+        ImGui::TableSetupColumn("CYCLES");
+        ImGui::TableSetupColumn("IPC");
+        ImGui::TableSetupColumn("L1D MISSES/KI");
+        ImGui::TableSetupColumn("LLC MISSES/KI");
+        ImGui::TableSetupColumn("BRANCH MISSES/KI");
+        ImGui::TableHeadersRow();
+
+        u32 siteCount = static_cast<u32>(profiler->siteCount);
+        for (u32 siteIndex = 0; siteIndex < siteCount; ++siteIndex)
+        {
+            ProfilerSiteCounters *counters = profiler->lastFrameSiteCounters + siteIndex;
+            if (!counters->hitCount)
+            {
+                continue;
+            }
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", profiler->sites[siteIndex].blockName);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", (unsigned long long)counters->hitCount);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", (unsigned long long)counters->values[perfCounter_cycles]);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", GetPerfCounterRatio(counters, perfCounter_instructions, perfCounter_cycles, 1.0));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", GetPerfCounterRatio(counters, perfCounter_l1dMisses, perfCounter_instructions, 1000.0));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", GetPerfCounterRatio(counters, perfCounter_llcMisses, perfCounter_instructions, 1000.0));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", GetPerfCounterRatio(counters, perfCounter_branchMisses, perfCounter_instructions, 1000.0));
+        }
+
+        ImGui::EndTable();
+    }
+}
+
+#endif
+
+local void RenderProfiler(DebugProfiler *profiler)
+{
+    if (!profiler)
+    {
+        ImGui::TextDisabled("The platform didn't provide a profiler.");
+        return;
+    }
+
+    bool paused = profiler->paused;
+    if (ImGui::Checkbox("Pause", &paused))
+    {
+        profiler->paused = paused;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Export Chrome Trace"))
+    {
+        WriteProfilerChromeTrace(profiler, SKL_BASE_PATH "/profiler_trace.json");
+    }
+
+    u32 ringCount = static_cast<u32>(Minimum(profiler->ringCount, (u64)MAX_PROFILER_THREADS));
+    u64 droppedCount = 0;
+    for (u32 ringIndex = 0; ringIndex < ringCount; ++ringIndex)
+    {
+        droppedCount += profiler->rings[ringIndex].droppedCount;
+    }
+    ImGui::SameLine();
+    ImGui::Text("%u threads, %llu events dropped", ringCount, (unsigned long long)droppedCount);
+
+    // NOTE(marvin): Only requested once the slider is let go of, as
+    // every change restarts the workers.
+    if (globalJobScheduler)
+    {
+        local_persist s32 workerCount = 0;
+        local_persist b32 editing = false;
+        if (!editing)
+        {
+            workerCount = static_cast<s32>(GetJobWorkerCount(globalJobScheduler));
+        }
+        ImGui::SliderInt("Job Workers", &workerCount, 0, MAX_JOB_WORKERS);
+        editing = ImGui::IsItemActive();
+        if (ImGui::IsItemDeactivatedAfterEdit())
+        {
+            globalJobScheduler->requestedWorkerCount = static_cast<u32>(workerCount);
+        }
+    }
+
+#if SKL_PERF_COUNTERS
+    RenderPerfCounters(profiler);
+#endif
+
+    // NOTE(marvin): The frame that is still being recorded isn't
+    // complete, so the latest one that can be shown is the one before.
+    u64 frameCount = Minimum(profiler->frameIndex, (u64)PROFILER_HISTORY_FRAME_COUNT - 1);
+    if (frameCount < 2)
+    {
+        return;
+    }
+    local_persist s32 framesAgo = 1;
+    ImGui::SliderInt("Frames Ago", &framesAgo, 1, static_cast<s32>(frameCount) - 1);
+    u64 frameIndex = profiler->frameIndex - static_cast<u64>(framesAgo);
+    u64 frameBegin = profiler->frameStartTimestamps[frameIndex & (PROFILER_HISTORY_FRAME_COUNT - 1)];
+    u64 frameEnd = profiler->frameStartTimestamps[(frameIndex + 1) & (PROFILER_HISTORY_FRAME_COUNT - 1)];
+    if (frameEnd <= frameBegin)
+    {
+        return;
+    }
+
+    f64 cyclesToMs = profiler->cpuTimerFrequency > 0.0 ? 1000.0 / profiler->cpuTimerFrequency : 0.0;
+    if (cyclesToMs > 0.0)
+    {
+        ImGui::Text("Frame %llu: %.3f ms", (unsigned long long)frameIndex, (frameEnd - frameBegin) * cyclesToMs);
+    }
+    else
+    {
+        ImGui::Text("Frame %llu: %llu cycles", (unsigned long long)frameIndex, (unsigned long long)(frameEnd - frameBegin));
+    }
+
+    // NOTE(marvin): Static so that a frame's worth of blocks doesn't
+    // have to go on the stack or the heap.
+    local_persist ProfilerBar bars[MAX_PROFILER_BARS];
+    u32 threadDepths[MAX_PROFILER_THREADS] = {};
+    // NOTE(marvin): A block that ends in the next frame is moved into
+    // the history with that frame's events, so the walk stops at the
+    // end of the next frame rather than at the end of this one.
+    u64 historyEndIndex = profiler->historyWriteIndex;
+    if (frameIndex + 2 <= profiler->frameIndex)
+    {
+        historyEndIndex = profiler->frameStartHistoryIndices[(frameIndex + 2) & (PROFILER_HISTORY_FRAME_COUNT - 1)];
+    }
+    u32 barCount = CollectProfilerBars(profiler, frameBegin, frameEnd, historyEndIndex, bars, threadDepths);
+
+    f32 rowHeight = ImGui::GetTextLineHeightWithSpacing();
+    f32 laneTops[MAX_PROFILER_THREADS];
+    f32 timelineHeight = 0.0f;
+    for (u32 ringIndex = 0; ringIndex < ringCount; ++ringIndex)
+    {
+        laneTops[ringIndex] = timelineHeight;
+        // NOTE(marvin): One row for the name of the thread.
+        timelineHeight += rowHeight * (threadDepths[ringIndex] + 1);
+    }
+
+    if (ImGui::BeginChild("Profiler Timeline", ImVec2(0.0f, Minimum(timelineHeight, 600.0f) + rowHeight), ImGuiChildFlags_Borders))
+    {
+        ImDrawList *drawList = ImGui::GetWindowDrawList();
+        ImVec2 origin = ImGui::GetCursorScreenPos();
+        f32 width = ImGui::GetContentRegionAvail().x;
+        f64 cyclesToPixels = width / static_cast<f64>(frameEnd - frameBegin);
+
+        for (u32 ringIndex = 0; ringIndex < ringCount; ++ringIndex)
+        {
+            ImVec2 labelPosition = ImVec2(origin.x, origin.y + laneTops[ringIndex]);
+            drawList->AddText(labelPosition, IM_COL32(200, 200, 200, 255), profiler->rings[ringIndex].threadName);
+        }
+
+        for (u32 barIndex = 0; barIndex < barCount; ++barIndex)
+        {
+            ProfilerBar *bar = bars + barIndex;
+            ProfilerSite *site = profiler->sites + bar->siteIndex;
+
+            u64 begin = Maximum(bar->begin, frameBegin);
+            u64 end = Minimum(bar->end, frameEnd);
+            f32 top = origin.y + laneTops[bar->threadIndex] + rowHeight * (bar->depth + 1);
+            ImVec2 min = ImVec2(origin.x + static_cast<f32>((begin - frameBegin) * cyclesToPixels), top);
+            ImVec2 max = ImVec2(origin.x + static_cast<f32>((end - frameBegin) * cyclesToPixels) + 1.0f, top + rowHeight - 1.0f);
+
+            // NOTE(marvin): The colour comes from the site, so a block
+            // keeps its colour from frame to frame.
+            u32 hue = (bar->siteIndex * 2654435761u) >> 24;
+            ImU32 colour = IM_COL32(80 + hue / 4, 120 + (hue * 7) % 100, 200 - hue / 4, 255);
+            drawList->AddRectFilled(min, max, colour);
+
+            if (ImGui::CalcTextSize(site->blockName).x < max.x - min.x)
+            {
+                drawList->AddText(ImVec2(min.x + 2.0f, min.y), IM_COL32(0, 0, 0, 255), site->blockName);
+            }
+
+            if (ImGui::IsMouseHoveringRect(min, max))
+            {
+#if SKL_PERF_COUNTERS
+                ProfilerSiteCounters *counters = profiler->lastFrameSiteCounters + bar->siteIndex;
+                if (counters->hitCount)
+                {
+                    ImGui::SetTooltip("%s\nIPC %.2f, %.2f LLC misses/KI (last frame)\n%s:%u", site->blockName,
+                                      GetPerfCounterRatio(counters, perfCounter_instructions, perfCounter_cycles, 1.0),
+                                      GetPerfCounterRatio(counters, perfCounter_llcMisses, perfCounter_instructions, 1000.0),
+                                      site->fileName, site->lineNumber);
+                    continue;
+                }
+#endif
+                f64 duration = static_cast<f64>(bar->end - bar->begin);
+                if (cyclesToMs > 0.0)
+                {
+                    ImGui::SetTooltip("%s\n%.3f ms\n%s:%u", site->blockName, duration * cyclesToMs, site->fileName, site->lineNumber);
+                }
+                else
+                {
+                    ImGui::SetTooltip("%s\n%.0f cycles\n%s:%u", site->blockName, duration, site->fileName, site->lineNumber);
+                }
+            }
+        }
+
+        ImGui::Dummy(ImVec2(width, timelineHeight));
+    }
+    ImGui::EndChild();
+}
+
 #endif
 
 // NOTE(marvin): ECS editor functionality in the editor system.
@@ -103,6 +769,23 @@ void RenderOverlay(GameState &gameState)
                 gameState.overlayMode = overlayMode_ecsEditor;
                 ImGui::EndTabItem();
             }
+            if (ImGui::BeginTabItem("Telemetry"))
+            {
+                gameState.overlayMode = overlayMode_telemetry;
+                ImGui::EndTabItem();
+            }
+            if (ImGui::BeginTabItem("Frame Times"))
+            {
+                gameState.overlayMode = overlayMode_frameTimes;
+                ImGui::EndTabItem();
+            }
+#if SKL_INTERNAL
+            if (ImGui::BeginTabItem("Profiler"))
+            {
+                gameState.overlayMode = overlayMode_profiler;
+                ImGui::EndTabItem();
+            }
+#endif
 #if SKL_DEBUG_MEMORY_VIEWER
             if (ImGui::BeginTabItem("Memory"))
             {
@@ -113,23 +796,41 @@ void RenderOverlay(GameState &gameState)
             ImGui::EndTabBar();
         }
 
-#if SKL_DEBUG_MEMORY_VIEWER
         // NOTE(marvin): Tab content.
+        if (gameState.overlayMode == overlayMode_telemetry)
+        {
+            RenderTelemetry(globalMemoryTelemetry);
+        }
+
+        if (gameState.overlayMode == overlayMode_frameTimes)
+        {
+            RenderFrameTimes(globalFrameStats);
+        }
+
+#if SKL_INTERNAL
+        if (gameState.overlayMode == overlayMode_profiler)
+        {
+            RenderProfiler(globalDebugProfiler);
+        }
+#endif
+
+#if SKL_DEBUG_MEMORY_VIEWER
         if (gameState.overlayMode == overlayMode_memory)
         {
             DebugState *debugState = globalDebugState;
+            ImGuiTableFlags tableFlags =
+                ImGuiTableFlags_BordersV |
+                ImGuiTableFlags_BordersOuterH |
+                ImGuiTableFlags_Resizable |
+                ImGuiTableFlags_RowBg |
+                ImGuiTableFlags_NoBordersInBody;
+
+            RenderMemoryViewerMode(debugState);
 
             if (ImGui::BeginTabBar("Memory Options", tabBarFlags))
             {
                 if (ImGui::BeginTabItem("Sizes Viewer"))
                 {
-                    ImGuiTableFlags tableFlags =
-                        ImGuiTableFlags_BordersV |
-                        ImGuiTableFlags_BordersOuterH |
-                        ImGuiTableFlags_Resizable |
-                        ImGuiTableFlags_RowBg |
-                        ImGuiTableFlags_NoBordersInBody;
-
                     if (ImGui::BeginTable("Sizes Viewer Table", 5, tableFlags))
                     {
                         // NOTE(marvin): Headers
@@ -147,6 +848,12 @@ void RenderOverlay(GameState &gameState)
                     ImGui::EndTabItem();
                 }
 
+                if (ImGui::BeginTabItem("Call Sites"))
+                {
+                    RenderCallSites(&debugState->debugIDs, tableFlags);
+                    ImGui::EndTabItem();
+                }
+
                 ImGui::EndTabBar();
             }
         }
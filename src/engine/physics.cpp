@@ -15,35 +15,96 @@
 #include <Jolt/Core/Memory.h>
 #include <Jolt/Core/Reference.h>
 #include <Jolt/Core/TempAllocator.h>
-#include <Jolt/Core/JobSystemThreadPool.h>
+#include <Jolt/Core/JobSystemWithBarrier.h>
+#include <Jolt/Core/FixedSizeFreeList.h>
+#include <Jolt/Core/HashCombine.h>
+#include <Jolt/Core/StreamWrapper.h>
 #include <Jolt/Physics/PhysicsSettings.h>
 #include <Jolt/Physics/PhysicsSystem.h>
+#include <Jolt/Physics/StateRecorderImpl.h>
 #include <Jolt/Physics/Collision/CastResult.h>
 #include <Jolt/Physics/Collision/CollisionCollectorImpl.h>
 #include <Jolt/Physics/Collision/CollideShape.h>
+#include <Jolt/Physics/Collision/ContactListener.h>
 #include <Jolt/Physics/Collision/RayCast.h>
 #include <Jolt/Physics/Collision/Shape/BoxShape.h>
 #include <Jolt/Physics/Collision/Shape/CapsuleShape.h>
+#include <Jolt/Physics/Collision/Shape/ConvexHullShape.h>
+#include <Jolt/Physics/Collision/Shape/MeshShape.h>
+#include <Jolt/Physics/Collision/Shape/ScaledShape.h>
 #include <Jolt/Physics/Collision/Shape/SphereShape.h>
 #include <Jolt/Physics/Body/BodyCreationSettings.h>
 #include <Jolt/Physics/Body/BodyActivationListener.h>
+#include <Jolt/Physics/Body/BodyLockMulti.h>
 #include <Jolt/Physics/Character/CharacterVirtual.h>
 
+#include <algorithm>
+#include <bit>
 #include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
 
 #include <meta_definitions.h>
+#include <debug.h>
 #include <skl_math_types.h>
 #include <engine.h>
 #include <physics.h>
 #include <engine_components.h>
 #include <scene_view.h>
+#include <job_scheduler.h>
+
+// NOTE(marvin): Only what the temp allocator starts out with, it
+// grows to the most that a step has used.
+constexpr siz INITIAL_TEMPORARY_MEMORY_SIZE = Megabytes(1);
+
+// NOTE(marvin): Pulled these numbers out of my ass.
+constexpr u32 MAX_PHYSICS_JOBS = 2048;
+constexpr u32 MAX_PHYSICS_BARRIERS = 8;
+
+// NOTE(marvin): The least bodies the physics system is made for, a map
+// that has more gets twice what it has, rounded up to a power of 2.
+constexpr u32 MIN_PHYSICS_BODY_COUNT = 1024;
+
+// NOTE(marvin): Fewer queries than this in a job aren't worth the job,
+// and more jobs than this aren't worth the waiting on them.
+constexpr u32 MIN_PHYSICS_QUERIES_PER_JOB = 32;
+constexpr u32 MAX_PHYSICS_QUERY_JOBS = 64;
+
+// NOTE(marvin): The parameters of the shapes in the shape cache are
+// rounded to this, a power of 2 so that it is exact. Shapes that are
+// closer than it are the same shape.
+constexpr f32 SHAPE_CACHE_QUANTUM = 1.0f / 1024.0f;
+constexpr f32 BOX_CONVEX_RADIUS = 0.05f;
+constexpr siz MIN_SHAPE_CACHE_PRUNE_SIZE = 256;
+
+// NOTE(marvin): What the contact buffers start out with, each doubles
+// after a step that didn't fit in it.
+constexpr u32 INITIAL_CONTACT_RECORD_CAPACITY = 256;
+constexpr u32 INITIAL_CONTACT_EVENT_CAPACITY = 1024;
+constexpr u32 INITIAL_AWAKE_BODY_CAPACITY = 1024;
+// NOTE(marvin): A power of 2, and at least double the active contacts.
+constexpr u32 INITIAL_ACTIVE_CONTACT_CAPACITY = 1024;
+
+// NOTE(marvin): The shapes cooked from meshes are saved here, so that
+// loading a map again doesn't build the convex hulls again.
+#define COOKED_SHAPE_CACHE_PATH SKL_BASE_PATH "/cache/colliders/"
+constexpr u32 COOKED_SHAPE_MAGIC = 0x434c4b53;  // "SKLC"
+constexpr u32 COOKED_SHAPE_VERSION = 1;
 
-constexpr siz TEMPORARY_MEMORY_SIZE = Megabytes(1);
+// NOTE(marvin): Adding static bodies leaves the broad phase tree
+// unbalanced, this many of them is worth rebuilding it for.
+constexpr u32 OPTIMIZE_BROAD_PHASE_STATIC_BODY_COUNT = 64;
 
 SKLPhysicsSubSystemBuffer InitPhysicsSubsystemBuffer(u32 count)
 {
     SKLPhysicsSubSystemBuffer result = {};
-    void* base = allocator.Allocate(sizeof(skl_physics_subsystem_t*) * count);
+    void* base = allocator.Allocate(sizeof(skl_physics_subsystem_t*) * count, memoryTag_physics);
     result.subsystems = static_cast<skl_physics_subsystem_t**>(base);
     result.count = count;
     return result;
@@ -172,6 +233,66 @@ JPH::Vec3 LerpJPHVec3(JPH::Vec3 a, JPH::Vec3 b, f32 blendFactor)
     return result;
 }
 
+// NOTE(marvin): Jolt's coordinate system has the other handedness, so
+// besides moving the axes of a quaternion over, it also turns the other
+// way around them.
+
+JPH::Quat OurToJoltRotation(glm::vec3 ourRotation)
+{
+    JPH::Quat ourQuat = JPH::Quat::sEulerAngles(JPH::Vec3{glm::radians(ourRotation.x),
+                                                          glm::radians(ourRotation.y),
+                                                          glm::radians(ourRotation.z)});
+    JPH::Quat result{ourQuat.GetY(), -ourQuat.GetZ(), -ourQuat.GetX(), ourQuat.GetW()};
+    return result;
+}
+
+glm::vec3 JoltToOurRotation(JPH::Quat joltRotation)
+{
+    JPH::Quat ourQuat{-joltRotation.GetZ(), joltRotation.GetX(), -joltRotation.GetY(), joltRotation.GetW()};
+    JPH::Vec3 eulerAngles = ourQuat.GetEulerAngles();
+    glm::vec3 result{glm::degrees(eulerAngles.GetX()),
+                     glm::degrees(eulerAngles.GetY()),
+                     glm::degrees(eulerAngles.GetZ())};
+    return result;
+}
+
+local glm::vec3 JPHVec3ToGLM(JPH::Vec3 v)
+{
+    glm::vec3 result{v.GetX(), v.GetY(), v.GetZ()};
+    return result;
+}
+
+local JPH::Vec3 GLMToJPHVec3(glm::vec3 v)
+{
+    JPH::Vec3 result{v.x, v.y, v.z};
+    return result;
+}
+
+local glm::vec4 JPHQuatToGLM(JPH::Quat q)
+{
+    glm::vec4 result{q.GetX(), q.GetY(), q.GetZ(), q.GetW()};
+    return result;
+}
+
+local JPH::Quat GLMToJPHQuat(glm::vec4 q)
+{
+    JPH::Quat result{q.x, q.y, q.z, q.w};
+    return result;
+}
+
+glm::mat4 GetRigidBodyRenderTransform(RigidBody *rigidBody, Transform3D *transform, f32 blendFactor)
+{
+    JPH::Vec3 joltPosition = LerpJPHVec3(GLMToJPHVec3(rigidBody->previousPosition),
+                                         GLMToJPHVec3(rigidBody->position), blendFactor);
+    JPH::Quat joltRotation = GLMToJPHQuat(rigidBody->previousRotation).SLERP(GLMToJPHQuat(rigidBody->rotation), blendFactor);
+
+    glm::vec3 position = JoltToOurCoordinateSystem(joltPosition);
+    glm::quat rotation{joltRotation.GetW(), -joltRotation.GetZ(), joltRotation.GetX(), -joltRotation.GetY()};
+    glm::mat4 result = glm::scale(glm::translate(glm::mat4(1.0f), position) * glm::mat4_cast(rotation),
+                                  transform->GetLocalScale());
+    return result;
+}
+
 /**
  * JOLT ALLOCATION FUNCTIONS
  */
@@ -181,7 +302,7 @@ JPH::Vec3 LerpJPHVec3(JPH::Vec3 a, JPH::Vec3 b, f32 blendFactor)
 
 void *JoltAlignedAllocate(size_t size, size_t alignment)
 {
-    void *result = allocator.AlignedAllocate(size, alignment);
+    void *result = allocator.AlignedAllocate(size, alignment, memoryTag_physics);
     return result;
 }
 
@@ -192,7 +313,7 @@ void JoltAlignedFree(void *block)
 
 void *JoltAllocate(size_t size)
 {
-    void *result = allocator.Allocate(size);
+    void *result = allocator.Allocate(size, memoryTag_physics);
     return result;
 }
 
@@ -203,10 +324,383 @@ void JoltFree(void *block)
 
 void *JoltReallocate(void *block, size_t oldSize, size_t newSize)
 {
-    void *result = allocator.Realloc(block, oldSize, newSize);
+    // NOTE(marvin): Realloc only knows the tag of an existing block.
+    void *result = block ? allocator.Realloc(block, oldSize, newSize) : allocator.Allocate(newSize, memoryTag_physics);
+    return result;
+}
+
+/**
+ * TEMP ALLOCATOR
+ */
+
+// NOTE(marvin): Jolt allocates and frees its temporary memory in
+// stack order, within a step, so it is a memory arena. Unlike Jolt's
+// TempAllocatorImpl, it doesn't fail when it is full: what doesn't fit
+// goes to the platform allocator, and the arena grows to the most that
+// a step has used before the next one. The arena is registered with
+// the memory telemetry, so its high-water mark is in the overlay.
+
+// NOTE(marvin): Jolt only uses it from one thread at a time, so the
+// arena is bumped directly, rather than with PushSize, which would
+// also put every allocation of every step in the memory viewer.
+
+local void ResizeTempArena(SKLTempArena *tempArena, siz size)
+{
+    ASSERT(!tempArena->arena.used && !tempArena->overflowUsed);
+    if (tempArena->arena.base)
+    {
+        allocator.AlignedFree(tempArena->arena.base);
+    }
+    tempArena->arena.base = static_cast<u08 *>(allocator.AlignedAllocate(size, JPH_RVECTOR_ALIGNMENT, memoryTag_physics));
+    tempArena->arena.size = size;
+    tempArena->arena.used = 0;
+}
+
+local void BeginTempArenaStep(SKLTempArena *tempArena)
+{
+    tempArena->stepHighWater = tempArena->arena.used + tempArena->overflowUsed;
+}
+
+// NOTE(marvin): Everything of the step has been freed by now, so this
+// is where the arena can be moved.
+local void EndTempArenaStep(SKLTempArena *tempArena)
+{
+    tempArena->highWater = Maximum(tempArena->highWater, tempArena->stepHighWater);
+    if (tempArena->stepHighWater > tempArena->arena.size && !tempArena->arena.used && !tempArena->overflowUsed)
+    {
+        // NOTE(marvin): A quarter more than the step used, so that a
+        // step that uses a little more doesn't grow it again.
+        siz size = std::bit_ceil(tempArena->stepHighWater + tempArena->stepHighWater / 4);
+        LOG("Growing the physics temp allocator from " << tempArena->arena.size << " to " << size
+            << " bytes, " << tempArena->overflowCount << " allocations didn't fit.");
+        ResizeTempArena(tempArena, size);
+        tempArena->overflowCount = 0;
+    }
+}
+
+// NOTE(marvin): Only a pointer to the arena, which is in the physics
+// system, because the virtual table of the allocator is in the game
+// module, and so it is made again after every hot reload.
+class SKLTempAllocator final : public JPH::TempAllocator
+{
+public:
+    JPH_OVERRIDE_NEW_DELETE
+
+    SKLTempArena *tempArena;
+
+    SKLTempAllocator(SKLTempArena *tempArena)
+    {
+        this->tempArena = tempArena;
+    }
+
+    virtual void *Allocate(JPH::uint size) override
+    {
+        if (!size)
+        {
+            return nullptr;
+        }
+
+        SKLTempArena *tempArena = this->tempArena;
+        MemoryArena *arena = &tempArena->arena;
+        siz alignedSize = JPH::AlignUp(size, JPH_RVECTOR_ALIGNMENT);
+        void *result;
+        if (arena->used + alignedSize <= arena->size)
+        {
+            result = arena->base + arena->used;
+            arena->used += alignedSize;
+            arena->peakUsed = Maximum(arena->peakUsed, arena->used);
+        }
+        else
+        {
+            result = allocator.AlignedAllocate(alignedSize, JPH_RVECTOR_ALIGNMENT, memoryTag_physics);
+            tempArena->overflowUsed += alignedSize;
+            ++tempArena->overflowCount;
+        }
+
+        tempArena->stepHighWater = Maximum(tempArena->stepHighWater, arena->used + tempArena->overflowUsed);
+        return result;
+    }
+
+    virtual void Free(void *address, JPH::uint size) override
+    {
+        if (!address)
+        {
+            return;
+        }
+
+        SKLTempArena *tempArena = this->tempArena;
+        MemoryArena *arena = &tempArena->arena;
+        siz alignedSize = JPH::AlignUp(size, JPH_RVECTOR_ALIGNMENT);
+        u08 *block = static_cast<u08 *>(address);
+        if (block >= arena->base && block < arena->base + arena->size)
+        {
+            ASSERT(block + alignedSize == arena->base + arena->used);
+            arena->used -= alignedSize;
+        }
+        else
+        {
+            allocator.AlignedFree(address);
+            tempArena->overflowUsed -= alignedSize;
+        }
+    }
+};
+
+/**
+ * JOB SYSTEM
+ */
+
+// NOTE(marvin): Jolt's jobs run on the engine's job scheduler, instead
+// of on threads of its own. Jolt keeps track of their dependencies and
+// barriers, the scheduler is only handed the ones that are ready. Same
+// as the temp allocator, it is made again after every hot reload, in
+// place, which is fine as no job is in flight between frames.
+
+class SKLJobSystem final : public JPH::JobSystemWithBarrier
+{
+public:
+    JPH_OVERRIDE_NEW_DELETE
+
+    JobScheduler *scheduler;
+    JPH::FixedSizeFreeList<Job> jobs;
+
+    SKLJobSystem(JobScheduler *scheduler, u32 maxJobs, u32 maxBarriers) : JPH::JobSystemWithBarrier(maxBarriers)
+    {
+        this->scheduler = scheduler;
+        this->jobs.Init(maxJobs, maxJobs);
+    }
+
+    // NOTE(marvin): The thread that waits on a barrier runs jobs too.
+    virtual int GetMaxConcurrency() const override
+    {
+        return static_cast<int>(GetJobWorkerCount(this->scheduler)) + 1;
+    }
+
+    virtual JobHandle CreateJob(const char *name, JPH::ColorArg color, const JobFunction &jobFunction,
+                                JPH::uint32 numDependencies = 0) override
+    {
+        u32 jobIndex = this->jobs.ConstructObject(name, color, this, jobFunction, numDependencies);
+        while (jobIndex == JPH::FixedSizeFreeList<Job>::cInvalidObjectIndex)
+        {
+            LOG_ERROR("Out of physics jobs, waiting for one to be freed.");
+            std::this_thread::yield();
+            jobIndex = this->jobs.ConstructObject(name, color, this, jobFunction, numDependencies);
+        }
+
+        Job *job = &this->jobs.Get(jobIndex);
+        JobHandle result{job};
+        if (!numDependencies)
+        {
+            this->QueueJob(job);
+        }
+        return result;
+    }
+
+    virtual void QueueJob(Job *job) override
+    {
+        // NOTE(marvin): Released once it has run, see RunJob.
+        job->AddRef();
+        SubmitJob(this->scheduler, RunJob, job, jobPriority_high);
+    }
+
+    virtual void QueueJobs(Job **jobs, JPH::uint jobCount) override
+    {
+        for (JPH::uint jobIndex = 0; jobIndex < jobCount; ++jobIndex)
+        {
+            this->QueueJob(jobs[jobIndex]);
+        }
+    }
+
+    virtual void FreeJob(Job *job) override
+    {
+        this->jobs.DestructObject(job);
+    }
+
+private:
+    // NOTE(marvin): A job that a barrier already ran is not run again.
+    static JOB_FUNCTION(RunJob)
+    {
+        Job *job = static_cast<Job *>(data);
+        job->Execute();
+        job->Release();
+    }
+};
+
+/**
+ * CAPACITIES
+ */
+
+local u32 GetPhysicsBodyCapacity(u32 bodyCount)
+{
+    u32 result = std::bit_ceil(Maximum(2 * bodyCount, MIN_PHYSICS_BODY_COUNT));
+    result = Minimum(result, static_cast<u32>(JPH::BodyID::cMaxBodyIndex));
+    return result;
+}
+
+// NOTE(marvin): Only the static boxes, the rigid bodies, and the
+// characters have bodies for now.
+local u32 CountPhysicsBodies(Scene *scene)
+{
+    u32 result = 0;
+    for (EntityID ent : SceneView<StaticBox>(*scene))
+    {
+        ++result;
+    }
+    for (EntityID ent : SceneView<RigidBody>(*scene))
+    {
+        ++result;
+    }
+    for (EntityID ent : SceneView<MeshCollider>(*scene))
+    {
+        ++result;
+    }
+    for (EntityID ent : SceneView<PlayerCharacter>(*scene))
+    {
+        ++result;
+    }
+    return result;
+}
+
+local JPH::PhysicsSystem *CreateJoltPhysicsSystem(SKLPhysicsSystem *sklPhysicsSystem, SKLPhysicsCapacities capacities)
+{
+    const u32 numBodyMutexes = 0;  // 0 means auto-detect.
+
+    // NOTE(marvin): This is not our ECS system! Jolt happened to name it System as well.
+    JPH::PhysicsSystem *result = new JPH::PhysicsSystem();
+    result->Init(capacities.maxBodies, numBodyMutexes, capacities.maxBodyPairs, capacities.maxContactConstraints,
+                 *sklPhysicsSystem->broadPhaseLayer, *sklPhysicsSystem->objectVsBroadPhaseLayerFilter,
+                 *sklPhysicsSystem->objectLayerPairFilter);
+    result->SetContactListener(sklPhysicsSystem->contactListener);
+    return result;
+}
+
+// NOTE(marvin): Constraints and character virtuals point at the
+// bodies, and at the physics system, that they were made with, and
+// can't be made again from what Jolt keeps of them. So the physics
+// system isn't recreated while there are any.
+local b32 CanRecreatePhysicsSystem(SKLPhysicsSystem *sklPhysicsSystem, Scene *scene)
+{
+    if (!sklPhysicsSystem->physicsSystem->GetConstraints().empty())
+    {
+        LOG_ERROR("Unable to grow the physics system, it has constraints, which can't be moved to a new one.");
+        return false;
+    }
+    for (EntityID ent : SceneView<PlayerCharacter>(*scene))
+    {
+        if (scene->Get<PlayerCharacter>(ent)->characterVirtual)
+        {
+            LOG_ERROR("Unable to grow the physics system, the character virtual of entity " << ent
+                      << " can't be moved to a new one.");
+            return false;
+        }
+    }
+    return true;
+}
+
+// NOTE(marvin): Jolt can't change the capacities of a physics system
+// that has been initialized, so a new one is made with the requested
+// ones, and every body is moved over to it with the same ID, as it is
+// now. Called between steps. When it can't be, the requested
+// capacities are dropped, so that it isn't tried again every step.
+local void RecreatePhysicsSystem(SKLPhysicsSystem *sklPhysicsSystem, Scene *scene)
+{
+    PROFILE_SCOPE("RecreatePhysicsSystem");
+
+    if (!CanRecreatePhysicsSystem(sklPhysicsSystem, scene))
+    {
+        sklPhysicsSystem->requestedCapacities = sklPhysicsSystem->capacities;
+        return;
+    }
+
+    SKLPhysicsCapacities capacities = sklPhysicsSystem->requestedCapacities;
+    LOG("Recreating the physics system for " << capacities.maxBodies << " bodies, "
+        << capacities.maxBodyPairs << " body pairs, and "
+        << capacities.maxContactConstraints << " contact constraints.");
+
+    JPH::PhysicsSystem *oldSystem = sklPhysicsSystem->physicsSystem;
+    JPH::PhysicsSystem *newSystem = CreateJoltPhysicsSystem(sklPhysicsSystem, capacities);
+    newSystem->SetPhysicsSettings(oldSystem->GetPhysicsSettings());
+    newSystem->SetGravity(oldSystem->GetGravity());
+
+    JPH::BodyIDVector bodyIDs;
+    oldSystem->GetBodies(bodyIDs);
+
+    const JPH::BodyLockInterfaceNoLock &oldLockInterface = oldSystem->GetBodyLockInterfaceNoLock();
+    JPH::BodyInterface &oldBodyInterface = oldSystem->GetBodyInterfaceNoLock();
+    JPH::BodyInterface &newBodyInterface = newSystem->GetBodyInterfaceNoLock();
+    for (JPH::BodyID bodyID : bodyIDs)
+    {
+        const JPH::Body *body = oldLockInterface.TryGetBody(bodyID);
+        JPH::Body *newBody = newBodyInterface.CreateBodyWithID(bodyID, body->GetBodyCreationSettings());
+        ASSERT(newBody);
+    }
+
+    // NOTE(marvin): Added as two batches, so that the bodies that were
+    // asleep stay asleep.
+    auto activeEnd = std::partition(bodyIDs.begin(), bodyIDs.end(),
+                                    [&](JPH::BodyID bodyID) { return oldBodyInterface.IsActive(bodyID); });
+    s32 activeCount = static_cast<s32>(activeEnd - bodyIDs.begin());
+    s32 inactiveCount = static_cast<s32>(bodyIDs.size()) - activeCount;
+    if (activeCount)
+    {
+        JPH::BodyInterface::AddState addState = newBodyInterface.AddBodiesPrepare(bodyIDs.data(), activeCount);
+        newBodyInterface.AddBodiesFinalize(bodyIDs.data(), activeCount, addState, JPH::EActivation::Activate);
+    }
+    if (inactiveCount)
+    {
+        JPH::BodyID *inactiveIDs = bodyIDs.data() + activeCount;
+        JPH::BodyInterface::AddState addState = newBodyInterface.AddBodiesPrepare(inactiveIDs, inactiveCount);
+        newBodyInterface.AddBodiesFinalize(inactiveIDs, inactiveCount, addState, JPH::EActivation::DontActivate);
+    }
+    newSystem->OptimizeBroadPhase();
+
+    delete oldSystem;
+    sklPhysicsSystem->physicsSystem = newSystem;
+    sklPhysicsSystem->capacities = capacities;
+    sklPhysicsSystem->staticBodiesSinceOptimize = 0;
+    ++sklPhysicsSystem->physicsSystemGeneration;
+}
+
+// NOTE(marvin): When a step runs out of body pairs or contact
+// constraints, Jolt drops the collisions that didn't fit and reports
+// it, they are doubled for the next step.
+local void RequestCapacitiesForUpdateError(SKLPhysicsSystem *sklPhysicsSystem, JPH::EPhysicsUpdateError error)
+{
+    SKLPhysicsCapacities *requested = &sklPhysicsSystem->requestedCapacities;
+    SKLPhysicsCapacities *capacities = &sklPhysicsSystem->capacities;
+    if ((error & JPH::EPhysicsUpdateError::BodyPairCacheFull) != JPH::EPhysicsUpdateError::None)
+    {
+        requested->maxBodyPairs = Maximum(requested->maxBodyPairs, 2 * capacities->maxBodyPairs);
+    }
+    if ((error & (JPH::EPhysicsUpdateError::ContactConstraintsFull | JPH::EPhysicsUpdateError::ManifoldCacheFull)) != JPH::EPhysicsUpdateError::None)
+    {
+        requested->maxContactConstraints = Maximum(requested->maxContactConstraints, 2 * capacities->maxContactConstraints);
+    }
+}
+
+local b32 CapacitiesRequested(SKLPhysicsSystem *sklPhysicsSystem)
+{
+    SKLPhysicsCapacities *requested = &sklPhysicsSystem->requestedCapacities;
+    SKLPhysicsCapacities *capacities = &sklPhysicsSystem->capacities;
+    b32 result = requested->maxBodies != capacities->maxBodies
+        || requested->maxBodyPairs != capacities->maxBodyPairs
+        || requested->maxContactConstraints != capacities->maxContactConstraints;
     return result;
 }
 
+// Makes room for the given number of bodies more than there are,
+// recreating the physics system if there isn't. Called between steps,
+// before a batch of bodies is created, rather than when creating one
+// fails halfway through it.
+local void ReservePhysicsBodies(SKLPhysicsSystem *sklPhysicsSystem, Scene *scene, u32 bodyCount)
+{
+    u32 requiredBodyCount = sklPhysicsSystem->physicsSystem->GetNumBodies() + bodyCount;
+    if (requiredBodyCount > sklPhysicsSystem->capacities.maxBodies)
+    {
+        sklPhysicsSystem->requestedCapacities.maxBodies = GetPhysicsBodyCapacity(requiredBodyCount);
+        RecreatePhysicsSystem(sklPhysicsSystem, scene);
+    }
+}
+
 /**
  * SUBSYSTEM
  */
@@ -222,108 +716,1828 @@ local void UpdateSubsystems(SKLPhysicsSubSystemBuffer buffer, SKLPhysicsSystem*
 
 
 /**
- * SYSTEM DEFINITION
+ * SHAPE CACHE
  */
 
-SKLPhysicsSystem::SKLPhysicsSystem() : SYSTEM_SUPER(SKLPhysicsSystem)
+enum SKLShapeType
 {
-    this->preUpdateSubsystemBuffer = {};
-    this->postUpdateSubsystemBuffer = {};
-}
+    sklShapeType_box          = 0,
+    sklShapeType_convexMesh   = 1,
+    sklShapeType_triangleMesh = 2,
+};
 
-SKLPhysicsSystem::~SKLPhysicsSystem()
+// NOTE(marvin): No padding, so that it can be hashed as bytes.
+struct SKLShapeKey
 {
-    delete this->allocator;
-    delete this->jobSystem;
-    delete this->objectLayerPairFilter;
-    delete this->objectVsBroadPhaseLayerFilter;
-    delete this->broadPhaseLayer;
-    delete this->physicsSystem;
-}
+    SKLShapeType type;
+    s32 parameters[4];
 
-MAKE_SYSTEM_MANUAL_VTABLE(SKLPhysicsSystem);
+    bool operator==(const SKLShapeKey &other) const = default;
+};
 
-SYSTEM_ON_UPDATE(SKLPhysicsSystem)
+struct SKLShapeKeyHash
 {
-    // NOTE(marvin): Initialising static boxes
-    JPH::BodyInterface &bodyInterface = this->physicsSystem->GetBodyInterface();
-    for (EntityID ent : SceneView<StaticBox, Transform3D>(*scene))
+    siz operator()(const SKLShapeKey &key) const
     {
-        StaticBox *sb = scene->Get<StaticBox>(ent);
-        Transform3D *t = scene->Get<Transform3D>(ent);
+        siz result = static_cast<siz>(JPH::HashBytes(&key, sizeof(key)));
+        return result;
+    }
+};
 
-        if (!sb->initialized)
-        {
-            JPH::Vec3 joltVolume = OurToJoltCoordinateSystem(t->GetLocalScale());
-            JPH::Vec3 halfExtent{
-                abs(abs(joltVolume.GetX()) / 2),
-                abs(abs(joltVolume.GetY()) / 2),
-                abs(abs(joltVolume.GetZ()) / 2)
-            };
-            JPH::BoxShapeSettings staticBodySettings{halfExtent, 0.05f};
-            JPH::ShapeSettings::ShapeResult shapeResult = staticBodySettings.Create();
-            JPH::ShapeRefC shape = shapeResult.Get();
+// NOTE(marvin): Maps act like procedural cities, with a few extents
+// used over and over, so the bodies with the same shape share one
+// instead of each having their own copy of it.
+struct SKLShapeCache
+{
+    std::unordered_map<SKLShapeKey, JPH::ShapeRefC, SKLShapeKeyHash> shapes;
+    // The size at which the shapes that no body uses anymore are let go.
+    siz pruneSize;
+    u64 hitCount;
+    u64 missCount;
 
-            JPH::Vec3 position = OurToJoltCoordinateSystem(t->GetWorldPosition());
-            JPH::BodyCreationSettings bodyCreationSettings{shape, position,
-                                                           JPH::Quat::sIdentity(), JPH::EMotionType::Static, Layer::NON_MOVING};
-            JPH::Body *body = bodyInterface.CreateBody(bodyCreationSettings);
-            bodyInterface.AddBody(body->GetID(), JPH::EActivation::DontActivate);
+    // NOTE(marvin): The shapes cooked from meshes, before they are
+    // scaled, by the name of the mesh and whether it is the convex hull.
+    // A shape in the shapes above refers to one by its index here. A
+    // mesh that couldn't be cooked has a null shape, so that it isn't
+    // tried again for every collider.
+    std::unordered_map<std::string, u32> cookedMeshIndices;
+    std::vector<JPH::ShapeRefC> cookedMeshes;
+};
 
-            sb->initialized = true;
-        }
-    }
+local s32 QuantizeShapeParameter(f32 value)
+{
+    s32 result = static_cast<s32>(std::lround(value / SHAPE_CACHE_QUANTUM));
+    return result;
+}
 
-    UpdateSubsystems(this->preUpdateSubsystemBuffer, this, SYSTEM_VTABLE_ON_UPDATE_PASS);
+local f32 DequantizeShapeParameter(s32 value)
+{
+    f32 result = static_cast<f32>(value) * SHAPE_CACHE_QUANTUM;
+    return result;
+}
 
-    u32 collisionSteps = 1;
-    this->physicsSystem->Update(deltaTime, collisionSteps, this->allocator, this->jobSystem);
+// NOTE(marvin): Only the cache holds on to those shapes, which happens
+// when the bodies that used them were removed. Pruned when the cache
+// has doubled since, so that it costs nothing per shape.
+local void PruneShapeCache(SKLShapeCache *shapeCache)
+{
+    siz previousCount = shapeCache->shapes.size();
+    std::erase_if(shapeCache->shapes, [](const auto &entry) { return entry.second->GetRefCount() == 1; });
+    shapeCache->pruneSize = Maximum(2 * shapeCache->shapes.size(), static_cast<siz>(MIN_SHAPE_CACHE_PRUNE_SIZE));
+    LOG("Pruned " << previousCount - shapeCache->shapes.size() << " unused shapes from the shape cache, "
+        << shapeCache->shapes.size() << " are left.");
+}
 
-    UpdateSubsystems(this->postUpdateSubsystemBuffer, this, SYSTEM_VTABLE_ON_UPDATE_PASS);
+local SKLShapeCache *CreateShapeCache()
+{
+    SKLShapeCache *result = new SKLShapeCache();
+    result->pruneSize = MIN_SHAPE_CACHE_PRUNE_SIZE;
+    return result;
 }
 
-void SKLPhysicsSystem::Initialize(b32 firstTime)
+// NOTE(marvin): A box the size of the scale of the transform.
+local JPH::ShapeRefC GetBoxShape(SKLShapeCache *shapeCache, Transform3D *t)
 {
-    JPH::AlignedAllocate = JoltAlignedAllocate;
-    JPH::AlignedFree = JoltAlignedFree;
-    JPH::Allocate = JoltAllocate;
-    JPH::Free = JoltFree;
-    JPH::Reallocate = JoltReallocate;
+    JPH::Vec3 joltHalfExtent = (OurToJoltCoordinateSystem(t->GetLocalScale()) / 2.0f).Abs();
+    SKLShapeKey key = {};
+    key.type = sklShapeType_box;
+    key.parameters[0] = QuantizeShapeParameter(joltHalfExtent.GetX());
+    key.parameters[1] = QuantizeShapeParameter(joltHalfExtent.GetY());
+    key.parameters[2] = QuantizeShapeParameter(joltHalfExtent.GetZ());
+    key.parameters[3] = QuantizeShapeParameter(BOX_CONVEX_RADIUS);
 
-    if (firstTime)
+    auto found = shapeCache->shapes.find(key);
+    if (found != shapeCache->shapes.end())
     {
-        JPH::Factory::sInstance = new JPH::Factory();
-        JPH::RegisterTypes();
+        ++shapeCache->hitCount;
+        return found->second;
+    }
+    ++shapeCache->missCount;
 
-        // NOTE(marvin): Pulled these numbers out of my ass.
-        const u32 maxPhysicsJobs = 2048;
-        const u32 maxPhysicsBarriers = 8;
-        const u32 maxBodies = 1024;
-        const u32 numBodyMutexes = 0;  // 0 means auto-detect.
-        const u32 maxBodyPairs = 1024;
-        const u32 maxContactConstraints = 1024;
-        const u32 numPhysicsThreads = std::thread::hardware_concurrency() - 1;  // Subtract main thread
+    if (shapeCache->shapes.size() >= shapeCache->pruneSize)
+    {
+        PruneShapeCache(shapeCache);
+    }
 
-        JPH::JobSystemThreadPool *jobSystem = new JPH::JobSystemThreadPool(maxPhysicsJobs, maxPhysicsBarriers, numPhysicsThreads);
+    // NOTE(marvin): Made from the rounded parameters, so that the shape
+    // is the same whichever of the boxes that share it came first. The
+    // convex radius can't be more than the smallest half extent.
+    JPH::Vec3 halfExtent{DequantizeShapeParameter(key.parameters[0]),
+                         DequantizeShapeParameter(key.parameters[1]),
+                         DequantizeShapeParameter(key.parameters[2])};
+    f32 convexRadius = Minimum(DequantizeShapeParameter(key.parameters[3]), halfExtent.ReduceMin());
+    JPH::BoxShapeSettings boxShapeSettings{halfExtent, convexRadius};
+    JPH::ShapeSettings::ShapeResult shapeResult = boxShapeSettings.Create();
+    if (shapeResult.HasError())
+    {
+        LOG_ERROR("Unable to create a box shape: " << shapeResult.GetError() << ".");
+        return nullptr;
+    }
 
-        // NOTE(marvin): This is not our ECS system! Jolt happened to name it System as well.
-        JPH::PhysicsSystem* physicsSystem = new JPH::PhysicsSystem();
+    JPH::ShapeRefC result = shapeResult.Get();
+    shapeCache->shapes.emplace(key, result);
+    return result;
+}
 
-        if (!this->userOverrideLayers)
-        {
-            this->broadPhaseLayer = new SklBroadPhaseLayer();
-            this->objectVsBroadPhaseLayerFilter = new SklObjectVsBroadPhaseLayerFilter();
-            this->objectLayerPairFilter = new SklObjectLayerPairFilter();
-        }
-    
-        physicsSystem->Init(maxBodies, numBodyMutexes, maxBodyPairs, maxContactConstraints,
-                            *this->broadPhaseLayer, *this->objectVsBroadPhaseLayerFilter,
-                            *this->objectLayerPairFilter);
+struct CookedShapeHeader
+{
+    u32 magic;
+    u32 version;
+    // NOTE(marvin): Of the mesh it was cooked from, and of the version
+    // of Jolt that cooked it, so that a cache of a mesh that has since
+    // changed is cooked again.
+    u64 sourceHash;
+};
 
-        this->physicsSystem = physicsSystem;
-        this->jobSystem = jobSystem;
+local u64 HashCookedShapeSource(MeshAsset *mesh, b32 convex)
+{
+    u32 settings[2] = {static_cast<u32>(JPH_VERSION_ID), static_cast<u32>(convex)};
+    u64 result = JPH::HashBytes(settings, sizeof(settings));
+    result = JPH::HashBytes(mesh->positions.data(), static_cast<u32>(mesh->positions.size() * sizeof(glm::vec3)), result);
+    result = JPH::HashBytes(mesh->indices.data(), static_cast<u32>(mesh->indices.size() * sizeof(u32)), result);
+    return result;
+}
 
-        this->allocator = new JPH::TempAllocatorImpl(TEMPORARY_MEMORY_SIZE);
+local JPH::ShapeRefC LoadCookedShape(const std::filesystem::path &path, u64 sourceHash)
+{
+    std::ifstream file{path, std::ios::binary};
+    if (!file)
+    {
+        return nullptr;
+    }
+
+    CookedShapeHeader header;
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file || header.magic != COOKED_SHAPE_MAGIC || header.version != COOKED_SHAPE_VERSION
+        || header.sourceHash != sourceHash)
+    {
+        return nullptr;
+    }
+
+    JPH::StreamInWrapper stream{file};
+    JPH::Shape::IDToShapeMap shapeMap;
+    JPH::Shape::IDToMaterialMap materialMap;
+    JPH::Shape::ShapeResult shapeResult = JPH::Shape::sRestoreWithChildren(stream, shapeMap, materialMap);
+    if (shapeResult.HasError())
+    {
+        LOG_ERROR("Unable to read the cooked shape " << path.string() << ": " << shapeResult.GetError() << ".");
+        return nullptr;
+    }
+
+    JPH::ShapeRefC result = shapeResult.Get();
+    return result;
+}
+
+local void SaveCookedShape(const std::filesystem::path &path, u64 sourceHash, const JPH::Shape *shape)
+{
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    std::ofstream file{path, std::ios::binary | std::ios::trunc};
+    if (!file)
+    {
+        LOG_ERROR("Unable to write the cooked shape " << path.string() << ".");
+        return;
+    }
+
+    CookedShapeHeader header = {COOKED_SHAPE_MAGIC, COOKED_SHAPE_VERSION, sourceHash};
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    // NOTE(marvin): With its children and materials, which the binary
+    // state of the shape itself only refers to.
+    JPH::StreamOutWrapper stream{file};
+    JPH::Shape::ShapeToIDMap shapeMap;
+    JPH::Shape::MaterialToIDMap materialMap;
+    shape->SaveWithChildren(stream, shapeMap, materialMap);
+    if (stream.IsFailed())
+    {
+        LOG_ERROR("Unable to write the cooked shape " << path.string() << ".");
+    }
+}
+
+// NOTE(marvin): The winding of the triangles stays as it is, the
+// conversion from glTF to our coordinate system and the one from ours to
+// Jolt's each mirror it, which cancels out.
+local JPH::ShapeRefC CookMeshShape(MeshAsset *mesh, b32 convex)
+{
+    PROFILE_SCOPE("CookMeshShape");
+
+    JPH::Shape::ShapeResult shapeResult;
+    if (convex)
+    {
+        JPH::Array<JPH::Vec3> points;
+        points.reserve(mesh->positions.size());
+        for (glm::vec3 position : mesh->positions)
+        {
+            points.push_back(OurToJoltCoordinateSystem(position));
+        }
+
+        // NOTE(marvin): Without a convex radius, as it would be scaled
+        // along with the mesh, and meshes are scaled by a lot.
+        JPH::ConvexHullShapeSettings settings{points, 0.0f};
+        shapeResult = settings.Create();
+    }
+    else
+    {
+        JPH::VertexList vertices;
+        vertices.reserve(mesh->positions.size());
+        for (glm::vec3 position : mesh->positions)
+        {
+            JPH::Vec3 joltPosition = OurToJoltCoordinateSystem(position);
+            vertices.push_back(JPH::Float3{joltPosition.GetX(), joltPosition.GetY(), joltPosition.GetZ()});
+        }
+
+        JPH::IndexedTriangleList triangles;
+        triangles.reserve(mesh->indices.size() / 3);
+        for (siz index = 0; index + 2 < mesh->indices.size(); index += 3)
+        {
+            triangles.push_back(JPH::IndexedTriangle{mesh->indices[index], mesh->indices[index + 1], mesh->indices[index + 2]});
+        }
+
+        JPH::MeshShapeSettings settings{std::move(vertices), std::move(triangles)};
+        shapeResult = settings.Create();
+    }
+
+    if (shapeResult.HasError())
+    {
+        LOG_ERROR("Unable to cook the collider of mesh " << mesh->name << ": " << shapeResult.GetError() << ".");
+        return nullptr;
+    }
+
+    JPH::ShapeRefC result = shapeResult.Get();
+    return result;
+}
+
+// Produces the shape cooked from the mesh, from the cache on disk if it
+// was cooked before, and cooking it and saving it otherwise.
+local JPH::ShapeRefC GetCookedMeshShape(MeshAsset *mesh, b32 convex)
+{
+    u64 sourceHash = HashCookedShapeSource(mesh, convex);
+    std::filesystem::path path = COOKED_SHAPE_CACHE_PATH + mesh->name + (convex ? ".hull" : ".mesh");
+
+    JPH::ShapeRefC result = LoadCookedShape(path, sourceHash);
+    if (result)
+    {
+        return result;
+    }
+
+    result = CookMeshShape(mesh, convex);
+    if (result)
+    {
+        SaveCookedShape(path, sourceHash, result);
+    }
+    return result;
+}
+
+// NOTE(marvin): A mesh the size of the scale of the transform, which
+// is shared by the colliders of the same mesh and scale, on top of the
+// unscaled shape that all of those of the same mesh share.
+local JPH::ShapeRefC GetMeshShape(SKLShapeCache *shapeCache, MeshAsset *mesh, b32 convex, Transform3D *t)
+{
+    std::string cookedName = mesh->name + (convex ? "|hull" : "|mesh");
+    auto cooked = shapeCache->cookedMeshIndices.find(cookedName);
+    if (cooked == shapeCache->cookedMeshIndices.end())
+    {
+        u32 cookedIndex = static_cast<u32>(shapeCache->cookedMeshes.size());
+        shapeCache->cookedMeshes.push_back(GetCookedMeshShape(mesh, convex));
+        cooked = shapeCache->cookedMeshIndices.emplace(cookedName, cookedIndex).first;
+    }
+
+    u32 cookedIndex = cooked->second;
+    const JPH::Shape *cookedShape = shapeCache->cookedMeshes[cookedIndex];
+    if (!cookedShape)
+    {
+        return nullptr;
+    }
+
+    JPH::Vec3 joltScale = OurToJoltCoordinateSystem(t->GetLocalScale()).Abs();
+    SKLShapeKey key = {};
+    key.type = convex ? sklShapeType_convexMesh : sklShapeType_triangleMesh;
+    key.parameters[0] = QuantizeShapeParameter(joltScale.GetX());
+    key.parameters[1] = QuantizeShapeParameter(joltScale.GetY());
+    key.parameters[2] = QuantizeShapeParameter(joltScale.GetZ());
+    key.parameters[3] = static_cast<s32>(cookedIndex);
+    if (!key.parameters[0] || !key.parameters[1] || !key.parameters[2])
+    {
+        LOG_ERROR("A collider of mesh " << mesh->name << " has a scale of 0.");
+        return nullptr;
+    }
+
+    auto found = shapeCache->shapes.find(key);
+    if (found != shapeCache->shapes.end())
+    {
+        ++shapeCache->hitCount;
+        return found->second;
+    }
+    ++shapeCache->missCount;
+
+    if (shapeCache->shapes.size() >= shapeCache->pruneSize)
+    {
+        PruneShapeCache(shapeCache);
+    }
+
+    JPH::Vec3 scale{DequantizeShapeParameter(key.parameters[0]),
+                    DequantizeShapeParameter(key.parameters[1]),
+                    DequantizeShapeParameter(key.parameters[2])};
+    JPH::ShapeRefC result = new JPH::ScaledShape(cookedShape, scale);
+    shapeCache->shapes.emplace(key, result);
+    return result;
+}
+
+/**
+ * STATIC BODIES
+ */
+
+// Creates the body of a static box that doesn't have one yet, without
+// adding it to the physics system. Produces whether it was created.
+local b32 CreateStaticBoxBody(JPH::BodyInterface &bodyInterface, SKLShapeCache *shapeCache, Scene *scene,
+                              EntityID ent, JPH::BodyID *bodyID)
+{
+    EntityEntry *entityEntry;
+    if (EntityAlreadyDeleted(&scene->entities, ent, &entityEntry))
+    {
+        return false;
+    }
+
+    StaticBox *sb = scene->Get<StaticBox>(ent);
+    Transform3D *t = scene->Get<Transform3D>(ent);
+    if (!sb || !t || sb->initialized)
+    {
+        return false;
+    }
+
+    JPH::ShapeRefC shape = GetBoxShape(shapeCache, t);
+    if (!shape)
+    {
+        return false;
+    }
+
+    JPH::Vec3 position = OurToJoltCoordinateSystem(t->GetWorldPosition());
+    JPH::BodyCreationSettings bodyCreationSettings{shape, position,
+                                                   JPH::Quat::sIdentity(), JPH::EMotionType::Static, Layer::NON_MOVING};
+    // NOTE(marvin): So that a query can get from a body back to its
+    // entity.
+    bodyCreationSettings.mUserData = static_cast<u64>(ent);
+    JPH::Body *body = bodyInterface.CreateBody(bodyCreationSettings);
+    if (!body)
+    {
+        LOG_ERROR("Out of physics bodies, the static box of entity " << ent << " has no collision.");
+        return false;
+    }
+
+    *bodyID = body->GetID();
+    sb->initialized = true;
+    return true;
+}
+
+// NOTE(marvin): The static boxes are created from the list of the ones
+// that were assigned since the last update, rather than scanning all
+// of them every frame, and are added to the broad phase as one batch,
+// which builds one subtree for all of them instead of inserting them
+// one at a time.
+local void AddNewStaticBoxes(SKLPhysicsSystem *sklPhysicsSystem, Scene *scene)
+{
+    ComponentAddedList *added = scene->GetAdded<StaticBox>();
+    if (!added->count && !added->overflowed)
+    {
+        return;
+    }
+
+    PROFILE_SCOPE("AddNewStaticBoxes");
+
+    // NOTE(marvin): When the list overflowed, every static box is a
+    // candidate, those with a body already are skipped.
+    u32 candidateCount = added->overflowed ? GetEntitiesPoolSize(&scene->entities) : added->count;
+
+    ReservePhysicsBodies(sklPhysicsSystem, scene, candidateCount);
+
+    JPH::PhysicsSystem *physicsSystem = sklPhysicsSystem->physicsSystem;
+    JPH::BodyInterface &bodyInterface = physicsSystem->GetBodyInterface();
+    JPH::TempAllocator *tempAllocator = sklPhysicsSystem->allocator;
+    SKLShapeCache *shapeCache = sklPhysicsSystem->shapeCache;
+    JPH::BodyID *bodyIDs = static_cast<JPH::BodyID *>(tempAllocator->Allocate(candidateCount * sizeof(JPH::BodyID)));
+    u32 bodyCount = 0;
+
+    // NOTE(marvin): A static box that doesn't have its transform yet
+    // stays in the list for the next update.
+    if (added->overflowed)
+    {
+        ClearComponentAdded(added);
+        for (EntityID ent : SceneView<StaticBox>(*scene))
+        {
+            if (!scene->Has<Transform3D>(ent))
+            {
+                PushComponentAdded(added, ent);
+                continue;
+            }
+            bodyCount += CreateStaticBoxBody(bodyInterface, shapeCache, scene, ent, bodyIDs + bodyCount);
+        }
+    }
+    else
+    {
+        u32 keptCount = 0;
+        for (u32 addedIndex = 0; addedIndex < added->count; ++addedIndex)
+        {
+            EntityID ent = added->entities[addedIndex];
+            if (!EntityAlreadyDeleted(&scene->entities, ent) && scene->Has<StaticBox>(ent) && !scene->Has<Transform3D>(ent))
+            {
+                added->entities[keptCount++] = ent;
+                continue;
+            }
+            bodyCount += CreateStaticBoxBody(bodyInterface, shapeCache, scene, ent, bodyIDs + bodyCount);
+        }
+        added->count = keptCount;
+    }
+
+    if (bodyCount)
+    {
+        JPH::BodyInterface::AddState addState = bodyInterface.AddBodiesPrepare(bodyIDs, bodyCount);
+        bodyInterface.AddBodiesFinalize(bodyIDs, bodyCount, addState, JPH::EActivation::DontActivate);
+
+        sklPhysicsSystem->staticBodiesSinceOptimize += bodyCount;
+        if (sklPhysicsSystem->staticBodiesSinceOptimize >= OPTIMIZE_BROAD_PHASE_STATIC_BODY_COUNT)
+        {
+            physicsSystem->OptimizeBroadPhase();
+            sklPhysicsSystem->staticBodiesSinceOptimize = 0;
+        }
+    }
+
+    tempAllocator->Free(bodyIDs, candidateCount * sizeof(JPH::BodyID));
+}
+
+/**
+ * MESH COLLIDERS
+ */
+
+// Creates the body of a mesh collider that doesn't have one yet,
+// without adding it to the physics system. Produces whether it was
+// created.
+local b32 CreateMeshColliderBody(JPH::BodyInterface &bodyInterface, SKLShapeCache *shapeCache, Scene *scene,
+                                 EntityID ent, JPH::BodyID *bodyID)
+{
+    if (EntityAlreadyDeleted(&scene->entities, ent))
+    {
+        return false;
+    }
+
+    MeshCollider *mc = scene->Get<MeshCollider>(ent);
+    MeshComponent *m = scene->Get<MeshComponent>(ent);
+    Transform3D *t = scene->Get<Transform3D>(ent);
+    if (!mc || !m || !m->mesh || !t || mc->bodyID != JPH::BodyID::cInvalidBodyID)
+    {
+        return false;
+    }
+
+    JPH::ShapeRefC shape = GetMeshShape(shapeCache, m->mesh, mc->convex, t);
+    if (!shape)
+    {
+        return false;
+    }
+
+    JPH::Vec3 position = OurToJoltCoordinateSystem(t->GetWorldPosition());
+    JPH::Quat rotation = OurToJoltRotation(t->GetLocalRotation());
+    JPH::BodyCreationSettings bodyCreationSettings{shape, position, rotation,
+                                                   JPH::EMotionType::Static, Layer::NON_MOVING};
+    bodyCreationSettings.mUserData = static_cast<u64>(ent);
+    JPH::Body *body = bodyInterface.CreateBody(bodyCreationSettings);
+    if (!body)
+    {
+        LOG_ERROR("Out of physics bodies, the mesh collider of entity " << ent << " has no collision.");
+        return false;
+    }
+
+    *bodyID = body->GetID();
+    mc->bodyID = bodyID->GetIndexAndSequenceNumber();
+    return true;
+}
+
+local b32 MeshColliderIsPending(Scene *scene, EntityID ent)
+{
+    MeshComponent *m = scene->Get<MeshComponent>(ent);
+    b32 result = !scene->Has<Transform3D>(ent) || !m || !m->mesh;
+    return result;
+}
+
+// NOTE(marvin): Same as the static boxes, see AddNewStaticBoxes, except
+// that a mesh collider also waits on its mesh.
+local void AddNewMeshColliders(SKLPhysicsSystem *sklPhysicsSystem, Scene *scene)
+{
+    ComponentAddedList *added = scene->GetAdded<MeshCollider>();
+    if (!added->count && !added->overflowed)
+    {
+        return;
+    }
+
+    PROFILE_SCOPE("AddNewMeshColliders");
+
+    u32 candidateCount = added->overflowed ? GetEntitiesPoolSize(&scene->entities) : added->count;
+    ReservePhysicsBodies(sklPhysicsSystem, scene, candidateCount);
+
+    JPH::PhysicsSystem *physicsSystem = sklPhysicsSystem->physicsSystem;
+    JPH::BodyInterface &bodyInterface = physicsSystem->GetBodyInterface();
+    JPH::TempAllocator *tempAllocator = sklPhysicsSystem->allocator;
+    SKLShapeCache *shapeCache = sklPhysicsSystem->shapeCache;
+    JPH::BodyID *bodyIDs = static_cast<JPH::BodyID *>(tempAllocator->Allocate(candidateCount * sizeof(JPH::BodyID)));
+    u32 bodyCount = 0;
+
+    if (added->overflowed)
+    {
+        ClearComponentAdded(added);
+        for (EntityID ent : SceneView<MeshCollider>(*scene))
+        {
+            if (MeshColliderIsPending(scene, ent))
+            {
+                PushComponentAdded(added, ent);
+                continue;
+            }
+            bodyCount += CreateMeshColliderBody(bodyInterface, shapeCache, scene, ent, bodyIDs + bodyCount);
+        }
+    }
+    else
+    {
+        u32 keptCount = 0;
+        for (u32 addedIndex = 0; addedIndex < added->count; ++addedIndex)
+        {
+            EntityID ent = added->entities[addedIndex];
+            if (!EntityAlreadyDeleted(&scene->entities, ent) && scene->Has<MeshCollider>(ent) && MeshColliderIsPending(scene, ent))
+            {
+                added->entities[keptCount++] = ent;
+                continue;
+            }
+            bodyCount += CreateMeshColliderBody(bodyInterface, shapeCache, scene, ent, bodyIDs + bodyCount);
+        }
+        added->count = keptCount;
+    }
+
+    if (bodyCount)
+    {
+        JPH::BodyInterface::AddState addState = bodyInterface.AddBodiesPrepare(bodyIDs, bodyCount);
+        bodyInterface.AddBodiesFinalize(bodyIDs, bodyCount, addState, JPH::EActivation::DontActivate);
+
+        sklPhysicsSystem->staticBodiesSinceOptimize += bodyCount;
+        if (sklPhysicsSystem->staticBodiesSinceOptimize >= OPTIMIZE_BROAD_PHASE_STATIC_BODY_COUNT)
+        {
+            physicsSystem->OptimizeBroadPhase();
+            sklPhysicsSystem->staticBodiesSinceOptimize = 0;
+        }
+    }
+
+    tempAllocator->Free(bodyIDs, candidateCount * sizeof(JPH::BodyID));
+}
+
+/**
+ * RIGID BODIES
+ */
+
+// Creates the body of a rigid body that doesn't have one yet, without
+// adding it to the physics system. Produces whether it was created.
+local b32 CreateRigidBodyBody(JPH::BodyInterface &bodyInterface, SKLShapeCache *shapeCache, Scene *scene,
+                              EntityID ent, JPH::BodyID *bodyID)
+{
+    if (EntityAlreadyDeleted(&scene->entities, ent))
+    {
+        return false;
+    }
+
+    RigidBody *rb = scene->Get<RigidBody>(ent);
+    Transform3D *t = scene->Get<Transform3D>(ent);
+    if (!rb || !t || rb->bodyID != JPH::BodyID::cInvalidBodyID)
+    {
+        return false;
+    }
+
+    JPH::ShapeRefC shape = GetBoxShape(shapeCache, t);
+    if (!shape)
+    {
+        return false;
+    }
+    JPH::Vec3 position = OurToJoltCoordinateSystem(t->GetWorldPosition());
+    JPH::Quat rotation = OurToJoltRotation(t->GetLocalRotation());
+    JPH::BodyCreationSettings bodyCreationSettings{shape, position, rotation,
+                                                   JPH::EMotionType::Dynamic, Layer::MOVING};
+    bodyCreationSettings.mOverrideMassProperties = JPH::EOverrideMassProperties::CalculateInertia;
+    bodyCreationSettings.mMassPropertiesOverride.mMass = rb->mass;
+    bodyCreationSettings.mFriction = rb->friction;
+    bodyCreationSettings.mRestitution = rb->restitution;
+    // NOTE(marvin): So that the writeback can get from a body back to
+    // its entity.
+    bodyCreationSettings.mUserData = static_cast<u64>(ent);
+
+    JPH::Body *body = bodyInterface.CreateBody(bodyCreationSettings);
+    if (!body)
+    {
+        LOG_ERROR("Out of physics bodies, the rigid body of entity " << ent << " wasn't created.");
+        return false;
+    }
+
+    *bodyID = body->GetID();
+    rb->bodyID = bodyID->GetIndexAndSequenceNumber();
+    rb->previousPosition = JPHVec3ToGLM(position);
+    rb->position = rb->previousPosition;
+    rb->previousRotation = JPHQuatToGLM(rotation);
+    rb->rotation = rb->previousRotation;
+    return true;
+}
+
+// NOTE(marvin): Same as the static boxes, see AddNewStaticBoxes, except
+// that they start out awake.
+local void AddNewRigidBodies(SKLPhysicsSystem *sklPhysicsSystem, Scene *scene)
+{
+    ComponentAddedList *added = scene->GetAdded<RigidBody>();
+    if (!added->count && !added->overflowed)
+    {
+        return;
+    }
+
+    PROFILE_SCOPE("AddNewRigidBodies");
+
+    u32 candidateCount = added->overflowed ? GetEntitiesPoolSize(&scene->entities) : added->count;
+    ReservePhysicsBodies(sklPhysicsSystem, scene, candidateCount);
+
+    JPH::BodyInterface &bodyInterface = sklPhysicsSystem->physicsSystem->GetBodyInterface();
+    JPH::TempAllocator *tempAllocator = sklPhysicsSystem->allocator;
+    SKLShapeCache *shapeCache = sklPhysicsSystem->shapeCache;
+    JPH::BodyID *bodyIDs = static_cast<JPH::BodyID *>(tempAllocator->Allocate(candidateCount * sizeof(JPH::BodyID)));
+    u32 bodyCount = 0;
+
+    if (added->overflowed)
+    {
+        ClearComponentAdded(added);
+        for (EntityID ent : SceneView<RigidBody>(*scene))
+        {
+            if (!scene->Has<Transform3D>(ent))
+            {
+                PushComponentAdded(added, ent);
+                continue;
+            }
+            bodyCount += CreateRigidBodyBody(bodyInterface, shapeCache, scene, ent, bodyIDs + bodyCount);
+        }
+    }
+    else
+    {
+        u32 keptCount = 0;
+        for (u32 addedIndex = 0; addedIndex < added->count; ++addedIndex)
+        {
+            EntityID ent = added->entities[addedIndex];
+            if (!EntityAlreadyDeleted(&scene->entities, ent) && scene->Has<RigidBody>(ent) && !scene->Has<Transform3D>(ent))
+            {
+                added->entities[keptCount++] = ent;
+                continue;
+            }
+            bodyCount += CreateRigidBodyBody(bodyInterface, shapeCache, scene, ent, bodyIDs + bodyCount);
+        }
+        added->count = keptCount;
+    }
+
+    if (bodyCount)
+    {
+        JPH::BodyInterface::AddState addState = bodyInterface.AddBodiesPrepare(bodyIDs, bodyCount);
+        bodyInterface.AddBodiesFinalize(bodyIDs, bodyCount, addState, JPH::EActivation::Activate);
+    }
+
+    tempAllocator->Free(bodyIDs, candidateCount * sizeof(JPH::BodyID));
+}
+
+// Produces the components of the entity that the body was made for, if
+// the body is still the one of its rigid body.
+local b32 GetRigidBodyOfBody(Scene *scene, const JPH::Body *body, RigidBody **rb, Transform3D **t)
+{
+    EntityID ent = static_cast<EntityID>(body->GetUserData());
+    if (EntityAlreadyDeleted(&scene->entities, ent))
+    {
+        return false;
+    }
+
+    *rb = scene->Get<RigidBody>(ent);
+    *t = scene->Get<Transform3D>(ent);
+    b32 result = *rb && *t && (*rb)->bodyID == body->GetID().GetIndexAndSequenceNumber();
+    return result;
+}
+
+// NOTE(marvin): A body that fell asleep is no longer in the list of
+// active bodies, so it would keep blending between its last two states
+// while it is at rest. It is snapped to where it went to sleep instead.
+local void SettleDeactivatedBodies(SKLPhysicsSystem *sklPhysicsSystem, Scene *scene)
+{
+    const JPH::BodyLockInterface &lockInterface = sklPhysicsSystem->physicsSystem->GetBodyLockInterface();
+    for (u32 awakeIndex = 0; awakeIndex < sklPhysicsSystem->awakeBodyCount; ++awakeIndex)
+    {
+        JPH::BodyLockRead lock{lockInterface, JPH::BodyID{sklPhysicsSystem->awakeBodyIDs[awakeIndex]}};
+        if (!lock.Succeeded() || lock.GetBody().IsActive())
+        {
+            continue;
+        }
+
+        const JPH::Body *body = &lock.GetBody();
+        RigidBody *rb;
+        Transform3D *t;
+        if (!GetRigidBodyOfBody(scene, body, &rb, &t))
+        {
+            continue;
+        }
+
+        JPH::Vec3 position = body->GetPosition();
+        JPH::Quat rotation = body->GetRotation();
+        rb->position = JPHVec3ToGLM(position);
+        rb->rotation = JPHQuatToGLM(rotation);
+        rb->previousPosition = rb->position;
+        rb->previousRotation = rb->rotation;
+
+        t->SetLocalPosition(JoltToOurCoordinateSystem(position));
+        t->SetLocalRotation(JoltToOurRotation(rotation));
+    }
+}
+
+// NOTE(marvin): Only the bodies that are awake can have moved, Jolt
+// keeps a list of them, and they are all locked at once rather than one
+// at a time. The list is kept until the next step, to settle the ones
+// that fall asleep in it.
+local void WriteBackActiveBodies(SKLPhysicsSystem *sklPhysicsSystem, Scene *scene)
+{
+    PROFILE_SCOPE("WriteBackActiveBodies");
+
+    SettleDeactivatedBodies(sklPhysicsSystem, scene);
+
+    JPH::PhysicsSystem *physicsSystem = sklPhysicsSystem->physicsSystem;
+    u32 activeBodyCount = physicsSystem->GetNumActiveBodies(JPH::EBodyType::RigidBody);
+    sklPhysicsSystem->awakeBodyCount = 0;
+    if (!activeBodyCount)
+    {
+        return;
+    }
+
+    // NOTE(marvin): Only safe to read between steps.
+    const JPH::BodyID *activeBodyIDs = physicsSystem->GetActiveBodiesUnsafe(JPH::EBodyType::RigidBody);
+    if (activeBodyCount > sklPhysicsSystem->awakeBodyCapacity)
+    {
+        u32 capacity = Maximum(2 * sklPhysicsSystem->awakeBodyCapacity, activeBodyCount);
+        ::allocator.Free(sklPhysicsSystem->awakeBodyIDs);
+        sklPhysicsSystem->awakeBodyIDs = static_cast<u32 *>(::allocator.Allocate(capacity * sizeof(u32), memoryTag_physics));
+        sklPhysicsSystem->awakeBodyCapacity = capacity;
+    }
+
+    JPH::BodyLockMultiRead lock{physicsSystem->GetBodyLockInterface(), activeBodyIDs, static_cast<s32>(activeBodyCount)};
+    for (u32 activeIndex = 0; activeIndex < activeBodyCount; ++activeIndex)
+    {
+        sklPhysicsSystem->awakeBodyIDs[sklPhysicsSystem->awakeBodyCount++] = activeBodyIDs[activeIndex].GetIndexAndSequenceNumber();
+
+        const JPH::Body *body = lock.GetBody(activeIndex);
+        RigidBody *rb;
+        Transform3D *t;
+        if (!body || !GetRigidBodyOfBody(scene, body, &rb, &t))
+        {
+            continue;
+        }
+
+        JPH::Vec3 position = body->GetPosition();
+        JPH::Quat rotation = body->GetRotation();
+        rb->previousPosition = rb->position;
+        rb->previousRotation = rb->rotation;
+        rb->position = JPHVec3ToGLM(position);
+        rb->rotation = JPHQuatToGLM(rotation);
+
+        t->SetLocalPosition(JoltToOurCoordinateSystem(position));
+        t->SetLocalRotation(JoltToOurRotation(rotation));
+    }
+}
+
+/**
+ * QUERIES
+ */
+
+enum PhysicsQueryType
+{
+    physicsQueryType_ray    = 0,
+    physicsQueryType_box    = 1,
+    physicsQueryType_sphere = 2,
+};
+
+// A range of the queries of one call, for one job.
+struct PhysicsQueryJob
+{
+    PhysicsQueryType type;
+    JPH::PhysicsSystem *physicsSystem;
+    const void *queries;
+    void *results;
+    // The room for the hits of every overlap query, maxHitsPerQuery of
+    // them each.
+    EntityID *hitEntities;
+    u32 maxHitsPerQuery;
+    u32 firstQuery;
+    u32 queryCount;
+};
+
+// NOTE(marvin): Only keeps the bodies, as the body is still locked by
+// the query when a hit is added. Several hits of the same body, on
+// different parts of its shape, come in one after another.
+class SKLOverlapCollector final : public JPH::CollideShapeCollector
+{
+public:
+    JPH::BodyID *bodyIDs;
+    u32 maxCount;
+    u32 count;
+    b32 truncated;
+
+    SKLOverlapCollector(JPH::BodyID *bodyIDs, u32 maxCount)
+        : bodyIDs(bodyIDs), maxCount(maxCount), count(0), truncated(false)
+    {
+    }
+
+    virtual void AddHit(const JPH::CollideShapeResult &result) override
+    {
+        if (this->count && this->bodyIDs[this->count - 1] == result.mBodyID2)
+        {
+            return;
+        }
+        if (this->count == this->maxCount)
+        {
+            this->truncated = true;
+            ForceEarlyOut();
+            return;
+        }
+        this->bodyIDs[this->count++] = result.mBodyID2;
+    }
+};
+
+local void CastRay(JPH::PhysicsSystem *physicsSystem, const SKLRay *ray, SKLRayHit *hit)
+{
+    *hit = {};
+    JPH::RRayCast joltRay{OurToJoltCoordinateSystem(ray->origin), OurToJoltCoordinateSystem(ray->direction)};
+    JPH::RayCastResult result;
+    if (!physicsSystem->GetNarrowPhaseQuery().CastRay(joltRay, result))
+    {
+        return;
+    }
+
+    JPH::BodyLockRead lock{physicsSystem->GetBodyLockInterface(), result.mBodyID};
+    if (!lock.Succeeded())
+    {
+        return;
+    }
+
+    const JPH::Body &body = lock.GetBody();
+    JPH::Vec3 joltPoint = joltRay.GetPointOnRay(result.mFraction);
+    hit->hit = true;
+    hit->entity = static_cast<EntityID>(body.GetUserData());
+    hit->bodyID = result.mBodyID.GetIndexAndSequenceNumber();
+    hit->fraction = result.mFraction;
+    hit->point = JoltToOurCoordinateSystem(joltPoint);
+    hit->normal = JoltToOurCoordinateSystem(body.GetWorldSpaceSurfaceNormal(result.mSubShapeID2, joltPoint));
+}
+
+// NOTE(marvin): The body IDs are collected into the memory of the
+// entities, which are as large, and then replaced by them.
+local void CollideOverlapShape(JPH::PhysicsSystem *physicsSystem, const JPH::Shape *shape, JPH::RMat44Arg transform,
+                               SKLOverlap *overlap, EntityID *entities, u32 maxHits)
+{
+    static_assert(sizeof(EntityID) >= sizeof(JPH::BodyID));
+    JPH::BodyID *bodyIDs = reinterpret_cast<JPH::BodyID *>(entities);
+
+    SKLOverlapCollector collector{bodyIDs, maxHits};
+    JPH::CollideShapeSettings settings;
+    physicsSystem->GetNarrowPhaseQuery().CollideShape(shape, JPH::Vec3::sReplicate(1.0f), transform, settings,
+                                                      JPH::RVec3::sZero(), collector);
+
+    // NOTE(marvin): Back to front, as an entity is larger than a body
+    // ID and covers the ones after it, so that none is overwritten
+    // before it is read.
+    JPH::BodyInterface &bodyInterface = physicsSystem->GetBodyInterface();
+    for (u32 hitIndex = collector.count; hitIndex > 0; --hitIndex)
+    {
+        JPH::BodyID bodyID = bodyIDs[hitIndex - 1];
+        entities[hitIndex - 1] = static_cast<EntityID>(bodyInterface.GetUserData(bodyID));
+    }
+
+    overlap->entities = entities;
+    overlap->count = collector.count;
+    overlap->truncated = collector.truncated;
+}
+
+local void OverlapBox(JPH::PhysicsSystem *physicsSystem, const SKLOverlapBox *box,
+                      SKLOverlap *overlap, EntityID *entities, u32 maxHits)
+{
+    JPH::Vec3 joltHalfExtents = OurToJoltCoordinateSystem(box->halfExtents).Abs();
+    JPH::BoxShape shape{joltHalfExtents, 0.0f};
+    shape.SetEmbedded();
+
+    JPH::RMat44 transform = JPH::RMat44::sRotationTranslation(OurToJoltRotation(box->rotation),
+                                                              OurToJoltCoordinateSystem(box->center));
+    CollideOverlapShape(physicsSystem, &shape, transform, overlap, entities, maxHits);
+}
+
+local void OverlapSphere(JPH::PhysicsSystem *physicsSystem, const SKLOverlapSphere *sphere,
+                         SKLOverlap *overlap, EntityID *entities, u32 maxHits)
+{
+    JPH::SphereShape shape{sphere->radius};
+    shape.SetEmbedded();
+
+    JPH::RMat44 transform = JPH::RMat44::sTranslation(OurToJoltCoordinateSystem(sphere->center));
+    CollideOverlapShape(physicsSystem, &shape, transform, overlap, entities, maxHits);
+}
+
+local JOB_FUNCTION(RunPhysicsQueryJob)
+{
+    PhysicsQueryJob *job = static_cast<PhysicsQueryJob *>(data);
+    u32 endQuery = job->firstQuery + job->queryCount;
+    for (u32 queryIndex = job->firstQuery; queryIndex < endQuery; ++queryIndex)
+    {
+        EntityID *entities = job->hitEntities + static_cast<siz>(queryIndex) * job->maxHitsPerQuery;
+        switch (job->type)
+        {
+            case physicsQueryType_ray:
+                CastRay(job->physicsSystem, static_cast<const SKLRay *>(job->queries) + queryIndex,
+                        static_cast<SKLRayHit *>(job->results) + queryIndex);
+                break;
+            case physicsQueryType_box:
+                OverlapBox(job->physicsSystem, static_cast<const SKLOverlapBox *>(job->queries) + queryIndex,
+                           static_cast<SKLOverlap *>(job->results) + queryIndex, entities, job->maxHitsPerQuery);
+                break;
+            case physicsQueryType_sphere:
+                OverlapSphere(job->physicsSystem, static_cast<const SKLOverlapSphere *>(job->queries) + queryIndex,
+                              static_cast<SKLOverlap *>(job->results) + queryIndex, entities, job->maxHitsPerQuery);
+                break;
+            default:
+                ASSERT(false);
+                break;
+        }
+    }
+}
+
+// NOTE(marvin): Every query writes only to its own result, so the jobs
+// need no locks of their own. The calling thread runs jobs too while it
+// waits.
+local void RunPhysicsQueries(PhysicsQueryJob *prototype, u32 queryCount)
+{
+    if (!queryCount)
+    {
+        return;
+    }
+
+    u32 jobCount = (queryCount + MIN_PHYSICS_QUERIES_PER_JOB - 1) / MIN_PHYSICS_QUERIES_PER_JOB;
+    jobCount = Minimum(jobCount, Minimum(MAX_PHYSICS_QUERY_JOBS, GetJobWorkerCount(globalJobScheduler) + 1));
+
+    PhysicsQueryJob jobs[MAX_PHYSICS_QUERY_JOBS];
+    u64 volatile counter = 0;
+    u32 firstQuery = 0;
+    for (u32 jobIndex = 0; jobIndex < jobCount; ++jobIndex)
+    {
+        // NOTE(marvin): Spreads the remainder over the first jobs.
+        u32 jobQueryCount = queryCount / jobCount + (jobIndex < queryCount % jobCount);
+        jobs[jobIndex] = *prototype;
+        jobs[jobIndex].firstQuery = firstQuery;
+        jobs[jobIndex].queryCount = jobQueryCount;
+        firstQuery += jobQueryCount;
+        SubmitJob(globalJobScheduler, RunPhysicsQueryJob, &jobs[jobIndex], jobPriority_high, &counter);
+    }
+    ASSERT(firstQuery == queryCount);
+
+    WaitForJobCounter(globalJobScheduler, &counter);
+}
+
+SKLRayHit *SKLPhysicsSystem::CastRays(std::span<const SKLRay> rays, MemoryArena *resultArena)
+{
+    PROFILE_SCOPE("CastRays");
+
+    u32 rayCount = static_cast<u32>(rays.size());
+    SKLRayHit *result = PushArray(resultArena, rayCount, SKLRayHit, NoClearArenaParams());
+
+    PhysicsQueryJob prototype = {};
+    prototype.type = physicsQueryType_ray;
+    prototype.physicsSystem = this->physicsSystem;
+    prototype.queries = rays.data();
+    prototype.results = result;
+    RunPhysicsQueries(&prototype, rayCount);
+    return result;
+}
+
+local SKLOverlap *Overlap(JPH::PhysicsSystem *physicsSystem, PhysicsQueryType type, const void *queries, u32 queryCount,
+                          u32 maxHitsPerQuery, MemoryArena *resultArena)
+{
+    SKLOverlap *result = PushArray(resultArena, queryCount, SKLOverlap, NoClearArenaParams());
+    EntityID *hitEntities = PushArray(resultArena, static_cast<siz>(queryCount) * maxHitsPerQuery, EntityID,
+                                      NoClearArenaParams());
+
+    PhysicsQueryJob prototype = {};
+    prototype.type = type;
+    prototype.physicsSystem = physicsSystem;
+    prototype.queries = queries;
+    prototype.results = result;
+    prototype.hitEntities = hitEntities;
+    prototype.maxHitsPerQuery = maxHitsPerQuery;
+    RunPhysicsQueries(&prototype, queryCount);
+    return result;
+}
+
+SKLOverlap *SKLPhysicsSystem::OverlapBoxes(std::span<const SKLOverlapBox> boxes, u32 maxHitsPerQuery, MemoryArena *resultArena)
+{
+    PROFILE_SCOPE("OverlapBoxes");
+    SKLOverlap *result = Overlap(this->physicsSystem, physicsQueryType_box, boxes.data(), static_cast<u32>(boxes.size()),
+                                 maxHitsPerQuery, resultArena);
+    return result;
+}
+
+SKLOverlap *SKLPhysicsSystem::OverlapSpheres(std::span<const SKLOverlapSphere> spheres, u32 maxHitsPerQuery, MemoryArena *resultArena)
+{
+    PROFILE_SCOPE("OverlapSpheres");
+    SKLOverlap *result = Overlap(this->physicsSystem, physicsQueryType_sphere, spheres.data(), static_cast<u32>(spheres.size()),
+                                 maxHitsPerQuery, resultArena);
+    return result;
+}
+
+/**
+ * SNAPSHOTS
+ */
+
+// NOTE(marvin): Zero runs shorter than this are kept in with the bytes
+// around them, as a record of their own would take more room.
+constexpr siz MIN_SNAPSHOT_ZERO_RUN = 2 * sizeof(u32);
+
+// NOTE(marvin): A snapshot that would have more bases than this before
+// it keeps the whole state instead, so that decoding one that isn't
+// cached goes through at most this many.
+constexpr u32 MAX_SNAPSHOT_CHAIN_LENGTH = 16;
+
+// NOTE(marvin): The decoded state of the snapshot that was saved or
+// restored last, which is the base of the next snapshot when there is
+// one a frame, so that it doesn't have to be decoded again.
+struct SKLSnapshotCache
+{
+    SKLPhysicsSnapshot *snapshot;
+    std::string state;
+};
+
+// NOTE(marvin): The state is XORed with the state of the base, if any,
+// so that every byte that didn't change is 0, and the runs of zeros are
+// left out. It is a list of records, each a u32 number of zeros,
+// followed by a u32 number of bytes, followed by those bytes.
+local void EncodeSnapshotState(const std::string &state, const std::string &baseState, std::string *encoded)
+{
+    encoded->clear();
+    siz stateSize = state.size();
+    auto GetDeltaByte = [&](siz position) -> u8
+    {
+        u8 baseByte = position < baseState.size() ? static_cast<u8>(baseState[position]) : 0;
+        u8 result = static_cast<u8>(state[position]) ^ baseByte;
+        return result;
+    };
+
+    siz position = 0;
+    while (position < stateSize)
+    {
+        siz zeroStart = position;
+        while (position < stateSize && !GetDeltaByte(position))
+        {
+            ++position;
+        }
+
+        siz literalStart = position;
+        siz literalEnd = position;
+        while (position < stateSize)
+        {
+            if (GetDeltaByte(position))
+            {
+                literalEnd = ++position;
+                continue;
+            }
+
+            siz zeroEnd = position;
+            while (zeroEnd < stateSize && !GetDeltaByte(zeroEnd))
+            {
+                ++zeroEnd;
+            }
+            if (zeroEnd - position >= MIN_SNAPSHOT_ZERO_RUN || zeroEnd == stateSize)
+            {
+                break;
+            }
+            position = zeroEnd;
+            literalEnd = zeroEnd;
+        }
+        position = literalEnd;
+
+        u32 header[2] = {static_cast<u32>(literalStart - zeroStart), static_cast<u32>(literalEnd - literalStart)};
+        encoded->append(reinterpret_cast<const char *>(header), sizeof(header));
+        for (siz literalIndex = literalStart; literalIndex < literalEnd; ++literalIndex)
+        {
+            encoded->push_back(static_cast<char>(GetDeltaByte(literalIndex)));
+        }
+    }
+}
+
+// Applies the records of one snapshot onto the state of its base.
+local b32 ApplySnapshotRecords(SKLPhysicsSnapshot *snapshot, std::string *state)
+{
+    state->resize(snapshot->stateSize, '\0');
+
+    siz position = 0;
+    siz cursor = 0;
+    while (cursor < snapshot->size)
+    {
+        u32 header[2];
+        if (snapshot->size - cursor < sizeof(header))
+        {
+            return false;
+        }
+        memcpy(header, snapshot->data + cursor, sizeof(header));
+        cursor += sizeof(header);
+
+        siz literalCount = header[1];
+        position += header[0];
+        if (position + literalCount > snapshot->stateSize || snapshot->size - cursor < literalCount)
+        {
+            return false;
+        }
+        for (siz literalIndex = 0; literalIndex < literalCount; ++literalIndex)
+        {
+            (*state)[position++] ^= static_cast<char>(snapshot->data[cursor++]);
+        }
+    }
+
+    b32 result = position <= snapshot->stateSize;
+    return result;
+}
+
+// Produces whether the snapshot, and every base before it, could be
+// decoded. The bases are applied from the oldest, or from the cached
+// one if it is in the chain.
+local b32 DecodeSnapshotState(SKLSnapshotCache *snapshotCache, SKLPhysicsSnapshot *snapshot, std::string *state)
+{
+    SKLPhysicsSnapshot *chain[MAX_SNAPSHOT_CHAIN_LENGTH + 1];
+    u32 chainCount = 0;
+    b32 cached = false;
+    for (SKLPhysicsSnapshot *at = snapshot; at; at = at->base)
+    {
+        if (at == snapshotCache->snapshot)
+        {
+            cached = true;
+            break;
+        }
+        if (chainCount == ArrayCount(chain))
+        {
+            return false;
+        }
+        chain[chainCount++] = at;
+    }
+
+    if (cached)
+    {
+        *state = snapshotCache->state;
+    }
+    else
+    {
+        state->clear();
+    }
+
+    for (u32 chainIndex = chainCount; chainIndex > 0; --chainIndex)
+    {
+        if (!ApplySnapshotRecords(chain[chainIndex - 1], state))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+SKLPhysicsSnapshot *SKLPhysicsSystem::SaveState(MemoryArena *arena, SKLPhysicsSnapshot *base)
+{
+    PROFILE_SCOPE("SavePhysicsState");
+
+    JPH::StateRecorderImpl recorder;
+    this->physicsSystem->SaveState(recorder);
+    std::string state = recorder.GetData();
+
+    if (base && base->chainLength + 1 >= MAX_SNAPSHOT_CHAIN_LENGTH)
+    {
+        base = nullptr;
+    }
+
+    std::string baseState;
+    if (base && !DecodeSnapshotState(this->snapshotCache, base, &baseState))
+    {
+        LOG_ERROR("Unable to decode the base of a physics snapshot, saving the whole state instead.");
+        base = nullptr;
+        baseState.clear();
+    }
+
+    std::string encoded;
+    EncodeSnapshotState(state, baseState, &encoded);
+
+    SKLPhysicsSnapshot *result = PushStruct(arena, SKLPhysicsSnapshot);
+    result->base = base;
+    result->data = PushArray(arena, encoded.size(), u8, NoClearArenaParams());
+    result->size = encoded.size();
+    result->stateSize = state.size();
+    result->chainLength = base ? base->chainLength + 1 : 0;
+    memcpy(result->data, encoded.data(), encoded.size());
+
+    this->snapshotCache->snapshot = result;
+    this->snapshotCache->state = std::move(state);
+    return result;
+}
+
+// NOTE(marvin): Every rigid body may have moved, not just the ones that
+// are awake, and there is nothing to blend from.
+local void WriteBackAllRigidBodies(SKLPhysicsSystem *sklPhysicsSystem, Scene *scene)
+{
+    JPH::BodyInterface &bodyInterface = sklPhysicsSystem->physicsSystem->GetBodyInterface();
+    for (EntityID ent : SceneView<RigidBody, Transform3D>(*scene))
+    {
+        RigidBody *rb = scene->Get<RigidBody>(ent);
+        Transform3D *t = scene->Get<Transform3D>(ent);
+        JPH::BodyID bodyID{rb->bodyID};
+        if (rb->bodyID == JPH::BodyID::cInvalidBodyID || !bodyInterface.IsAdded(bodyID))
+        {
+            continue;
+        }
+
+        JPH::Vec3 position;
+        JPH::Quat rotation;
+        bodyInterface.GetPositionAndRotation(bodyID, position, rotation);
+        rb->position = JPHVec3ToGLM(position);
+        rb->rotation = JPHQuatToGLM(rotation);
+        rb->previousPosition = rb->position;
+        rb->previousRotation = rb->rotation;
+
+        t->SetLocalPosition(JoltToOurCoordinateSystem(position));
+        t->SetLocalRotation(JoltToOurRotation(rotation));
+    }
+}
+
+b32 SKLPhysicsSystem::RestoreState(SKLPhysicsSnapshot *snapshot, Scene *scene)
+{
+    PROFILE_SCOPE("RestorePhysicsState");
+
+    std::string state;
+    if (!DecodeSnapshotState(this->snapshotCache, snapshot, &state))
+    {
+        LOG_ERROR("Unable to decode the physics snapshot.");
+        return false;
+    }
+
+    JPH::StateRecorderImpl recorder;
+    recorder.WriteBytes(state.data(), state.size());
+    recorder.Rewind();
+    if (!this->physicsSystem->RestoreState(recorder))
+    {
+        LOG_ERROR("Unable to restore the physics snapshot, the bodies have changed since it was saved.");
+        return false;
+    }
+
+    this->snapshotCache->snapshot = snapshot;
+    this->snapshotCache->state = std::move(state);
+
+    WriteBackAllRigidBodies(this, scene);
+    return true;
+}
+
+/**
+ * CONTACT EVENTS
+ */
+
+// The pair of sub shapes that a contact is between, as Jolt keeps
+// track of them.
+struct SKLContactKey
+{
+    u32 bodyID1;
+    u32 subShapeID1;
+    u32 bodyID2;
+    u32 subShapeID2;
+
+    bool operator==(const SKLContactKey &other) const = default;
+};
+
+// What a contact is between, from when it was added, for when it is
+// removed.
+struct SKLContactEntities
+{
+    EntityID ent1;
+    EntityID ent2;
+    b32 sensor;
+};
+
+// A contact as Jolt reported it. The entities are only known for the
+// contacts that were added or persisted, as Jolt only has the IDs of
+// the bodies of a contact that was removed.
+struct SKLContactRecord
+{
+    SKLContactEventType type;
+    SKLContactKey key;
+    SKLContactEntities entities;
+    f32 penetrationDepth;
+    JPH::Float3 point;
+    // From body 1 towards body 2.
+    JPH::Float3 normal;
+};
+
+// NOTE(marvin): Only ever written to by one thread during a step, so
+// it needs no locks, and on a cache line of its own, so that the
+// threads don't slow each other down.
+struct alignas(64) SKLContactRecordBuffer
+{
+    SKLContactRecord *records;
+    u32 count;
+    u32 capacity;
+    // The records that didn't fit in this step.
+    u32 droppedCount;
+};
+
+struct SKLActiveContact
+{
+    SKLContactKey key;
+    SKLContactEntities entities;
+    b32 occupied;
+};
+
+// NOTE(marvin): An open addressing table with linear probing, which is
+// never more than half full, as it grows before a merge that could
+// make it so. Removing shifts the contacts after it back, instead of
+// leaving a tombstone, so that a lookup only ever stops at an empty
+// slot.
+struct SKLActiveContactTable
+{
+    SKLActiveContact *slots;
+    u32 capacity;
+    u32 count;
+};
+
+// One record buffer for every thread that can run a physics job.
+struct SKLContactRecorder
+{
+    SKLContactRecordBuffer buffers[MAX_JOB_WORKERS + 1];
+    // NOTE(marvin): Only touched while merging, on the thread that ran
+    // the step, so that the contacts of a body that is gone by the
+    // time they are removed still have their entities.
+    SKLActiveContactTable activeContacts;
+};
+
+// NOTE(marvin): Called on the threads that run the physics jobs, in
+// the middle of a step, so it only records what it was told into the
+// buffer of the calling thread. Only a pointer to the buffers, because
+// the virtual table is in the game module, and so it is made again
+// after every hot reload, like the temp allocator.
+class SKLContactListener final : public JPH::ContactListener
+{
+public:
+    SKLContactRecorder *recorder;
+
+    explicit SKLContactListener(SKLContactRecorder *recorder) : recorder(recorder)
+    {
+    }
+
+    virtual void OnContactAdded(const JPH::Body &body1, const JPH::Body &body2,
+                                const JPH::ContactManifold &manifold, JPH::ContactSettings &settings) override
+    {
+        RecordContact(contactEventType_added, body1, body2, manifold);
+    }
+
+    virtual void OnContactPersisted(const JPH::Body &body1, const JPH::Body &body2,
+                                    const JPH::ContactManifold &manifold, JPH::ContactSettings &settings) override
+    {
+        RecordContact(contactEventType_persisted, body1, body2, manifold);
+    }
+
+    virtual void OnContactRemoved(const JPH::SubShapeIDPair &subShapePair) override
+    {
+        SKLContactRecord *record = PushRecord();
+        if (record)
+        {
+            record->type = contactEventType_removed;
+            record->key.bodyID1 = subShapePair.GetBody1ID().GetIndexAndSequenceNumber();
+            record->key.subShapeID1 = subShapePair.GetSubShapeID1().GetValue();
+            record->key.bodyID2 = subShapePair.GetBody2ID().GetIndexAndSequenceNumber();
+            record->key.subShapeID2 = subShapePair.GetSubShapeID2().GetValue();
+        }
+    }
+
+private:
+    SKLContactRecord *PushRecord()
+    {
+        SKLContactRecordBuffer *buffer = &this->recorder->buffers[GetJobThreadIndex(globalJobScheduler)];
+        if (buffer->count == buffer->capacity)
+        {
+            ++buffer->droppedCount;
+            return nullptr;
+        }
+
+        SKLContactRecord *result = &buffer->records[buffer->count++];
+        *result = {};
+        return result;
+    }
+
+    void RecordContact(SKLContactEventType type, const JPH::Body &body1, const JPH::Body &body2,
+                       const JPH::ContactManifold &manifold)
+    {
+        SKLContactRecord *record = PushRecord();
+        if (record)
+        {
+            record->type = type;
+            record->key.bodyID1 = body1.GetID().GetIndexAndSequenceNumber();
+            record->key.subShapeID1 = manifold.mSubShapeID1.GetValue();
+            record->key.bodyID2 = body2.GetID().GetIndexAndSequenceNumber();
+            record->key.subShapeID2 = manifold.mSubShapeID2.GetValue();
+            record->entities.ent1 = static_cast<EntityID>(body1.GetUserData());
+            record->entities.ent2 = static_cast<EntityID>(body2.GetUserData());
+            record->entities.sensor = body1.IsSensor() || body2.IsSensor();
+
+            JPH::Vec3 point = manifold.mRelativeContactPointsOn1.empty()
+                ? JPH::Vec3{manifold.mBaseOffset}
+                : JPH::Vec3{manifold.GetWorldSpaceContactPointOn1(0)};
+            point.StoreFloat3(&record->point);
+            manifold.mWorldSpaceNormal.StoreFloat3(&record->normal);
+            record->penetrationDepth = manifold.mPenetrationDepth;
+        }
+    }
+};
+
+local SKLActiveContact *AllocateActiveContacts(u32 capacity)
+{
+    SKLActiveContact *result = static_cast<SKLActiveContact *>(allocator.Allocate(capacity * sizeof(SKLActiveContact),
+                                                                                  memoryTag_physics));
+    memset(result, 0, capacity * sizeof(SKLActiveContact));
+    return result;
+}
+
+local u32 GetActiveContactHome(SKLActiveContactTable *table, const SKLContactKey &key)
+{
+    u32 result = static_cast<u32>(JPH::HashBytes(&key, sizeof(key))) & (table->capacity - 1);
+    return result;
+}
+
+// Produces the slot of the contact, or the empty slot where it would go.
+local SKLActiveContact *FindActiveContactSlot(SKLActiveContactTable *table, const SKLContactKey &key)
+{
+    u32 mask = table->capacity - 1;
+    u32 index = GetActiveContactHome(table, key);
+    while (table->slots[index].occupied && !(table->slots[index].key == key))
+    {
+        index = (index + 1) & mask;
+    }
+    SKLActiveContact *result = &table->slots[index];
+    return result;
+}
+
+local void SetActiveContact(SKLActiveContactTable *table, const SKLContactKey &key, const SKLContactEntities &entities)
+{
+    ASSERT(2 * (table->count + 1) <= table->capacity);
+    SKLActiveContact *slot = FindActiveContactSlot(table, key);
+    if (!slot->occupied)
+    {
+        slot->key = key;
+        slot->occupied = true;
+        ++table->count;
+    }
+    slot->entities = entities;
+}
+
+local void RemoveActiveContact(SKLActiveContactTable *table, SKLActiveContact *slot)
+{
+    u32 mask = table->capacity - 1;
+    u32 hole = static_cast<u32>(slot - table->slots);
+    u32 index = hole;
+    for (;;)
+    {
+        index = (index + 1) & mask;
+        SKLActiveContact *next = &table->slots[index];
+        if (!next->occupied)
+        {
+            break;
+        }
+
+        // NOTE(marvin): A contact can only move back into the hole if
+        // the hole is between its home and where it is now, or the
+        // lookups for it would stop at the hole.
+        u32 home = GetActiveContactHome(table, next->key);
+        if (((index - home) & mask) >= ((index - hole) & mask))
+        {
+            table->slots[hole] = *next;
+            hole = index;
+        }
+    }
+    table->slots[hole] = {};
+    --table->count;
+}
+
+// Grows the table so that the given number of contacts can be added
+// while it stays at most half full.
+local void ReserveActiveContacts(SKLActiveContactTable *table, u32 addCount)
+{
+    u32 capacity = table->capacity;
+    while (2 * (table->count + addCount) > capacity)
+    {
+        capacity *= 2;
+    }
+    if (capacity == table->capacity)
+    {
+        return;
+    }
+
+    SKLActiveContactTable grown = {AllocateActiveContacts(capacity), capacity, 0};
+    for (u32 index = 0; index < table->capacity; ++index)
+    {
+        SKLActiveContact *contact = &table->slots[index];
+        if (contact->occupied)
+        {
+            SetActiveContact(&grown, contact->key, contact->entities);
+        }
+    }
+    allocator.Free(table->slots);
+    *table = grown;
+}
+
+local SKLContactRecorder *CreateContactRecorder()
+{
+    SKLContactRecorder *result = new SKLContactRecorder();
+    for (SKLContactRecordBuffer &buffer : result->buffers)
+    {
+        buffer = {};
+        buffer.capacity = INITIAL_CONTACT_RECORD_CAPACITY;
+        buffer.records = static_cast<SKLContactRecord *>(allocator.Allocate(buffer.capacity * sizeof(SKLContactRecord),
+                                                                            memoryTag_physics));
+    }
+    result->activeContacts = {AllocateActiveContacts(INITIAL_ACTIVE_CONTACT_CAPACITY), INITIAL_ACTIVE_CONTACT_CAPACITY, 0};
+    return result;
+}
+
+local void DestroyContactRecorder(SKLContactRecorder *recorder)
+{
+    for (SKLContactRecordBuffer &buffer : recorder->buffers)
+    {
+        allocator.Free(buffer.records);
+    }
+    allocator.Free(recorder->activeContacts.slots);
+    delete recorder;
+}
+
+local JPH::Vec3 LoadFloat3(JPH::Float3 value)
+{
+    JPH::Vec3 result{value.x, value.y, value.z};
+    return result;
+}
+
+local void PushContactEvent(SKLPhysicsSystem *sklPhysicsSystem, SKLContactEvent *event)
+{
+    if (sklPhysicsSystem->contactEventCount == sklPhysicsSystem->contactEventCapacity)
+    {
+        u32 capacity = 2 * sklPhysicsSystem->contactEventCapacity;
+        sklPhysicsSystem->contactEvents = static_cast<SKLContactEvent *>(
+            allocator.Realloc(sklPhysicsSystem->contactEvents, sklPhysicsSystem->contactEventCapacity * sizeof(SKLContactEvent),
+                              capacity * sizeof(SKLContactEvent)));
+        sklPhysicsSystem->contactEventCapacity = capacity;
+    }
+    sklPhysicsSystem->contactEvents[sklPhysicsSystem->contactEventCount++] = *event;
+}
+
+local void PushContactEvents(SKLPhysicsSystem *sklPhysicsSystem, SKLContactRecord *record,
+                             SKLContactEntities *entities, u32 stepIndex)
+{
+    SKLContactEvent event = {};
+    event.type = record->type;
+    event.sensor = entities->sensor;
+    event.stepIndex = stepIndex;
+    event.point = JoltToOurCoordinateSystem(LoadFloat3(record->point));
+    event.penetrationDepth = record->penetrationDepth;
+
+    event.entity = entities->ent1;
+    event.otherEntity = entities->ent2;
+    event.bodyID = record->key.bodyID1;
+    event.otherBodyID = record->key.bodyID2;
+    event.normal = JoltToOurCoordinateSystem(LoadFloat3(record->normal));
+    PushContactEvent(sklPhysicsSystem, &event);
+
+    event.entity = entities->ent2;
+    event.otherEntity = entities->ent1;
+    event.bodyID = record->key.bodyID2;
+    event.otherBodyID = record->key.bodyID1;
+    event.normal = -event.normal;
+    PushContactEvent(sklPhysicsSystem, &event);
+}
+
+// NOTE(marvin): Called after a step, on the thread that ran it, which
+// is where the records become events of the entities, and where the
+// buffers that ran out grow. The bodies aren't locked here, as those of
+// the removed contacts may be gone, the entities of a contact are kept
+// from when it was added or persisted instead. So the contacts that were
+// added or persisted go first, and then the removed ones.
+local void MergeContactRecords(SKLPhysicsSystem *sklPhysicsSystem)
+{
+    PROFILE_SCOPE("MergeContactRecords");
+
+    SKLContactRecorder *recorder = sklPhysicsSystem->contactRecorder;
+    u32 stepIndex = sklPhysicsSystem->frameStepCount++;
+
+    // NOTE(marvin): Only grows after a step with more contacts than
+    // ever before, like the buffers.
+    u32 recordCount = 0;
+    for (SKLContactRecordBuffer &buffer : recorder->buffers)
+    {
+        recordCount += buffer.count;
+    }
+    ReserveActiveContacts(&recorder->activeContacts, recordCount);
+
+    for (SKLContactRecordBuffer &buffer : recorder->buffers)
+    {
+        for (u32 recordIndex = 0; recordIndex < buffer.count; ++recordIndex)
+        {
+            SKLContactRecord *record = &buffer.records[recordIndex];
+            if (record->type != contactEventType_removed)
+            {
+                SetActiveContact(&recorder->activeContacts, record->key, record->entities);
+                PushContactEvents(sklPhysicsSystem, record, &record->entities, stepIndex);
+            }
+        }
+    }
+
+    for (SKLContactRecordBuffer &buffer : recorder->buffers)
+    {
+        for (u32 recordIndex = 0; recordIndex < buffer.count; ++recordIndex)
+        {
+            SKLContactRecord *record = &buffer.records[recordIndex];
+            if (record->type == contactEventType_removed)
+            {
+                // NOTE(marvin): Not there for a contact that was added
+                // before the physics system was restored or remade.
+                SKLActiveContact *contact = FindActiveContactSlot(&recorder->activeContacts, record->key);
+                if (contact->occupied)
+                {
+                    PushContactEvents(sklPhysicsSystem, record, &contact->entities, stepIndex);
+                    RemoveActiveContact(&recorder->activeContacts, contact);
+                }
+            }
+        }
+        buffer.count = 0;
+
+        if (buffer.droppedCount)
+        {
+            u32 capacity = 2 * buffer.capacity;
+            LOG_ERROR(buffer.droppedCount << " contacts didn't fit in a contact buffer of " << buffer.capacity
+                      << ", growing it to " << capacity << ".");
+            buffer.records = static_cast<SKLContactRecord *>(
+                allocator.Realloc(buffer.records, buffer.capacity * sizeof(SKLContactRecord), capacity * sizeof(SKLContactRecord)));
+            buffer.capacity = capacity;
+            buffer.droppedCount = 0;
+        }
+    }
+
+    // NOTE(marvin): By the step as well, so that the events of an entity
+    // stay in the order of the steps. std::sort, unlike a stable sort,
+    // doesn't allocate.
+    std::sort(sklPhysicsSystem->contactEvents, sklPhysicsSystem->contactEvents + sklPhysicsSystem->contactEventCount,
+              [](const SKLContactEvent &a, const SKLContactEvent &b)
+              {
+                  return a.entity < b.entity || (a.entity == b.entity && a.stepIndex < b.stepIndex);
+              });
+}
+
+void SKLPhysicsSystem::BeginFrame()
+{
+    this->contactEventCount = 0;
+    this->frameStepCount = 0;
+}
+
+std::span<SKLContactEvent> SKLPhysicsSystem::GetContactEvents()
+{
+    std::span<SKLContactEvent> result{this->contactEvents, this->contactEventCount};
+    return result;
+}
+
+std::span<SKLContactEvent> SKLPhysicsSystem::GetContactEvents(EntityID ent)
+{
+    SKLContactEvent *begin = this->contactEvents;
+    SKLContactEvent *end = this->contactEvents + this->contactEventCount;
+    SKLContactEvent *first = std::lower_bound(begin, end, ent,
+                                              [](const SKLContactEvent &event, EntityID value) { return event.entity < value; });
+    SKLContactEvent *last = std::upper_bound(first, end, ent,
+                                             [](EntityID value, const SKLContactEvent &event) { return value < event.entity; });
+    std::span<SKLContactEvent> result{first, static_cast<siz>(last - first)};
+    return result;
+}
+
+/**
+ * SYSTEM DEFINITION
+ */
+
+SKLPhysicsSystem::SKLPhysicsSystem() : SYSTEM_SUPER(SKLPhysicsSystem)
+{
+    this->preUpdateSubsystemBuffer = {};
+    this->postUpdateSubsystemBuffer = {};
+}
+
+SKLPhysicsSystem::~SKLPhysicsSystem()
+{
+    delete this->allocator;
+    delete this->jobSystem;
+    ::allocator.AlignedFree(this->tempArena.arena.base);
+    delete this->objectLayerPairFilter;
+    delete this->objectVsBroadPhaseLayerFilter;
+    delete this->broadPhaseLayer;
+    delete this->physicsSystem;
+    delete this->shapeCache;
+    delete this->snapshotCache;
+    delete this->contactListener;
+    DestroyContactRecorder(this->contactRecorder);
+    ::allocator.Free(this->contactEvents);
+    ::allocator.Free(this->awakeBodyIDs);
+}
+
+MAKE_SYSTEM_MANUAL_VTABLE(SKLPhysicsSystem);
+
+SYSTEM_ON_START(SKLPhysicsSystem)
+{
+    scene->TrackAdded<StaticBox>();
+    scene->TrackAdded<RigidBody>();
+    scene->TrackAdded<MeshCollider>();
+}
+
+SYSTEM_ON_UPDATE(SKLPhysicsSystem)
+{
+    BeginTempArenaStep(&this->tempArena);
+
+    if (CapacitiesRequested(this))
+    {
+        RecreatePhysicsSystem(this, scene);
+    }
+
+    AddNewStaticBoxes(this, scene);
+    AddNewMeshColliders(this, scene);
+    AddNewRigidBodies(this, scene);
+
+    UpdateSubsystems(this->preUpdateSubsystemBuffer, this, SYSTEM_VTABLE_ON_UPDATE_PASS);
+
+    u32 collisionSteps = 1;
+    JPH::EPhysicsUpdateError error = this->physicsSystem->Update(deltaTime, collisionSteps, this->allocator, this->jobSystem);
+    if (error != JPH::EPhysicsUpdateError::None)
+    {
+        RequestCapacitiesForUpdateError(this, error);
+    }
+
+    WriteBackActiveBodies(this, scene);
+    MergeContactRecords(this);
+
+    UpdateSubsystems(this->postUpdateSubsystemBuffer, this, SYSTEM_VTABLE_ON_UPDATE_PASS);
+
+    EndTempArenaStep(&this->tempArena);
+}
+
+void SKLPhysicsSystem::Initialize(b32 firstTime, Scene *scene)
+{
+    JPH::AlignedAllocate = JoltAlignedAllocate;
+    JPH::AlignedFree = JoltAlignedFree;
+    JPH::Allocate = JoltAllocate;
+    JPH::Free = JoltFree;
+    JPH::Reallocate = JoltReallocate;
+
+    if (firstTime)
+    {
+        JPH::Factory::sInstance = new JPH::Factory();
+        JPH::RegisterTypes();
+
+        this->jobSystem = new SKLJobSystem(globalJobScheduler, MAX_PHYSICS_JOBS, MAX_PHYSICS_BARRIERS);
+
+        if (!this->userOverrideLayers)
+        {
+            this->broadPhaseLayer = new SklBroadPhaseLayer();
+            this->objectVsBroadPhaseLayerFilter = new SklObjectVsBroadPhaseLayerFilter();
+            this->objectLayerPairFilter = new SklObjectLayerPairFilter();
+        }
+
+        // NOTE(marvin): Sized for the bodies of the map that was loaded.
+        // The body pairs and contact constraints start out the same, and
+        // each grows on its own when a step runs out of it.
+        u32 bodyCount = scene ? CountPhysicsBodies(scene) : 0;
+        u32 maxBodies = GetPhysicsBodyCapacity(bodyCount);
+        this->capacities = {maxBodies, maxBodies, maxBodies};
+        this->requestedCapacities = this->capacities;
+        this->physicsSystemGeneration = 0;
+
+        this->contactRecorder = CreateContactRecorder();
+        this->contactListener = new SKLContactListener(this->contactRecorder);
+        this->contactEventCapacity = INITIAL_CONTACT_EVENT_CAPACITY;
+        this->contactEvents = static_cast<SKLContactEvent *>(::allocator.Allocate(this->contactEventCapacity * sizeof(SKLContactEvent),
+                                                                               memoryTag_physics));
+        this->contactEventCount = 0;
+        this->frameStepCount = 0;
+        this->awakeBodyCapacity = INITIAL_AWAKE_BODY_CAPACITY;
+        this->awakeBodyIDs = static_cast<u32 *>(::allocator.Allocate(this->awakeBodyCapacity * sizeof(u32), memoryTag_physics));
+        this->awakeBodyCount = 0;
+
+        this->physicsSystem = CreateJoltPhysicsSystem(this, this->capacities);
+        this->shapeCache = CreateShapeCache();
+        this->snapshotCache = new SKLSnapshotCache();
+
+        this->tempArena = {};
+        ResizeTempArena(&this->tempArena, INITIAL_TEMPORARY_MEMORY_SIZE);
+        this->allocator = new SKLTempAllocator(&this->tempArena);
+        RegisterTelemetryArena(globalMemoryTelemetry, &this->tempArena.arena, "Physics Temp", memoryTag_physics);
+    }
+    else
+    {
+        // NOTE(marvin): Their virtual tables were in the previous game
+        // module. The job system is destroyed without going through its
+        // virtual table, and then they are all made again where they
+        // were.
+        SKLJobSystem *jobSystem = static_cast<SKLJobSystem *>(this->jobSystem);
+        jobSystem->SKLJobSystem::~SKLJobSystem();
+        new (jobSystem) SKLJobSystem(globalJobScheduler, MAX_PHYSICS_JOBS, MAX_PHYSICS_BARRIERS);
+        new (this->allocator) SKLTempAllocator(&this->tempArena);
+        new (static_cast<SKLContactListener *>(this->contactListener)) SKLContactListener(this->contactRecorder);
     }
 }
 
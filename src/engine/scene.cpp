@@ -1,6 +1,8 @@
 #include <meta_definitions.h>
 #include <scene.h>
 #include <system_registry.h>
+#include <debug.h>
+#include <component_layout.h>
 
 /*
  * ENTITY FUNCTIONALITY
@@ -63,6 +65,12 @@ void ComponentPoolsBuffer::Push(ComponentPool componentPool)
  * SCENE FUNCTIONALITY
  */
 
+#if SKL_INTERNAL
+// NOTE(marvin): Each system's updates are timed as if they were a
+// timed block named after the system, indexed by the system index.
+DebugRecord debugSystemRecordArray[MAX_SYSTEMS * 2];
+#endif
+
 void PushSystemsBuffer(SystemsBuffer *systemsBuffer, System *system)
 {
     ASSERT(systemsBuffer->count < MAX_SYSTEMS);
@@ -94,6 +102,9 @@ void UpdateAllSystems(SystemsBuffer *systemsBuffer, Scene *scene, GameInput *inp
     {
         System *system = systemsBuffer->base[i];
         SystemVTable* vtable = GetSystemVTable(system);
+#if SKL_INTERNAL
+        TimedBlock timedBlock = TimedBlock(debugSystemRecordArray[system->index], __FILE__, __LINE__, vtable->name);
+#endif
         vtable->onUpdate(system, scene, input, deltaTime);
     }
 }
@@ -108,6 +119,8 @@ Scene::Scene(MemoryArena *remainingArena)
     this->systemsArena = SubArena(remainingArena, SYSTEMS_MEMORY, "Systems");
     this->componentPools = ComponentPoolsBuffer(remainingArena);
     this->componentPoolsArena = SubArena(remainingArena, COMPONENT_POOLS_MEMORY, "Component Pools");
+    this->componentLayouts = PushStruct(remainingArena, ComponentLayoutTable);
+    this->componentAddedLists = PushArray(remainingArena, MAX_COMPONENTS, ComponentAddedList);
 }
 
 Scene::~Scene()
@@ -148,6 +161,31 @@ void Scene::AddComponentPool(size_t componentSize)
     componentPools.Push(componentPool);
 }
 
+void Scene::TrackAdded(ComponentID componentId)
+{
+    ASSERT(componentId < GetNumCompTypes());
+    ComponentAddedList *added = componentAddedLists + componentId;
+    if (added->entities)
+    {
+        return;
+    }
+
+    // NOTE(marvin): Along with the component pools, as it is
+    // bookkeeping of the components.
+    added->entities = PushArray(&componentPoolsArena, COMPONENT_ADDED_LIST_CAPACITY, EntityID);
+    ClearComponentAdded(added);
+
+    u32 entityCount = GetEntitiesPoolSize(&entities);
+    for (u32 entityIndex = 0; entityIndex < entityCount; ++entityIndex)
+    {
+        EntityEntry *entityEntry = GetFromEntitiesPool(&entities, entityIndex);
+        if (EntityEntryValid(entityEntry) && entityEntry->mask.test(componentId))
+        {
+            PushComponentAdded(added, entityEntry->id);
+        }
+    }
+}
+
 EntityID Scene::NewEntity()
 {
     if (!FreeIndicesStackIsEmpty(&freeIndices))
@@ -2,28 +2,29 @@
 
 #include <utils.h>
 #include <game_platform.h>
+#include <input_actions.h>
 #include <skl_math_types.h>
 
 glm::vec3 GetMovementDirection(GameInput *input, Transform3D *t)
 {
     glm::vec3 result{};
 
-    if (OnHold(input, "W"))
+    if (OnHold(input, inputAction_moveForward))
     {
         result += t->GetForwardVector();
     }
 
-    if (OnHold(input, "S"))
+    if (OnHold(input, inputAction_moveBackward))
     {
         result -= t->GetForwardVector();
     }
 
-    if (OnHold(input, "D"))
+    if (OnHold(input, inputAction_moveRight))
     {
         result += t->GetRightVector();
     }
 
-    if (OnHold(input, "A"))
+    if (OnHold(input, inputAction_moveLeft))
     {
         result -= t->GetRightVector();
     }
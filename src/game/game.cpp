@@ -20,7 +20,10 @@ void OnGameStart(GameState* gameState, GameMemory* gameMemory)
     Scene &scene = gameState->scene;
     b32 slowStep = false;
 
-    scene.CreateSemifixedTimestepSystem<MovementSystem>();
+    // NOTE(marvin): Movement goes by the mouse of the frame, which a
+    // frame without a fixed step would drop, and one with two would
+    // apply twice.
+    scene.CreateVariableTimestepSystem<MovementSystem>();
     scene.CreateSemifixedTimestepSystem<BuilderSystem>(slowStep);
 
     assetUtils.LoadSkyboxAsset({"YokohamaSkybox/posx", "YokohamaSkybox/negx", "YokohamaSkybox/posy", "YokohamaSkybox/negy", "YokohamaSkybox/posz", "YokohamaSkybox/negz"});
@@ -58,8 +58,10 @@ void RemoveMemoryBlock(SDLState *state, SDLMemoryBlock *block)
 
 // >>> Game Module Interface Implementation <<<
 
-void* AlignedAllocate(siz requestedSize, siz alignment)
+void* AlignedAllocate(siz requestedSize, siz alignment, MemoryTag tag)
 {
+    RECORD_GUARDED_ALLOCATION(allocationGuardSource_platformAllocator, requestedSize);
+
     // NOTE(marvin): As to not mess with the alignment. There might be
     // space at the front that has to be sacrificed.
     siz sizeForMemoryBlock = RoundUpToMultiple(sizeof(SDLMemoryBlock), alignment);
@@ -81,7 +83,9 @@ void* AlignedAllocate(siz requestedSize, siz alignment)
     memoryBlockBase->requestedBase = result;
     memoryBlockBase->wholeBase = base;
     memoryBlockBase->requestedSize = requestedSize;
+    memoryBlockBase->tag = tag;
     AddMemoryBlock(&globalSDLState, memoryBlockBase);
+    RecordTelemetryAllocate(&globalSDLState.memoryTelemetry, tag, requestedSize);
 
     return result;
 }
@@ -90,6 +94,7 @@ void AlignedFree(void* block)
 {
     SDLMemoryBlock *memoryBlockBase = static_cast<SDLMemoryBlock*>(block) - 1;
     void* toFree = memoryBlockBase->wholeBase;
+    RecordTelemetryFree(&globalSDLState.memoryTelemetry, memoryBlockBase->tag, memoryBlockBase->requestedSize);
     if (LoopUtils::GetIsStateInLoop(&globalSDLState)) 
     {
         LoopUtils::SetBlockFlagLoopFreed(memoryBlockBase);
@@ -103,8 +108,10 @@ void AlignedFree(void* block)
 
 // TODO(marvin): The non-aligned de/allocation procedures look very similar to their aligned counterparts. Main difference is round up to multiple and figuring out where memory block base is. Is it worth abstracting? 
 
-void* Allocate(siz requestedSize)
+void* Allocate(siz requestedSize, MemoryTag tag)
 {
+    RECORD_GUARDED_ALLOCATION(allocationGuardSource_platformAllocator, requestedSize);
+
     siz sizeForMemoryBlock = sizeof(SDLMemoryBlock);
     siz totalSize = sizeForMemoryBlock + requestedSize;
     void *base = SDL_malloc(totalSize);
@@ -123,7 +130,9 @@ void* Allocate(siz requestedSize)
     memoryBlockBase->requestedBase = result;
     memoryBlockBase->wholeBase = base;
     memoryBlockBase->requestedSize = requestedSize;
+    memoryBlockBase->tag = tag;
     AddMemoryBlock(&globalSDLState, memoryBlockBase);
+    RecordTelemetryAllocate(&globalSDLState.memoryTelemetry, tag, requestedSize);
     return result;
 }
 
@@ -132,6 +141,7 @@ void Free(void* block)
     // TODO(marvin): Very similar to AlignedFree, except SDL_free instead of SDL_aligned_free.... Is it worth abstracting?
     SDLMemoryBlock* memoryBlockBase = static_cast<SDLMemoryBlock*>(block) - 1;
     void* toFree = memoryBlockBase->wholeBase;
+    RecordTelemetryFree(&globalSDLState.memoryTelemetry, memoryBlockBase->tag, memoryBlockBase->requestedSize);
 
     if (LoopUtils::GetIsStateInLoop(&globalSDLState)) 
     {
@@ -149,7 +159,7 @@ void* Realloc(void* block, siz oldRequestedSize, siz newRequestedSize)
     if (block == nullptr)
     {
         ASSERT(oldRequestedSize == 0);
-        return Allocate(newRequestedSize);
+        return Allocate(newRequestedSize, memoryTag_general);
     }
     
     siz sizeForMemoryBlock = sizeof(SDLMemoryBlock);
@@ -160,34 +170,44 @@ void* Realloc(void* block, siz oldRequestedSize, siz newRequestedSize)
     void* oldMemoryBlockBaseAddr = static_cast<void*>(oldMemoryBlockBase);
     void* oldWholeBase = oldMemoryBlockBase->wholeBase;
     siz padding = static_cast<u8*>(oldMemoryBlockBaseAddr) - static_cast<u8*>(oldWholeBase);
+    MemoryTag tag = oldMemoryBlockBase->tag;
     
     // NOTE(marvin): If in loop, can't just use SDL_realloc as that
     // would purge the memory block, when it is needed when the loop
-    // restarts.
-    b32 canRealloc = !LoopUtils::GetIsStateInLoop(&globalSDLState);
+    // restarts. Instead, a fresh block is made and the old one is
+    // flagged as freed.
+    if (LoopUtils::GetIsStateInLoop(&globalSDLState))
+    {
+        void* result = Allocate(newRequestedSize, tag);
+        SDL_memcpy(result, block, Minimum(oldRequestedSize, newRequestedSize));
+        RecordTelemetryFree(&globalSDLState.memoryTelemetry, tag, oldMemoryBlockBase->requestedSize);
+        LoopUtils::SetBlockFlagLoopFreed(oldMemoryBlockBase);
+        return result;
+    }
+
+    RecordTelemetryFree(&globalSDLState.memoryTelemetry, tag, oldMemoryBlockBase->requestedSize);
+    RECORD_GUARDED_ALLOCATION(allocationGuardSource_platformAllocator, newRequestedSize);
 
-    void* newBase = canRealloc ? SDL_realloc(oldWholeBase, newTotalSize) : Allocate(newTotalSize);
+    void* newBase = SDL_realloc(oldWholeBase, newTotalSize);
     void* newMemoryBlockBaseAddr = static_cast<void*>(static_cast<u8*>(newBase) + padding);
     SDLMemoryBlock* newMemoryBlockBase = static_cast<SDLMemoryBlock*>(newMemoryBlockBaseAddr);
     u8* requestedBase = static_cast<u8*>(newMemoryBlockBaseAddr) + sizeForMemoryBlock;
     void* result = static_cast<void*>(requestedBase);
 
-    if (canRealloc && newMemoryBlockBase != oldMemoryBlockBase)
+    newMemoryBlockBase->requestedSize = newRequestedSize;
+    if (newMemoryBlockBase != oldMemoryBlockBase)
     {
         newMemoryBlockBase->requestedBase = result;
         newMemoryBlockBase->wholeBase = newBase;
-        newMemoryBlockBase->requestedSize = newRequestedSize;
 
-        RemoveMemoryBlock(&globalSDLState, oldMemoryBlockBase);
+        // NOTE(marvin): The old block is gone, but its neighbours are
+        // still linked to it. The moved header still has the same
+        // links, so unlinking it fixes up the neighbours.
+        RemoveMemoryBlock(&globalSDLState, newMemoryBlockBase);
         AddMemoryBlock(&globalSDLState, newMemoryBlockBase);
     }
-    else if (!canRealloc)
-    {
-        // NOTE(marvin): It is a necessary condition that in loop, so can skip check.
-        LoopUtils::SetBlockFlagLoopFreed(oldMemoryBlockBase);
-    }
+
+    RecordTelemetryAllocate(&globalSDLState.memoryTelemetry, tag, newRequestedSize);
     
     return result;
 }
-
-
@@ -13,6 +13,7 @@
 #include <asset_types.h>
 #include <meta_definitions.h>
 #include <render_backend.h>
+#include <platform_memory.h>
 
 template <>
 struct fastgltf::ElementTraits<glm::vec3> : fastgltf::ElementTraitsBase<glm::vec3, AccessorType::Vec3, f32> {};
@@ -226,8 +227,20 @@ MeshAsset* LoadMeshAsset(std::string name)
 
     MeshAsset asset;
     asset.name = name;
-    asset.id = UploadMesh(info);
-    meshAssets[name] = asset;
+    asset.id = globalSDLState.noRenderer ? -1 : UploadMesh(info);
+    asset.positions.reserve(vertices.size());
+    for (Vertex &vertex : vertices)
+    {
+        asset.positions.push_back(vertex.position);
+    }
+    asset.indices = indices;
+    meshAssets[name] = std::move(asset);
+
+    // NOTE(marvin): The positions and indices kept for the colliders
+    // stay resident here, the uploaded copy is recorded by the
+    // renderer.
+    u64 colliderBytes = vertices.size() * sizeof(glm::vec3) + indices.size() * sizeof(u32);
+    RecordTelemetryAllocate(&globalSDLState.memoryTelemetry, memoryTag_assets, colliderBytes);
 
     return &meshAssets[name];
 }
@@ -250,9 +263,9 @@ TextureAsset* LoadTextureAsset(std::string name)
     asset.width = info.width;
     asset.height = info.height;
     RenderUploadTextureInfo uploadInfo = {info.width, info.height, info.data};
-    asset.id = UploadTexture(uploadInfo);
+    asset.id = globalSDLState.noRenderer ? -1 : UploadTexture(uploadInfo);
     texAssets[name] = asset;
-    
+
     return &texAssets[name];
 }
 
@@ -281,7 +294,10 @@ void LoadSkyboxAsset(std::array<std::string,6> names) {
     setInfo.width = firstWidth;
     setInfo.height = firstHeight;
     setInfo.cubemapData = setData;
-    SetSkyboxTexture(setInfo);
+    if (!globalSDLState.noRenderer)
+    {
+        SetSkyboxTexture(setInfo);
+    }
 }
 
 DataEntry* LoadDataAsset(std::string name)
@@ -17,6 +17,8 @@
 #include <game_platform.h>
 #include <render_backend.h>
 #include <platform_loader.h>
+#include <platform_replay.h>
+#include <job_scheduler.h>
 #include <main.h>
 
 #if SKL_DEBUG_MEMORY_VIEWER
@@ -24,6 +26,12 @@ DebugState globalDebugState_;
 DebugState* globalDebugState = &globalDebugState_;
 #endif
 
+#if SKL_INTERNAL
+DebugProfiler globalDebugProfiler_;
+#endif
+
+JobScheduler globalJobScheduler;
+
 struct AppInformation
 {
     GameCode gameCode;
@@ -52,7 +60,7 @@ struct AppInformation
 #define WINDOW_WIDTH 1600
 #define WINDOW_HEIGHT 1200
 
-file_global std::set<std::string> keysDown;
+file_global InputButtons buttonsDown;
 file_global f32 mouseDeltaX = 0;
 file_global f32 mouseDeltaY = 0;
 
@@ -77,6 +85,36 @@ local void LaunchGame(SDLState* state, const char* mapName)
     }
 }
 
+#if SKL_INTERNAL
+// Shows the slot and the frame of looped live editing, and lets the
+// playback be scrubbed to any frame of the recording.
+local void RenderLoopControls()
+{
+    if (!LoopUtils::GetIsStateInLoop(&globalSDLState))
+    {
+        return;
+    }
+
+    ImGui::Begin("Loop");
+    ImGui::Text("Slot %u", LoopUtils::GetSlotIndex(&globalSDLState) + 1);
+
+    s32 frameCount = static_cast<s32>(LoopUtils::GetRecordedFrameCount(&globalSDLState));
+    if (LoopUtils::GetIsStateInPlayback(&globalSDLState) && frameCount > 0)
+    {
+        s32 frameIndex = static_cast<s32>(LoopUtils::GetPlaybackFrameIndex(&globalSDLState));
+        if (ImGui::SliderInt("Frame", &frameIndex, 0, frameCount - 1))
+        {
+            LoopUtils::SeekToFrame(&globalSDLState, frameIndex);
+        }
+    }
+    else
+    {
+        ImGui::Text("Recording frame %d", frameCount);
+    }
+    ImGui::End();
+}
+#endif
+
 void updateLoop(void* appInfo) {
     AppInformation* info = (AppInformation* )appInfo;
     info->last = info->now;
@@ -84,10 +122,18 @@ void updateLoop(void* appInfo) {
 
     f32 frameTime = (f32)((info->now - info->last) / (f32)SDL_GetPerformanceFrequency());
 
+    FrameStats *frameStats = &globalSDLState.frameStats;
+    BeginFrameStatsFrame(frameStats, info->now, SDL_GetPerformanceFrequency());
+    BeginFramePhase(frameStats, framePhase_input);
+
+    // NOTE(marvin): Before the game code may be reloaded, as no job of
+    // the game module is running between frames.
+    ApplyJobWorkerCount(&globalJobScheduler);
+
     info->gameCode.updateGameCode(info->gameMemory, info->editor);
 
-    GameInput gameInput;
-    gameInput.keysDownPrevFrame = keysDown;
+    GameInput gameInput = {};
+    gameInput.buttonsDownPrevFrame = buttonsDown;
 
     b8 forceReloadGameCode = false;
 
@@ -117,21 +163,37 @@ void updateLoop(void* appInfo) {
                         forceReloadGameCode = true;
                     }
                 }
+                else if (info->e.key.key >= SDLK_F1 && info->e.key.key <= SDLK_F4)
+                {
+                    LoopUtils::SelectSlot(&globalSDLState, info->e.key.key - SDLK_F1);
+                }
 #endif
                 else if (info->editor && info->e.key.key == SDLK_R && (SDL_GetModState() & SDL_KMOD_CTRL))
                 {
                     LaunchGame(&globalSDLState, info->mapName);
                 }
-                keysDown.insert(SDL_GetKeyName(info->e.key.key));
+                if (info->e.key.scancode < keyCode_count)
+                {
+                    SetKeyDown(&buttonsDown, info->e.key.scancode, true);
+                }
                 break;
             case SDL_EVENT_KEY_UP:
-                keysDown.erase(SDL_GetKeyName(info->e.key.key));
+                if (info->e.key.scancode < keyCode_count)
+                {
+                    SetKeyDown(&buttonsDown, info->e.key.scancode, false);
+                }
                 break;
             case SDL_EVENT_MOUSE_BUTTON_DOWN:
-                keysDown.insert(std::format("Mouse {}", info->e.button.button));
+                if (info->e.button.button < mouseButton_count)
+                {
+                    SetMouseButtonDown(&buttonsDown, info->e.button.button, true);
+                }
                 break;
             case SDL_EVENT_MOUSE_BUTTON_UP:
-                keysDown.erase(std::format("Mouse {}", info->e.button.button));
+                if (info->e.button.button < mouseButton_count)
+                {
+                    SetMouseButtonDown(&buttonsDown, info->e.button.button, false);
+                }
                 break;
         }
     }
@@ -149,63 +211,63 @@ void updateLoop(void* appInfo) {
     
     if (io.WantCaptureMouse)
     {
-        keysDown.erase("Mouse 1");
+        SetMouseButtonDown(&buttonsDown, mouseButton_left, false);
     }
 
     gameInput.mouseDeltaX = mouseDeltaX;
     gameInput.mouseDeltaY = mouseDeltaY;
     gameInput.mouseX = mouseX;
     gameInput.mouseY = mouseY;
-    gameInput.keysDownThisFrame = keysDown;
+    gameInput.buttonsDownThisFrame = buttonsDown;
 
-    b32 shouldReloadGameCode = LoopUtils::ProcessInputWithLooping(&globalSDLState, &gameInput, forceReloadGameCode);
+#if SKL_INTERNAL
+    RenderLoopControls();
+
+    // NOTE(marvin): After a seek, the frames between the keyframe and
+    // the frame that was sought are simulated without rendering.
+    // Their systems count towards the phases of this frame.
+    GameInput fastForwardInput;
+    f32 fastForwardFrameTime;
+    EndFramePhase(frameStats, framePhase_input);
+    info->gameMemory.skipRender = true;
+    while (LoopUtils::NextFastForwardInput(&globalSDLState, &fastForwardInput, &fastForwardFrameTime))
+    {
+        info->gameCode.gameUpdateAndRender(info->gameMemory, fastForwardInput, fastForwardFrameTime);
+    }
+    info->gameMemory.skipRender = false;
+    BeginFramePhase(frameStats, framePhase_input);
+#endif
+
+    b32 shouldReloadGameCode = LoopUtils::ProcessInputWithLooping(&globalSDLState, &gameInput, &frameTime, forceReloadGameCode);
     if (shouldReloadGameCode)
     {
         info->gameCode.gameLoad(info->gameMemory, info->editor, true);
     }
-    
+    EndFramePhase(frameStats, framePhase_input);
+
     info->gameCode.gameUpdateAndRender(info->gameMemory, gameInput, frameTime);
 
+    EndMemoryTelemetryFrame(&globalSDLState.memoryTelemetry);
+#if SKL_INTERNAL
+    UpdateProfilerTimerFrequency(globalDebugProfiler, SDL_GetPerformanceCounter(), SDL_GetPerformanceFrequency());
+#endif
+
     mouseDeltaX = 0;
     mouseDeltaY = 0;
-
-    f32 msPerFrame =  1000.0f * frameTime;
-    f32 fps = 1 / frameTime;
-    //printf("%.02f ms/frame (FPS: %.02f)\n", msPerFrame, fps);
-    return;
 }
 
 
 int main(int argc, char** argv)
 {
     std::cout << "Current path: " << std::filesystem::current_path() << std::endl;
-    srand(static_cast<unsigned>(time(0)));
-
-    InitSDLState(&globalSDLState);
-
-    SDL_Window *window = NULL;
-    SDL_Surface *screenSurface = NULL;
-    if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS))
-    {
-        printf("SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
-        return 1;
-    }
-
-    window = SDL_CreateWindow("Skyline Engine", WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_RESIZABLE | GetRenderWindowFlags());
-    if (window == NULL)
-    {
-        printf("Window could not be created! SDL_Error: %s\n", SDL_GetError());
-        return 1;
-    }
-
-    ImGuiContext *imGuiContext = ImGui::CreateContext();
-    ImGuiIO& io = ImGui::GetIO(); (void)io;
-    ImGui_ImplSDL3_InitForOther(window);
 
     std::string mapName = "start";
     bool editor = false;
     bool recordOnStart = false;
 
+    ReplayOptions replayOptions = {};
+    replayOptions.frameTime = 1.0f / 60.0f;
+
     for (int i = 0; i < argc; i++)
     {
         if (!strcmp(argv[i], "-editor"))
@@ -220,25 +282,110 @@ int main(int argc, char** argv)
         {
             recordOnStart = true;
         }
+        else if ((!strcmp(argv[i], "-replay")) && ((++i) < argc))
+        {
+            replayOptions.inputPath = argv[i];
+        }
+        else if ((!strcmp(argv[i], "-frames")) && ((++i) < argc))
+        {
+            replayOptions.frameCount = strtoull(argv[i], nullptr, 10);
+        }
+        else if ((!strcmp(argv[i], "-frame-time")) && ((++i) < argc))
+        {
+            replayOptions.frameTime = strtof(argv[i], nullptr);
+        }
+        else if ((!strcmp(argv[i], "-report")) && ((++i) < argc))
+        {
+            replayOptions.reportPath = argv[i];
+        }
+    }
+
+    b32 headless = replayOptions.inputPath != nullptr;
+    if (headless && (editor || replayOptions.frameTime <= 0.0f))
+    {
+        printf("A replay needs a positive -frame-time, and can't be of the editor.\n");
+        return 1;
+    }
+
+    // NOTE(marvin): A replay always uses the same seed, so that every
+    // run of it simulates the same thing.
+    srand(headless ? 0 : static_cast<unsigned>(time(0)));
+
+    // NOTE(marvin): The null renderer doesn't need a window, so a
+    // headless replay can still go through it, and draw as usual.
+#if SKL_RENDERER == 2
+    b32 hasRenderer = true;
+#else
+    b32 hasRenderer = !headless;
+#endif
+    replayOptions.render = hasRenderer;
+    replayOptions.displayWidth = WINDOW_WIDTH;
+    replayOptions.displayHeight = WINDOW_HEIGHT;
+
+    InitSDLState(&globalSDLState);
+    globalSDLState.noRenderer = !hasRenderer;
+
+    SDL_Window *window = NULL;
+    SDL_Surface *screenSurface = NULL;
+    SDL_InitFlags initFlags = headless ? SDL_INIT_EVENTS : (SDL_INIT_VIDEO | SDL_INIT_EVENTS);
+    if (!SDL_Init(initFlags))
+    {
+        printf("SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
+        return 1;
     }
 
-    if (!editor)
+    InitFrameStats(&globalSDLState.frameStats, SDL_GetPerformanceCounter());
+
+#if SKL_INTERNAL
+    // NOTE(marvin): Before any of the platform's threads are started,
+    // so that they can name themselves.
+    globalDebugProfiler = &globalDebugProfiler_;
+    InitDebugProfiler(globalDebugProfiler, SDL_GetPerformanceCounter());
+    ProfilerRegisterThread(globalDebugProfiler, "Main");
+#endif
+
+    InitJobScheduler(&globalJobScheduler, GetDefaultJobWorkerCount());
+
+    if (!headless)
     {
-        SDL_SetWindowRelativeMouseMode(window, true);
+        window = SDL_CreateWindow("Skyline Engine", WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_RESIZABLE | GetRenderWindowFlags());
+        if (window == NULL)
+        {
+            printf("Window could not be created! SDL_Error: %s\n", SDL_GetError());
+            return 1;
+        }
     }
 
+    ImGuiContext *imGuiContext = ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO(); (void)io;
 
-    RenderInitInfo initDesc
+    // NOTE(marvin): A headless replay has no window to present to, nor
+    // any input for the ImGui backend to process.
+    if (!headless)
     {
-        .window = window,
-        .startWidth = WINDOW_WIDTH,
-        .startHeight = WINDOW_HEIGHT,
-        .editor = editor
-    };
-    InitRenderer(initDesc);
+        ImGui_ImplSDL3_InitForOther(window);
 
-    RenderPipelineInitInfo pipelinesInfo;
-    InitPipelines(pipelinesInfo);
+        if (!editor)
+        {
+            SDL_SetWindowRelativeMouseMode(window, true);
+        }
+    }
+
+    if (hasRenderer)
+    {
+        RenderInitInfo initDesc
+        {
+            .window = window,
+            .startWidth = WINDOW_WIDTH,
+            .startHeight = WINDOW_HEIGHT,
+            .editor = editor,
+            .memoryTelemetry = &globalSDLState.memoryTelemetry
+        };
+        InitRenderer(initDesc);
+
+        RenderPipelineInitInfo pipelinesInfo;
+        InitPipelines(pipelinesInfo);
+    }
 
     GameCode gameCode{ editor };
 
@@ -247,12 +394,32 @@ int main(int argc, char** argv)
     gameMemory.debugState = globalDebugState;
 #endif
     gameMemory.imGuiContext = imGuiContext;
+    gameMemory.memoryTelemetry = &globalSDLState.memoryTelemetry;
+    gameMemory.frameStats = &globalSDLState.frameStats;
+    gameMemory.jobScheduler = &globalJobScheduler;
+#if SKL_INTERNAL
+    gameMemory.debugProfiler = globalDebugProfiler;
+#endif
+#if SKL_ALLOCATION_GUARD
+    InitAllocationGuard(&globalSDLState.allocationGuard);
+    gameMemory.allocationGuard = &globalSDLState.allocationGuard;
+#endif
     gameMemory.platformAPI.assetUtils = constructPlatformAssetUtils();
-    gameMemory.platformAPI.renderer = constructPlatformRenderer();
+    gameMemory.platformAPI.renderer = hasRenderer ? constructPlatformRenderer() : ConstructHeadlessRenderer();
     gameMemory.platformAPI.allocator = constructPlatformAllocator();
     gameCode.gameLoad(gameMemory, editor, false);
     gameCode.gameInitialize(gameMemory, mapName, editor);
 
+    if (headless)
+    {
+        replayOptions.mapName = mapName.c_str();
+        s32 exitCode = RunHeadlessReplay(gameCode, gameMemory, replayOptions);
+        LoopUtils::Shutdown(&globalSDLState);
+        StopJobWorkers(&globalJobScheduler);
+        SDL_Quit();
+        return exitCode;
+    }
+
     SDL_Event e;
     bool playing = true;
 
@@ -278,6 +445,9 @@ int main(int argc, char** argv)
         updateLoop(&app);
     }
     #endif
+    // NOTE(marvin): So that what was recorded of a loop is on disk.
+    LoopUtils::Shutdown(&globalSDLState);
+    StopJobWorkers(&globalJobScheduler);
     SDL_DestroyWindow(window);
     SDL_Quit();
     return 0;
@@ -0,0 +1,191 @@
+#include <cstring>
+
+#include <platform_compression.h>
+
+// NOTE(marvin): The compressed data is a sequence of sequences. Each
+// sequence is a token, whose high nibble is the number of literals and
+// low nibble the length of the match minus the minimum, then the
+// literals, then the offset of the match back from the current
+// position. A nibble of 15 is followed by bytes that are added to it,
+// until one is less than 255. The last sequence is literals only.
+
+constexpr u32 LZ_MIN_MATCH = 4;
+constexpr u32 LZ_MAX_OFFSET = 0xFFFF;
+constexpr u32 LZ_HASH_BITS = 12;
+constexpr u32 LZ_NIBBLE_MAX = 15;
+
+// >>> Local Helper Functions <<<
+local u32 ReadU32(const u8* source)
+{
+    u32 result;
+    memcpy(&result, source, sizeof(result));
+    return result;
+}
+
+local u32 HashLZ(u32 sequence)
+{
+    u32 result = (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+    return result;
+}
+
+local u8* WriteLengthExtension(u8* dest, u64 length)
+{
+    if (length >= LZ_NIBBLE_MAX)
+    {
+        length -= LZ_NIBBLE_MAX;
+        while (length >= 255)
+        {
+            *dest++ = 255;
+            length -= 255;
+        }
+        *dest++ = static_cast<u8>(length);
+    }
+    return dest;
+}
+
+local b32 ReadLengthExtension(const u8** source, const u8* sourceEnd, u64* length)
+{
+    if (*length == LZ_NIBBLE_MAX)
+    {
+        u8 extension;
+        do
+        {
+            if (*source >= sourceEnd)
+            {
+                return false;
+            }
+            extension = *(*source)++;
+            *length += extension;
+        } while (extension == 255);
+    }
+    return true;
+}
+
+local u8* WriteSequence(u8* dest, const u8* literals, u64 literalCount, u64 offset, u64 matchLength)
+{
+    u64 literalNibble = Minimum(literalCount, static_cast<u64>(LZ_NIBBLE_MAX));
+    u64 matchNibble = (matchLength == 0) ? 0 : Minimum(matchLength - LZ_MIN_MATCH, static_cast<u64>(LZ_NIBBLE_MAX));
+    *dest++ = static_cast<u8>((literalNibble << 4) | matchNibble);
+    dest = WriteLengthExtension(dest, literalCount);
+    memcpy(dest, literals, literalCount);
+    dest += literalCount;
+
+    if (matchLength != 0)
+    {
+        *dest++ = static_cast<u8>(offset & 0xFF);
+        *dest++ = static_cast<u8>(offset >> 8);
+        dest = WriteLengthExtension(dest, matchLength - LZ_MIN_MATCH);
+    }
+    return dest;
+}
+
+// >>> Global Function Interface <<<
+u64 GetCompressLZBound(u64 sourceSize)
+{
+    u64 result = sourceSize + (sourceSize / 255) + 16;
+    return result;
+}
+
+u64 CompressLZ(const u8* source, u64 sourceSize, u8* dest, u64 destCapacity)
+{
+    ASSERT(destCapacity >= GetCompressLZBound(sourceSize));
+
+    // NOTE(marvin): Positions are stored plus one, so that zero means
+    // that there is no earlier occurrence of the sequence.
+    u64 table[1 << LZ_HASH_BITS] = {};
+    u8* cursor = dest;
+    u64 anchor = 0;
+    u64 position = 0;
+
+    while (position + LZ_MIN_MATCH <= sourceSize)
+    {
+        u32 sequence = ReadU32(source + position);
+        u32 hash = HashLZ(sequence);
+        u64 candidate = table[hash];
+        table[hash] = position + 1;
+
+        if (candidate != 0 &&
+            (position - (candidate - 1)) <= LZ_MAX_OFFSET &&
+            ReadU32(source + candidate - 1) == sequence)
+        {
+            u64 matchStart = candidate - 1;
+            u64 matchLength = LZ_MIN_MATCH;
+            while (position + matchLength < sourceSize &&
+                   source[matchStart + matchLength] == source[position + matchLength])
+            {
+                ++matchLength;
+            }
+
+            cursor = WriteSequence(cursor, source + anchor, position - anchor, position - matchStart, matchLength);
+            position += matchLength;
+            anchor = position;
+        }
+        else
+        {
+            ++position;
+        }
+    }
+
+    cursor = WriteSequence(cursor, source + anchor, sourceSize - anchor, 0, 0);
+    u64 result = static_cast<u64>(cursor - dest);
+    return result;
+}
+
+b32 DecompressLZ(const u8* source, u64 sourceSize, u8* dest, u64 destSize)
+{
+    const u8* sourceEnd = source + sourceSize;
+    u8* cursor = dest;
+    u8* destEnd = dest + destSize;
+
+    while (source < sourceEnd)
+    {
+        u8 token = *source++;
+        u64 literalCount = token >> 4;
+        if (!ReadLengthExtension(&source, sourceEnd, &literalCount) ||
+            literalCount > static_cast<u64>(sourceEnd - source) ||
+            literalCount > static_cast<u64>(destEnd - cursor))
+        {
+            return false;
+        }
+        memcpy(cursor, source, literalCount);
+        source += literalCount;
+        cursor += literalCount;
+
+        if (source == sourceEnd)
+        {
+            break;
+        }
+
+        if (sourceEnd - source < 2)
+        {
+            return false;
+        }
+        u64 offset = source[0] | (source[1] << 8);
+        source += 2;
+        u64 matchLength = token & 0xF;
+        if (!ReadLengthExtension(&source, sourceEnd, &matchLength))
+        {
+            return false;
+        }
+        matchLength += LZ_MIN_MATCH;
+
+        if (offset == 0 ||
+            offset > static_cast<u64>(cursor - dest) ||
+            matchLength > static_cast<u64>(destEnd - cursor))
+        {
+            return false;
+        }
+
+        // NOTE(marvin): Byte by byte, since the match may overlap
+        // what it is copying, which is how runs are encoded.
+        const u8* match = cursor - offset;
+        for (u64 index = 0; index < matchLength; ++index)
+        {
+            cursor[index] = match[index];
+        }
+        cursor += matchLength;
+    }
+
+    b32 result = (cursor == destEnd);
+    return result;
+}
@@ -0,0 +1,137 @@
+#include <platform_io_thread.h>
+#include <platform_memory.h>
+#include <debug_profiler.h>
+
+// >>> Local Helper Functions <<<
+local void DoIOMessage(SDLIOMessage* message)
+{
+    PROFILE_SCOPE("DoIOMessage");
+    switch (message->type)
+    {
+      case sdlIOMessage_writeInput:
+      {
+          siz bytesWritten = SDL_WriteIO(message->stream, &message->input, sizeof(message->input));
+          if (bytesWritten != sizeof(message->input))
+          {
+              LOG_ERROR("Failed to write the recorded input: " << SDL_GetError());
+          }
+      } break;
+      case sdlIOMessage_writeSnapshot:
+      {
+          WriteSnapshotCapture(message->capture, message->stream);
+      } break;
+      case sdlIOMessage_close:
+      {
+          if (!SDL_CloseIO(message->stream))
+          {
+              LOG_ERROR(SDL_GetError());
+          }
+      } break;
+      case sdlIOMessage_stop:
+      {
+      } break;
+    }
+}
+
+local s32 SDLCALL RunIOThread(void* data)
+{
+    SDLIOThread* ioThread = static_cast<SDLIOThread*>(data);
+#if SKL_INTERNAL
+    if (globalDebugProfiler)
+    {
+        ProfilerRegisterThread(globalDebugProfiler, "I/O");
+    }
+#endif
+    b32 stopping = false;
+    while (!stopping)
+    {
+        SDL_WaitSemaphore(ioThread->semaphore);
+
+        u64 readIndex = ioThread->readIndex;
+        while (readIndex != AtomicLoadAcquireU64(&ioThread->writeIndex))
+        {
+            SDLIOMessage* message = ioThread->messages + (readIndex & (SDL_IO_QUEUE_SIZE - 1));
+            stopping |= message->type == sdlIOMessage_stop;
+            DoIOMessage(message);
+            ++readIndex;
+            AtomicStoreReleaseU64(&ioThread->readIndex, readIndex);
+        }
+    }
+    return 0;
+}
+
+// >>> Global Function Interface <<<
+void StartIOThread(SDLIOThread* ioThread)
+{
+    if (ioThread->thread)
+    {
+        return;
+    }
+
+    ioThread->semaphore = SDL_CreateSemaphore(0);
+    if (ioThread->semaphore)
+    {
+        ioThread->thread = SDL_CreateThread(RunIOThread, "skl-io", ioThread);
+    }
+
+    if (!ioThread->thread)
+    {
+        LOG_ERROR("Failed to start the I/O thread, writing on the main thread: " << SDL_GetError());
+    }
+}
+
+void PushIOMessage(SDLIOThread* ioThread, const SDLIOMessage* message)
+{
+    if (!ioThread->thread)
+    {
+        SDLIOMessage copy = *message;
+        DoIOMessage(&copy);
+        return;
+    }
+
+    u64 writeIndex = ioThread->writeIndex;
+    while (writeIndex - AtomicLoadAcquireU64(&ioThread->readIndex) == SDL_IO_QUEUE_SIZE)
+    {
+        SDL_Delay(0);
+    }
+
+    ioThread->messages[writeIndex & (SDL_IO_QUEUE_SIZE - 1)] = *message;
+    AtomicStoreReleaseU64(&ioThread->writeIndex, writeIndex + 1);
+    SDL_SignalSemaphore(ioThread->semaphore);
+}
+
+void DrainIOThread(SDLIOThread* ioThread)
+{
+    WaitForIOThread(ioThread, 0);
+}
+
+void WaitForIOThread(SDLIOThread* ioThread, u64 maxPendingCount)
+{
+    if (!ioThread->thread)
+    {
+        return;
+    }
+
+    while (ioThread->writeIndex - AtomicLoadAcquireU64(&ioThread->readIndex) > maxPendingCount)
+    {
+        SDL_Delay(1);
+    }
+}
+
+void StopIOThread(SDLIOThread* ioThread)
+{
+    if (!ioThread->thread)
+    {
+        return;
+    }
+
+    // NOTE(marvin): The stop message is the last one that is pushed, so
+    // everything before it is done by the time the thread ends.
+    SDLIOMessage message = {};
+    message.type = sdlIOMessage_stop;
+    PushIOMessage(ioThread, &message);
+    SDL_WaitThread(ioThread->thread, nullptr);
+    SDL_DestroySemaphore(ioThread->semaphore);
+    ioThread->thread = nullptr;
+    ioThread->semaphore = nullptr;
+}
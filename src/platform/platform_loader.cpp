@@ -1,20 +1,7 @@
 #include <platform_loader.h>
 
-#include <format>
-
 #define PATH_BUFFER_COUNT 8
 
-const char* GameCode::getGameCodeSrcFilePath()
-{
-    const char* result;
-#if defined(PLATFORM_WINDOWS)
-    result = GAME_CODE_SRC_FILE_NAME ".dll";
-#else
-    result = "./lib" GAME_CODE_SRC_FILE_NAME ".so";
-#endif
-    return result;
-}
-
 const char* GameCode::getJoltLibSrcFilePath()
 {
     const char* result;
@@ -28,95 +15,15 @@ const char* GameCode::getJoltLibSrcFilePath()
     return result;
 }
 
-inline SDL_Time GameCode::getFileLastWritten(const char *path)
-{
-    SDL_Time result;
-    SDL_PathInfo pathInfo;
-    if (SDL_GetPathInfo(path, &pathInfo))
-    {
-        result = pathInfo.modify_time;
-    }
-    else
-    {
-        LOG_ERROR("Unable to get path info of game code.");
-    }
-    return result;
-}
-
-
-b8 GameCode::loadGameCode(SDL_Time newFileLastWritten, b8 editor)
-{
-    // Temporary objects only fully loaded in on confirmation of successful load
-    SDL_SharedObject* tempSharedHandle;
-    game_initialize_t* tempGameInitializePtr;
-    game_load_t* tempGameLoadPtr;
-    game_get_persistent_dll_paths_t* tempGameGetPersistentDLLPathsPtr;
-    game_update_and_render_t* tempGameUpdateAndRenderPtr;
-
-    std::string tag = "game";
-    if (editor)
-    {
-        tag = "editor";
-    }
-    const char *gameCodeSrcFilePath = getGameCodeSrcFilePath();
-    // NOTE(marvin): Could make a macro to generalize, but lazy and
-    // unsure of impact on compile time.
-    std::string gameCodeUseFilePath;
-#if defined(PLATFORM_WINDOWS)
-    gameCodeUseFilePath = std::format(GAME_CODE_USE_FILE_NAME "_{}_{}.dll", tag.c_str(), m_loadCount);
-#else
-    gameCodeUseFilePath = std::format("./lib" GAME_CODE_USE_FILE_NAME "_{}_{}.so", tag.c_str(), m_loadCount);
-#endif
-
-    // NOTE(marvin): Need to have a copy for the platform executable
-    // to use so that when recompile, allowed to rewrite the source
-    // without it being locked by the platform executable.
-    if(!SDL_CopyFile(gameCodeSrcFilePath, gameCodeUseFilePath.c_str()))
-    {
-        LOG_ERROR("Unable to copy game module source to used.");
-        LOG_ERROR(SDL_GetError());
-    }
-    tempSharedHandle = SDL_LoadObject(gameCodeUseFilePath.c_str());
-    if (!tempSharedHandle)
-    {
-        LOG_ERROR("Game code loading failed.");
-        LOG_ERROR(SDL_GetError());
-        SDL_RemovePath(gameCodeUseFilePath.c_str());
-    }
-
-    tempGameInitializePtr = (game_initialize_t *)SDL_LoadFunction(tempSharedHandle, "GameInitialize");
-    tempGameLoadPtr = (game_load_t *)SDL_LoadFunction(tempSharedHandle, "GameLoad");
-    tempGameGetPersistentDLLPathsPtr = (game_get_persistent_dll_paths_t *)SDL_LoadFunction(tempSharedHandle, "GameGetPersistentDLLPaths");
-    tempGameUpdateAndRenderPtr = (game_update_and_render_t *)SDL_LoadFunction(tempSharedHandle, "GameUpdateAndRender");
-    if (tempGameInitializePtr && tempGameLoadPtr && tempGameGetPersistentDLLPathsPtr && tempGameUpdateAndRenderPtr)
-    {
-        m_fileLastWritten = newFileLastWritten;
-        if (m_sharedObjectHandle) {
-            unloadGameCode();
-        }
-        m_sharedObjectHandle = tempSharedHandle;
-        m_gameInitializePtr =  tempGameInitializePtr;
-        m_gameLoadPtr = tempGameLoadPtr;
-        m_gameGetPersistentDLLPathsPtr = tempGameGetPersistentDLLPathsPtr;
-        m_gameUpdateAndRenderPtr = tempGameUpdateAndRenderPtr;
-        m_loadCount++;
-        return true;
-    }
-    else
-    {
-        LOG_ERROR("Unable to load symbols from game shared object.");
-        if (tempSharedHandle)
-        {
-            SDL_UnloadObject(tempSharedHandle);
-        }
-        return false;
-    }
-}
-
-b8 GameCode::loadGameCode(b8 editor)
+void GameCode::swapGameCode(const SDLLoadedGameCode &loaded)
 {
-    const char *gameCodeSrcFilePath = getGameCodeSrcFilePath();
-    return loadGameCode(getFileLastWritten(gameCodeSrcFilePath), editor);
+    unloadGameCode();
+    m_sharedObjectHandle = loaded.sharedObjectHandle;
+    m_gameInitializePtr = loaded.gameInitializePtr;
+    m_gameLoadPtr = loaded.gameLoadPtr;
+    m_gameGetPersistentDLLPathsPtr = loaded.gameGetPersistentDLLPathsPtr;
+    m_gameUpdateAndRenderPtr = loaded.gameUpdateAndRenderPtr;
+    m_loadCount++;
 }
 
 void GameCode::unloadGameCode()
@@ -132,24 +39,6 @@ void GameCode::unloadGameCode()
     m_gameUpdateAndRenderPtr = 0;
 }
 
-b8 GameCode::hasGameCodeChanged()
-{
-    const char *gameCodeSrcFilePath = getGameCodeSrcFilePath();
-    SDL_PathInfo pathInfo;
-    if (!SDL_GetPathInfo(gameCodeSrcFilePath, &pathInfo))
-    {
-        LOG_ERROR("Unable to get game code path info");
-        return false;
-    }
-    if (!pathInfo.size)
-    {
-        return false;
-    }
-
-    m_fileNewLastWritten = pathInfo.modify_time;
-    return m_fileNewLastWritten > m_fileLastWritten;
-}
-
 // NOTE(marvin): Have the platform hold onto the shared object so that
 // it persists between hot reloads.
 local void LoadSharedObject(const char* path)
@@ -166,7 +55,13 @@ GameCode::GameCode(bool editor) {
     const char* joltLibSrcFilePath = getJoltLibSrcFilePath();
     LoadSharedObject(joltLibSrcFilePath);
 
-    loadGameCode(editor);
+    const char* gameCodeSrcFilePath = GetGameCodeSrcFilePath();
+    SDL_Time fileLastWritten = GetFileLastWritten(gameCodeSrcFilePath);
+    SDLLoadedGameCode loaded = {};
+    if (LoadGameCodeObject(gameCodeSrcFilePath, editor, m_loadCount, &loaded))
+    {
+        swapGameCode(loaded);
+    }
 
     const char* pathBuffer[PATH_BUFFER_COUNT] = {0};
     m_gameGetPersistentDLLPathsPtr(pathBuffer);
@@ -179,15 +74,38 @@ GameCode::GameCode(bool editor) {
             LoadSharedObject(path);
         }
     }
-    
+
+    m_reloadThread = static_cast<SDLReloadThread*>(SDL_calloc(1, sizeof(SDLReloadThread)));
+    StartReloadThread(m_reloadThread, editor, m_loadCount, fileLastWritten);
 }
+
 void GameCode::updateGameCode(GameMemory& memory, b8 hasEditor) {
-    if (hasGameCodeChanged())
+    if (!m_reloadThread->thread)
     {
-        if (loadGameCode(m_fileNewLastWritten, hasEditor)) {
-            gameLoad(memory, hasEditor, true);
-        }
+        PollForNewBuild(m_reloadThread);
     }
+
+    SDLLoadedGameCode* loaded = GetReadyGameCode(m_reloadThread);
+    if (!loaded)
+    {
+        return;
+    }
+
+    u64 swapStartNS = SDL_GetTicksNS();
+    swapGameCode(*loaded);
+    gameLoad(memory, hasEditor, true);
+    u64 swapEndNS = SDL_GetTicksNS();
+
+    // NOTE(marvin): The latency is from when the build was noticed to
+    // when it runs, and the stall is what the main thread paid for it.
+    f64 latencyMs = (swapEndNS - loaded->detectedNS) / 1000000.0;
+    f64 backgroundMs = (loaded->loadedNS - loaded->detectedNS) / 1000000.0;
+    f64 stallMs = (swapEndNS - swapStartNS) / 1000000.0;
+    FinishReload(m_reloadThread);
+
+    LOG("Reloaded the game module " << latencyMs << " ms after its build was written ("
+        << backgroundMs << " ms loading in the background), stalling the main thread for "
+        << stallMs << " ms.");
 }
 
 GAME_LOAD(GameCode::gameLoad) {
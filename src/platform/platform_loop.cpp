@@ -5,12 +5,41 @@
 #include <game_platform.h>
 
 // >>> Local Helper Functions <<<
-const char* LoopUtils::SDLGetInputFilePath()
+const char* LoopUtils::SDLGetInputFilePath(u32 slotIndex)
 {
-    const char* result = "loop_start.skli";
+    local_persist const char* inputFilePaths[] =
+    {
+        "loop_1_input.skli", "loop_2_input.skli", "loop_3_input.skli", "loop_4_input.skli",
+    };
+    static_assert(ArrayCount(inputFilePaths) == LOOP_SLOT_COUNT);
+    const char* result = inputFilePaths[slotIndex];
+    return result;
+}
+
+const char* LoopUtils::SDLGetImageFilePath(u32 slotIndex)
+{
+    local_persist const char* imageFilePaths[] =
+    {
+        "loop_1_start.skli", "loop_2_start.skli", "loop_3_start.skli", "loop_4_start.skli",
+    };
+    static_assert(ArrayCount(imageFilePaths) == LOOP_SLOT_COUNT);
+    const char* result = imageFilePaths[slotIndex];
     return result;
 }
 
+// NOTE(marvin): The soft-dirty bits are for the whole process, so
+// once one slot clears them, the others can't rely on them.
+void LoopUtils::SDLInvalidateOtherSnapshots(SDLState* state)
+{
+    for (u32 slotIndex = 0; slotIndex < LOOP_SLOT_COUNT; ++slotIndex)
+    {
+        if (slotIndex != state->loopState.slotIndex)
+        {
+            state->loopSnapshots[slotIndex].cleanPagesMatchImage = false;
+        }
+    }
+}
+
 void LoopUtils::SDLClearBlocksByMask(SDLState* state, LoopMemoryFlags::SDLMemoryFlags mask)
 {
     SDLMemoryBlock* sentinel = &state->memoryBlockSentinel;
@@ -36,8 +65,13 @@ void LoopUtils::SDLClearBlocksByMask(SDLState* state, LoopMemoryFlags::SDLMemory
 void LoopUtils::SDLBeginInputPlayback(SDLState* state)
 {
     SDLClearBlocksByMask(state, LoopMemoryFlags::sdlMem_allocatedDuringLoop);
+
+    // NOTE(marvin): The image and the input have to be on disk before
+    // they can be read back.
+    DrainIOThread(&state->loopIOThread);
     
-    const char* inputFilePath = SDLGetInputFilePath();
+    u32 slotIndex = state->loopState.slotIndex;
+    const char* inputFilePath = SDLGetInputFilePath(slotIndex);
     state->loopState.playbackHandle = SDL_IOFromFile(inputFilePath, "r");
     if (state->loopState.playbackHandle == NULL)
     {
@@ -47,7 +81,10 @@ void LoopUtils::SDLBeginInputPlayback(SDLState* state)
     else
     {
         state->loopState.loopedLiveEditingState = LoopState::LoopedLiveEditingState::playing;
-        RestoreMemoryBlocksFromFile(state->loopState.playbackHandle);
+        state->loopState.frameIndex = 0;
+        state->loopState.fastForwardFrameCount = 0;
+        SDLInvalidateOtherSnapshots(state);
+        RestoreMemorySnapshot(state->loopSnapshots + slotIndex, SDLGetImageFilePath(slotIndex), 0);
     }
 }
 
@@ -61,79 +98,105 @@ void LoopUtils::SDLEndInputPlayback(SDLState* state)
 
 void LoopUtils::SDLBeginRecordingInput(SDLState* state)
 {
-    const char* inputFilePath = SDLGetInputFilePath();
+    StartIOThread(&state->loopIOThread);
+
+    u32 slotIndex = state->loopState.slotIndex;
+    state->loopState.recordedFrameCounts[slotIndex] = 0;
+    SDLInvalidateOtherSnapshots(state);
+    SDLSnapshotProgress progress = BeginMemorySnapshot(state, state->loopSnapshots + slotIndex, &state->loopIOThread,
+                                                       SDLGetImageFilePath(slotIndex), true);
+    if (progress == sdlSnapshot_capturing)
+    {
+        state->loopState.loopedLiveEditingState = LoopState::LoopedLiveEditingState::capturing;
+    }
+    else
+    {
+        SDLStartRecordingFrames(state);
+    }
+}
+
+void LoopUtils::SDLContinueRecordingInput(SDLState* state)
+{
+    u32 slotIndex = state->loopState.slotIndex;
+    SDLSnapshotProgress progress = ContinueMemorySnapshot(state, state->loopSnapshots + slotIndex, &state->loopIOThread,
+                                                          SDLGetImageFilePath(slotIndex));
+    if (progress != sdlSnapshot_capturing)
+    {
+        SDLStartRecordingFrames(state);
+    }
+}
+
+// NOTE(marvin): Once the image is captured, the frames are recorded
+// from the one that it was captured before. A recording whose image
+// failed is still made, it only can't be played back.
+void LoopUtils::SDLStartRecordingFrames(SDLState* state)
+{
+    u32 slotIndex = state->loopState.slotIndex;
+    const char* inputFilePath = SDLGetInputFilePath(slotIndex);
     state->loopState.recordingHandle = SDL_IOFromFile(inputFilePath, "w");
     if (state->loopState.recordingHandle == NULL)
     {
         LOG_ERROR(SDL_GetError());
         ASSERT_PRINT(false, "Failed to create recording handle for looped-live editing.");
+        state->loopState.loopedLiveEditingState = LoopState::LoopedLiveEditingState::none;
     }
     else
     {
         state->loopState.loopedLiveEditingState = LoopState::LoopedLiveEditingState::recording;
-        WriteMemoryBlocksToFile(state, state->loopState.recordingHandle);
+        state->loopState.frameIndex = 0;
     }
-    
 }
 
 void LoopUtils::SDLEndRecordingInput(SDLState* state)
 {
-    TRY(SDL_CloseIO(state->loopState.recordingHandle));
+    SDLIOMessage message = {};
+    message.type = sdlIOMessage_close;
+    message.stream = state->loopState.recordingHandle;
+    PushIOMessage(&state->loopIOThread, &message);
     state->loopState.loopedLiveEditingState = LoopState::LoopedLiveEditingState::none;
 }
 
-void LoopUtils::SDLRecordStdString(SDLState* state, const std::string* str)
-{
-    u32 length = static_cast<u32>(str->size());
-    TRY_EXPECT(SDL_WriteIO(state->loopState.recordingHandle, &length, sizeof(length)), sizeof(length));
-    TRY_EXPECT(SDL_WriteIO(state->loopState.recordingHandle, str->data(), length), length);
-}
-
-void LoopUtils::SDLRecordStdSetOfString(SDLState* state, const std::set<std::string>* strings)
+void LoopUtils::SDLRecordInput(SDLState* state, const GameInput* gameInput, f32 frameTime)
 {
-    u32 count = static_cast<u32>(strings->size());
-    TRY_EXPECT(SDL_WriteIO(state->loopState.recordingHandle, &count, sizeof(count)), sizeof(count));
+    u32 slotIndex = state->loopState.slotIndex;
+    u64 frameIndex = state->loopState.frameIndex;
 
-    for (const std::string& str : *strings)
+    // NOTE(marvin): The keyframe is the memory before the frame's input
+    // is simulated, the same as the start image is for the first frame.
+    if (frameIndex != 0 && (frameIndex % LOOP_KEYFRAME_INTERVAL) == 0)
     {
-        SDLRecordStdString(state, &str);
+        AddMemorySnapshotKeyframe(state, state->loopSnapshots + slotIndex, &state->loopIOThread,
+                                  SDLGetImageFilePath(slotIndex), frameIndex);
     }
-}
-
-void LoopUtils::SDLRecordInput(SDLState* state, const GameInput* gameInput)
-{
-    // NOTE(marvin): The keys down is not going to be used.
-    siz bytesWritten = SDL_WriteIO(state->loopState.recordingHandle, gameInput, sizeof(*gameInput));
-    ASSERT_PRINT(bytesWritten == sizeof(*gameInput), "Failed to properly write.");
-
-    // NOTE(marvin): Have to manually deserialize std set.
-    SDLRecordStdSetOfString(state, &gameInput->keysDownPrevFrame);
-    SDLRecordStdSetOfString(state, &gameInput->keysDownThisFrame);
-}
 
-void LoopUtils::SDLPlaybackStdString(SDLState* state, std::set<std::string>* strings)
-{
-    u32 length;
-    TRY_EXPECT(SDL_ReadIO(state->loopState.playbackHandle, &length, sizeof(length)), sizeof(length));
+    SDLIOMessage message = {};
+    message.type = sdlIOMessage_writeInput;
+    message.stream = state->loopState.recordingHandle;
+    message.input.input = *gameInput;
+    message.input.frameTime = frameTime;
+    PushIOMessage(&state->loopIOThread, &message);
 
-    std::string str(length, '\0');
-    TRY_EXPECT(SDL_ReadIO(state->loopState.playbackHandle, str.data(), length), length);
-    strings->insert(std::move(str));
+    state->loopState.frameIndex = frameIndex + 1;
+    state->loopState.recordedFrameCounts[slotIndex] = frameIndex + 1;
 }
 
-void LoopUtils::SDLPlaybackStdSetOfString(SDLState* state, std::set<std::string>* strings)
+b8 LoopUtils::SDLReadInputRecord(SDLState* state, GameInput* gameInput, f32* frameTime)
 {
-    u32 count;
-    TRY_EXPECT(SDL_ReadIO(state->loopState.playbackHandle, &count, sizeof(count)), sizeof(count));
-
-    for (u32 index = 0; index < count; ++index)
+    LoopInputRecord record;
+    siz bytesRead = SDL_ReadIO(state->loopState.playbackHandle, &record, sizeof(record));
+    if (bytesRead != sizeof(record))
     {
-        SDLPlaybackStdString(state, strings);
+        return false;
     }
+
+    *gameInput = record.input;
+    *frameTime = record.frameTime;
+    ++state->loopState.frameIndex;
+    return true;
 }
 
 // Did a reset happen?
-b8 LoopUtils::SDLPlaybackInput(SDLState* state, GameInput* gameInput, b8 forceReloadGameCode)
+b8 LoopUtils::SDLPlaybackInput(SDLState* state, GameInput* gameInput, f32* frameTime, b8 forceReloadGameCode)
 {
     // NOTE(marvin): Would it be possible for there to be two notion
     // of mouse? One used in the game, and one for interacting with
@@ -141,34 +204,26 @@ b8 LoopUtils::SDLPlaybackInput(SDLState* state, GameInput* gameInput, b8 forceRe
 
     b32 result = false;
 
-    // NOTE(marvin): Need to destroy the std set prior to writing to
-    // it because the write will corrupt std set memory. Reconstruct it after.
-    gameInput->keysDownPrevFrame.~set();
-    gameInput->keysDownThisFrame.~set();
-    siz bytesRead = SDL_ReadIO(state->loopState.playbackHandle, gameInput, sizeof(*gameInput));
-
-    if (bytesRead == 0 || forceReloadGameCode)
+    b8 hasRecord = !forceReloadGameCode && SDLReadInputRecord(state, gameInput, frameTime);
+    if (!hasRecord)
     {
         // NOTE(marvin): Could also rewind the stream, but going
         // through end and start again is safer.
         SDLEndInputPlayback(state);
         SDLBeginInputPlayback(state);
-        bytesRead = SDL_ReadIO(state->loopState.playbackHandle, gameInput, sizeof(*gameInput));
+        hasRecord = SDLReadInputRecord(state, gameInput, frameTime);
         result = true;
     }
-    ASSERT(bytesRead == sizeof(*gameInput));
-    
-    new (&gameInput->keysDownPrevFrame) std::set<std::string>();
-    new (&gameInput->keysDownThisFrame) std::set<std::string>();
-    SDLPlaybackStdSetOfString(state, &gameInput->keysDownPrevFrame);
-    SDLPlaybackStdSetOfString(state, &gameInput->keysDownThisFrame);
+    ASSERT(hasRecord);
     return result;
 }
 
 // >>> Public Interface <<<
 b8 LoopUtils::GetIsStateInLoop(const SDLState* state)
 {
-    return state->loopState.loopedLiveEditingState != LoopState::LoopedLiveEditingState::none;
+    LoopState::LoopedLiveEditingState loopedLiveEditingState = state->loopState.loopedLiveEditingState;
+    return (loopedLiveEditingState != LoopState::LoopedLiveEditingState::none) &&
+        (loopedLiveEditingState != LoopState::LoopedLiveEditingState::capturing);
 }
 
 b8 LoopUtils::GetIsStateInPlayback(const SDLState* state)
@@ -184,6 +239,14 @@ void LoopUtils::ToggleLoopedLiveEditingState(SDLState* state)
       {
           SDLBeginRecordingInput(state);
       } break;
+      case LoopState::LoopedLiveEditingState::capturing:
+      {
+          // NOTE(marvin): Nothing has been recorded yet, so there is
+          // no loop to play back.
+          CancelMemorySnapshot(state->loopSnapshots + state->loopState.slotIndex, &state->loopIOThread);
+          state->loopState.loopedLiveEditingState = LoopState::LoopedLiveEditingState::none;
+          LOG("Looped live editing cancelled before its recording started.");
+      } break;
       case LoopState::LoopedLiveEditingState::recording:
       {
           SDLEndRecordingInput(state);
@@ -196,24 +259,102 @@ void LoopUtils::ToggleLoopedLiveEditingState(SDLState* state)
     }
 }
 
-b8 LoopUtils::ProcessInputWithLooping(SDLState* state, GameInput* gameInput, b8 forceReloadGameCode)
+b8 LoopUtils::ProcessInputWithLooping(SDLState* state, GameInput* gameInput, f32* frameTime, b8 forceReloadGameCode)
 {
     b32 result = false;
     switch (state->loopState.loopedLiveEditingState)
     {
       case LoopState::LoopedLiveEditingState::none: {} break;
+      case LoopState::LoopedLiveEditingState::capturing:
+      {
+          SDLContinueRecordingInput(state);
+          if (state->loopState.loopedLiveEditingState == LoopState::LoopedLiveEditingState::recording)
+          {
+              SDLRecordInput(state, gameInput, *frameTime);
+          }
+      } break;
       case LoopState::LoopedLiveEditingState::recording:
       {
-          SDLRecordInput(state, gameInput);
+          SDLRecordInput(state, gameInput, *frameTime);
       } break;
       case LoopState::LoopedLiveEditingState::playing:
       {
-          result = SDLPlaybackInput(state, gameInput, forceReloadGameCode);
+          result = SDLPlaybackInput(state, gameInput, frameTime, forceReloadGameCode);
       } break;
     }
     return result;
 }
 
+void LoopUtils::SelectSlot(SDLState* state, u32 slotIndex)
+{
+    if ((state->loopState.loopedLiveEditingState != LoopState::LoopedLiveEditingState::none) ||
+        slotIndex >= LOOP_SLOT_COUNT)
+    {
+        return;
+    }
+
+    state->loopState.slotIndex = slotIndex;
+    LOG("Looped live editing slot " << (slotIndex + 1) << " selected.");
+}
+
+u32 LoopUtils::GetSlotIndex(const SDLState* state)
+{
+    return state->loopState.slotIndex;
+}
+
+u64 LoopUtils::GetRecordedFrameCount(const SDLState* state)
+{
+    return state->loopState.recordedFrameCounts[state->loopState.slotIndex];
+}
+
+u64 LoopUtils::GetPlaybackFrameIndex(const SDLState* state)
+{
+    return state->loopState.frameIndex + state->loopState.fastForwardFrameCount;
+}
+
+void LoopUtils::SeekToFrame(SDLState* state, u64 frameIndex)
+{
+    u64 recordedFrameCount = GetRecordedFrameCount(state);
+    if (!GetIsStateInPlayback(state) || recordedFrameCount == 0)
+    {
+        return;
+    }
+
+    frameIndex = Minimum(frameIndex, recordedFrameCount - 1);
+    u32 slotIndex = state->loopState.slotIndex;
+    SDLMemorySnapshot* snapshot = state->loopSnapshots + slotIndex;
+    u32 keyframeIndex = FindMemorySnapshotKeyframe(snapshot, frameIndex);
+    u64 keyframeFrameIndex = snapshot->keyframes[keyframeIndex].frameIndex;
+
+    // NOTE(marvin): The same as restarting the loop, except from the
+    // keyframe. Only the memory blocks that existed at the start are
+    // in the image, which is why keyframes stop being taken once the
+    // game allocates during the recording.
+    SDLClearBlocksByMask(state, LoopMemoryFlags::sdlMem_allocatedDuringLoop);
+    RestoreMemorySnapshot(snapshot, SDLGetImageFilePath(slotIndex), keyframeIndex);
+
+    s64 offset = static_cast<s64>(keyframeFrameIndex * sizeof(LoopInputRecord));
+    TRY(SDL_SeekIO(state->loopState.playbackHandle, offset, SDL_IO_SEEK_SET) == offset);
+    state->loopState.frameIndex = keyframeFrameIndex;
+    state->loopState.fastForwardFrameCount = frameIndex - keyframeFrameIndex;
+}
+
+b8 LoopUtils::NextFastForwardInput(SDLState* state, GameInput* gameInput, f32* frameTime)
+{
+    if (!GetIsStateInPlayback(state) || state->loopState.fastForwardFrameCount == 0)
+    {
+        return false;
+    }
+
+    --state->loopState.fastForwardFrameCount;
+    b8 result = SDLReadInputRecord(state, gameInput, frameTime);
+    if (!result)
+    {
+        state->loopState.fastForwardFrameCount = 0;
+    }
+    return result;
+}
+
 void LoopUtils::SetBlockFlagLoopAllocated(SDLMemoryBlock* block) {
     block->loopingFlags.m_flags = LoopMemoryFlags::sdlMem_allocatedDuringLoop;
 }
@@ -228,12 +369,21 @@ void LoopUtils::SetBlockFlagLoopNone(SDLMemoryBlock* block) {
 b8 LoopUtils::GetBlockFlagLoopAllocated(const SDLMemoryBlock* block)  {
     return block->loopingFlags.m_flags == LoopMemoryFlags::sdlMem_allocatedDuringLoop;
 }
+
+void LoopUtils::Shutdown(SDLState* state)
+{
+    CancelMemorySnapshot(state->loopSnapshots + state->loopState.slotIndex, &state->loopIOThread);
+    DrainIOThread(&state->loopIOThread);
+    StopIOThread(&state->loopIOThread);
+}
 #else 
 b8 LoopUtils::GetIsStateInLoop(const SDLState* state) {}
 void LoopUtils::ToggleLoopedLiveEditingState(SDLState* state) {}
-b8 LoopUtils::ProcessInputWithLooping(SDLState* state, GameInput* gameInput, b8 forceReloadGameCode) { return false; }
+b8 LoopUtils::ProcessInputWithLooping(SDLState* state, GameInput* gameInput, f32* frameTime, b8 forceReloadGameCode) { return false; }
+b8 LoopUtils::NextFastForwardInput(SDLState* state, GameInput* gameInput, f32* frameTime) { return false; }
 void LoopUtils::SetBlockFlagLoopAllocated(SDLMemoryBlock* block) {}
 void LoopUtils::SetBlockFlagLoopFreed(SDLMemoryBlock* block) {}
 void LoopUtils::SetBlockFlagLoopNone(SDLMemoryBlock* block) {}
 b8 LoopUtils::GetBlockFlagLoopAllocated(const SDLMemoryBlock* block) { return true; }
+void LoopUtils::Shutdown(SDLState* state) {}
 #endif
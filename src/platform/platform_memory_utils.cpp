@@ -1,60 +1,957 @@
 // Implements how custom memory allocation interacts with IO data
 #include <platform_memory.h>
+#include <platform_compression.h>
 
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#define SKL_SOFT_DIRTY_PAGES 1
+#else
+#define SKL_SOFT_DIRTY_PAGES 0
+#endif
 
-void RestoreSavedMemoryBlock(SDLSavedMemoryBlock savedMemoryBlock, SDL_IOStream* fileHandle)
+// NOTE(marvin): Writing and restoring the whole image used to take
+// seconds, as the fixed size storage alone is hundreds of
+// megabytes. Most of the pages are never touched between the start of
+// the loop and its end, so only the pages that the kernel says have
+// been written are copied. The copy is all that happens on the main
+// thread, the I/O thread compresses and writes it. The copy goes to
+// the I/O thread a chunk at a time, so there is never more than a few
+// megabytes of it around, and the first image is copied a few
+// megabytes a frame, with the pages written in the meantime copied
+// again at the end, so that starting a loop doesn't stall.
+
+constexpr u32 MEMORY_SNAPSHOT_MAGIC = 0x534B4C49;  // "SKLI"
+constexpr u32 MEMORY_SNAPSHOT_VERSION = 2;
+
+// NOTE(marvin): Rewriting the image appends to the file, so once the
+// pages that were replaced take up more of the file than this, the
+// whole image is written anew.
+constexpr u64 MEMORY_SNAPSHOT_MAX_GARBAGE = Megabytes(64);
+
+// NOTE(marvin): The pagemap is read in chunks of this many pages.
+constexpr u32 PAGEMAP_CHUNK_PAGES = 4096;
+
+// NOTE(marvin): The copies of the pages are handed to the I/O thread
+// in chunks of this many pages, and the main thread waits when this
+// many chunks are still to be written.
+constexpr u64 MEMORY_SNAPSHOT_CHUNK_PAGES = 256;
+constexpr u64 MEMORY_SNAPSHOT_MAX_PENDING_CHUNKS = 16;
+
+// NOTE(marvin): How many pages of the first image are copied a frame.
+constexpr u64 MEMORY_SNAPSHOT_FRAME_PAGES = 2048;
+
+struct SDLMemorySnapshotHeader
+{
+    u32 magic;
+    u32 version;
+    u64 pageSize;
+};
+
+// >>> Local Helper Functions <<<
+local u64 GetPageSize()
+{
+#if SKL_SOFT_DIRTY_PAGES
+    u64 result = static_cast<u64>(sysconf(_SC_PAGESIZE));
+#else
+    u64 result = 4096;
+#endif
+    return result;
+}
+
+local u8* GetFirstPage(const SDLSnapshotBlock* block, u64 pageSize)
+{
+    u64 address = reinterpret_cast<u64>(block->requestedBase);
+    u8* result = reinterpret_cast<u8*>(address - (address % pageSize));
+    return result;
+}
+
+local u64 GetPageCount(const SDLSnapshotBlock* block, u64 pageSize)
+{
+    u8* firstPage = GetFirstPage(block, pageSize);
+    u8* end = static_cast<u8*>(block->requestedBase) + block->requestedSize;
+    u64 result = (static_cast<u64>(end - firstPage) + pageSize - 1) / pageSize;
+    return result;
+}
+
+// NOTE(marvin): The first and last pages of a block are shared with
+// whatever is next to it, including the memory block headers, so only
+// the part of the page within the block is ever copied.
+local void GetPageIntersection(const SDLSnapshotBlock* block, u8* page, u64 pageSize, u8** start, u64* size)
+{
+    u8* blockStart = static_cast<u8*>(block->requestedBase);
+    u8* blockEnd = blockStart + block->requestedSize;
+    u8* intersectionStart = Maximum(page, blockStart);
+    u8* intersectionEnd = Minimum(page + pageSize, blockEnd);
+    *start = intersectionStart;
+    *size = (intersectionEnd > intersectionStart) ? static_cast<u64>(intersectionEnd - intersectionStart) : 0;
+}
+
+local b32 WriteAt(SDL_IOStream* fileHandle, u64 offset, const void* data, u64 size)
+{
+    b32 result = (SDL_SeekIO(fileHandle, offset, SDL_IO_SEEK_SET) >= 0) &&
+        (SDL_WriteIO(fileHandle, data, size) == size);
+    return result;
+}
+
+local b32 ReadAt(SDL_IOStream* fileHandle, u64 offset, void* data, u64 size)
+{
+    b32 result = (SDL_SeekIO(fileHandle, offset, SDL_IO_SEEK_SET) >= 0) &&
+        (SDL_ReadIO(fileHandle, data, size) == size);
+    return result;
+}
+
+#if SKL_SOFT_DIRTY_PAGES
+constexpr u64 PAGEMAP_SOFT_DIRTY = 1ull << 55;
+constexpr u64 PAGEMAP_SWAPPED = 1ull << 62;
+constexpr u64 PAGEMAP_PRESENT = 1ull << 63;
+
+local b32 ClearSoftDirtyBits()
+{
+    s32 fd = open("/proc/self/clear_refs", O_WRONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    b32 result = (write(fd, "4", 1) == 1);
+    close(fd);
+    return result;
+}
+
+// Reads the pagemap entries of the given pages.
+local b32 ReadPagemap(s32 pagemapFd, u8* firstPage, u64 pageCount, u64 pageSize, u64* entries)
+{
+    u64 offset = (reinterpret_cast<u64>(firstPage) / pageSize) * sizeof(u64);
+    u64 size = pageCount * sizeof(u64);
+    b32 result = (pread(pagemapFd, entries, size, offset) == static_cast<ssize_t>(size));
+    return result;
+}
+
+// NOTE(marvin): The soft-dirty bits need a kernel built with
+// CONFIG_MEM_SOFT_DIRTY, so check that a write to a page actually
+// sets its bit.
+local b32 ProbeSoftDirty(u64 pageSize)
+{
+    s32 pagemapFd = open("/proc/self/pagemap", O_RDONLY);
+    if (pagemapFd < 0)
+    {
+        return false;
+    }
+
+    u8* page = static_cast<u8*>(SDL_aligned_alloc(pageSize, pageSize));
+    b32 result = false;
+    if (page)
+    {
+        volatile u8* probe = page;
+        probe[0] = 1;
+        u64 entry;
+        if (ClearSoftDirtyBits() &&
+            ReadPagemap(pagemapFd, page, 1, pageSize, &entry) && !(entry & PAGEMAP_SOFT_DIRTY))
+        {
+            probe[0] = 2;
+            result = ReadPagemap(pagemapFd, page, 1, pageSize, &entry) && (entry & PAGEMAP_SOFT_DIRTY);
+        }
+        SDL_aligned_free(page);
+    }
+
+    close(pagemapFd);
+    return result;
+}
+#endif
+
+// Calls the procedure with each page of the block that passes the
+// filter on its pagemap entry. Without a pagemap, every page passes.
+template <typename F>
+local b32 ForEachPage(const SDLSnapshotBlock* block, u64 pageSize, s32 pagemapFd, u64 filter, F&& procedure)
+{
+    u8* firstPage = GetFirstPage(block, pageSize);
+    u64 pageCount = GetPageCount(block, pageSize);
+
+#if SKL_SOFT_DIRTY_PAGES
+    if (pagemapFd >= 0)
+    {
+        local_persist u64 entries[PAGEMAP_CHUNK_PAGES];
+        for (u64 chunkStart = 0; chunkStart < pageCount; chunkStart += PAGEMAP_CHUNK_PAGES)
+        {
+            u64 chunkCount = Minimum(pageCount - chunkStart, static_cast<u64>(PAGEMAP_CHUNK_PAGES));
+            u8* chunkFirstPage = firstPage + chunkStart * pageSize;
+            if (!ReadPagemap(pagemapFd, chunkFirstPage, chunkCount, pageSize, entries))
+            {
+                return false;
+            }
+
+            for (u64 index = 0; index < chunkCount; ++index)
+            {
+                if ((entries[index] & filter) && !procedure(chunkFirstPage + index * pageSize))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+#endif
+
+    for (u64 index = 0; index < pageCount; ++index)
+    {
+        if (!procedure(firstPage + index * pageSize))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Produces whether the memory blocks are still the ones in the snapshot.
+local b32 GatherSnapshotBlocks(SDLState* state, SDLMemorySnapshot* snapshot)
+{
+    SDLMemoryBlock* sentinel = &state->memoryBlockSentinel;
+
+    BeginTicketMutex(&state->memoryMutex);
+    u32 blockCount = 0;
+    for (SDLMemoryBlock* block = sentinel->next; block != sentinel; block = block->next)
+    {
+        ++blockCount;
+    }
+
+    if (blockCount > snapshot->blockCapacity)
+    {
+        SDL_free(snapshot->blocks);
+        snapshot->blockCapacity = blockCount * 2;
+        snapshot->blocks = static_cast<SDLSnapshotBlock*>(SDL_malloc(snapshot->blockCapacity * sizeof(SDLSnapshotBlock)));
+    }
+
+    b32 result = (blockCount == snapshot->blockCount);
+    u32 index = 0;
+    for (SDLMemoryBlock* block = sentinel->next; block != sentinel; block = block->next, ++index)
+    {
+        SDLSnapshotBlock* snapshotBlock = snapshot->blocks + index;
+        if (result && (index < snapshot->blockCount))
+        {
+            result = (snapshotBlock->requestedBase == block->requestedBase) &&
+                (snapshotBlock->requestedSize == block->requestedSize);
+        }
+        snapshotBlock->requestedBase = block->requestedBase;
+        snapshotBlock->requestedSize = block->requestedSize;
+    }
+    EndTicketMutex(&state->memoryMutex);
+
+    snapshot->blockCount = blockCount;
+
+    u64 pageCount = 0;
+    for (u32 blockIndex = 0; blockIndex < blockCount; ++blockIndex)
+    {
+        SDLSnapshotBlock* snapshotBlock = snapshot->blocks + blockIndex;
+        snapshotBlock->firstPage = pageCount;
+        pageCount += GetPageCount(snapshotBlock, snapshot->pageSize);
+    }
+
+    if (pageCount > snapshot->pageCapacity)
+    {
+        SDL_free(snapshot->pages);
+        snapshot->pageCapacity = pageCount * 2;
+        snapshot->pages = static_cast<SDLSnapshotPageRecord*>(SDL_malloc(snapshot->pageCapacity * sizeof(SDLSnapshotPageRecord)));
+    }
+    snapshot->pageCount = pageCount;
+
+    return result;
+}
+
+local SDLSnapshotPageRecord* GetPageRecord(SDLMemorySnapshot* snapshot, const SDLSnapshotBlock* block, u8* page)
 {
-    void* requestedBase = savedMemoryBlock.requestedBase;
-    u64 requestedSize = savedMemoryBlock.requestedSize;
-    siz bytesRead = SDL_ReadIO(fileHandle, requestedBase, requestedSize);
-    ASSERT(bytesRead == requestedSize);
+    u64 pageIndex = static_cast<u64>(page - GetFirstPage(block, snapshot->pageSize)) / snapshot->pageSize;
+    SDLSnapshotPageRecord* result = snapshot->pages + block->firstPage + pageIndex;
+    return result;
 }
 
-inline SDLSavedMemoryBlock InitSavedMemoryBlock(SDLMemoryBlock* source)
+local b32 IsZeroPage(const u8* page, u64 pageSize)
 {
-    SDLSavedMemoryBlock result = {};
-    result.requestedBase = source->requestedBase;
-    result.requestedSize = source->requestedSize;
+    const u64* words = reinterpret_cast<const u64*>(page);
+    for (u64 index = 0; index < pageSize / sizeof(u64); ++index)
+    {
+        if (words[index] != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+local s32 OpenPagemap()
+{
+#if SKL_SOFT_DIRTY_PAGES
+    s32 result = open("/proc/self/pagemap", O_RDONLY);
     return result;
+#else
+    return -1;
+#endif
+}
+
+local void ClosePagemap(s32 pagemapFd)
+{
+#if SKL_SOFT_DIRTY_PAGES
+    if (pagemapFd >= 0)
+    {
+        close(pagemapFd);
+    }
+#endif
 }
 
-void WriteSavedMemoryBlockToFile(SDLSavedMemoryBlock* savedMemoryBlock, SDL_IOStream* fileHandle)
+local void ResetSoftDirtyTracking(SDLMemorySnapshot* snapshot)
 {
-    TRY_EXPECT(SDL_WriteIO(fileHandle, savedMemoryBlock, sizeof(*savedMemoryBlock)), sizeof(*savedMemoryBlock));
-    TRY_EXPECT(SDL_WriteIO(fileHandle, savedMemoryBlock->requestedBase, savedMemoryBlock->requestedSize), savedMemoryBlock->requestedSize);
+#if SKL_SOFT_DIRTY_PAGES
+    snapshot->cleanPagesMatchImage = snapshot->softDirtyAvailable && ClearSoftDirtyBits();
+#else
+    snapshot->cleanPagesMatchImage = false;
+#endif
 }
 
-void WriteMemoryBlocksToFile(SDLState* state, SDL_IOStream* fileHandle)
+local b32 SnapshotBlocksMatch(SDLState* state, const SDLMemorySnapshot* snapshot)
 {
     SDLMemoryBlock* sentinel = &state->memoryBlockSentinel;
+
     BeginTicketMutex(&state->memoryMutex);
-    for (SDLMemoryBlock* sourceBlock = sentinel->next;
-         sourceBlock != sentinel;
-         sourceBlock = sourceBlock->next)
+    b32 result = true;
+    u32 index = 0;
+    for (SDLMemoryBlock* block = sentinel->next; result && block != sentinel; block = block->next, ++index)
     {
-        SDLSavedMemoryBlock savedMemoryBlock = InitSavedMemoryBlock(sourceBlock);
-        WriteSavedMemoryBlockToFile(&savedMemoryBlock, fileHandle);
+        const SDLSnapshotBlock* snapshotBlock = snapshot->blocks + index;
+        result = (index < snapshot->blockCount) &&
+            (snapshotBlock->requestedBase == block->requestedBase) &&
+            (snapshotBlock->requestedSize == block->requestedSize);
     }
     EndTicketMutex(&state->memoryMutex);
 
-    // NOTE(marvin): Ending with an empty saved block to mark the end.
-    SDLSavedMemoryBlock savedMemoryBlock = {};
-    WriteSavedMemoryBlockToFile(&savedMemoryBlock, fileHandle);
+    result = result && (index == snapshot->blockCount);
+    return result;
+}
+
+// Sets the page records to the image at the keyframe.
+local void ResolvePageRecords(SDLMemorySnapshot* snapshot, u32 keyframeIndex)
+{
+    SDL_memset(snapshot->pages, 0, snapshot->pageCount * sizeof(SDLSnapshotPageRecord));
+
+    const SDLSnapshotKeyframe* keyframe = snapshot->keyframes + keyframeIndex;
+    u64 changeEnd = keyframe->firstChange + keyframe->changeCount;
+    for (u64 changeIndex = 0; changeIndex < changeEnd; ++changeIndex)
+    {
+        const SDLSnapshotPageChange* change = snapshot->changes + changeIndex;
+        snapshot->pages[change->pageIndex] = change->record;
+    }
+}
+
+local void AppendPageChange(SDLMemorySnapshot* snapshot, u64 pageIndex, SDLSnapshotPageRecord record)
+{
+    if (snapshot->changeCount == snapshot->changeCapacity)
+    {
+        snapshot->changeCapacity = Maximum(snapshot->changeCapacity * 2, 1024ull);
+        snapshot->changes = static_cast<SDLSnapshotPageChange*>(
+            SDL_realloc(snapshot->changes, snapshot->changeCapacity * sizeof(SDLSnapshotPageChange)));
+    }
+    snapshot->changes[snapshot->changeCount++] = {pageIndex, record};
+}
+
+local void ProbeSnapshotSupport(SDLMemorySnapshot* snapshot)
+{
+    if (!snapshot->softDirtyProbed)
+    {
+        snapshot->pageSize = GetPageSize();
+#if SKL_SOFT_DIRTY_PAGES
+        snapshot->softDirtyAvailable = ProbeSoftDirty(snapshot->pageSize);
+#endif
+        snapshot->softDirtyProbed = true;
+        if (!snapshot->softDirtyAvailable)
+        {
+            LOG("Soft-dirty pages are not available, looped live editing copies all of the memory and takes no keyframes.");
+        }
+    }
+}
+
+// Hands the chunk that is being filled to the I/O thread. The last
+// chunk is pushed even if it is empty, as it closes the stream.
+local void FlushCaptureChunk(SDLMemorySnapshot* snapshot, SDLIOThread* ioThread, b32 last)
+{
+    SDLSnapshotCapture* capture = snapshot->captureChunk;
+    if (!capture && !last)
+    {
+        return;
+    }
+
+    if (!capture)
+    {
+        capture = static_cast<SDLSnapshotCapture*>(SDL_calloc(1, sizeof(SDLSnapshotCapture)));
+        capture->snapshot = snapshot;
+        capture->keyframeIndex = snapshot->captureKeyframe;
+    }
+    capture->first = !snapshot->captureStarted;
+    capture->last = last;
+
+    SDLIOMessage message = {};
+    message.type = sdlIOMessage_writeSnapshot;
+    message.stream = snapshot->captureStream;
+    message.capture = capture;
+    PushIOMessage(ioThread, &message);
+
+    snapshot->captureChunk = nullptr;
+    snapshot->captureStarted = true;
+    if (last)
+    {
+        snapshot->captureStream = nullptr;
+    }
+    WaitForIOThread(ioThread, MEMORY_SNAPSHOT_MAX_PENDING_CHUNKS);
+}
+
+local b32 AddCapturePage(SDLMemorySnapshot* snapshot, SDLIOThread* ioThread, u64 pageIndex, const u8* page)
+{
+    u64 pageSize = snapshot->pageSize;
+    SDLSnapshotCapture* capture = snapshot->captureChunk;
+    if (!capture)
+    {
+        capture = static_cast<SDLSnapshotCapture*>(SDL_calloc(1, sizeof(SDLSnapshotCapture)));
+        capture->snapshot = snapshot;
+        capture->keyframeIndex = snapshot->captureKeyframe;
+        capture->pageIndices = static_cast<u64*>(SDL_malloc(MEMORY_SNAPSHOT_CHUNK_PAGES * sizeof(u64)));
+        capture->pages = static_cast<u8*>(SDL_malloc(MEMORY_SNAPSHOT_CHUNK_PAGES * pageSize));
+        snapshot->captureChunk = capture;
+        if (!capture->pageIndices || !capture->pages)
+        {
+            return false;
+        }
+    }
+
+    capture->pageIndices[capture->count] = pageIndex;
+    SDL_memcpy(capture->pages + capture->count * pageSize, page, pageSize);
+    ++capture->count;
+    if (capture->count == MEMORY_SNAPSHOT_CHUNK_PAGES)
+    {
+        FlushCaptureChunk(snapshot, ioThread, false);
+    }
+    return true;
+}
+
+local void StartCapture(SDLMemorySnapshot* snapshot, SDL_IOStream* fileHandle, u32 keyframeIndex)
+{
+    snapshot->captureStream = fileHandle;
+    snapshot->captureChunk = nullptr;
+    snapshot->captureKeyframe = keyframeIndex;
+    snapshot->captureStarted = false;
+}
+
+// Copies the pages that pass the filter into the chunks of the capture.
+local b32 CaptureFilteredPages(SDLMemorySnapshot* snapshot, SDLIOThread* ioThread, u64 filter, u64* pageCount)
+{
+    u64 pageSize = snapshot->pageSize;
+    s32 pagemapFd = OpenPagemap();
+
+    b32 result = true;
+    for (u32 index = 0; result && index < snapshot->blockCount; ++index)
+    {
+        SDLSnapshotBlock* block = snapshot->blocks + index;
+        result = ForEachPage(block, pageSize, pagemapFd, filter, [&](u8* page)
+        {
+            ++*pageCount;
+            u64 pageIndex = static_cast<u64>(GetPageRecord(snapshot, block, page) - snapshot->pages);
+            return AddCapturePage(snapshot, ioThread, pageIndex, page);
+        });
+    }
+    ClosePagemap(pagemapFd);
+    return result;
+}
+
+// Pushes the rest of the capture, which closes the stream. If the
+// capture failed, whatever was already written of the keyframe is in
+// the changes, so the snapshot can't be restored anymore.
+local b32 EndCapture(SDLMemorySnapshot* snapshot, SDLIOThread* ioThread, b32 result)
+{
+    FlushCaptureChunk(snapshot, ioThread, true);
+    if (result)
+    {
+        snapshot->matchedKeyframe = snapshot->captureKeyframe;
+        ResetSoftDirtyTracking(snapshot);
+    }
+    else
+    {
+        LOG_ERROR("Failed to capture the memory snapshot.");
+        DrainIOThread(ioThread);
+        snapshot->writeFailed = true;
+        snapshot->cleanPagesMatchImage = false;
+    }
+    return result;
+}
+
+// Copies the pages that pass the filter, and has the I/O thread write
+// them as the keyframe. Takes ownership of the file handle.
+local b32 CaptureMemorySnapshot(SDLMemorySnapshot* snapshot, SDLIOThread* ioThread, SDL_IOStream* fileHandle,
+                                u32 keyframeIndex, u64 filter, u64* pageCount)
+{
+    StartCapture(snapshot, fileHandle, keyframeIndex);
+    *pageCount = 0;
+    b32 result = CaptureFilteredPages(snapshot, ioThread, filter, pageCount);
+    result = EndCapture(snapshot, ioThread, result);
+    return result;
+}
+
+#if SKL_SOFT_DIRTY_PAGES
+// Gathers the pages that pass the filter, to be copied later.
+local b32 GatherStagedPages(SDLMemorySnapshot* snapshot, u64 filter)
+{
+    u64 pageSize = snapshot->pageSize;
+    s32 pagemapFd = OpenPagemap();
+
+    snapshot->stagedPageCount = 0;
+    snapshot->stagedPageCursor = 0;
+    b32 result = (pagemapFd >= 0);
+    for (u32 index = 0; result && index < snapshot->blockCount; ++index)
+    {
+        SDLSnapshotBlock* block = snapshot->blocks + index;
+        result = ForEachPage(block, pageSize, pagemapFd, filter, [&](u8* page)
+        {
+            if (snapshot->stagedPageCount == snapshot->stagedPageCapacity)
+            {
+                snapshot->stagedPageCapacity = Maximum(snapshot->stagedPageCapacity * 2, 1024ull);
+                snapshot->stagedPages = static_cast<SDLSnapshotStagedPage*>(
+                    SDL_realloc(snapshot->stagedPages, snapshot->stagedPageCapacity * sizeof(SDLSnapshotStagedPage)));
+            }
+            u64 pageIndex = static_cast<u64>(GetPageRecord(snapshot, block, page) - snapshot->pages);
+            snapshot->stagedPages[snapshot->stagedPageCount++] = {page, pageIndex};
+            return true;
+        });
+    }
+    ClosePagemap(pagemapFd);
+    return result;
+}
+#endif
+
+// >>> Global Function Interface <<<
+SDLSnapshotProgress BeginMemorySnapshot(SDLState* state, SDLMemorySnapshot* snapshot, SDLIOThread* ioThread,
+                                        const char* path, b32 staged)
+{
+    u64 startTime = SDL_GetTicksNS();
+
+    // NOTE(marvin): The page records belong to the I/O thread until
+    // it is done with the previous image.
+    DrainIOThread(ioThread);
+    ProbeSnapshotSupport(snapshot);
+
+    u64 pageSize = snapshot->pageSize;
+    b32 sameBlocks = GatherSnapshotBlocks(state, snapshot);
+    b32 incremental = sameBlocks && snapshot->cleanPagesMatchImage && !snapshot->writeFailed &&
+        (snapshot->fileSize - snapshot->liveBytes <= MEMORY_SNAPSHOT_MAX_GARBAGE);
+
+    SDL_IOStream* fileHandle = SDL_IOFromFile(path, incremental ? "r+b" : "w+b");
+    if (!fileHandle && incremental)
+    {
+        incremental = false;
+        fileHandle = SDL_IOFromFile(path, "w+b");
+    }
+    if (!fileHandle)
+    {
+        LOG_ERROR(SDL_GetError());
+        snapshot->cleanPagesMatchImage = false;
+        return sdlSnapshot_failed;
+    }
+
+    snapshot->keyframes[0] = {};
+    snapshot->keyframeCount = 1;
+    snapshot->changeCount = 0;
+
+    if (incremental)
+    {
+        // NOTE(marvin): The pages that aren't soft-dirty are still the
+        // ones at the matched keyframe, which become the start of the
+        // new first keyframe. Whatever else is in the file is garbage.
+        snapshot->liveBytes = 0;
+        for (u64 pageIndex = 0; pageIndex < snapshot->pageCount; ++pageIndex)
+        {
+            SDLSnapshotPageRecord record = snapshot->pages[pageIndex];
+            if (record.fileOffset != 0)
+            {
+                AppendPageChange(snapshot, pageIndex, record);
+                snapshot->liveBytes += record.storedSize;
+            }
+        }
+    }
+    else
+    {
+        // NOTE(marvin): The pages that aren't captured below aren't
+        // backed by memory, so they are zero.
+        SDL_memset(snapshot->pages, 0, snapshot->pageCount * sizeof(SDLSnapshotPageRecord));
+        SDLMemorySnapshotHeader header = {MEMORY_SNAPSHOT_MAGIC, MEMORY_SNAPSHOT_VERSION, pageSize};
+        snapshot->fileSize = sizeof(header);
+        snapshot->liveBytes = 0;
+        snapshot->writeFailed = false;
+        if (!WriteAt(fileHandle, 0, &header, sizeof(header)))
+        {
+            LOG_ERROR("Failed to write the memory snapshot: " << SDL_GetError());
+            SDL_CloseIO(fileHandle);
+            snapshot->cleanPagesMatchImage = false;
+            return sdlSnapshot_failed;
+        }
+    }
+
+#if SKL_SOFT_DIRTY_PAGES
+    // NOTE(marvin): A fresh image only needs the pages that are backed
+    // by memory. A rewritten one only needs the soft-dirty pages.
+    u64 filter = incremental ? PAGEMAP_SOFT_DIRTY : (PAGEMAP_PRESENT | PAGEMAP_SWAPPED);
+
+    // NOTE(marvin): Once the bits are cleared, the pages that are
+    // written while the staged pages are copied become soft-dirty, and
+    // are copied again at the end.
+    if (staged && snapshot->softDirtyAvailable &&
+        GatherStagedPages(snapshot, filter) && ClearSoftDirtyBits())
+    {
+        StartCapture(snapshot, fileHandle, 0);
+        snapshot->staging = true;
+        snapshot->cleanPagesMatchImage = false;
+        LOG("Memory snapshot started: " << snapshot->stagedPageCount << " pages to copy.");
+        return sdlSnapshot_capturing;
+    }
+#else
+    u64 filter = 0;
+#endif
+
+    u64 pageCount;
+    b32 result = CaptureMemorySnapshot(snapshot, ioThread, fileHandle, 0, filter, &pageCount);
+
+    LOG("Memory snapshot " << (incremental ? "updated" : "captured") << ": " << pageCount << " pages in "
+        << (SDL_GetTicksNS() - startTime) / 1000000.0 << " ms.");
+    return result ? sdlSnapshot_done : sdlSnapshot_failed;
+}
+
+SDLSnapshotProgress ContinueMemorySnapshot(SDLState* state, SDLMemorySnapshot* snapshot, SDLIOThread* ioThread,
+                                           const char* path)
+{
+    ASSERT(snapshot->staging);
+
+    // NOTE(marvin): The staged pages are only still there if the memory
+    // blocks are. As the game could change them every frame, the image
+    // is then captured at once.
+    if (!SnapshotBlocksMatch(state, snapshot))
+    {
+        LOG("The memory blocks changed while the memory snapshot was captured, capturing it at once.");
+        CancelMemorySnapshot(snapshot, ioThread);
+        return BeginMemorySnapshot(state, snapshot, ioThread, path, false);
+    }
+
+    b32 result = true;
+    u64 copyEnd = Minimum(snapshot->stagedPageCursor + MEMORY_SNAPSHOT_FRAME_PAGES, snapshot->stagedPageCount);
+    for (; result && snapshot->stagedPageCursor < copyEnd; ++snapshot->stagedPageCursor)
+    {
+        SDLSnapshotStagedPage* staged = snapshot->stagedPages + snapshot->stagedPageCursor;
+        result = AddCapturePage(snapshot, ioThread, staged->pageIndex, staged->page);
+    }
+
+    if (result && snapshot->stagedPageCursor < snapshot->stagedPageCount)
+    {
+        return sdlSnapshot_capturing;
+    }
+
+    u64 dirtyPageCount = 0;
+#if SKL_SOFT_DIRTY_PAGES
+    result = result && CaptureFilteredPages(snapshot, ioThread, PAGEMAP_SOFT_DIRTY, &dirtyPageCount);
+#endif
+    snapshot->staging = false;
+    result = EndCapture(snapshot, ioThread, result);
+
+    if (result)
+    {
+        LOG("Memory snapshot captured: " << snapshot->stagedPageCount << " pages, and " << dirtyPageCount
+            << " written while they were copied.");
+    }
+    return result ? sdlSnapshot_done : sdlSnapshot_failed;
+}
+
+void CancelMemorySnapshot(SDLMemorySnapshot* snapshot, SDLIOThread* ioThread)
+{
+    if (!snapshot->staging)
+    {
+        return;
+    }
+
+    FlushCaptureChunk(snapshot, ioThread, true);
+    DrainIOThread(ioThread);
+    snapshot->staging = false;
+    snapshot->writeFailed = true;
+    snapshot->cleanPagesMatchImage = false;
+}
+
+b32 AddMemorySnapshotKeyframe(SDLState* state, SDLMemorySnapshot* snapshot, SDLIOThread* ioThread,
+                              const char* path, u64 frameIndex)
+{
+#if SKL_SOFT_DIRTY_PAGES
+    if (!snapshot->cleanPagesMatchImage ||
+        (snapshot->keyframeCount == MAX_SNAPSHOT_KEYFRAMES) ||
+        !SnapshotBlocksMatch(state, snapshot))
+    {
+        return false;
+    }
+
+    // NOTE(marvin): By now the I/O thread should long be done with
+    // the previous keyframe, so this doesn't wait.
+    DrainIOThread(ioThread);
+    if (snapshot->writeFailed)
+    {
+        return false;
+    }
+
+    SDL_IOStream* fileHandle = SDL_IOFromFile(path, "r+b");
+    if (!fileHandle)
+    {
+        LOG_ERROR(SDL_GetError());
+        return false;
+    }
+
+    u32 keyframeIndex = snapshot->keyframeCount++;
+    snapshot->keyframes[keyframeIndex] = {frameIndex, 0, 0};
+
+    u64 pageCount;
+    b32 result = CaptureMemorySnapshot(snapshot, ioThread, fileHandle, keyframeIndex, PAGEMAP_SOFT_DIRTY, &pageCount);
+    return result;
+#else
+    return false;
+#endif
+}
+
+void WriteSnapshotCapture(SDLSnapshotCapture* capture, SDL_IOStream* fileHandle)
+{
+    SDLMemorySnapshot* snapshot = capture->snapshot;
+    SDLSnapshotKeyframe* keyframe = snapshot->keyframes + capture->keyframeIndex;
+    u64 pageSize = snapshot->pageSize;
+    u64 compressedCapacity = GetCompressLZBound(pageSize);
+    u8* compressed = static_cast<u8*>(SDL_malloc(compressedCapacity));
+
+    // NOTE(marvin): The changes of the first keyframe may have been
+    // started by the main thread.
+    if (capture->first && capture->keyframeIndex != 0)
+    {
+        keyframe->firstChange = snapshot->changeCount;
+    }
+
+    b32 result = (compressed != nullptr) && (SDL_SeekIO(fileHandle, snapshot->fileSize, SDL_IO_SEEK_SET) >= 0);
+    for (u64 index = 0; result && index < capture->count; ++index)
+    {
+        u8* page = capture->pages + index * pageSize;
+        u64 pageIndex = capture->pageIndices[index];
+        SDLSnapshotPageRecord record = {};
+
+        if (!IsZeroPage(page, pageSize))
+        {
+            // NOTE(marvin): Pages that don't compress are stored as is.
+            u64 compressedSize = CompressLZ(page, pageSize, compressed, compressedCapacity);
+            const u8* stored = compressed;
+            u64 storedSize = compressedSize;
+            if (compressedSize >= pageSize)
+            {
+                stored = page;
+                storedSize = pageSize;
+            }
+
+            result = (SDL_WriteIO(fileHandle, stored, storedSize) == storedSize);
+            record.fileOffset = snapshot->fileSize;
+            record.storedSize = static_cast<u32>(storedSize);
+            snapshot->fileSize += storedSize;
+            snapshot->liveBytes += storedSize;
+        }
+
+        // NOTE(marvin): The first keyframe is the only one that
+        // nothing else refers to, so what it replaces is garbage. Its
+        // pages can be captured more than once when it is staged.
+        if (capture->keyframeIndex == 0)
+        {
+            snapshot->liveBytes -= snapshot->pages[pageIndex].storedSize;
+        }
+
+        // NOTE(marvin): Zero pages only need a change when they
+        // replace a page that wasn't.
+        if (record.fileOffset != 0 || snapshot->pages[pageIndex].fileOffset != 0)
+        {
+            AppendPageChange(snapshot, pageIndex, record);
+        }
+        snapshot->pages[pageIndex] = record;
+    }
+    keyframe->changeCount = snapshot->changeCount - keyframe->firstChange;
+
+    if (capture->last)
+    {
+        result = SDL_CloseIO(fileHandle) && result;
+    }
+    if (!result)
+    {
+        LOG_ERROR("Failed to write the memory snapshot: " << SDL_GetError());
+        snapshot->writeFailed = true;
+    }
+
+    SDL_free(compressed);
+    SDL_free(capture->pageIndices);
+    SDL_free(capture->pages);
+    SDL_free(capture);
+}
+
+u32 FindMemorySnapshotKeyframe(const SDLMemorySnapshot* snapshot, u64 frameIndex)
+{
+    u32 result = 0;
+    for (u32 index = 1; index < snapshot->keyframeCount; ++index)
+    {
+        if (snapshot->keyframes[index].frameIndex <= frameIndex)
+        {
+            result = index;
+        }
+    }
+    return result;
 }
 
-void RestoreMemoryBlocksFromFile(SDL_IOStream* fileHandle)
+b32 RestoreMemorySnapshot(SDLMemorySnapshot* snapshot, const char* path, u32 keyframeIndex)
 {
-    for (;;)
+    u64 startTime = SDL_GetTicksNS();
+
+    if (snapshot->writeFailed || keyframeIndex >= snapshot->keyframeCount)
+    {
+        LOG_ERROR("The memory snapshot wasn't fully written, it can't be restored.");
+        return false;
+    }
+
+    SDL_IOStream* fileHandle = SDL_IOFromFile(path, "rb");
+    if (!fileHandle)
+    {
+        LOG_ERROR(SDL_GetError());
+        return false;
+    }
+
+    u64 pageSize = snapshot->pageSize;
+    SDLMemorySnapshotHeader header = {};
+    b32 result = ReadAt(fileHandle, 0, &header, sizeof(header)) &&
+        (header.magic == MEMORY_SNAPSHOT_MAGIC) &&
+        (header.version == MEMORY_SNAPSHOT_VERSION) &&
+        (header.pageSize == pageSize);
+    ASSERT_PRINT(result, "The memory snapshot doesn't match the one that was written.");
+
+    u8* compressed = static_cast<u8*>(SDL_malloc(pageSize));
+    u8* decompressed = static_cast<u8*>(SDL_malloc(pageSize));
+    u8* restoreFlags = static_cast<u8*>(SDL_calloc(Maximum(snapshot->pageCount, 1ull), 1));
+    result = result && compressed && decompressed && restoreFlags;
+
+    s32 pagemapFd = OpenPagemap();
+    b32 incremental = snapshot->cleanPagesMatchImage && (pagemapFd >= 0);
+    if (result && incremental)
     {
-        SDLSavedMemoryBlock savedMemoryBlock = {};
-        TRY_EXPECT(SDL_ReadIO(fileHandle, &savedMemoryBlock, sizeof(savedMemoryBlock)), sizeof(savedMemoryBlock));
-        if (savedMemoryBlock.requestedBase != 0)
+        // NOTE(marvin): The pages that differ from the keyframe are the
+        // ones written since the memory matched a keyframe, and the
+        // ones that changed between that keyframe and this one.
+#if SKL_SOFT_DIRTY_PAGES
+        for (u32 index = 0; index < snapshot->blockCount; ++index)
         {
-            RestoreSavedMemoryBlock(savedMemoryBlock, fileHandle);
+            SDLSnapshotBlock* block = snapshot->blocks + index;
+            ForEachPage(block, pageSize, pagemapFd, PAGEMAP_SOFT_DIRTY, [&](u8* page)
+            {
+                restoreFlags[GetPageRecord(snapshot, block, page) - snapshot->pages] = true;
+                return true;
+            });
         }
-        else
+#endif
+
+        u32 firstKeyframe = Minimum(snapshot->matchedKeyframe, keyframeIndex) + 1;
+        u32 lastKeyframe = Maximum(snapshot->matchedKeyframe, keyframeIndex);
+        for (u32 index = firstKeyframe; index <= lastKeyframe; ++index)
         {
-            break;
+            const SDLSnapshotKeyframe* keyframe = snapshot->keyframes + index;
+            for (u64 changeIndex = keyframe->firstChange;
+                 changeIndex < keyframe->firstChange + keyframe->changeCount;
+                 ++changeIndex)
+            {
+                restoreFlags[snapshot->changes[changeIndex].pageIndex] = true;
+            }
         }
     }
+
+    if (result)
+    {
+        ResolvePageRecords(snapshot, keyframeIndex);
+    }
+
+    if (result && !incremental)
+    {
+        // NOTE(marvin): Pages that aren't backed by memory are already
+        // zero, so only those and the ones in the image are restored.
+#if SKL_SOFT_DIRTY_PAGES
+        u64 filter = PAGEMAP_PRESENT | PAGEMAP_SWAPPED;
+#else
+        u64 filter = 0;
+#endif
+        for (u32 index = 0; index < snapshot->blockCount; ++index)
+        {
+            SDLSnapshotBlock* block = snapshot->blocks + index;
+            ForEachPage(block, pageSize, pagemapFd, filter, [&](u8* page)
+            {
+                restoreFlags[GetPageRecord(snapshot, block, page) - snapshot->pages] = true;
+                return true;
+            });
+        }
+
+        for (u64 pageIndex = 0; pageIndex < snapshot->pageCount; ++pageIndex)
+        {
+            if (snapshot->pages[pageIndex].fileOffset != 0)
+            {
+                restoreFlags[pageIndex] = true;
+            }
+        }
+    }
+    ClosePagemap(pagemapFd);
+
+    u64 pagesRestored = 0;
+    for (u32 index = 0; result && index < snapshot->blockCount; ++index)
+    {
+        SDLSnapshotBlock* block = snapshot->blocks + index;
+        u8* firstPage = GetFirstPage(block, pageSize);
+        u64 pageCount = GetPageCount(block, pageSize);
+        for (u64 blockPageIndex = 0; result && blockPageIndex < pageCount; ++blockPageIndex)
+        {
+            u64 pageIndex = block->firstPage + blockPageIndex;
+            if (!restoreFlags[pageIndex])
+            {
+                continue;
+            }
+            ++pagesRestored;
+
+            u8* page = firstPage + blockPageIndex * pageSize;
+            u8* start;
+            u64 size;
+            GetPageIntersection(block, page, pageSize, &start, &size);
+
+            SDLSnapshotPageRecord* record = snapshot->pages + pageIndex;
+            if (record->fileOffset == 0)
+            {
+                SDL_memset(start, 0, size);
+                continue;
+            }
+
+            b32 stored = (record->storedSize == pageSize);
+            u8* destination = stored ? decompressed : compressed;
+            result = ReadAt(fileHandle, record->fileOffset, destination, record->storedSize) &&
+                (stored || DecompressLZ(compressed, record->storedSize, decompressed, pageSize));
+            if (result)
+            {
+                SDL_memcpy(start, decompressed + (start - page), size);
+            }
+        }
+    }
+
+    SDL_CloseIO(fileHandle);
+    SDL_free(compressed);
+    SDL_free(decompressed);
+    SDL_free(restoreFlags);
+
+    if (result)
+    {
+        snapshot->matchedKeyframe = keyframeIndex;
+        ResetSoftDirtyTracking(snapshot);
+    }
+    else
+    {
+        LOG_ERROR("Failed to restore the memory snapshot: " << SDL_GetError());
+        snapshot->cleanPagesMatchImage = false;
+    }
+
+    LOG("Memory snapshot restored to frame " << snapshot->keyframes[keyframeIndex].frameIndex << ": "
+        << pagesRestored << " pages in " << (SDL_GetTicksNS() - startTime) / 1000000.0 << " ms.");
+    return result;
 }
@@ -0,0 +1,254 @@
+#include <platform_reload_thread.h>
+#include <platform_loader.h>
+
+#include <format>
+#include <string>
+
+#include <skl_thread_safe_primitives.h>
+#include <debug_profiler.h>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// NOTE(marvin): How often the modify time is polled when there is no
+// inotify, and how long to wait between checks for the main thread to
+// swap in the last build.
+#define RELOAD_POLL_INTERVAL_MS 100
+
+// >>> Local Helper Functions <<<
+
+// Produces whether there is a build newer than the last one loaded.
+local b8 HasNewBuild(SDLReloadThread *reloadThread, SDL_Time *newFileLastWritten)
+{
+    SDL_PathInfo pathInfo;
+    if (!SDL_GetPathInfo(GetGameCodeSrcFilePath(), &pathInfo) || !pathInfo.size)
+    {
+        return false;
+    }
+
+    *newFileLastWritten = pathInfo.modify_time;
+    return pathInfo.modify_time > reloadThread->fileLastWritten;
+}
+
+local void LoadNewBuild(SDLReloadThread *reloadThread, u64 detectedNS)
+{
+    SDL_Time newFileLastWritten;
+    if (!HasNewBuild(reloadThread, &newFileLastWritten))
+    {
+        return;
+    }
+
+    // NOTE(marvin): The main thread hasn't swapped in the last build
+    // yet, which only takes until the next frame.
+    while (AtomicLoadAcquireU64(&reloadThread->state) != sdlReloadState_idle)
+    {
+        SDL_Delay(1);
+    }
+
+    PROFILE_SCOPE("LoadNewBuild");
+    SDLLoadedGameCode *loaded = &reloadThread->loaded;
+    if (!LoadGameCodeObject(GetGameCodeSrcFilePath(), reloadThread->editor, reloadThread->loadCount, loaded))
+    {
+        return;
+    }
+
+    ++reloadThread->loadCount;
+    reloadThread->fileLastWritten = newFileLastWritten;
+    loaded->fileLastWritten = newFileLastWritten;
+    loaded->detectedNS = detectedNS;
+    loaded->loadedNS = SDL_GetTicksNS();
+    AtomicStoreReleaseU64(&reloadThread->state, sdlReloadState_ready);
+}
+
+#if defined(__linux__)
+// NOTE(marvin): The directory is watched rather than the file, as the
+// build may replace the file instead of writing over it. Produces
+// false if inotify can't be used.
+local b8 WatchWithInotify(SDLReloadThread *reloadThread)
+{
+    std::string srcFilePath = GetGameCodeSrcFilePath();
+    siz slash = srcFilePath.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : srcFilePath.substr(0, slash);
+    std::string fileName = slash == std::string::npos ? srcFilePath : srcFilePath.substr(slash + 1);
+
+    s32 inotifyFd = inotify_init1(IN_CLOEXEC);
+    if (inotifyFd < 0)
+    {
+        return false;
+    }
+    if (inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        close(inotifyFd);
+        return false;
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    for (;;)
+    {
+        ssize_t bytesRead = read(inotifyFd, buffer, sizeof(buffer));
+        if (bytesRead <= 0)
+        {
+            LOG_ERROR("Failed to read the inotify events of the game module, polling instead.");
+            close(inotifyFd);
+            return false;
+        }
+
+        b8 written = false;
+        for (char *at = buffer; at < buffer + bytesRead;)
+        {
+            inotify_event *event = reinterpret_cast<inotify_event *>(at);
+            if (event->len && fileName == event->name)
+            {
+                written = true;
+            }
+            at += sizeof(inotify_event) + event->len;
+        }
+
+        if (written)
+        {
+            LoadNewBuild(reloadThread, SDL_GetTicksNS());
+        }
+    }
+}
+#endif
+
+local s32 SDLCALL RunReloadThread(void *data)
+{
+    SDLReloadThread *reloadThread = static_cast<SDLReloadThread *>(data);
+#if SKL_INTERNAL
+    if (globalDebugProfiler)
+    {
+        ProfilerRegisterThread(globalDebugProfiler, "Reload");
+    }
+#endif
+
+#if defined(__linux__)
+    WatchWithInotify(reloadThread);
+#endif
+
+    for (;;)
+    {
+        SDL_Delay(RELOAD_POLL_INTERVAL_MS);
+        LoadNewBuild(reloadThread, SDL_GetTicksNS());
+    }
+    return 0;
+}
+
+// >>> Global Function Interface <<<
+const char *GetGameCodeSrcFilePath()
+{
+    const char *result;
+#if defined(PLATFORM_WINDOWS)
+    result = GAME_CODE_SRC_FILE_NAME ".dll";
+#else
+    result = "./lib" GAME_CODE_SRC_FILE_NAME ".so";
+#endif
+    return result;
+}
+
+SDL_Time GetFileLastWritten(const char *path)
+{
+    SDL_Time result = 0;
+    SDL_PathInfo pathInfo;
+    if (SDL_GetPathInfo(path, &pathInfo))
+    {
+        result = pathInfo.modify_time;
+    }
+    else
+    {
+        LOG_ERROR("Unable to get path info of game code.");
+    }
+    return result;
+}
+
+b8 LoadGameCodeObject(const char *srcFilePath, b8 editor, u32 loadCount, SDLLoadedGameCode *loaded)
+{
+    const char *tag = editor ? "editor" : "game";
+    // NOTE(marvin): Could make a macro to generalize, but lazy and
+    // unsure of impact on compile time.
+    std::string useFilePath;
+#if defined(PLATFORM_WINDOWS)
+    useFilePath = std::format(GAME_CODE_USE_FILE_NAME "_{}_{}.dll", tag, loadCount);
+#else
+    useFilePath = std::format("./lib" GAME_CODE_USE_FILE_NAME "_{}_{}.so", tag, loadCount);
+#endif
+
+    // NOTE(marvin): Need to have a copy for the platform executable
+    // to use so that when recompile, allowed to rewrite the source
+    // without it being locked by the platform executable.
+    if (!SDL_CopyFile(srcFilePath, useFilePath.c_str()))
+    {
+        LOG_ERROR("Unable to copy game module source to used.");
+        LOG_ERROR(SDL_GetError());
+        return false;
+    }
+
+    SDL_SharedObject *sharedObjectHandle = SDL_LoadObject(useFilePath.c_str());
+    if (!sharedObjectHandle)
+    {
+        LOG_ERROR("Game code loading failed.");
+        LOG_ERROR(SDL_GetError());
+        SDL_RemovePath(useFilePath.c_str());
+        return false;
+    }
+
+    loaded->gameInitializePtr = (game_initialize_t *)SDL_LoadFunction(sharedObjectHandle, "GameInitialize");
+    loaded->gameLoadPtr = (game_load_t *)SDL_LoadFunction(sharedObjectHandle, "GameLoad");
+    loaded->gameGetPersistentDLLPathsPtr = (game_get_persistent_dll_paths_t *)SDL_LoadFunction(sharedObjectHandle, "GameGetPersistentDLLPaths");
+    loaded->gameUpdateAndRenderPtr = (game_update_and_render_t *)SDL_LoadFunction(sharedObjectHandle, "GameUpdateAndRender");
+    if (!(loaded->gameInitializePtr && loaded->gameLoadPtr && loaded->gameGetPersistentDLLPathsPtr && loaded->gameUpdateAndRenderPtr))
+    {
+        LOG_ERROR("Unable to load symbols from game shared object.");
+        SDL_UnloadObject(sharedObjectHandle);
+        return false;
+    }
+
+    loaded->sharedObjectHandle = sharedObjectHandle;
+    return true;
+}
+
+void StartReloadThread(SDLReloadThread *reloadThread, b8 editor, u32 loadCount, SDL_Time fileLastWritten)
+{
+    if (reloadThread->thread)
+    {
+        return;
+    }
+
+    reloadThread->editor = editor;
+    reloadThread->loadCount = loadCount;
+    reloadThread->fileLastWritten = fileLastWritten;
+    reloadThread->state = sdlReloadState_idle;
+
+    reloadThread->thread = SDL_CreateThread(RunReloadThread, "skl-reload", reloadThread);
+    if (reloadThread->thread)
+    {
+        // NOTE(marvin): Runs for as long as the platform does.
+        SDL_DetachThread(reloadThread->thread);
+    }
+    else
+    {
+        LOG_ERROR("Failed to start the reload thread, reloading on the main thread: " << SDL_GetError());
+    }
+}
+
+void PollForNewBuild(SDLReloadThread *reloadThread)
+{
+    LoadNewBuild(reloadThread, SDL_GetTicksNS());
+}
+
+SDLLoadedGameCode *GetReadyGameCode(SDLReloadThread *reloadThread)
+{
+    SDLLoadedGameCode *result = nullptr;
+    if (AtomicLoadAcquireU64(&reloadThread->state) == sdlReloadState_ready)
+    {
+        result = &reloadThread->loaded;
+    }
+    return result;
+}
+
+void FinishReload(SDLReloadThread *reloadThread)
+{
+    AtomicStoreReleaseU64(&reloadThread->state, sdlReloadState_idle);
+}
@@ -0,0 +1,273 @@
+#include <platform_replay.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include <SDL3/SDL.h>
+#include <imgui.h>
+
+#include <debug.h>
+#include <timer.h>
+#include <platform_loop.h>
+#include <platform_loader.h>
+
+#if SKL_RENDERER == 2
+#include <renderer_null.h>
+#endif
+
+// >>> Local Helper Functions <<<
+
+// NOTE(marvin): Nothing is drawn, so every light gets the invalid
+// handle.
+local LightID HeadlessAddLight()
+{
+    return -1;
+}
+
+local void HeadlessDestroyLight(LightID lightID)
+{
+}
+
+local u32 HeadlessGetIndexAtCursor()
+{
+    return 0;
+}
+
+local void HeadlessRenderUpdate(RenderFrameInfo &state)
+{
+}
+
+// Writes the string as a JSON string, quotes included.
+local void WriteJSONString(FILE *file, const char *string)
+{
+    fputc('"', file);
+    for (const char *c = string; c && *c; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            fputc('\\', file);
+            fputc(*c, file);
+        }
+        else if (static_cast<u8>(*c) < 0x20)
+        {
+            fprintf(file, "\\u%04x", static_cast<u32>(*c));
+        }
+        else
+        {
+            fputc(*c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+local void WriteFrameRecords(FILE *file, const DebugFrameSnapshot *snapshot)
+{
+    fputs("\"blocks\":[", file);
+    for (u32 i = 0; i < snapshot->recordCount; ++i)
+    {
+        const DebugFrameRecord *record = snapshot->records + i;
+        fputs(i ? ",{\"name\":" : "{\"name\":", file);
+        WriteJSONString(file, record->blockName);
+        fputs(",\"file\":", file);
+        WriteJSONString(file, record->fileName);
+        fprintf(file, ",\"line\":%u,\"hits\":%llu,\"cycles\":%llu}",
+                record->lineNumber, (unsigned long long)record->hitCount,
+                (unsigned long long)record->cycleCount);
+    }
+    fputc(']', file);
+}
+
+#if SKL_RENDERER == 2
+local void WriteRenderCounters(FILE *file, const NullRenderCounters &counters)
+{
+    fprintf(file, "\"render\":{\"passes\":%u,\"draws\":%u,\"instances\":%u,\"icons\":%u,"
+            "\"dirLights\":%u,\"spotLights\":%u,\"pointLights\":%u,\"invalidMeshes\":%u,"
+            "\"uploadedBytes\":%llu,\"frameUploadedBytes\":%llu}",
+            counters.passCount, counters.drawCount, counters.instanceCount, counters.iconCount,
+            counters.dirLightCount, counters.spotLightCount, counters.pointLightCount, counters.invalidMeshCount,
+            (unsigned long long)counters.uploadedBytes, (unsigned long long)counters.frameUploadedBytes);
+}
+#endif
+
+// Produces the frame time at the percentile of the sorted frame times.
+local f64 GetPercentile(const std::vector<f64> &sortedFrameMs, f64 percentile)
+{
+    siz index = static_cast<siz>(percentile * (sortedFrameMs.size() - 1) + 0.5);
+    f64 result = sortedFrameMs[index];
+    return result;
+}
+
+// >>> Global Function Interface <<<
+
+PlatformRenderer ConstructHeadlessRenderer()
+{
+    PlatformRenderer result;
+    result.AddDirLight = HeadlessAddLight;
+    result.AddSpotLight = HeadlessAddLight;
+    result.AddPointLight = HeadlessAddLight;
+    result.DestroyDirLight = HeadlessDestroyLight;
+    result.DestroySpotLight = HeadlessDestroyLight;
+    result.DestroyPointLight = HeadlessDestroyLight;
+    result.GetIndexAtCursor = HeadlessGetIndexAtCursor;
+    result.RenderUpdate = HeadlessRenderUpdate;
+    return result;
+}
+
+s32 RunHeadlessReplay(GameCode &gameCode, GameMemory &gameMemory, const ReplayOptions &options)
+{
+    SDL_IOStream *inputHandle = SDL_IOFromFile(options.inputPath, "rb");
+    if (!inputHandle)
+    {
+        LOG_ERROR("Failed to open the input stream " << options.inputPath << "! SDL_Error: " << SDL_GetError());
+        return 1;
+    }
+
+    u64 recordedFrameCount = static_cast<u64>(SDL_GetIOSize(inputHandle)) / sizeof(LoopInputRecord);
+    u64 frameCount = recordedFrameCount;
+    if (options.frameCount)
+    {
+        frameCount = Minimum(options.frameCount, recordedFrameCount);
+    }
+    if (frameCount == 0)
+    {
+        LOG_ERROR("The input stream " << options.inputPath << " has no frames.");
+        SDL_CloseIO(inputHandle);
+        return 1;
+    }
+
+    FILE *report = nullptr;
+    if (options.reportPath)
+    {
+        report = fopen(options.reportPath, "w");
+        if (!report)
+        {
+            LOG_ERROR("Failed to open " << options.reportPath << " for writing the replay report.");
+            SDL_CloseIO(inputHandle);
+            return 1;
+        }
+    }
+
+#if SKL_INTERNAL
+    // NOTE(marvin): Too big for the stack.
+    local_persist DebugFrameSnapshot frameSnapshot;
+    gameMemory.debugFrameSnapshot = report ? &frameSnapshot : nullptr;
+#endif
+
+    if (report)
+    {
+        fputs("{\"map\":", report);
+        WriteJSONString(report, options.mapName);
+        fputs(",\"input\":", report);
+        WriteJSONString(report, options.inputPath);
+        fprintf(report, ",\"frameTime\":%.9g,\"frames\":[", options.frameTime);
+    }
+
+    std::vector<f64> frameMs;
+    frameMs.reserve(frameCount);
+
+    f64 performanceFrequency = static_cast<f64>(SDL_GetPerformanceFrequency());
+    u64 replayStartCounter = SDL_GetPerformanceCounter();
+    u64 replayStartCycles = ReadCPUTimer();
+
+    gameMemory.skipRender = !options.render;
+    for (u64 frameIndex = 0; frameIndex < frameCount; ++frameIndex)
+    {
+        LoopInputRecord record;
+        if (SDL_ReadIO(inputHandle, &record, sizeof(record)) != sizeof(record))
+        {
+            LOG_ERROR("The input stream " << options.inputPath << " ended early at frame " << frameIndex << ".");
+            break;
+        }
+
+        // NOTE(marvin): The recorded frame time is ignored, so that
+        // every run of the replay simulates exactly the same steps.
+        u64 frameStartCounter = SDL_GetPerformanceCounter();
+        BeginFrameStatsFrame(gameMemory.frameStats, frameStartCounter, SDL_GetPerformanceFrequency());
+        if (options.render)
+        {
+            // NOTE(marvin): Stands in for the ImGui platform backend,
+            // as there is no window.
+            ImGuiIO &io = ImGui::GetIO();
+            io.DisplaySize = ImVec2(static_cast<f32>(options.displayWidth), static_cast<f32>(options.displayHeight));
+            io.DeltaTime = options.frameTime;
+            ImGui::NewFrame();
+        }
+        gameCode.gameUpdateAndRender(gameMemory, record.input, options.frameTime);
+        u64 frameEndCounter = SDL_GetPerformanceCounter();
+
+        EndMemoryTelemetryFrame(gameMemory.memoryTelemetry);
+
+        f64 ms = 1000.0 * (frameEndCounter - frameStartCounter) / performanceFrequency;
+        frameMs.push_back(ms);
+
+        if (report)
+        {
+            fprintf(report, "%s{\"frame\":%llu,\"cpuMs\":%.6f",
+                    frameIndex ? "," : "", (unsigned long long)frameIndex, ms);
+#if SKL_RENDERER == 2
+            fputc(',', report);
+            WriteRenderCounters(report, GetNullRenderCounters());
+#endif
+#if SKL_INTERNAL
+            fputc(',', report);
+            WriteFrameRecords(report, &frameSnapshot);
+#endif
+            fputc('}', report);
+        }
+    }
+
+    u64 replayCycles = ReadCPUTimer() - replayStartCycles;
+    f64 replaySeconds = (SDL_GetPerformanceCounter() - replayStartCounter) / performanceFrequency;
+
+    SDL_CloseIO(inputHandle);
+
+#if SKL_INTERNAL
+    gameMemory.debugFrameSnapshot = nullptr;
+#endif
+
+    if (frameMs.empty())
+    {
+        if (report)
+        {
+            fclose(report);
+        }
+        return 1;
+    }
+
+    f64 totalMs = 0.0;
+    for (f64 ms : frameMs)
+    {
+        totalMs += ms;
+    }
+
+    std::vector<f64> sortedFrameMs = frameMs;
+    std::sort(sortedFrameMs.begin(), sortedFrameMs.end());
+    f64 meanMs = totalMs / frameMs.size();
+    f64 minMs = sortedFrameMs.front();
+    f64 maxMs = sortedFrameMs.back();
+    f64 p50Ms = GetPercentile(sortedFrameMs, 0.50);
+    f64 p95Ms = GetPercentile(sortedFrameMs, 0.95);
+    f64 p99Ms = GetPercentile(sortedFrameMs, 0.99);
+
+    // NOTE(marvin): The cycle counts of the timed blocks are in
+    // whatever the CPU timer ticks at, which is estimated over the
+    // whole replay so that they can be turned into time.
+    f64 cpuTimerFrequency = replaySeconds > 0.0 ? replayCycles / replaySeconds : 0.0;
+
+    if (report)
+    {
+        fprintf(report,
+                "],\"summary\":{\"frameCount\":%llu,\"totalMs\":%.6f,\"meanMs\":%.6f,"
+                "\"minMs\":%.6f,\"maxMs\":%.6f,\"p50Ms\":%.6f,\"p95Ms\":%.6f,\"p99Ms\":%.6f,"
+                "\"cpuTimerFrequency\":%.0f}}\n",
+                (unsigned long long)frameMs.size(), totalMs, meanMs,
+                minMs, maxMs, p50Ms, p95Ms, p99Ms, cpuTimerFrequency);
+        fclose(report);
+    }
+
+    printf("Replayed %llu frames of %s in %.3f ms: mean %.3f ms, min %.3f ms, max %.3f ms, p95 %.3f ms, p99 %.3f ms\n",
+           (unsigned long long)frameMs.size(), options.inputPath, totalMs,
+           meanMs, minMs, maxMs, p95Ms, p99Ms);
+    return 0;
+}
@@ -0,0 +1,241 @@
+#include <iostream>
+#include <vector>
+
+#include <imgui.h>
+
+#include <render_backend.h>
+#include <renderer_null.h>
+
+#include <skl_math_types.h>
+#include <meta_definitions.h>
+#include <handle_pool.h>
+
+// NOTE(marvin): Matches the Vulkan backend, which is what the counters
+// are modelled after.
+#define NUM_CASCADES 6
+#define NUM_POINT_LIGHT_FACES 6
+
+struct NullMesh
+{
+    u32 vertCount;
+    u32 indexCount;
+};
+
+struct NullTexture
+{
+    u32 width;
+    u32 height;
+};
+
+enum NullLightType
+{
+    nullLightType_dir,
+    nullLightType_spot,
+    nullLightType_point,
+};
+
+struct NullLight
+{
+    NullLightType type;
+};
+
+// NOTE(marvin): The per instance data that the Vulkan backend uploads
+// every frame, only used for its size.
+struct NullObjectData
+{
+    glm::mat4 model;
+    u32 texture;
+    glm::vec4 color;
+    u32 id;
+};
+
+HandlePool<NullMesh> meshes;
+HandlePool<NullTexture> textures;
+HandlePool<NullLight> lights;
+
+bool editor;
+NullRenderCounters counters;
+MemoryTelemetry *memoryTelemetry;
+
+// NOTE(marvin): The frame each mesh slot was last drawn in, indexed by
+// the slot of the mesh handle, so that counting the unique meshes of a
+// frame needs neither a set nor a clear.
+std::vector<u64> meshDrawFrames;
+
+SDL_WindowFlags GetRenderWindowFlags()
+{
+    return 0;
+}
+
+// NOTE(marvin): The window may be null, for a headless replay.
+void InitRenderer(RenderInitInfo& info)
+{
+    editor = info.editor;
+    memoryTelemetry = info.memoryTelemetry;
+
+    // NOTE(marvin): Nothing samples the font atlas, but ImGui won't
+    // start a frame until it has been built.
+    ImGuiIO& io = ImGui::GetIO();
+    io.BackendRendererName = "skl_null";
+    u8* pixels;
+    s32 width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+}
+
+void InitPipelines(RenderPipelineInitInfo& info)
+{
+}
+
+MeshID UploadMesh(RenderUploadMeshInfo& info)
+{
+    NullMesh* mesh;
+    MeshID meshID = meshes.Add(&mesh);
+    mesh->vertCount = info.vertSize;
+    mesh->indexCount = info.idxSize;
+
+    u64 meshBytes = sizeof(Vertex) * info.vertSize + sizeof(u32) * info.idxSize;
+    counters.uploadedBytes += meshBytes;
+    RecordTelemetryAllocate(memoryTelemetry, memoryTag_renderer, meshBytes);
+    return meshID;
+}
+
+void DestroyMesh(RenderDestroyMeshInfo& info)
+{
+    NullMesh* mesh = meshes.Get(info.meshID);
+    if (!mesh)
+    {
+        LOG_ERROR("Tried to destroy a mesh that doesn't exist: " << info.meshID);
+        return;
+    }
+
+    RecordTelemetryFree(memoryTelemetry, memoryTag_renderer,
+                        sizeof(Vertex) * mesh->vertCount + sizeof(u32) * mesh->indexCount);
+    meshes.Remove(info.meshID);
+}
+
+TextureID UploadTexture(RenderUploadTextureInfo& info)
+{
+    NullTexture* texture;
+    TextureID textureID = textures.Add(&texture);
+    texture->width = info.width;
+    texture->height = info.height;
+
+    u64 textureBytes = sizeof(u32) * info.width * info.height;
+    counters.uploadedBytes += textureBytes;
+    RecordTelemetryAllocate(memoryTelemetry, memoryTag_renderer, textureBytes);
+    return textureID;
+}
+
+void SetSkyboxTexture(RenderSetSkyboxInfo& info)
+{
+    counters.uploadedBytes += 6ull * sizeof(u32) * info.width * info.height;
+}
+
+LightID AddDirLight()
+{
+    NullLight* light;
+    LightID lightID = lights.Add(&light);
+    light->type = nullLightType_dir;
+    return lightID;
+}
+
+LightID AddSpotLight()
+{
+    NullLight* light;
+    LightID lightID = lights.Add(&light);
+    light->type = nullLightType_spot;
+    return lightID;
+}
+
+LightID AddPointLight()
+{
+    NullLight* light;
+    LightID lightID = lights.Add(&light);
+    light->type = nullLightType_point;
+    return lightID;
+}
+
+void DestroyLight(LightID lightID)
+{
+    if (!lights.Remove(lightID))
+    {
+        LOG_ERROR("Tried to destroy a light that doesn't exist: " << lightID);
+    }
+}
+
+void DestroyDirLight(LightID lightID)
+{
+    DestroyLight(lightID);
+}
+
+void DestroySpotLight(LightID lightID)
+{
+    DestroyLight(lightID);
+}
+
+void DestroyPointLight(LightID lightID)
+{
+    DestroyLight(lightID);
+}
+
+u32 GetIndexAtCursor()
+{
+    return UINT32_MAX;
+}
+
+void RenderUpdate(RenderFrameInfo& info)
+{
+    meshDrawFrames.resize(meshes.slots.size());
+    u64 drawFrame = counters.frameCount + 1;
+    u32 uniqueMeshCount = 0;
+    u32 invalidMeshCount = 0;
+    for (MeshRenderInfo& meshInfo : info.meshes)
+    {
+        if (meshes.Get(meshInfo.mesh))
+        {
+            u64& meshDrawFrame = meshDrawFrames[HandlePool<NullMesh>::GetHandleIndex(meshInfo.mesh)];
+            if (meshDrawFrame != drawFrame)
+            {
+                meshDrawFrame = drawFrame;
+                ++uniqueMeshCount;
+            }
+        }
+        else
+        {
+            ++invalidMeshCount;
+        }
+    }
+
+    u32 dirLightCount = static_cast<u32>(info.dirLights.size());
+    u32 spotLightCount = static_cast<u32>(info.spotLights.size());
+    u32 pointLightCount = static_cast<u32>(info.pointLights.size());
+    u32 iconCount = editor ? static_cast<u32>(info.icons.size()) : 0;
+
+    u32 shadowPassCount = dirLightCount * NUM_CASCADES + spotLightCount + pointLightCount * NUM_POINT_LIGHT_FACES;
+    u32 meshPassCount = 2 + shadowPassCount;
+    u32 instanceCount = static_cast<u32>(info.meshes.size()) - invalidMeshCount;
+
+    counters.passCount = meshPassCount + (iconCount ? 1 : 0);
+    counters.drawCount = meshPassCount * uniqueMeshCount + (iconCount ? 1 : 0);
+    counters.instanceCount = instanceCount;
+    counters.iconCount = iconCount;
+    counters.dirLightCount = dirLightCount;
+    counters.spotLightCount = spotLightCount;
+    counters.pointLightCount = pointLightCount;
+    counters.invalidMeshCount = invalidMeshCount;
+    counters.frameUploadedBytes = sizeof(NullObjectData) * (instanceCount + iconCount);
+    ++counters.frameCount;
+
+    // NOTE(marvin): Ends the ImGui frame, as the other backends do
+    // when they draw it.
+    ImGui::Render();
+}
+
+NullRenderCounters GetNullRenderCounters()
+{
+    NullRenderCounters result = counters;
+    result.liveMeshCount = meshes.liveCount;
+    result.liveTextureCount = textures.liveCount;
+    result.liveLightCount = lights.liveCount;
+    return result;
+}
@@ -25,6 +25,7 @@
 #include <skl_math_types.h>
 #include <skl_math_utils.h>
 #include <meta_definitions.h>
+#include <handle_pool.h>
 #include <pipeline_builder.h>
 
 // Vulkan structures
@@ -61,6 +62,10 @@ std::vector<VkSemaphore> renderSemaphores;
 VkCommandPool mainCommandPool;
 FrameData frames[NUM_FRAMES];
 
+// The camera buffer indices that were freed, to be reused, so that the
+// indices of the other camera buffers never shift.
+std::vector<u32> freeCameraIndices;
+
 VkPipelineLayout depthPipelineLayout;
 VkPipelineLayout shadowPipelineLayout;
 VkPipelineLayout colorPipelineLayout;
@@ -86,12 +91,14 @@ u32 currentIndexCount;
 VkPipelineLayout *currentLayout;
 std::vector<VkImageMemoryBarrier2> imageBarriers;
 
-MeshID currentMeshID;
-std::unordered_map<MeshID,Mesh> meshes;
-TextureID currentTexID;
-std::unordered_map<TextureID,Texture> textures;
-LightID currentLightID;
-std::unordered_map<LightID,LightEntry> lights;
+HandlePool<Mesh> meshes;
+HandlePool<Texture> textures;
+HandlePool<LightEntry> lights;
+
+// The texture handles are for the game, the shaders index into the
+// texture descriptor array, which the shadow maps also take slots of.
+u32 nextDescriptorIndex;
+std::vector<u32> freeDescriptorIndices;
 
 VkSampler shadowSampler;
 VkSampler textureSampler;
@@ -101,14 +108,44 @@ u32 mainCamIndex;
 
 bool editor;
 u32 cursorEntityIndex = UINT32_MAX;
+MemoryTelemetry *memoryTelemetry;
 AllocatedBuffer iconIndexBuffer;
 
+u32 AllocateDescriptorIndex()
+{
+    if (!freeDescriptorIndices.empty())
+    {
+        u32 result = freeDescriptorIndices.back();
+        freeDescriptorIndices.pop_back();
+        return result;
+    }
+
+    return nextDescriptorIndex++;
+}
+
+void FreeDescriptorIndex(u32 descriptorIndex)
+{
+    freeDescriptorIndices.push_back(descriptorIndex);
+}
+
+u64 GetMeshBytes(const Mesh& mesh)
+{
+    u64 result = sizeof(u32) * mesh.indexCount + sizeof(Vertex) * mesh.vertCount;
+    return result;
+}
+
+u64 GetTextureBytes(const Texture& texture)
+{
+    u64 result = 4ull * texture.extent.width * texture.extent.height;
+    return result;
+}
+
 // Upload a mesh to the gpu
 MeshID UploadMesh(u32 vertCount, Vertex* vertices, u32 indexCount, u32* indices)
 {
-    currentMeshID++;
-    auto iter = meshes.emplace(currentMeshID, Mesh());
-    Mesh& mesh = iter.first->second;
+    Mesh* meshPtr;
+    MeshID meshID = meshes.Add(&meshPtr);
+    Mesh& mesh = *meshPtr;
 
     size_t indexSize = sizeof(u32) * indexCount;
     size_t vertSize = sizeof(Vertex) * vertCount;
@@ -130,8 +167,10 @@ MeshID UploadMesh(u32 vertCount, Vertex* vertices, u32 indexCount, u32* indices)
     StagedCopyToBuffer(device, deviceAllocator, mainCommandPool, graphicsQueue, mesh.vertBuffer, vertices, vertSize);
 
     mesh.indexCount = indexCount;
+    mesh.vertCount = vertCount;
+    RecordTelemetryAllocate(memoryTelemetry, memoryTag_renderer, GetMeshBytes(mesh));
 
-    return currentMeshID;
+    return meshID;
 }
 
 MeshID UploadMesh(RenderUploadMeshInfo& info)
@@ -141,14 +180,31 @@ MeshID UploadMesh(RenderUploadMeshInfo& info)
 
 void DestroyMesh(RenderDestroyMeshInfo& info)
 {
-    Mesh& mesh = meshes[info.meshID];
-    DestroyBuffer(deviceAllocator, mesh.indexBuffer);
-    DestroyBuffer(deviceAllocator, mesh.vertBuffer);
-    meshes.erase(info.meshID);
+    Mesh* mesh = meshes.Get(info.meshID);
+    if (!mesh)
+    {
+        LOG_ERROR("Tried to destroy a mesh that doesn't exist: " << info.meshID);
+        return;
+    }
+    DestroyBuffer(deviceAllocator, mesh->indexBuffer);
+    DestroyBuffer(deviceAllocator, mesh->vertBuffer);
+    RecordTelemetryFree(memoryTelemetry, memoryTag_renderer, GetMeshBytes(*mesh));
+    meshes.Remove(info.meshID);
 }
 
 u32 CreateCameraBuffer(u32 viewCount)
 {
+    if (!freeCameraIndices.empty())
+    {
+        u32 index = freeCameraIndices.back();
+        freeCameraIndices.pop_back();
+        for (int i = 0; i < NUM_FRAMES; i++)
+        {
+            frames[i].cameraBuffers[index] = CreateShaderBuffer(device, deviceAllocator, sizeof(CameraData) * viewCount);
+        }
+        return index;
+    }
+
     for (int i = 0; i < NUM_FRAMES; i++)
     {
         frames[i].cameraBuffers.push_back(CreateShaderBuffer(device, deviceAllocator, sizeof(CameraData) * viewCount));
@@ -157,6 +213,18 @@ u32 CreateCameraBuffer(u32 viewCount)
     return frames[0].cameraBuffers.size() - 1;
 }
 
+// Frees the camera buffer of every frame. None of the frames in flight
+// may still be using it.
+void DestroyCameraBuffer(u32 index)
+{
+    for (int i = 0; i < NUM_FRAMES; i++)
+    {
+        DestroyBuffer(deviceAllocator, frames[i].cameraBuffers[index]);
+        frames[i].cameraBuffers[index] = {};
+    }
+    freeCameraIndices.push_back(index);
+}
+
 Texture CreateDepthTexture(u32 width, u32 height)
 {
     AllocatedImage depthTexture = CreateImage(deviceAllocator,
@@ -187,6 +255,7 @@ Texture CreateDepthTexture(u32 width, u32 height)
 
     VK_CHECK(vkCreateImageView(device, &depthViewInfo, nullptr, &depthTexView));
 
+    u32 descriptorIndex = AllocateDescriptorIndex();
     VkDescriptorImageInfo imageInfo{.imageView = depthTexView, .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
 
     VkWriteDescriptorSet descriptorWrite
@@ -194,7 +263,7 @@ Texture CreateDepthTexture(u32 width, u32 height)
         .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
         .dstSet = texDescriptorSet,
         .dstBinding = 0,
-        .dstArrayElement = (u32)currentTexID,
+        .dstArrayElement = descriptorIndex,
         .descriptorCount = 1,
         .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
         .pImageInfo = &imageInfo
@@ -207,11 +276,9 @@ Texture CreateDepthTexture(u32 width, u32 height)
         .texture = depthTexture,
         .imageView = depthTexView,
         .extent = {width, height},
-        .descriptorIndex = (u32)currentTexID
+        .descriptorIndex = descriptorIndex
     };
 
-    currentTexID++;
-
     return texture;
 }
 
@@ -245,6 +312,7 @@ Texture CreateDepthArray(u32 width, u32 height, u32 layers)
 
     VK_CHECK(vkCreateImageView(device, &depthViewInfo, nullptr, &depthTexView));
 
+    u32 descriptorIndex = AllocateDescriptorIndex();
     VkDescriptorImageInfo imageInfo{.imageView = depthTexView, .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
 
     VkWriteDescriptorSet descriptorWrite
@@ -252,7 +320,7 @@ Texture CreateDepthArray(u32 width, u32 height, u32 layers)
         .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
         .dstSet = texDescriptorSet,
         .dstBinding = 0,
-        .dstArrayElement = (u32)currentTexID,
+        .dstArrayElement = descriptorIndex,
         .descriptorCount = 1,
         .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
         .pImageInfo = &imageInfo
@@ -265,11 +333,9 @@ Texture CreateDepthArray(u32 width, u32 height, u32 layers)
         .texture = depthTexture,
         .imageView = depthTexView,
         .extent = {width, height},
-        .descriptorIndex = (u32)currentTexID
+        .descriptorIndex = descriptorIndex
     };
 
-    currentTexID++;
-
     return texture;
 }
 
@@ -304,6 +370,7 @@ Texture CreateDepthCubemap(u32 width, u32 height)
 
     VK_CHECK(vkCreateImageView(device, &depthViewInfo, nullptr, &depthTexView));
 
+    u32 descriptorIndex = AllocateDescriptorIndex();
     VkDescriptorImageInfo imageInfo{.imageView = depthTexView, .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
 
     VkWriteDescriptorSet descriptorWrite
@@ -311,7 +378,7 @@ Texture CreateDepthCubemap(u32 width, u32 height)
         .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
         .dstSet = texDescriptorSet,
         .dstBinding = 0,
-        .dstArrayElement = (u32)currentTexID,
+        .dstArrayElement = descriptorIndex,
         .descriptorCount = 1,
         .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
         .pImageInfo = &imageInfo
@@ -324,11 +391,9 @@ Texture CreateDepthCubemap(u32 width, u32 height)
         .texture = depthTexture,
         .imageView = depthTexView,
         .extent = {width, height},
-        .descriptorIndex = (u32)currentTexID
+        .descriptorIndex = descriptorIndex
     };
 
-    currentTexID++;
-
     return texture;
 }
 
@@ -362,6 +427,7 @@ TextureID UploadTexture(RenderUploadTextureInfo& info)
 
     VK_CHECK(vkCreateImageView(device, &texViewInfo, nullptr, &texView));
 
+    u32 descriptorIndex = AllocateDescriptorIndex();
     VkDescriptorImageInfo imageInfo{.imageView = texView, .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
 
     VkWriteDescriptorSet descriptorWrite
@@ -369,7 +435,7 @@ TextureID UploadTexture(RenderUploadTextureInfo& info)
         .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
         .dstSet = texDescriptorSet,
         .dstBinding = 0,
-        .dstArrayElement = (u32)currentTexID,
+        .dstArrayElement = descriptorIndex,
         .descriptorCount = 1,
         .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
         .pImageInfo = &imageInfo
@@ -424,74 +490,110 @@ TextureID UploadTexture(RenderUploadTextureInfo& info)
     EndImmediateCommands(device, graphicsQueue, mainCommandPool, commandBuffer);
 
     DestroyBuffer(deviceAllocator, uploadBuffer);
-    auto iter = textures.emplace(currentTexID, Texture());
-    Texture& texture = iter.first->second;
+    Texture* texture;
+    TextureID texID = textures.Add(&texture);
 
-    texture =
+    *texture =
     {
         .texture = texImage,
         .imageView = texView,
         .extent = {info.width, info.height},
-        .descriptorIndex = (u32)currentTexID
+        .descriptorIndex = descriptorIndex
     };
+    RecordTelemetryAllocate(memoryTelemetry, memoryTag_renderer, GetTextureBytes(*texture));
 
-    return currentTexID++;
+    return texID;
 }
 
-void DestroyTexture(TextureID texID)
+void DestroyTextureResources(Texture& texture)
 {
-    Texture& texture = textures[texID];
     vkDestroyImageView(device, texture.imageView, nullptr);
     DestroyImage(deviceAllocator, texture.texture);
-    textures.erase(texID);
+    FreeDescriptorIndex(texture.descriptorIndex);
+}
+
+void DestroyTexture(TextureID texID)
+{
+    Texture* texture = textures.Get(texID);
+    if (!texture)
+    {
+        LOG_ERROR("Tried to destroy a texture that doesn't exist: " << texID);
+        return;
+    }
+    DestroyTextureResources(*texture);
+    RecordTelemetryFree(memoryTelemetry, memoryTag_renderer, GetTextureBytes(*texture));
+    textures.Remove(texID);
+}
+
+// Produces the index of the texture in the texture descriptor array,
+// or -1 if there is no texture.
+s32 GetTextureDescriptorIndex(TextureID texID)
+{
+    Texture* texture = textures.Get(texID);
+    s32 result = texture ? (s32)texture->descriptorIndex : -1;
+    return result;
 }
 
 LightID AddDirLight()
 {
-    currentLightID++;
-    auto iter = lights.emplace(currentLightID, LightEntry());
-    LightEntry& light = iter.first->second;
-    light.cameraIndex = CreateCameraBuffer(NUM_CASCADES);
-    light.shadowMap = CreateDepthArray(4096, 4096, NUM_CASCADES);
+    LightEntry* light;
+    LightID lightID = lights.Add(&light);
+    light->cameraIndex = CreateCameraBuffer(NUM_CASCADES);
+    light->shadowMap = CreateDepthArray(4096, 4096, NUM_CASCADES);
 
-    return currentLightID;
+    return lightID;
 }
 
 LightID AddSpotLight()
 {
-    currentLightID++;
-    auto iter = lights.emplace(currentLightID, LightEntry());
-    LightEntry& light = iter.first->second;
-    light.cameraIndex = CreateCameraBuffer(1);
-    light.shadowMap = CreateDepthTexture(1024, 1024);
+    LightEntry* light;
+    LightID lightID = lights.Add(&light);
+    light->cameraIndex = CreateCameraBuffer(1);
+    light->shadowMap = CreateDepthTexture(1024, 1024);
 
-    return currentLightID;
+    return lightID;
 }
 
 LightID AddPointLight()
 {
-    currentLightID++;
-    auto iter = lights.emplace(currentLightID, LightEntry());
-    LightEntry& light = iter.first->second;
-    light.cameraIndex = CreateCameraBuffer(6);
-    light.shadowMap = CreateDepthCubemap(512, 512);
+    LightEntry* light;
+    LightID lightID = lights.Add(&light);
+    light->cameraIndex = CreateCameraBuffer(6);
+    light->shadowMap = CreateDepthCubemap(512, 512);
 
-    return currentLightID;
+    return lightID;
 }
 
-void DestroyDirLight(LightID lightID)
+void DestroyLight(LightID lightID)
 {
+    LightEntry* light = lights.Get(lightID);
+    if (!light)
+    {
+        LOG_ERROR("Tried to destroy a light that doesn't exist: " << lightID);
+        return;
+    }
 
+    // The shadow map and the camera buffers may still be in use by the
+    // frames in flight.
+    vkDeviceWaitIdle(device);
+    DestroyTextureResources(light->shadowMap);
+    DestroyCameraBuffer(light->cameraIndex);
+    lights.Remove(lightID);
 }
 
-void DestroySpotLight(LightID lightID)
+void DestroyDirLight(LightID lightID)
 {
+    DestroyLight(lightID);
+}
 
+void DestroySpotLight(LightID lightID)
+{
+    DestroyLight(lightID);
 }
 
 void DestroyPointLight(LightID lightID)
 {
-
+    DestroyLight(lightID);
 }
 
 u32 GetIndexAtCursor()
@@ -632,6 +734,7 @@ SDL_WindowFlags GetRenderWindowFlags()
 void InitRenderer(RenderInitInfo& info)
 {
     editor = info.editor;
+    memoryTelemetry = info.memoryTelemetry;
 
     volkInitializeCustom((PFN_vkGetInstanceProcAddr)SDL_Vulkan_GetVkGetInstanceProcAddr());
 
@@ -1526,9 +1629,14 @@ void SetObjectData(std::vector<ObjectData>& objects, std::vector<u32>& ids)
 }
 
 // Set the mesh currently being rendered (Must be called between InitFrame and EndFrame)
-void SetMesh(MeshID meshIndex)
+// Produces false if the mesh doesn't exist, in which case nothing should be drawn
+bool SetMesh(MeshID meshIndex)
 {
-    Mesh* mesh = &meshes[meshIndex];
+    Mesh* mesh = meshes.Get(meshIndex);
+    if (!mesh)
+    {
+        return false;
+    }
 
     // Send addresses to vertex buffer as a push constant
     VkCommandBuffer& cmd = frames[frameNum].commandBuffer;
@@ -1538,6 +1646,7 @@ void SetMesh(MeshID meshIndex)
     vkCmdBindIndexBuffer(cmd, mesh->indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
 
     currentIndexCount = mesh->indexCount;
+    return true;
 }
 
 // Draw multiple objects to the screen (Must be called between InitFrame and EndFrame and after SetMesh)
@@ -1646,8 +1755,19 @@ void DrawIcons(std::vector<IconRenderInfo>& icons)
     vkCmdBindIndexBuffer(cmd, iconIndexBuffer.buffer, 0, VK_INDEX_TYPE_UINT16);
 
     AllocatedBuffer& objectBuffer = frames[frameNum].iconBuffer;
-    void* objectData = objectBuffer.info.pMappedData;
-    memcpy(objectData, icons.data(), sizeof(IconData) * icons.size());
+    IconData* objectData = (IconData*)objectBuffer.info.pMappedData;
+    u32 iconCount = 0;
+    for (IconRenderInfo& icon : icons)
+    {
+        // Icons whose texture doesn't exist are skipped, rather than
+        // indexing past the end of the texture descriptor array
+        s32 descriptorIndex = GetTextureDescriptorIndex(icon.texture);
+        if (descriptorIndex == -1)
+        {
+            continue;
+        }
+        objectData[iconCount++] = {icon.pos, (u32)descriptorIndex, icon.id};
+    }
 
     f32 aspect = (f32)swapExtent.height / swapExtent.width;
     glm::vec2 iconScale = {0.0625 * aspect, 0.0625};
@@ -1663,7 +1783,7 @@ void DrawIcons(std::vector<IconRenderInfo>& icons)
     vkCmdPushConstants(cmd, colorPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
                        0, sizeof(IconPushConstants), &pushConstants);
 
-    vkCmdDrawIndexed(cmd, 6, icons.size(), 0, 0, 0);
+    vkCmdDrawIndexed(cmd, 6, iconCount, 0, 0, 0);
 }
 
 void RenderUpdate(RenderFrameInfo& info)
@@ -1703,7 +1823,7 @@ void RenderUpdate(RenderFrameInfo& info)
         TextureID tex = meshInfo.texture;
         glm::vec3 color = meshInfo.rgbColor;
 
-        objects[offsets[mesh]] = {model, tex, sRGBToLinear(glm::vec4(color.r, color.g, color.b, 1.0f))};
+        objects[offsets[mesh]] = {model, GetTextureDescriptorIndex(tex), sRGBToLinear(glm::vec4(color.r, color.g, color.b, 1.0f))};
         ids[offsets[mesh]++] = meshInfo.id;
     }
 
@@ -1776,7 +1896,12 @@ void RenderUpdate(RenderFrameInfo& info)
             cascades.push_back({dirProj * dirView, currentNear});
         }
 
-        LightEntry lightEntry = lights[dirInfo.lightID];
+        LightEntry* lightEntryPtr = lights.Get(dirInfo.lightID);
+        if (!lightEntryPtr)
+        {
+            continue;
+        }
+        LightEntry& lightEntry = *lightEntryPtr;
 
         BeginCascadedPass(lightEntry.shadowMap, CullMode::BACK);
 
@@ -1786,8 +1911,10 @@ void RenderUpdate(RenderFrameInfo& info)
         startIndex = 0;
         for (std::pair<MeshID, u32> pair: meshCounts)
         {
-            SetMesh(pair.first);
-            DrawObjects(pair.second, startIndex);
+            if (SetMesh(pair.first))
+            {
+                DrawObjects(pair.second, startIndex);
+            }
             startIndex += pair.second;
         }
         EndPass();
@@ -1806,7 +1933,12 @@ void RenderUpdate(RenderFrameInfo& info)
         glm::mat4 spotView = spotTransform->GetViewMatrix();
         glm::mat4 spotProj = glm::perspective(glm::radians(spotInfo.outerCone * 2), 1.0f, 0.01f, spotInfo.range);
         glm::vec3 spotPos = spotTransform->GetWorldTransform() * glm::vec4(0, 0, 0, 1);
-        LightEntry lightEntry = lights[spotInfo.lightID];
+        LightEntry* lightEntryPtr = lights.Get(spotInfo.lightID);
+        if (!lightEntryPtr)
+        {
+            continue;
+        }
+        LightEntry& lightEntry = *lightEntryPtr;
 
         if (spotInfo.needsUpdate)
         {
@@ -1822,8 +1954,10 @@ void RenderUpdate(RenderFrameInfo& info)
             startIndex = 0;
             for (std::pair<MeshID, u32> pair: meshCounts)
             {
-                SetMesh(pair.first);
-                DrawObjects(pair.second, startIndex);
+                if (SetMesh(pair.first))
+                {
+                    DrawObjects(pair.second, startIndex);
+                }
                 startIndex += pair.second;
             }
             EndPass();
@@ -1842,7 +1976,12 @@ void RenderUpdate(RenderFrameInfo& info)
     {
         Transform3D* pointTransform = pointInfo.transform;
         glm::vec3 pointPos = pointTransform->GetWorldTransform() * glm::vec4(0, 0, 0, 1);
-        LightEntry lightEntry = lights[pointInfo.lightID];
+        LightEntry* lightEntryPtr = lights.Get(pointInfo.lightID);
+        if (!lightEntryPtr)
+        {
+            continue;
+        }
+        LightEntry& lightEntry = *lightEntryPtr;
 
         if (pointInfo.needsUpdate)
         {
@@ -1868,8 +2007,10 @@ void RenderUpdate(RenderFrameInfo& info)
             startIndex = 0;
             for (std::pair<MeshID, u32> pair: meshCounts)
             {
-                SetMesh(pair.first);
-                DrawObjects(pair.second, startIndex);
+                if (SetMesh(pair.first))
+                {
+                    DrawObjects(pair.second, startIndex);
+                }
                 startIndex += pair.second;
             }
             EndPass();
@@ -1890,8 +2031,10 @@ void RenderUpdate(RenderFrameInfo& info)
     startIndex = 0;
     for (std::pair<MeshID, u32> pair: meshCounts)
     {
-        SetMesh(pair.first);
-        DrawObjects(pair.second, startIndex);
+        if (SetMesh(pair.first))
+        {
+            DrawObjects(pair.second, startIndex);
+        }
         startIndex += pair.second;
     }
     EndPass();
@@ -1906,8 +2049,10 @@ void RenderUpdate(RenderFrameInfo& info)
     startIndex = 0;
     for (std::pair<MeshID, u32> pair: meshCounts)
     {
-        SetMesh(pair.first);
-        DrawObjects(pair.second, startIndex);
+        if (SetMesh(pair.first))
+        {
+            DrawObjects(pair.second, startIndex);
+        }
         startIndex += pair.second;
     }
 
@@ -14,7 +14,7 @@ SDL_WindowFlags GetRenderWindowFlags() {
 }
 
 void InitRenderer(RenderInitInfo& desc) {
-    wgpuRenderer.InitRenderer(desc.window, desc.startWidth, desc.startHeight);
+    wgpuRenderer.InitRenderer(desc.window, desc.startWidth, desc.startHeight, desc.memoryTelemetry);
 }
 
 void InitPipelines(RenderPipelineInitInfo& desc) {
@@ -25,8 +25,9 @@ MeshID UploadMesh(RenderUploadMeshInfo& desc) {
     return wgpuRenderer.UploadMesh(desc.vertSize, desc.vertData, desc.idxSize, desc.idxData);
 }
 
+// Textures aren't supported by this backend yet, so there is nothing to hand out a handle to
 TextureID UploadTexture(RenderUploadTextureInfo& desc) {
-        return 0;
+    return INVALID_HANDLE;
 }
 
 void SetSkyboxTexture(RenderSetSkyboxInfo& info) {
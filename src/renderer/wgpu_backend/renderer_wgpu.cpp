@@ -229,8 +229,12 @@ void WGPURenderBackend::DrawObjects(std::map<MeshID, u32>& meshCounts) {
   u32 startIndex = 0;
   for (std::pair<MeshID, u32> pair : meshCounts)
   {
-    WGPUBackendMeshIdx& gotMesh = m_meshStore[pair.first];
-    wgpuRenderPassEncoderDrawIndexed(m_renderPassEncoder, gotMesh.m_indexCount, pair.second, gotMesh.m_baseIndex, gotMesh.m_baseVertex, startIndex);
+    WGPUBackendMeshIdx* gotMesh = m_meshStore.Get(pair.first);
+    if (!gotMesh) {
+      startIndex += pair.second;
+      continue;
+    }
+    wgpuRenderPassEncoderDrawIndexed(m_renderPassEncoder, gotMesh->m_indexCount, pair.second, gotMesh->m_baseIndex, gotMesh->m_baseVertex, startIndex);
     startIndex += pair.second;
   }
 }
@@ -471,9 +475,10 @@ WGPURenderBackend::~WGPURenderBackend() {
   wgpuQueueRelease(m_wgpuQueue);
 }
 
-void WGPURenderBackend::InitRenderer(SDL_Window *window, u32 startWidth, u32 startHeight) {
+void WGPURenderBackend::InitRenderer(SDL_Window *window, u32 startWidth, u32 startHeight, MemoryTelemetry* memoryTelemetry) {
   m_screenWidth = startWidth;
   m_screenHeight = startHeight;
+  m_memoryTelemetry = memoryTelemetry;
   // Creates instance
   WGPUInstanceDescriptor instanceDescriptor { 
     .nextInChain = nullptr
@@ -1257,44 +1262,59 @@ void WGPURenderBackend::InitPipelines()
 }
 
 MeshID WGPURenderBackend::UploadMesh(u32 vertCount, Vertex* vertices, u32 indexCount, u32* indices) {
-  u32 retInt = m_nextMeshID;
-  m_meshStore.emplace(std::pair<u32, WGPUBackendMeshIdx>(retInt, WGPUBackendMeshIdx(m_meshTotalIndices, m_meshTotalVertices, indexCount, vertCount)));
+  WGPUBackendMeshIdx* newMesh;
+  MeshID retID = m_meshStore.Add(&newMesh);
+  *newMesh = WGPUBackendMeshIdx(m_meshTotalIndices, m_meshTotalVertices, indexCount, vertCount);
   
   m_meshVertexBuffer.AppendToBack(m_wgpuCore.m_device, m_wgpuQueue, vertices, vertCount);
   m_meshIndexBuffer.AppendToBack(m_wgpuCore.m_device, m_wgpuQueue, indices, indexCount);
 
-  m_nextMeshID++;
   m_meshTotalIndices += indexCount; 
   m_meshTotalVertices += vertCount;
 
-  return retInt;
+  RecordTelemetryAllocate(m_memoryTelemetry, memoryTag_renderer, sizeof(Vertex) * vertCount + sizeof(u32) * indexCount);
+
+  return retID;
 }
 
 void WGPURenderBackend::DestroyMesh(MeshID meshID) {
-  WGPUBackendMeshIdx& gotMesh = m_meshStore[meshID];
+  WGPUBackendMeshIdx* foundMesh = m_meshStore.Get(meshID);
+  if (!foundMesh) {
+    LOG_ERROR("Tried to destroy a mesh that doesn't exist: " << meshID);
+    return;
+  }
+  WGPUBackendMeshIdx gotMesh = *foundMesh;
 
   // Removes mesh gpu side informations
   m_meshVertexBuffer.EraseRange(m_wgpuCore.m_device, m_wgpuQueue, gotMesh.m_baseVertex , gotMesh.m_vertexCount);
   m_meshIndexBuffer.EraseRange(m_wgpuCore.m_device, m_wgpuQueue, gotMesh.m_baseIndex , gotMesh.m_indexCount);
 
-  // Readjusts mesh cpu side descriptors
-  for (std::pair<MeshID, WGPUBackendMeshIdx> meshIter : m_meshStore) {
-    if(meshIter.first > meshID) {
-      WGPUBackendMeshIdx& editMesh = meshIter.second;
+  // Readjusts mesh cpu side descriptors of the meshes placed after the removed one,
+  // handles get reused so the placement is what orders the meshes
+  m_meshStore.ForEach([&](MeshID, WGPUBackendMeshIdx& editMesh) {
+    if (editMesh.m_baseVertex > gotMesh.m_baseVertex) {
       editMesh.m_baseIndex -= gotMesh.m_indexCount;
       editMesh.m_baseVertex -= gotMesh.m_vertexCount;
     }
-  }
+  });
 
-  m_meshTotalVertices -= gotMesh.m_indexCount;
+  m_meshTotalIndices -= gotMesh.m_indexCount;
   m_meshTotalVertices -= gotMesh.m_vertexCount;
 
+  RecordTelemetryFree(m_memoryTelemetry, memoryTag_renderer,
+                      sizeof(Vertex) * gotMesh.m_vertexCount + sizeof(u32) * gotMesh.m_indexCount);
+
   // Removes mesh cpu side descriptors
-  m_meshStore.erase(meshID);
+  m_meshStore.Remove(meshID);
 }
 
 void WGPURenderBackend::SetSkybox(u32 width, u32 height, const std::array<u32*,6>& faceData) {
   m_skyboxTexture.Insert(m_wgpuCore.m_device, m_wgpuQueue, width, height, faceData);
+
+  // The new skybox replaces the old one
+  RecordTelemetryFree(m_memoryTelemetry, memoryTag_renderer, m_skyboxBytes);
+  m_skyboxBytes = 6ull * sizeof(u32) * width * height;
+  RecordTelemetryAllocate(m_memoryTelemetry, memoryTag_renderer, m_skyboxBytes);
 }
 
 void WGPURenderBackend::RenderUpdate(RenderFrameInfo& state) {
@@ -1424,31 +1444,49 @@ void WGPURenderBackend::RenderUpdate(RenderFrameInfo& state) {
 
 // Adds dynamic lights into scene
 LightID WGPURenderBackend::AddDirLight() {
-  LightID lightID = m_dynamicShadowedDirLightNextID;
-  m_dynamicShadowedDirLightNextID++;
+  WGPUBackendLightEntry* light;
+  LightID lightID = m_lightStore.Add(&light);
+  light->m_type = WGPUBackendLightType::Dir;
   m_dynamicDirLightShadowMapTexture.RegisterShadow(m_wgpuCore.m_device, m_wgpuQueue);
   return lightID;
 }
 LightID WGPURenderBackend::AddSpotLight() {
-  LightID lightID = m_dynamicShadowedSpotLightNextID;
-  m_dynamicShadowedSpotLightNextID++;
+  WGPUBackendLightEntry* light;
+  LightID lightID = m_lightStore.Add(&light);
+  light->m_type = WGPUBackendLightType::Spot;
   return lightID;
 }
 LightID WGPURenderBackend::AddPointLight() {
-  LightID lightID = m_dynamicShadowedPointLightNextID;
-  m_dynamicShadowedPointLightNextID++;
+  WGPUBackendLightEntry* light;
+  LightID lightID = m_lightStore.Add(&light);
+  light->m_type = WGPUBackendLightType::Point;
   m_dynamicPointLightShadowMapTexture.RegisterShadow(m_wgpuCore.m_device, m_wgpuQueue);
   return lightID;
 }
 
+// Removes the light only if the handle is still live and of the expected type,
+// so a stale handle can't unregister the shadow of another light
+bool WGPURenderBackend::RemoveLight(LightID lightID, WGPUBackendLightType type) {
+  WGPUBackendLightEntry* light = m_lightStore.Get(lightID);
+  if (!light || light->m_type != type) {
+    LOG_ERROR("Tried to destroy a light that doesn't exist: " << lightID);
+    return false;
+  }
+  m_lightStore.Remove(lightID);
+  return true;
+}
+
 void WGPURenderBackend::DestroyDirLight(LightID lightID) {
-  m_dynamicDirLightShadowMapTexture.UnregisterShadow();
+  if (RemoveLight(lightID, WGPUBackendLightType::Dir)) {
+    m_dynamicDirLightShadowMapTexture.UnregisterShadow();
+  }
 }
-// TODO Actually implement
 void WGPURenderBackend::DestroySpotLight(LightID lightID) {
-  
+  RemoveLight(lightID, WGPUBackendLightType::Spot);
 }
 void WGPURenderBackend::DestroyPointLight(LightID lightID) {
-  m_dynamicPointLightShadowMapTexture.UnregisterShadow();
+  if (RemoveLight(lightID, WGPUBackendLightType::Point)) {
+    m_dynamicPointLightShadowMapTexture.UnregisterShadow();
+  }
 }
 #pragma endregion
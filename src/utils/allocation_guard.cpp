@@ -0,0 +1,321 @@
+#if SKL_ALLOCATION_GUARD
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <meta_definitions.h>
+#include <allocation_guard.h>
+
+#if defined(PLATFORM_UNIX) && !defined(EMSCRIPTEN)
+#define ALLOCATION_GUARD_HAS_BACKTRACE 1
+#include <execinfo.h>
+#include <dlfcn.h>
+#include <cxxabi.h>
+#else
+#define ALLOCATION_GUARD_HAS_BACKTRACE 0
+#endif
+
+AllocationGuard *globalAllocationGuard;
+
+// NOTE(marvin): Walking the stack or taking the lock may allocate
+// themselves, which must not be recorded again.
+thread_local b32 insideAllocationGuard;
+
+// NOTE(marvin): The procedures between the call site and the stack
+// walk are kept out of line, so that the number of frames to skip is
+// the same no matter the optimization level.
+constexpr u32 MAX_SKIPPED_FRAMES = 4;
+
+__attribute__((noinline)) local u32 CaptureStack(void **stack, u32 maxDepth, u32 skip)
+{
+#if ALLOCATION_GUARD_HAS_BACKTRACE
+    void *frames[ALLOCATION_GUARD_STACK_DEPTH + MAX_SKIPPED_FRAMES];
+    s32 depth = backtrace(frames, ArrayCount(frames));
+
+    u32 result = 0;
+    for (s32 i = skip; i < depth && result < maxDepth; ++i)
+    {
+        stack[result++] = frames[i];
+    }
+    return result;
+#else
+    stack[0] = __builtin_return_address(0);
+    return 1;
+#endif
+}
+
+local b32 StacksMatch(AllocationGuardSite *site, AllocationGuardSource source, void **stack, u32 stackDepth)
+{
+    b32 result = (site->source == source) &&
+        (site->stackDepth == stackDepth) &&
+        (memcmp(site->stack, stack, stackDepth * sizeof(void *)) == 0);
+    return result;
+}
+
+local const char *GetAllocationGuardSourceName(AllocationGuardSource source)
+{
+    const char *result = (source == allocationGuardSource_platformAllocator) ? "platform allocator" : "operator new";
+    return result;
+}
+
+local void PrintStackFrame(u32 frameIndex, void *address)
+{
+#if ALLOCATION_GUARD_HAS_BACKTRACE
+    Dl_info info = {};
+    if (dladdr(address, &info) && info.dli_fname)
+    {
+        const char *moduleName = strrchr(info.dli_fname, '/');
+        moduleName = moduleName ? moduleName + 1 : info.dli_fname;
+        siz moduleOffset = static_cast<u8 *>(address) - static_cast<u8 *>(info.dli_fbase);
+
+        if (info.dli_sname)
+        {
+            s32 status = 0;
+            char *demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            siz symbolOffset = static_cast<u8 *>(address) - static_cast<u8 *>(info.dli_saddr);
+            printf("    #%u %s+0x%zx (%s+0x%zx)\n", frameIndex,
+                   (status == 0) ? demangled : info.dli_sname, symbolOffset,
+                   moduleName, moduleOffset);
+            free(demangled);
+        }
+        else
+        {
+            printf("    #%u ?? (%s+0x%zx)\n", frameIndex, moduleName, moduleOffset);
+        }
+        return;
+    }
+#endif
+    printf("    #%u %p\n", frameIndex, address);
+}
+
+void InitAllocationGuard(AllocationGuard *guard)
+{
+    globalAllocationGuard = guard;
+
+#if ALLOCATION_GUARD_HAS_BACKTRACE
+    // NOTE(marvin): The first backtrace loads the unwinder, which allocates.
+    void *frames[ALLOCATION_GUARD_STACK_DEPTH];
+    backtrace(frames, ArrayCount(frames));
+#endif
+}
+
+void ResetAllocationGuardWarmup(AllocationGuard *guard)
+{
+    guard->framesSinceLoad = 0;
+}
+
+void ArmAllocationGuard(AllocationGuard *guard)
+{
+    ++guard->frameIndex;
+    if (guard->framesSinceLoad < ALLOCATION_GUARD_WARMUP_FRAMES)
+    {
+        ++guard->framesSinceLoad;
+        return;
+    }
+
+    guard->armed = true;
+}
+
+void DisarmAllocationGuard(AllocationGuard *guard)
+{
+    if (!guard->armed)
+    {
+        return;
+    }
+    guard->armed = false;
+
+    // NOTE(marvin): Worker threads could still be in the middle of
+    // recording, wait for them.
+    BeginTicketMutex(&guard->mutex);
+
+    if (guard->siteCount > 0)
+    {
+        u64 totalCount = guard->droppedCount;
+        u64 totalBytes = 0;
+        for (u32 i = 0; i < guard->siteCount; ++i)
+        {
+            totalCount += guard->sites[i].count;
+            totalBytes += guard->sites[i].bytes;
+        }
+
+        printf("Allocation guard: %llu allocations (%llu bytes) during frame %llu\n",
+               (unsigned long long)totalCount, (unsigned long long)totalBytes,
+               (unsigned long long)guard->frameIndex);
+
+        for (u32 i = 0; i < guard->siteCount; ++i)
+        {
+            AllocationGuardSite *site = guard->sites + i;
+            printf("  %llux, %llu bytes through %s\n",
+                   (unsigned long long)site->count, (unsigned long long)site->bytes,
+                   GetAllocationGuardSourceName(site->source));
+            for (u32 frameIndex = 0; frameIndex < site->stackDepth; ++frameIndex)
+            {
+                PrintStackFrame(frameIndex, site->stack[frameIndex]);
+            }
+        }
+
+        if (guard->droppedCount > 0)
+        {
+            printf("  %llu allocations from call sites beyond the first %u\n",
+                   (unsigned long long)guard->droppedCount, MAX_ALLOCATION_GUARD_SITES);
+        }
+        puts("");
+    }
+
+    guard->siteCount = 0;
+    guard->droppedCount = 0;
+    EndTicketMutex(&guard->mutex);
+}
+
+__attribute__((noinline)) void RecordGuardedAllocation(AllocationGuardSource source, u64 size)
+{
+    AllocationGuard *guard = globalAllocationGuard;
+    if (!guard || !guard->armed || insideAllocationGuard)
+    {
+        return;
+    }
+    insideAllocationGuard = true;
+
+    // NOTE(marvin): Skipping the stack walk and this procedure, as
+    // well as operator new and its helper.
+    u32 skip = (source == allocationGuardSource_operatorNew) ? 4 : 2;
+    void *stack[ALLOCATION_GUARD_STACK_DEPTH];
+    u32 stackDepth = CaptureStack(stack, ALLOCATION_GUARD_STACK_DEPTH, skip);
+
+    BeginTicketMutex(&guard->mutex);
+    AllocationGuardSite *site = nullptr;
+    for (u32 i = 0; i < guard->siteCount; ++i)
+    {
+        if (StacksMatch(guard->sites + i, source, stack, stackDepth))
+        {
+            site = guard->sites + i;
+            break;
+        }
+    }
+
+    if (!site && guard->siteCount < MAX_ALLOCATION_GUARD_SITES)
+    {
+        site = guard->sites + guard->siteCount++;
+        memcpy(site->stack, stack, stackDepth * sizeof(void *));
+        site->stackDepth = stackDepth;
+        site->source = source;
+        site->count = 0;
+        site->bytes = 0;
+    }
+
+    if (site)
+    {
+        ++site->count;
+        site->bytes += size;
+    }
+    else
+    {
+        ++guard->droppedCount;
+    }
+    EndTicketMutex(&guard->mutex);
+
+    insideAllocationGuard = false;
+}
+
+/**
+ * GLOBAL OPERATOR NEW
+ */
+
+// NOTE(marvin): Replacing the global operator new and delete. When
+// the platform executable defines them, the dynamic linker binds the
+// game module's (and every other library's) operator new to it as
+// well, so the one replacement covers the std containers on both
+// sides of the module boundary.
+// TODO(marvin): On Windows every DLL gets its own operator new, and
+// aligned_alloc doesn't exist, so only the platform allocator is
+// guarded there for now.
+#if !defined(PLATFORM_WINDOWS)
+
+__attribute__((noinline)) local void *GuardedNew(std::size_t size)
+{
+    RecordGuardedAllocation(allocationGuardSource_operatorNew, size);
+    void *result = malloc(size ? size : 1);
+    if (!result)
+    {
+        throw std::bad_alloc();
+    }
+    return result;
+}
+
+__attribute__((noinline)) local void *GuardedAlignedNew(std::size_t size, std::align_val_t alignment)
+{
+    RecordGuardedAllocation(allocationGuardSource_operatorNew, size);
+    siz alignmentBytes = static_cast<siz>(alignment);
+    siz alignedSize = ((size + alignmentBytes - 1) / alignmentBytes) * alignmentBytes;
+    void *result = aligned_alloc(alignmentBytes, alignedSize ? alignedSize : alignmentBytes);
+    if (!result)
+    {
+        throw std::bad_alloc();
+    }
+    return result;
+}
+
+void *operator new(std::size_t size)
+{
+    return GuardedNew(size);
+}
+
+void *operator new[](std::size_t size)
+{
+    return GuardedNew(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    return GuardedAlignedNew(size, alignment);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return GuardedAlignedNew(size, alignment);
+}
+
+void operator delete(void *block) noexcept
+{
+    free(block);
+}
+
+void operator delete[](void *block) noexcept
+{
+    free(block);
+}
+
+void operator delete(void *block, std::size_t) noexcept
+{
+    free(block);
+}
+
+void operator delete[](void *block, std::size_t) noexcept
+{
+    free(block);
+}
+
+void operator delete(void *block, std::align_val_t) noexcept
+{
+    free(block);
+}
+
+void operator delete[](void *block, std::align_val_t) noexcept
+{
+    free(block);
+}
+
+void operator delete(void *block, std::size_t, std::align_val_t) noexcept
+{
+    free(block);
+}
+
+void operator delete[](void *block, std::size_t, std::align_val_t) noexcept
+{
+    free(block);
+}
+
+#endif
+
+#endif
@@ -5,6 +5,9 @@
 
 constexpr u32 DEBUG_STORAGE_SIZE = Megabytes(256);
 constexpr u32 MAX_GENERAL_ALLOCATIONS = 1024 * 1024;
+constexpr u32 DEBUG_ID_TABLE_CAPACITY = 16 * 1024;
+constexpr u32 DEBUG_ARENA_TABLE_CAPACITY = 4 * 1024;
+constexpr u32 DEFAULT_SAMPLE_INTERVAL = 64;
 
 // NOTE(marvin): We store all of our strings (name and debug ID) in
 // the miscArena. For name, we always create a fresh new
@@ -12,8 +15,9 @@ constexpr u32 MAX_GENERAL_ALLOCATIONS = 1024 * 1024;
 // which (for now) is created once on game initialize. As the same
 // debug IDs are repeatedly use, every unique debug ID is stored in
 // our misc arena exactly once, and whenever a debug record call
-// happens, it searches for the debug ID in our misc arena, which all
-// of the debug instances use instead.
+// happens, it looks up the debug ID in the debug ID table, which
+// points to the one in our misc arena that all of the debug instances
+// use instead.
 
 local DebugState *GetGlobalDebugState()
 {
@@ -89,34 +93,92 @@ local DebugAllocations EmptyDebugAllocations()
     return result;
 }
 
-local DebugIDsBuffer InitDebugIDsBuffer(MemoryArena *remainingArena)
+local u64 HashDebugID(const char *debugID)
 {
-    DebugIDsBuffer result = {};
-    result.base = PushArray(remainingArena, MAX_GENERAL_ALLOCATIONS, char *);
+    // NOTE(marvin): FNV-1a.
+    u64 result = 14695981039346656037ull;
+    for (const char *at = debugID; *at; ++at)
+    {
+        result ^= static_cast<u8>(*at);
+        result *= 1099511628211ull;
+    }
+    return result;
+}
+
+local u64 HashSourceArena(u08 *base, siz size)
+{
+    u64 result = reinterpret_cast<u64>(base) ^ (static_cast<u64>(size) * 0x9E3779B97F4A7C15ull);
+    result ^= result >> 29;
+    result *= 0xBF58476D1CE4E5B9ull;
+    result ^= result >> 32;
+    return result;
+}
+
+local DebugIDTable InitDebugIDTable(MemoryArena *remainingArena)
+{
+    DebugIDTable result = {};
+    result.entries = PushArray(remainingArena, DEBUG_ID_TABLE_CAPACITY, DebugIDEntry);
+    memset(result.entries, 0, DEBUG_ID_TABLE_CAPACITY * sizeof(DebugIDEntry));
+    result.capacity = DEBUG_ID_TABLE_CAPACITY;
     result.count = 0;
     return result;
 }
 
-// Returns nullptr if no reference exists.
-local char *TryFindReferenceToDebugID(DebugIDsBuffer *debugIDsBuffer, const char *debugID)
+local DebugArenaTable InitDebugArenaTable(MemoryArena *remainingArena)
 {
-    for (u32 index = 0; index < debugIDsBuffer->count; ++index)
+    DebugArenaTable result = {};
+    result.entries = PushArray(remainingArena, DEBUG_ARENA_TABLE_CAPACITY, DebugArenaEntry);
+    memset(result.entries, 0, DEBUG_ARENA_TABLE_CAPACITY * sizeof(DebugArenaEntry));
+    result.capacity = DEBUG_ARENA_TABLE_CAPACITY;
+    result.count = 0;
+    return result;
+}
+
+// Produces the entry of the given debug ID, or the empty slot where it
+// should go if it doesn't exist.
+local DebugIDEntry *FindDebugIDEntry(DebugIDTable *table, const char *debugID, u64 hash)
+{
+    u32 mask = table->capacity - 1;
+    for (u32 index = static_cast<u32>(hash) & mask;; index = (index + 1) & mask)
     {
-        char *ourDebugID = debugIDsBuffer->base[index];
-        if (strcmp(ourDebugID, debugID) == 0)
+        DebugIDEntry *entry = table->entries + index;
+        if (!entry->debugID ||
+            (entry->hash == hash && strcmp(entry->debugID, debugID) == 0))
         {
-            return ourDebugID;
+            return entry;
         }
     }
+}
 
-    return 0;
+// Produces the entry of the given source arena, or the empty slot where
+// it should go if it doesn't exist.
+local DebugArenaEntry *FindDebugArenaEntry(DebugArenaTable *table, u08 *base, siz size)
+{
+    u32 mask = table->capacity - 1;
+    for (u32 index = static_cast<u32>(HashSourceArena(base, size)) & mask;; index = (index + 1) & mask)
+    {
+        DebugArenaEntry *entry = table->entries + index;
+        if (!entry->target || (entry->base == base && entry->size == size))
+        {
+            return entry;
+        }
+    }
 }
 
-local void AddReferenceToDebugID(DebugIDsBuffer *debugIDsBuffer, char *ourDebugID)
+// NOTE(marvin): The target must stay where it is, which it does, as
+// the nodes of the tree are never moved around in the pool.
+local void RegisterTargetOfSourceArena(DebugState *debugState, MemoryArena source, DebugArena *target)
 {
-    char **next = debugIDsBuffer->base + debugIDsBuffer->count;
-    *next = ourDebugID;
-    ++debugIDsBuffer->count;
+    DebugArenaTable *table = &debugState->arenaTargets;
+    DebugArenaEntry *entry = FindDebugArenaEntry(table, source.base, source.size);
+    if (!entry->target)
+    {
+        ASSERT_PRINT(table->count < table->capacity / 2, "Too many memory arenas for the debug arena table.");
+        ++table->count;
+    }
+    entry->base = source.base;
+    entry->size = source.size;
+    entry->target = target;
 }
 
 local void InitGlobalDebugState(MemoryArena *remainingArena)
@@ -124,7 +186,11 @@ local void InitGlobalDebugState(MemoryArena *remainingArena)
     *globalDebugState = {};
     InitDebugAllocationsStoreInPlace(&globalDebugState->targetsStore, remainingArena);
     globalDebugState->targets = EmptyDebugAllocations();
-    globalDebugState->debugIDsIndex = InitDebugIDsBuffer(remainingArena);
+    globalDebugState->debugIDs = InitDebugIDTable(remainingArena);
+    globalDebugState->arenaTargets = InitDebugArenaTable(remainingArena);
+    globalDebugState->mode = debugMemoryViewerMode_full;
+    globalDebugState->sampleInterval = DEFAULT_SAMPLE_INTERVAL;
+    globalDebugState->sampleCountdown = DEFAULT_SAMPLE_INTERVAL;
     globalDebugState->miscArena = SubArena(remainingArena, remainingArena->size - remainingArena->used);
     globalDebugState->readyToInitMemoryArena_ = true;
 }
@@ -161,6 +227,9 @@ local siz TruncateDebugRegularAllocation(DebugRegularAllocation* allocation, siz
         remainingSize = 0;
     }
 
+    // NOTE(marvin): A push that was only partly popped still counts.
+    allocation->count = allocation->size ? (allocation->size + allocation->pushSize - 1) / allocation->pushSize : 0;
+
     return remainingSize;
 }
 
@@ -192,7 +261,7 @@ local void TruncateAllocation(DebugAllocations* allocations, siz size)
         DebugRegularAllocation* allocation = &cursor->regular;
         remainingSize = TruncateDebugRegularAllocation(allocation, remainingSize);
         DebugGeneralAllocation* nextCursor = cursor->prev;
-        if (allocation->size == 0)
+        if (allocation->count == 0)
         {
             // TODO(marvin): Is there a way to encapsulate adding to/removing from the deque and also managing the memory in the store?
             RemoveAllocation(cursor);
@@ -212,26 +281,42 @@ local DebugGeneralAllocation *GetLastAllocation(DebugAllocations *allocations)
     return result;
 }
 
-// Gets the given debug ID in our misc arena. If it doesn't exist, then add it to our misc arena.
-char *GetDebugIDFromOurArena(DebugState *debugState, const char *debugID)
+// Gets the entry of the given debug ID, whose debug ID is in our misc
+// arena. If it doesn't exist, then add it to our misc arena.
+local DebugIDEntry *InternDebugID(DebugState *debugState, const char *debugID)
 {
-    DebugIDsBuffer *debugIDsIndex = &debugState->debugIDsIndex;
-    char *result = TryFindReferenceToDebugID(debugIDsIndex, debugID);
-    if (result == 0)
+    DebugIDTable *table = &debugState->debugIDs;
+    u64 hash = HashDebugID(debugID);
+    DebugIDEntry *result = FindDebugIDEntry(table, debugID, hash);
+    if (!result->debugID)
     {
+        ASSERT_PRINT(table->count < table->capacity / 2, "Too many debug IDs for the debug ID table.");
         b32 before = debugState->readyToRegularAllocate_;
         debugState->readyToRegularAllocate_ = false;
         char *ourDebugID = PushString(&debugState->miscArena, debugID);
-        AddReferenceToDebugID(debugIDsIndex, ourDebugID);
         debugState->readyToRegularAllocate_ = before;
+
+        // NOTE(marvin): The entry has to be filled in before recording
+        // the push below, which interns its own debug ID.
+        result->hash = hash;
+        result->debugID = ourDebugID;
+        result->pushCount = 0;
+        result->pushBytes = 0;
+        ++table->count;
+
         // TODO(marvin): Again, how to know requested vs effective size after allocation has been made? 
         DebugRecordPushSize(MAKE_DEBUG_ID, &debugState->miscArena,
                             strlen(ourDebugID) + 1, strlen(ourDebugID) + 1);
-        result = ourDebugID;
     }
     return result;
 }
 
+char *GetDebugIDFromOurArena(DebugState *debugState, const char *debugID)
+{
+    char *result = InternDebugID(debugState, debugID)->debugID;
+    return result;
+}
+
 void DebugInitialize_(GameMemory gameMemory)
 {
     globalDebugState = gameMemory.debugState;
@@ -239,7 +324,7 @@ void DebugInitialize_(GameMemory gameMemory)
     debugState->readyToInitMemoryArena_ = false;
     debugState->readyToRegularAllocate_ = false;
 
-    gameMemory.debugStorage = gameMemory.platformAPI.allocator.AlignedAllocate(DEBUG_STORAGE_SIZE, 8);
+    gameMemory.debugStorage = gameMemory.platformAPI.allocator.AlignedAllocate(DEBUG_STORAGE_SIZE, 8, memoryTag_debug);
     MemoryArena memoryArena = InitMemoryArena(gameMemory.debugStorage, DEBUG_STORAGE_SIZE);
     InitGlobalDebugState(&memoryArena);
 
@@ -287,16 +372,19 @@ local DebugRegularAllocation InitDebugRegularAllocation(u32 requestedSize, u32 a
     DebugRegularAllocation result = {};
     result.offset = actualSize - requestedSize;
     result.size = actualSize;
+    result.count = 1;
+    result.pushSize = actualSize;
     return result;
 }
 
-local void MapSourceArenaToTarget(DebugGeneralAllocation *target, MemoryArena source, MemoryArena *miscArena, const char *ourDebugID, const char *name)
+local void MapSourceArenaToTarget(DebugState *debugState, DebugGeneralAllocation *target, MemoryArena source, MemoryArena *miscArena, const char *ourDebugID, const char *name)
 {
     // NOTE(marvin): These have to come before PushString below because
-    // the arena needs to be registered in the allocations pool so
-    // that all the pushes can find it!
+    // the arena needs to be registered in the arena table so that all
+    // the pushes can find it!
     target->arena = InitDebugArena(source);
     target->type = allocationType_arena;
+    RegisterTargetOfSourceArena(debugState, source, &target->arena);
 
     target->debugID = ourDebugID;
     target->name = PushString(miscArena, name);
@@ -310,52 +398,41 @@ local void MapSourceAllocationToTarget(DebugGeneralAllocation *target, u32 reque
     target->regular = InitDebugRegularAllocation(requestedSize, actualSize);
 }
 
-// Assumes that exist.
-local DebugArena *FindTargetOfSourceArenaFromPool(DebugAllocationsStorePool *pool, MemoryArena *source)
-{
-    for (u32 index = 0; index < pool->count; ++index)
-    {
-        DebugGeneralAllocation *candidate = pool->arena + index;
-        if (candidate->type == allocationType_arena)
-        {
-            DebugArena *candidateTarget = &candidate->arena;
-            if (candidateTarget->base == source->base)
-            {
-                return candidateTarget;
-            }
-        }
-    }
-
-    ASSERT_PRINT(false, "Target not found.");
-    return 0;
-}
-
-local DebugArena *FindTargetOfSourceArena(DebugAllocationsStore *store, MemoryArena *source)
+// Produces nullptr if the source arena was never recorded, which is
+// only allowed once the tree is frozen.
+local DebugArena *FindTargetOfSourceArena(DebugState *debugState, MemoryArena *source)
 {
-    // TODO(marvin): Simple algorithm, O(number of allocated nodes in pool). Maybe a hashing scheme using the debug ID.
-    DebugArena *result = FindTargetOfSourceArenaFromPool(&store->pool, source);
-    return result;
+    DebugArenaEntry *entry = FindDebugArenaEntry(&debugState->arenaTargets, source->base, source->size);
+    ASSERT_PRINT(entry->target || debugState->mode != debugMemoryViewerMode_full, "Target not found.");
+    return entry->target;
 }
 
-// Assumes that the last allocation is regular.
-local void ForceLastAllocationToArena(DebugAllocations *allocations, DebugAllocationsStore *targetStore, MemoryArena subArenaSource, MemoryArena *miscArena, const char *ourDebugID, const char *name)
+// Assumes that the last allocation is regular, and that it holds the
+// push of the sub arena.
+local void ForceLastAllocationToArena(DebugState *debugState, DebugAllocations *allocations, MemoryArena subArenaSource, u32 pushActualSize, const char *ourDebugID, const char *name)
 {
     DebugGeneralAllocation *last = GetLastAllocation(allocations);
     ASSERT(last->type == allocationType_regular);
 
     DebugRegularAllocation *regular = &last->regular;
 
-    // NOTE(marvin): If there is an offset, the regular allocation
-    // object stays, but size gets cleared and move to new arena
-    // object. Otherwise, the regular allocation becomes an arena
-    // allocation.
-    if (regular->offset > 0)
+    // NOTE(marvin): If there is an offset, or the push of the sub
+    // arena got aggregated with previous pushes, the regular
+    // allocation object stays with the rest of its size, and the sub
+    // arena is split off into a new arena object. Otherwise, the
+    // regular allocation becomes an arena allocation.
+    if (regular->offset > 0 || regular->count > 1)
     {
-        ASSERT(regular->size == subArenaSource.size);
-        regular->size = 0;
-        DebugGeneralAllocation *subArenaTarget = NewDebugGeneralAllocation(targetStore);
+        ASSERT(regular->size >= pushActualSize);
+        ASSERT(pushActualSize >= subArenaSource.size);
+        regular->size -= subArenaSource.size;
+        if (regular->count > 1)
+        {
+            --regular->count;
+        }
+        DebugGeneralAllocation *subArenaTarget = NewDebugGeneralAllocation(&debugState->targetsStore);
         AddAllocation(allocations, subArenaTarget);
-        MapSourceArenaToTarget(subArenaTarget, subArenaSource, miscArena, ourDebugID, name);
+        MapSourceArenaToTarget(debugState, subArenaTarget, subArenaSource, &debugState->miscArena, ourDebugID, name);
     }
     else
     {
@@ -363,18 +440,19 @@ local void ForceLastAllocationToArena(DebugAllocations *allocations, DebugAlloca
         last->name = name;
         last->type = allocationType_arena;
         last->arena = InitDebugArena(subArenaSource);
+        RegisterTargetOfSourceArena(debugState, subArenaSource, &last->arena);
     }
 }
  
 void DebugRecordInitMemoryArena_(const char *debugID, const char *name, MemoryArena source)
 {
     DebugState *debugState = GetGlobalDebugState();
-    if (debugState->readyToInitMemoryArena_)
+    if (debugState->readyToInitMemoryArena_ && debugState->mode == debugMemoryViewerMode_full)
     {
         DebugGeneralAllocation *target = NewDebugGeneralAllocation(&debugState->targetsStore);
         AddAllocation(&debugState->targets, target);
         // NOTE(marvin): A workaround to fill in Debug ID after. See note in MapSourceArenaToTarget.
-        MapSourceArenaToTarget(target, source, &debugState->miscArena, "", name);
+        MapSourceArenaToTarget(debugState, target, source, &debugState->miscArena, "", name);
         target->debugID = GetDebugIDFromOurArena(debugState, debugID);
         
         // TODO(marvin): Record the debugID and name string. Both are available in target here. All under the condition that not ready to regular allocate, and flip that true in that condition.
@@ -393,26 +471,79 @@ void DebugRecordSubArena_(const char *debugID, const char *name, MemoryArena *so
     DebugState *debugState = GetGlobalDebugState();
     // NOTE(marvin): As DebugRecordPushSize_ must happen before this
     // call, this call is temporally dependent on that.
-    if (debugState->readyToRegularAllocate_)
+    if (debugState->readyToRegularAllocate_ && debugState->mode == debugMemoryViewerMode_full)
     {
-        DebugArena *targetContainingArena = FindTargetOfSourceArena(&debugState->targetsStore, sourceContainingArena);
+        // NOTE(marvin): Interning the debug ID may record a push of
+        // its own, so the size of the push of the sub arena has to be
+        // grabbed before.
+        u32 pushActualSize = debugState->lastPushActualSize;
+        DebugArena *targetContainingArena = FindTargetOfSourceArena(debugState, sourceContainingArena);
         const char *ourDebugID = GetDebugIDFromOurArena(debugState, debugID);
-        ForceLastAllocationToArena(&targetContainingArena->allocations, &debugState->targetsStore, subArenaSource, &debugState->miscArena, ourDebugID, name);
+        ForceLastAllocationToArena(debugState, &targetContainingArena->allocations, subArenaSource, pushActualSize, ourDebugID, name);
     }
 }
 
+local void RecordCallSite(DebugIDEntry *entry, u64 pushCount, u64 pushBytes)
+{
+    entry->pushCount += pushCount;
+    entry->pushBytes += pushBytes;
+}
+
 void DebugRecordPushSize_(const char *debugID, MemoryArena *source, siz requestedSize, siz actualSize)
 {
     DebugState *debugState = GetGlobalDebugState();
-    if (debugState->readyToRegularAllocate_)
+    if (!debugState->readyToRegularAllocate_)
+    {
+        return;
+    }
+
+    DebugArena *targetArena = FindTargetOfSourceArena(debugState, source);
+    if (targetArena)
     {
-        DebugArena *targetArena = FindTargetOfSourceArena(&debugState->targetsStore, source);
         targetArena->used += actualSize;
+    }
 
-        DebugGeneralAllocation *targetAllocation = NewDebugGeneralAllocation(&debugState->targetsStore);
-        AddAllocation(&targetArena->allocations, targetAllocation);
-        const char *ourDebugID = GetDebugIDFromOurArena(debugState, debugID);
-        MapSourceAllocationToTarget(targetAllocation, requestedSize, actualSize, &debugState->miscArena, ourDebugID);
+    switch (debugState->mode)
+    {
+        case debugMemoryViewerMode_full:
+        {
+            DebugIDEntry *entry = InternDebugID(debugState, debugID);
+            RecordCallSite(entry, 1, actualSize);
+            debugState->lastPushActualSize = actualSize;
+
+            // NOTE(marvin): Only pushes without an offset are
+            // aggregated, so that the offset of the regular
+            // allocation stays meaningful, and only those of the same
+            // size, so that popping them can be counted.
+            DebugGeneralAllocation *last = GetLastAllocation(&targetArena->allocations);
+            if (last->type == allocationType_regular && last->debugID == entry->debugID &&
+                actualSize == requestedSize && last->regular.offset == 0 && last->regular.pushSize == actualSize)
+            {
+                last->regular.size += actualSize;
+                ++last->regular.count;
+            }
+            else
+            {
+                DebugGeneralAllocation *targetAllocation = NewDebugGeneralAllocation(&debugState->targetsStore);
+                AddAllocation(&targetArena->allocations, targetAllocation);
+                MapSourceAllocationToTarget(targetAllocation, requestedSize, actualSize, &debugState->miscArena, entry->debugID);
+            }
+        } break;
+
+        case debugMemoryViewerMode_callSites:
+        {
+            RecordCallSite(InternDebugID(debugState, debugID), 1, actualSize);
+        } break;
+
+        case debugMemoryViewerMode_sampled:
+        {
+            if (--debugState->sampleCountdown == 0)
+            {
+                debugState->sampleCountdown = debugState->sampleInterval;
+                RecordCallSite(InternDebugID(debugState, debugID),
+                               debugState->sampleInterval, actualSize * debugState->sampleInterval);
+            }
+        } break;
     }
 }
 
@@ -420,10 +551,25 @@ void DebugRecordPopSize_(MemoryArena *source, siz size)
 {
     DebugState *debugState = GetGlobalDebugState();
     
-    DebugArena *targetArena = FindTargetOfSourceArena(&debugState->targetsStore, source);
+    DebugArena *targetArena = FindTargetOfSourceArena(debugState, source);
+    if (!targetArena)
+    {
+        return;
+    }
     targetArena->used -= size;
 
-    TruncateAllocation(&targetArena->allocations, size);
+    if (debugState->mode == debugMemoryViewerMode_full)
+    {
+        TruncateAllocation(&targetArena->allocations, size);
+    }
+}
+
+void DebugSetMemoryViewerMode(DebugState *debugState, DebugMemoryViewerMode mode)
+{
+    ASSERT_PRINT(mode != debugMemoryViewerMode_full || debugState->mode == debugMemoryViewerMode_full,
+                 "The tree of allocations can't be unfrozen.");
+    debugState->mode = mode;
+    debugState->sampleCountdown = debugState->sampleInterval;
 }
 
 #endif
@@ -0,0 +1,352 @@
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include <meta_definitions.h>
+#include <debug_profiler.h>
+
+#if SKL_INTERNAL
+
+DebugProfiler *globalDebugProfiler;
+
+// NOTE(marvin): Each module has its own copy of these, so a thread
+// that runs code of both finds its ring by its key the first time
+// each module records on it, including after a hot reload.
+thread_local ProfilerRing *profilerThreadRing;
+thread_local b32 profilerThreadRingUnavailable;
+
+// >>> Local Helper Functions <<<
+
+local u64 GetProfilerThreadKey()
+{
+    u64 result = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    if (result == 0)
+    {
+        result = 1;
+    }
+    return result;
+}
+
+local u32 GetProfilerRingCount(DebugProfiler *profiler)
+{
+    u64 ringCount = AtomicLoadAcquireU64(&profiler->ringCount);
+    u32 result = static_cast<u32>(Minimum(ringCount, (u64)MAX_PROFILER_THREADS));
+    return result;
+}
+
+local ProfilerRing *GetProfilerThreadRing(DebugProfiler *profiler)
+{
+    if (profilerThreadRing || profilerThreadRingUnavailable)
+    {
+        return profilerThreadRing;
+    }
+
+    u64 threadKey = GetProfilerThreadKey();
+    u32 ringCount = GetProfilerRingCount(profiler);
+    for (u32 ringIndex = 0; ringIndex < ringCount; ++ringIndex)
+    {
+        ProfilerRing *ring = profiler->rings + ringIndex;
+        if (AtomicLoadAcquireU64(&ring->threadKey) == threadKey)
+        {
+            profilerThreadRing = ring;
+            return ring;
+        }
+    }
+
+    u64 ringIndex = AtomicAddU64(&profiler->ringCount, 1);
+    if (ringIndex >= MAX_PROFILER_THREADS)
+    {
+        LOG_ERROR("Too many threads for the profiler, not profiling this one.");
+        profilerThreadRingUnavailable = true;
+        return nullptr;
+    }
+
+    ProfilerRing *ring = profiler->rings + ringIndex;
+    snprintf(ring->threadName, PROFILER_NAME_LENGTH, "Thread %llu", (unsigned long long)ringIndex);
+    AtomicStoreReleaseU64(&ring->threadKey, threadKey);
+    profilerThreadRing = ring;
+    return ring;
+}
+
+local const char *GetFileBaseName(const char *fileName)
+{
+    const char *result = fileName;
+    for (const char *at = fileName; *at; ++at)
+    {
+        if (*at == '/' || *at == '\\')
+        {
+            result = at + 1;
+        }
+    }
+    return result;
+}
+
+local void WriteTraceString(FILE *file, const char *string)
+{
+    fputc('"', file);
+    for (const char *at = string; *at; ++at)
+    {
+        if (*at == '"' || *at == '\\')
+        {
+            fputc('\\', file);
+        }
+        fputc(*at, file);
+    }
+    fputc('"', file);
+}
+
+// >>> Global Function Interface <<<
+
+void InitDebugProfiler(DebugProfiler *profiler, u64 counter)
+{
+    profiler->calibrationTimestamp = ReadCPUTimer();
+    profiler->calibrationCounter = counter;
+    profiler->cpuTimerFrequency = 0.0;
+}
+
+void ProfilerRegisterThread(DebugProfiler *profiler, const char *threadName)
+{
+    ProfilerRing *ring = GetProfilerThreadRing(profiler);
+    if (ring)
+    {
+        strncpy(ring->threadName, threadName, PROFILER_NAME_LENGTH - 1);
+        ring->threadName[PROFILER_NAME_LENGTH - 1] = '\0';
+    }
+}
+
+u32 ProfilerGetSite(DebugProfiler *profiler, const char *blockName, const char *fileName, u32 lineNumber)
+{
+    const char *fileBaseName = GetFileBaseName(fileName);
+
+    while (AtomicExchangeU64(&profiler->siteLock, 1))
+    {
+    }
+
+    u32 result = 0;
+    u32 siteCount = static_cast<u32>(profiler->siteCount);
+    for (u32 siteIndex = 0; siteIndex < siteCount; ++siteIndex)
+    {
+        ProfilerSite *site = profiler->sites + siteIndex;
+        if (site->lineNumber == lineNumber &&
+            strncmp(site->blockName, blockName, PROFILER_NAME_LENGTH - 1) == 0 &&
+            strncmp(site->fileName, fileBaseName, PROFILER_NAME_LENGTH - 1) == 0)
+        {
+            result = siteIndex + 1;
+            break;
+        }
+    }
+
+    if (!result && siteCount < MAX_PROFILER_SITES)
+    {
+        ProfilerSite *site = profiler->sites + siteCount;
+        strncpy(site->blockName, blockName, PROFILER_NAME_LENGTH - 1);
+        strncpy(site->fileName, fileBaseName, PROFILER_NAME_LENGTH - 1);
+        site->lineNumber = lineNumber;
+        AtomicStoreReleaseU64(&profiler->siteCount, siteCount + 1);
+        result = siteCount + 1;
+    }
+
+    AtomicStoreReleaseU64(&profiler->siteLock, 0);
+    return result;
+}
+
+void ProfilerRecordEvent(DebugProfiler *profiler, u32 site, ProfilerEventType type)
+{
+    ProfilerRing *ring = GetProfilerThreadRing(profiler);
+    if (!ring || !site)
+    {
+        return;
+    }
+
+    // NOTE(marvin): If the main thread hasn't drained the ring in time,
+    // the event is dropped rather than waiting on it.
+    u64 writeIndex = ring->writeIndex;
+    if (writeIndex - AtomicLoadAcquireU64(&ring->readIndex) >= PROFILER_RING_EVENT_COUNT)
+    {
+        AtomicStoreReleaseU64(&ring->droppedCount, ring->droppedCount + 1);
+        return;
+    }
+
+    ProfilerEvent *event = ring->events + (writeIndex & (PROFILER_RING_EVENT_COUNT - 1));
+    event->timestamp = ReadCPUTimer();
+    event->siteIndex = site - 1;
+    event->type = type;
+    AtomicStoreReleaseU64(&ring->writeIndex, writeIndex + 1);
+}
+
+void ProfilerBeginFrame(DebugProfiler *profiler)
+{
+    u64 frameStartTimestamp = ReadCPUTimer();
+
+    u32 ringCount = GetProfilerRingCount(profiler);
+    for (u32 ringIndex = 0; ringIndex < ringCount; ++ringIndex)
+    {
+        ProfilerRing *ring = profiler->rings + ringIndex;
+        if (!AtomicLoadAcquireU64(&ring->threadKey))
+        {
+            continue;
+        }
+
+        u64 writeIndex = AtomicLoadAcquireU64(&ring->writeIndex);
+        if (!profiler->paused)
+        {
+            for (u64 readIndex = ring->readIndex; readIndex < writeIndex; ++readIndex)
+            {
+                ProfilerEvent *event = ring->events + (readIndex & (PROFILER_RING_EVENT_COUNT - 1));
+                ProfilerHistoryEvent *historyEvent = profiler->history + (profiler->historyWriteIndex++ & (PROFILER_HISTORY_EVENT_COUNT - 1));
+                historyEvent->timestamp = event->timestamp;
+                historyEvent->siteIndex = event->siteIndex;
+                historyEvent->threadIndex = static_cast<u16>(ringIndex);
+                historyEvent->type = static_cast<u16>(event->type);
+            }
+        }
+        AtomicStoreReleaseU64(&ring->readIndex, writeIndex);
+    }
+
+#if SKL_PERF_COUNTERS
+    u32 siteCount = static_cast<u32>(AtomicLoadAcquireU64(&profiler->siteCount));
+    for (u32 siteIndex = 0; siteIndex < siteCount; ++siteIndex)
+    {
+        ProfilerSiteCounters *counters = profiler->siteCounters + siteIndex;
+        ProfilerSiteCounters *lastFrameCounters = profiler->lastFrameSiteCounters + siteIndex;
+        u64 hitCount = AtomicExchangeU64(&counters->hitCount, 0);
+        PerfCounterValues values;
+        for (u32 counterIndex = 0; counterIndex < perfCounter_count; ++counterIndex)
+        {
+            values.values[counterIndex] = AtomicExchangeU64(&counters->values[counterIndex], 0);
+        }
+        if (!profiler->paused)
+        {
+            lastFrameCounters->hitCount = hitCount;
+            for (u32 counterIndex = 0; counterIndex < perfCounter_count; ++counterIndex)
+            {
+                lastFrameCounters->values[counterIndex] = values.values[counterIndex];
+            }
+        }
+    }
+#endif
+
+    if (!profiler->paused)
+    {
+        // NOTE(marvin): The events that were just moved over are those
+        // of the frame that ended, so the new frame's events start after
+        // them.
+        ++profiler->frameIndex;
+        profiler->frameStartTimestamps[profiler->frameIndex & (PROFILER_HISTORY_FRAME_COUNT - 1)] = frameStartTimestamp;
+        profiler->frameStartHistoryIndices[profiler->frameIndex & (PROFILER_HISTORY_FRAME_COUNT - 1)] = profiler->historyWriteIndex;
+    }
+}
+
+#if SKL_PERF_COUNTERS
+b32 ProfilerReadPerfCounters(DebugProfiler *profiler, PerfCounterValues *values)
+{
+    ProfilerRing *ring = GetProfilerThreadRing(profiler);
+    if (!ring)
+    {
+        return false;
+    }
+
+    // NOTE(marvin): A thread whose ID is reused by a later thread
+    // leaves that one with counters that no longer count. Threads are
+    // only started at startup and with the physics system, so it
+    // isn't worth a system call per read to catch.
+    if (ring->perfCounters.state == perfCounterGroupState_unopened)
+    {
+        OpenPerfCounterGroup(&ring->perfCounters);
+    }
+    b32 result = ReadPerfCounterGroup(&ring->perfCounters, values);
+    return result;
+}
+
+void ProfilerAddSiteCounters(DebugProfiler *profiler, u32 site, PerfCounterValues *begin, PerfCounterValues *end)
+{
+    if (!site)
+    {
+        return;
+    }
+
+    ProfilerSiteCounters *counters = profiler->siteCounters + (site - 1);
+    AtomicAddU64(&counters->hitCount, 1);
+    for (u32 counterIndex = 0; counterIndex < perfCounter_count; ++counterIndex)
+    {
+        AtomicAddU64(&counters->values[counterIndex], end->values[counterIndex] - begin->values[counterIndex]);
+    }
+}
+#endif
+
+void UpdateProfilerTimerFrequency(DebugProfiler *profiler, u64 counter, u64 counterFrequency)
+{
+    u64 counterDelta = counter - profiler->calibrationCounter;
+    if (counterDelta)
+    {
+        f64 seconds = static_cast<f64>(counterDelta) / static_cast<f64>(counterFrequency);
+        profiler->cpuTimerFrequency = static_cast<f64>(ReadCPUTimer() - profiler->calibrationTimestamp) / seconds;
+    }
+}
+
+s32 WriteProfilerChromeTrace(DebugProfiler *profiler, const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        LOG_ERROR("Unable to open " << path << " to write the profiler trace to.");
+        return -1;
+    }
+
+    u64 historyWriteIndex = profiler->historyWriteIndex;
+    u64 historyReadIndex = historyWriteIndex > PROFILER_HISTORY_EVENT_COUNT ? historyWriteIndex - PROFILER_HISTORY_EVENT_COUNT : 0;
+
+    // NOTE(marvin): The history is merged from the rings of every thread
+    // a ring at a time, so the events aren't in the order of their
+    // timestamps, and the first one isn't necessarily the earliest.
+    u64 baseTimestamp = historyReadIndex < historyWriteIndex ? ~0ull : 0;
+    for (u64 historyIndex = historyReadIndex; historyIndex < historyWriteIndex; ++historyIndex)
+    {
+        ProfilerHistoryEvent *event = profiler->history + (historyIndex & (PROFILER_HISTORY_EVENT_COUNT - 1));
+        baseTimestamp = Minimum(baseTimestamp, event->timestamp);
+    }
+
+    // NOTE(marvin): The trace is in microseconds. Without a frequency
+    // yet, the cycles are written as is.
+    f64 cyclesToMicroseconds = profiler->cpuTimerFrequency > 0.0 ? 1000000.0 / profiler->cpuTimerFrequency : 1.0;
+
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+
+    u32 ringCount = GetProfilerRingCount(profiler);
+    for (u32 ringIndex = 0; ringIndex < ringCount; ++ringIndex)
+    {
+        fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", ringIndex);
+        WriteTraceString(file, profiler->rings[ringIndex].threadName);
+        fputs("}},\n", file);
+    }
+
+    for (u64 historyIndex = historyReadIndex; historyIndex < historyWriteIndex; ++historyIndex)
+    {
+        ProfilerHistoryEvent *event = profiler->history + (historyIndex & (PROFILER_HISTORY_EVENT_COUNT - 1));
+        ProfilerSite *site = profiler->sites + event->siteIndex;
+        f64 timestamp = static_cast<f64>(event->timestamp - baseTimestamp) * cyclesToMicroseconds;
+
+        fputs("{\"name\":", file);
+        WriteTraceString(file, site->blockName);
+        fprintf(file, ",\"cat\":\"skl\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":%u",
+                event->type == profilerEventType_begin ? "B" : "E", timestamp, event->threadIndex);
+        if (event->type == profilerEventType_begin)
+        {
+            fputs(",\"args\":{\"file\":", file);
+            WriteTraceString(file, site->fileName);
+            fprintf(file, ",\"line\":%u}", site->lineNumber);
+        }
+        fputs("},\n", file);
+    }
+
+    // NOTE(marvin): JSON doesn't allow a trailing comma, so the last
+    // entry is the process name.
+    fputs("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"skyline-engine\"}}\n]}\n", file);
+
+    s32 result = ferror(file) ? -1 : 0;
+    fclose(file);
+    LOG("Wrote " << (historyWriteIndex - historyReadIndex) << " profiler events to " << path);
+    return result;
+}
+
+#endif
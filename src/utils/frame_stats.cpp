@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include <meta_definitions.h>
+#include <frame_stats.h>
+
+// >>> Local Helper Functions <<<
+
+local u32 GetFrameStatsHistoryCount(FrameStats *stats)
+{
+    u32 result = static_cast<u32>(Minimum(stats->frameCount, (u64)FRAME_STATS_HISTORY_COUNT));
+    return result;
+}
+
+// NOTE(marvin): Nearest rank, on values that are already sorted.
+local f32 GetPercentile(f32 *sortedValues, u32 count, u32 percent)
+{
+    u32 rank = (count * percent + 99) / 100;
+    u32 index = rank ? rank - 1 : 0;
+    return sortedValues[index];
+}
+
+local void SummarizeFrameValues(f32 *values, u32 count, FramePercentiles *percentiles)
+{
+    std::sort(values, values + count);
+    percentiles->p50 = GetPercentile(values, count, 50);
+    percentiles->p95 = GetPercentile(values, count, 95);
+    percentiles->p99 = GetPercentile(values, count, 99);
+    percentiles->max = values[count - 1];
+}
+
+// >>> Global Function Interface <<<
+
+void InitFrameStats(FrameStats *stats, u64 counter)
+{
+    stats->calibrationTimestamp = ReadCPUTimer();
+    stats->calibrationCounter = counter;
+    stats->cpuTimerFrequency = 0.0;
+}
+
+void BeginFrameStatsFrame(FrameStats *stats, u64 counter, u64 counterFrequency)
+{
+    u64 frameBeginTimestamp = ReadCPUTimer();
+
+    u64 counterDelta = counter - stats->calibrationCounter;
+    if (counterDelta)
+    {
+        f64 seconds = static_cast<f64>(counterDelta) / static_cast<f64>(counterFrequency);
+        stats->cpuTimerFrequency = static_cast<f64>(frameBeginTimestamp - stats->calibrationTimestamp) / seconds;
+    }
+
+    if (stats->frameBeginTimestamp && stats->cpuTimerFrequency > 0.0 && !stats->paused)
+    {
+        f64 cyclesToMs = 1000.0 / stats->cpuTimerFrequency;
+        FrameStatsEntry *entry = stats->entries + (stats->frameCount & (FRAME_STATS_HISTORY_COUNT - 1));
+        entry->frameMs = static_cast<f32>((frameBeginTimestamp - stats->frameBeginTimestamp) * cyclesToMs);
+        for (u32 phaseIndex = 0; phaseIndex < framePhase_count; ++phaseIndex)
+        {
+            entry->phaseMs[phaseIndex] = static_cast<f32>(stats->phaseCycles[phaseIndex] * cyclesToMs);
+        }
+        entry->fixedStepCount = stats->fixedStepCount;
+        ++stats->frameCount;
+    }
+
+    stats->frameBeginTimestamp = frameBeginTimestamp;
+    memset(stats->phaseCycles, 0, sizeof(stats->phaseCycles));
+    stats->fixedStepCount = 0;
+}
+
+void SummarizeFrameStats(FrameStats *stats, FrameStatsSummary *summary)
+{
+    *summary = {};
+    u32 count = GetFrameStatsHistoryCount(stats);
+    summary->frameCount = count;
+    if (!count)
+    {
+        return;
+    }
+
+    f32 values[FRAME_STATS_HISTORY_COUNT];
+    for (u32 frameIndex = 0; frameIndex < count; ++frameIndex)
+    {
+        values[frameIndex] = stats->entries[frameIndex].frameMs;
+    }
+    SummarizeFrameValues(values, count, &summary->frame);
+
+    for (u32 phaseIndex = 0; phaseIndex < framePhase_count; ++phaseIndex)
+    {
+        for (u32 frameIndex = 0; frameIndex < count; ++frameIndex)
+        {
+            values[frameIndex] = stats->entries[frameIndex].phaseMs[phaseIndex];
+        }
+        SummarizeFrameValues(values, count, summary->phases + phaseIndex);
+    }
+}
+
+s32 WriteFrameStatsCSV(FrameStats *stats, const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+    {
+        LOG_ERROR("Failed to open " << path << " for writing the frame times.");
+        return -1;
+    }
+
+    fprintf(file, "frame,frame_ms,input_ms,fixed_ms,variable_ms,draw_ms,submit_ms,fixed_steps\n");
+
+    u32 count = GetFrameStatsHistoryCount(stats);
+    for (u32 framesAgo = count; framesAgo > 0; --framesAgo)
+    {
+        FrameStatsEntry *entry = GetFrameStatsEntry(stats, framesAgo - 1);
+        fprintf(file, "%llu,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%u\n",
+                (unsigned long long)(stats->frameCount - framesAgo),
+                entry->frameMs,
+                entry->phaseMs[framePhase_input],
+                entry->phaseMs[framePhase_fixed],
+                entry->phaseMs[framePhase_variable],
+                entry->phaseMs[framePhase_draw],
+                entry->phaseMs[framePhase_submit],
+                entry->fixedStepCount);
+    }
+
+    fclose(file);
+    LOG("Wrote " << count << " frame times to " << path);
+    return 0;
+}
@@ -0,0 +1,312 @@
+#include <cstdio>
+
+#include <meta_definitions.h>
+#include <job_scheduler.h>
+#include <debug_profiler.h>
+
+// >>> Local Helper Functions <<<
+
+local void RunJob(Job *job)
+{
+    job->function(job->data);
+    if (job->counter)
+    {
+        // NOTE(marvin): Unsigned wrap around does the subtraction.
+        AtomicAddU64(job->counter, ~0ull);
+    }
+}
+
+local b32 PushJobBack(JobDeque *deque, Job *job)
+{
+    std::lock_guard<std::mutex> lock(deque->mutex);
+    if (deque->tail - deque->head == JOB_DEQUE_CAPACITY)
+    {
+        return false;
+    }
+
+    deque->jobs[deque->tail & (JOB_DEQUE_CAPACITY - 1)] = *job;
+    ++deque->tail;
+    AtomicStoreReleaseU64(&deque->count, deque->tail - deque->head);
+    return true;
+}
+
+local b32 PopJobBack(JobDeque *deque, Job *job)
+{
+    if (!AtomicLoadAcquireU64(&deque->count))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(deque->mutex);
+    if (deque->tail == deque->head)
+    {
+        return false;
+    }
+
+    --deque->tail;
+    *job = deque->jobs[deque->tail & (JOB_DEQUE_CAPACITY - 1)];
+    AtomicStoreReleaseU64(&deque->count, deque->tail - deque->head);
+    return true;
+}
+
+local b32 StealJobFront(JobDeque *deque, Job *job)
+{
+    if (!AtomicLoadAcquireU64(&deque->count))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(deque->mutex);
+    if (deque->tail == deque->head)
+    {
+        return false;
+    }
+
+    *job = deque->jobs[deque->head & (JOB_DEQUE_CAPACITY - 1)];
+    ++deque->head;
+    AtomicStoreReleaseU64(&deque->count, deque->tail - deque->head);
+    return true;
+}
+
+// NOTE(marvin): Looked up by the thread ID rather than kept in a thread
+// local, as the platform and the game module each have their own copy
+// of this file, and so of any thread local in it.
+local u32 GetCallingDequeIndex(JobScheduler *scheduler)
+{
+    std::thread::id threadID = std::this_thread::get_id();
+    for (u32 workerIndex = 0; workerIndex < scheduler->workerCount; ++workerIndex)
+    {
+        if (scheduler->workerThreadIDs[workerIndex] == threadID)
+        {
+            return workerIndex;
+        }
+    }
+    return EXTERNAL_JOB_DEQUE_INDEX;
+}
+
+// NOTE(marvin): Every job of a higher priority, wherever it is, goes
+// before the jobs of a lower one. The others are stolen from starting
+// after the thief, so that the thieves don't all go for the same one.
+local b32 TakeJob(JobScheduler *scheduler, u32 dequeIndex, Job *job)
+{
+    constexpr u32 dequeCount = MAX_JOB_WORKERS + 1;
+    for (u32 priority = 0; priority < jobPriority_count; ++priority)
+    {
+        if (PopJobBack(&scheduler->deques[dequeIndex][priority], job))
+        {
+            AtomicAddU64(&scheduler->queuedJobCount, ~0ull);
+            return true;
+        }
+
+        for (u32 offset = 1; offset < dequeCount; ++offset)
+        {
+            u32 victimIndex = (dequeIndex + offset) % dequeCount;
+            if (StealJobFront(&scheduler->deques[victimIndex][priority], job))
+            {
+                AtomicAddU64(&scheduler->queuedJobCount, ~0ull);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+local void RunJobWorker(JobScheduler *scheduler, u32 workerIndex)
+{
+#if SKL_INTERNAL
+    if (globalDebugProfiler)
+    {
+        char threadName[PROFILER_NAME_LENGTH];
+        snprintf(threadName, sizeof(threadName), "Job Worker %u", workerIndex);
+        ProfilerRegisterThread(globalDebugProfiler, threadName);
+    }
+#endif
+
+    // NOTE(marvin): The jobs can ask for the index of the thread they
+    // are on, which is looked up in the thread IDs, so no job is taken
+    // before all of them are in.
+    {
+        std::unique_lock<std::mutex> lock(scheduler->sleepMutex);
+        scheduler->wakeCondition.wait(lock, [scheduler]
+        {
+            return AtomicLoadAcquireU64(&scheduler->started) || AtomicLoadAcquireU64(&scheduler->stopping);
+        });
+    }
+
+    while (!AtomicLoadAcquireU64(&scheduler->stopping))
+    {
+        Job job;
+        if (TakeJob(scheduler, workerIndex, &job))
+        {
+            RunJob(&job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(scheduler->sleepMutex);
+        scheduler->wakeCondition.wait(lock, [scheduler]
+        {
+            return AtomicLoadAcquireU64(&scheduler->stopping) || AtomicLoadAcquireU64(&scheduler->queuedJobCount) != 0;
+        });
+    }
+
+    AtomicAddU64(&scheduler->runningWorkerCount, ~0ull);
+}
+
+local void StartJobWorkers(JobScheduler *scheduler, u32 workerCount)
+{
+    ASSERT(!scheduler->workerCount && !AtomicLoadAcquireU64(&scheduler->runningWorkerCount));
+    workerCount = Minimum(workerCount, MAX_JOB_WORKERS);
+
+    AtomicStoreReleaseU64(&scheduler->started, false);
+    AtomicStoreReleaseU64(&scheduler->stopping, false);
+    for (u32 workerIndex = 0; workerIndex < workerCount; ++workerIndex)
+    {
+        AtomicAddU64(&scheduler->runningWorkerCount, 1);
+        std::thread thread{RunJobWorker, scheduler, workerIndex};
+        scheduler->workerThreadIDs[workerIndex] = thread.get_id();
+        thread.detach();
+    }
+    scheduler->workerCount = workerCount;
+    scheduler->requestedWorkerCount = workerCount;
+
+    {
+        std::lock_guard<std::mutex> lock(scheduler->sleepMutex);
+        AtomicStoreReleaseU64(&scheduler->started, true);
+    }
+    scheduler->wakeCondition.notify_all();
+}
+
+// >>> Global Function Interface <<<
+
+u32 GetDefaultJobWorkerCount()
+{
+#if EMSCRIPTEN
+    return 0;
+#else
+    u32 coreCount = std::thread::hardware_concurrency();
+    u32 result = coreCount > 1 ? coreCount - 1 : 0;  // Subtract main thread
+    return result;
+#endif
+}
+
+void InitJobScheduler(JobScheduler *scheduler, u32 workerCount)
+{
+    for (u32 dequeIndex = 0; dequeIndex < MAX_JOB_WORKERS + 1; ++dequeIndex)
+    {
+        for (u32 priority = 0; priority < jobPriority_count; ++priority)
+        {
+            JobDeque *deque = &scheduler->deques[dequeIndex][priority];
+            deque->head = 0;
+            deque->tail = 0;
+            deque->count = 0;
+        }
+    }
+    scheduler->workerCount = 0;
+    scheduler->runningWorkerCount = 0;
+    scheduler->started = false;
+    scheduler->queuedJobCount = 0;
+
+    StartJobWorkers(scheduler, workerCount);
+    LOG("Started " << scheduler->workerCount << " job workers.");
+}
+
+void StopJobWorkers(JobScheduler *scheduler)
+{
+    {
+        std::lock_guard<std::mutex> lock(scheduler->sleepMutex);
+        AtomicStoreReleaseU64(&scheduler->stopping, true);
+    }
+    scheduler->wakeCondition.notify_all();
+
+    while (AtomicLoadAcquireU64(&scheduler->runningWorkerCount))
+    {
+        std::this_thread::yield();
+    }
+    scheduler->workerCount = 0;
+}
+
+void ApplyJobWorkerCount(JobScheduler *scheduler)
+{
+    u32 workerCount = Minimum(scheduler->requestedWorkerCount, MAX_JOB_WORKERS);
+    if (workerCount == scheduler->workerCount)
+    {
+        return;
+    }
+
+    LOG("Going from " << scheduler->workerCount << " to " << workerCount << " job workers.");
+    StopJobWorkers(scheduler);
+
+    // NOTE(marvin): Without workers, nothing would take the jobs that
+    // are left, and the ones submitted from now on are run right away.
+    if (!workerCount)
+    {
+        while (RunQueuedJob(scheduler))
+        {
+        }
+    }
+
+    StartJobWorkers(scheduler, workerCount);
+}
+
+u32 GetJobThreadIndex(JobScheduler *scheduler)
+{
+    u32 result = GetCallingDequeIndex(scheduler);
+    return result;
+}
+
+void SubmitJob(JobScheduler *scheduler, job_function_t *function, void *data,
+               JobPriority priority, u64 volatile *counter)
+{
+    ASSERT(priority < jobPriority_count);
+    if (counter)
+    {
+        AtomicAddU64(counter, 1);
+    }
+
+    Job job = {function, data, counter};
+    if (!scheduler->workerCount)
+    {
+        RunJob(&job);
+        return;
+    }
+
+    // NOTE(marvin): Counted before it is pushed, so that a worker that
+    // takes it right away never sees the count go below 0.
+    AtomicAddU64(&scheduler->queuedJobCount, 1);
+    u32 dequeIndex = GetCallingDequeIndex(scheduler);
+    if (!PushJobBack(&scheduler->deques[dequeIndex][priority], &job))
+    {
+        AtomicAddU64(&scheduler->queuedJobCount, ~0ull);
+        RunJob(&job);
+        return;
+    }
+
+    // NOTE(marvin): Taking the lock orders this after a worker that is
+    // about to sleep has checked the count, so it can't miss the wake.
+    {
+        std::lock_guard<std::mutex> lock(scheduler->sleepMutex);
+    }
+    scheduler->wakeCondition.notify_one();
+}
+
+b32 RunQueuedJob(JobScheduler *scheduler)
+{
+    Job job;
+    b32 result = TakeJob(scheduler, GetCallingDequeIndex(scheduler), &job);
+    if (result)
+    {
+        RunJob(&job);
+    }
+    return result;
+}
+
+void WaitForJobCounter(JobScheduler *scheduler, u64 volatile *counter)
+{
+    while (AtomicLoadAcquireU64(counter))
+    {
+        if (!RunQueuedJob(scheduler))
+        {
+            std::this_thread::yield();
+        }
+    }
+}
@@ -0,0 +1,110 @@
+#include <cstdio>
+#include <cstring>
+
+#include <meta_definitions.h>
+#include <memory_telemetry.h>
+
+void RegisterTelemetryArena(MemoryTelemetry *telemetry, MemoryArena *arena, const char *name, MemoryTag tag)
+{
+    MemoryTelemetryArena *entry = nullptr;
+    for (u32 i = 0; i < telemetry->arenaCount; ++i)
+    {
+        if (telemetry->arenas[i].arena == arena)
+        {
+            entry = telemetry->arenas + i;
+            break;
+        }
+    }
+
+    if (!entry)
+    {
+        if (telemetry->arenaCount >= MAX_TELEMETRY_ARENAS)
+        {
+            LOG_ERROR("Too many arenas registered with the memory telemetry, ignoring " << name);
+            return;
+        }
+        entry = telemetry->arenas + telemetry->arenaCount++;
+    }
+
+    strncpy(entry->name, name, TELEMETRY_ARENA_NAME_LENGTH - 1);
+    entry->name[TELEMETRY_ARENA_NAME_LENGTH - 1] = '\0';
+    entry->tag = tag;
+    entry->arena = arena;
+}
+
+void GetTelemetryArenaTotals(MemoryTelemetry *telemetry, MemoryTag tag, siz *used, siz *peakUsed, siz *size)
+{
+    *used = 0;
+    *peakUsed = 0;
+    *size = 0;
+    for (u32 i = 0; i < telemetry->arenaCount; ++i)
+    {
+        MemoryTelemetryArena *entry = telemetry->arenas + i;
+        if (entry->tag == tag)
+        {
+            *used += entry->arena->used;
+            *peakUsed += entry->arena->peakUsed;
+            *size += entry->arena->size;
+        }
+    }
+}
+
+void EndMemoryTelemetryFrame(MemoryTelemetry *telemetry)
+{
+    for (u32 tagIndex = 0; tagIndex < memoryTag_count; ++tagIndex)
+    {
+        MemoryTagStats *stats = telemetry->tags + tagIndex;
+        stats->allocationsLastFrame = AtomicExchangeU64(&stats->allocationsThisFrame, 0);
+        stats->bytesLastFrame = AtomicExchangeU64(&stats->bytesThisFrame, 0);
+
+        // NOTE(marvin): Only warns on the frame that the budget is
+        // crossed, otherwise it would flood the log.
+        b32 overBudget = stats->budget && (stats->bytesLive > stats->budget);
+        if (overBudget && !stats->overBudget)
+        {
+            LOG_ERROR("Memory budget exceeded for " << GetMemoryTagName(static_cast<MemoryTag>(tagIndex))
+                      << ": " << stats->bytesLive << " / " << stats->budget << " bytes.");
+        }
+        stats->overBudget = overBudget;
+    }
+
+    ++telemetry->frameIndex;
+}
+
+s32 WriteMemoryTelemetryCSV(MemoryTelemetry *telemetry, const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+    {
+        LOG_ERROR("Failed to open " << path << " for writing the memory telemetry.");
+        return -1;
+    }
+
+    fprintf(file, "kind,name,tag,bytes_live,bytes_peak,allocations_per_frame,bytes_per_frame,budget,size\n");
+
+    for (u32 tagIndex = 0; tagIndex < memoryTag_count; ++tagIndex)
+    {
+        MemoryTag tag = static_cast<MemoryTag>(tagIndex);
+        MemoryTagStats *stats = telemetry->tags + tagIndex;
+        fprintf(file, "heap,%s,%s,%llu,%llu,%llu,%llu,%llu,\n",
+                GetMemoryTagName(tag), GetMemoryTagName(tag),
+                (unsigned long long)stats->bytesLive,
+                (unsigned long long)stats->bytesPeak,
+                (unsigned long long)stats->allocationsLastFrame,
+                (unsigned long long)stats->bytesLastFrame,
+                (unsigned long long)stats->budget);
+    }
+
+    for (u32 i = 0; i < telemetry->arenaCount; ++i)
+    {
+        MemoryTelemetryArena *entry = telemetry->arenas + i;
+        fprintf(file, "arena,%s,%s,%llu,%llu,,,,%llu\n",
+                entry->name, GetMemoryTagName(entry->tag),
+                (unsigned long long)entry->arena->used,
+                (unsigned long long)entry->arena->peakUsed,
+                (unsigned long long)entry->arena->size);
+    }
+
+    fclose(file);
+    return 0;
+}
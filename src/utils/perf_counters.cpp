@@ -0,0 +1,140 @@
+#include <meta_definitions.h>
+#include <perf_counters.h>
+
+#if SKL_PERF_COUNTERS
+
+#include <cerrno>
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// >>> Local Helper Functions <<<
+
+local s32 OpenPerfCounter(u32 type, u64 config, s32 groupFd)
+{
+    perf_event_attr attr = {};
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    // NOTE(marvin): pid 0 and cpu -1 is the calling thread, on any CPU.
+    s32 result = static_cast<s32>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, PERF_FLAG_FD_CLOEXEC));
+    return result;
+}
+
+local void GetPerfCounterConfig(PerfCounter counter, u32 *type, u64 *config)
+{
+    u64 cacheReadMiss = (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    switch (counter)
+    {
+        case perfCounter_cycles:
+            *type = PERF_TYPE_HARDWARE;
+            *config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case perfCounter_instructions:
+            *type = PERF_TYPE_HARDWARE;
+            *config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case perfCounter_l1dMisses:
+            *type = PERF_TYPE_HW_CACHE;
+            *config = PERF_COUNT_HW_CACHE_L1D | cacheReadMiss;
+            break;
+        case perfCounter_llcMisses:
+            *type = PERF_TYPE_HW_CACHE;
+            *config = PERF_COUNT_HW_CACHE_LL | cacheReadMiss;
+            break;
+        case perfCounter_branchMisses:
+            *type = PERF_TYPE_HARDWARE;
+            *config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        default:
+            ASSERT(false);
+            break;
+    }
+}
+
+// >>> Global Function Interface <<<
+
+b32 OpenPerfCounterGroup(PerfCounterGroup *group)
+{
+    group->slotCount = 0;
+    for (u32 counterIndex = 0; counterIndex < perfCounter_count; ++counterIndex)
+    {
+        group->fds[counterIndex] = -1;
+    }
+
+    // NOTE(marvin): The cycles are the leader of the group, without
+    // them there is nothing to relate the rest to.
+    for (u32 counterIndex = 0; counterIndex < perfCounter_count; ++counterIndex)
+    {
+        u32 type;
+        u64 config;
+        GetPerfCounterConfig(static_cast<PerfCounter>(counterIndex), &type, &config);
+        s32 fd = OpenPerfCounter(type, config, group->fds[perfCounter_cycles]);
+        if (fd < 0)
+        {
+            LOG_ERROR("Unable to open the " << GetPerfCounterName(static_cast<PerfCounter>(counterIndex))
+                      << " counter: " << strerror(errno) << ".");
+            if (counterIndex == perfCounter_cycles)
+            {
+                LOG_ERROR("No performance counters on this thread, check /proc/sys/kernel/perf_event_paranoid.");
+                group->state = perfCounterGroupState_failed;
+                return false;
+            }
+            continue;
+        }
+
+        group->fds[counterIndex] = fd;
+        group->slotCounters[group->slotCount++] = counterIndex;
+    }
+
+    group->state = perfCounterGroupState_open;
+    return true;
+}
+
+void ClosePerfCounterGroup(PerfCounterGroup *group)
+{
+    // NOTE(marvin): The members before the leader.
+    for (u32 counterIndex = perfCounter_count; counterIndex > 0; --counterIndex)
+    {
+        s32 fd = group->fds[counterIndex - 1];
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        group->fds[counterIndex - 1] = -1;
+    }
+    group->slotCount = 0;
+    group->state = perfCounterGroupState_unopened;
+}
+
+b32 ReadPerfCounterGroup(PerfCounterGroup *group, PerfCounterValues *values)
+{
+    *values = {};
+    if (group->state != perfCounterGroupState_open)
+    {
+        return false;
+    }
+
+    // NOTE(marvin): With PERF_FORMAT_GROUP, a read of the leader is
+    // the number of counters followed by each of their values.
+    u64 buffer[perfCounter_count + 1];
+    ssize_t bytesRead = read(group->fds[perfCounter_cycles], buffer, sizeof(buffer));
+    if (bytesRead < static_cast<ssize_t>(sizeof(u64)) || buffer[0] != group->slotCount)
+    {
+        return false;
+    }
+
+    for (u32 slotIndex = 0; slotIndex < group->slotCount; ++slotIndex)
+    {
+        values->values[group->slotCounters[slotIndex]] = buffer[slotIndex + 1];
+    }
+    return true;
+}
+
+#endif